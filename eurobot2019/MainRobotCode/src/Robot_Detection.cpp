@@ -51,7 +51,7 @@ double Robot::avoidOtherRobots()
   bool forward = true;
   if (!currentTrajectories_.empty())
   {
-    miam::trajectory::TrajectoryPoint trajectoryPoint = currentTrajectories_.at(0)->getCurrentPoint(curvilinearAbscissa_);
+    miam::trajectory::TrajectoryPoint trajectoryPoint = currentTrajectories_.front().getCurrentPoint(curvilinearAbscissa_);
     forward = (trajectoryPoint.linearVelocity >= 0);
   }
 
@@ -145,7 +145,7 @@ double Robot::avoidOtherRobots()
           // Replan and retry trajectory.
           if (!currentTrajectories_.empty())
           {
-              currentTrajectories_.at(0)->replanify(curvilinearAbscissa_);
+              currentTrajectories_.front().replanify(curvilinearAbscissa_);
               curvilinearAbscissa_ = 0;
           }
       }
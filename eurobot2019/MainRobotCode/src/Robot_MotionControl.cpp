@@ -88,7 +88,7 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
     if(!newTrajectories_.empty())
     {
         // We have new trajectories, erase the current trajectories and follow the new one.
-        currentTrajectories_ = newTrajectories_;
+        currentTrajectories_.assign(newTrajectories_);
         curvilinearAbscissa_ = 0;
         newTrajectories_.clear();
         std::cout << "Received new trajectory" << std::endl;
@@ -104,7 +104,7 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
     else
     {
         // Load first trajectory, look if we are done following it.
-        Trajectory *traj = currentTrajectories_.at(0).get();
+        Trajectory *traj = currentTrajectories_.front().get();
         // Look if first trajectory is done.
         // No avoidance if point turn.
         if (traj->getCurrentPoint(curvilinearAbscissa_).linearVelocity == 0)
@@ -116,9 +116,8 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
             // If we still have a trajectory after that, immediately switch to the next trajectory.
             if(currentTrajectories_.size() > 1)
             {
-                // Not obtimal, could be improved.
-                currentTrajectories_.erase(currentTrajectories_.begin());
-                traj = currentTrajectories_.at(0).get();
+                currentTrajectories_.pop_front();
+                traj = currentTrajectories_.front().get();
                 trajectoryStartTime_ = currentTime_;
                 curvilinearAbscissa_ = 0.0;
                 std::cout << "Trajectory done, going to next one" << std::endl;
@@ -129,7 +128,7 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
         if(curvilinearAbscissa_ - 0.1 >  traj->getDuration())
         {
             std::cout << "Timeout on trajectory following" << std::endl;
-            currentTrajectories_.erase(currentTrajectories_.begin());
+            currentTrajectories_.pop_front();
             motorSpeed_[0] = 0.0;
             motorSpeed_[1] = 0.0;
             curvilinearAbscissa_ = 0.;
@@ -141,7 +140,7 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
             // If we finished the last trajectory, we can just end it straight away.
             if(trajectoryDone && currentTrajectories_.size() == 1)
             {
-                currentTrajectories_.erase(currentTrajectories_.begin());
+                currentTrajectories_.pop_front();
                 motorSpeed_[0] = 0.0;
                 motorSpeed_[1] = 0.0;
                 curvilinearAbscissa_ = 0.;
@@ -378,8 +378,8 @@ void Robot::lowLevelLoop()
             encoderIncrement.left = temp;
         }
 
-        // Update motor position.
-        motorPosition_ = stepperMotors_.getPosition();
+        // New tick: trajectory evaluations of the previous tick are outdated.
+        trajectoryEvaluation_.clear();
 
         // Update the lidar
         if (!DISABLE_LIDAR)
@@ -406,13 +406,25 @@ void Robot::lowLevelLoop()
         {
             // Integrate encoder measurements.
             RobotPosition currentPosition = currentPosition_.get();
-            kinematics_.integratePosition(encoderIncrement, currentPosition);
+            kinematics_.integratePositionArc(encoderIncrement, currentPosition);
             currentPosition_.set(currentPosition);
 
             // Perform trajectory tracking.
             updateTrajectoryFollowingTarget(dt);
         }
 
+        // Communicate with the motors in a single transaction: read status and position, send new target.
+        // Before the match, motor speed is not sent, as it is handled by setupBeforeMatchStart.
+        if (hasMatchStarted_)
+        {
+            uint32_t motorErrors[2];
+            stepperMotors_.exchange(motorSpeed_.data(), motorPosition_.data(), motorErrors);
+        }
+        else
+        {
+            stepperMotors_.exchange(NULL, motorPosition_.data(), NULL);
+        }
+
         // Get current encoder speeds (in rad/s)
         WheelSpeed instantWheelSpeedEncoder;
         instantWheelSpeedEncoder.right = encoderIncrement.right / dt;
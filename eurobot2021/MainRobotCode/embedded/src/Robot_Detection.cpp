@@ -51,7 +51,7 @@ double Robot::avoidOtherRobots()
   bool forward = true;
   if (!currentTrajectories_.empty())
   {
-    miam::trajectory::TrajectoryPoint trajectoryPoint = currentTrajectories_.at(0)->getCurrentPoint(curvilinearAbscissa_);
+    miam::trajectory::TrajectoryPoint trajectoryPoint = trajectoryEvaluation_.getCurrentPoint(currentTrajectories_.front().get(), curvilinearAbscissa_);
     forward = (trajectoryPoint.linearVelocity >= 0);
   }
 
@@ -145,8 +145,9 @@ double Robot::avoidOtherRobots()
           // Replan and retry trajectory.
           if (!currentTrajectories_.empty())
           {
-              currentTrajectories_.at(0)->replanify(curvilinearAbscissa_);
+              currentTrajectories_.front().replanify(curvilinearAbscissa_);
               curvilinearAbscissa_ = 0;
+              trajectoryEvaluation_.clear();
           }
       }
       num_stop_iters = 0;
@@ -8,7 +8,7 @@
 bool Robot::followTrajectory(Trajectory *traj, double const& curvilinearAbscissa_, double const & dt)
 {
     // Get current trajectory state.
-    trajectoryPoint_ = traj->getCurrentPoint(curvilinearAbscissa_);
+    trajectoryPoint_ = trajectoryEvaluation_.getCurrentPoint(traj, curvilinearAbscissa_);
 
     // Update trajectory velocity based on lidar coeff.
     trajectoryPoint_.linearVelocity *= coeff_;
@@ -88,9 +88,10 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
     if(!newTrajectories_.empty())
     {
         // We have new trajectories, erase the current trajectories and follow the new one.
-        currentTrajectories_ = newTrajectories_;
+        currentTrajectories_.assign(newTrajectories_);
         curvilinearAbscissa_ = 0;
         newTrajectories_.clear();
+        trajectoryEvaluation_.clear();
         std::cout << "Received new trajectory" << std::endl;
     }
 
@@ -104,10 +105,10 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
     else
     {
         // Load first trajectory, look if we are done following it.
-        Trajectory *traj = currentTrajectories_.at(0).get();
+        Trajectory *traj = currentTrajectories_.front().get();
         // Look if first trajectory is done.
         // No avoidance if point turn.
-        if (traj->getCurrentPoint(curvilinearAbscissa_).linearVelocity == 0)
+        if (trajectoryEvaluation_.getCurrentPoint(traj, curvilinearAbscissa_).linearVelocity == 0)
             coeff_ = 1.0;
 
         curvilinearAbscissa_ += coeff_ * dt;
@@ -116,9 +117,8 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
             // If we still have a trajectory after that, immediately switch to the next trajectory.
             if(currentTrajectories_.size() > 1)
             {
-                // Not obtimal, could be improved.
-                currentTrajectories_.erase(currentTrajectories_.begin());
-                traj = currentTrajectories_.at(0).get();
+                currentTrajectories_.pop_front();
+                traj = currentTrajectories_.front().get();
                 trajectoryStartTime_ = currentTime_;
                 curvilinearAbscissa_ = 0.0;
                 std::cout << "Trajectory done, going to next one" << std::endl;
@@ -129,7 +129,7 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
         if(curvilinearAbscissa_ - 0.1 >  traj->getDuration())
         {
             std::cout << "Timeout on trajectory following" << std::endl;
-            currentTrajectories_.erase(currentTrajectories_.begin());
+            currentTrajectories_.pop_front();
             motorSpeed_[0] = 0.0;
             motorSpeed_[1] = 0.0;
             curvilinearAbscissa_ = 0.;
@@ -141,18 +141,13 @@ void Robot::updateTrajectoryFollowingTarget(double const& dt)
             // If we finished the last trajectory, we can just end it straight away.
             if(trajectoryDone && currentTrajectories_.size() == 1)
             {
-                currentTrajectories_.erase(currentTrajectories_.begin());
+                currentTrajectories_.pop_front();
                 motorSpeed_[0] = 0.0;
                 motorSpeed_[1] = 0.0;
                 curvilinearAbscissa_ = 0.;
             }
         }
     }
-
-    // Read and clear error
-    stepperMotors_.getError();
-    // Send target to motors.
-    stepperMotors_.setSpeed(motorSpeed_);
-    //~ stepperMotors_.highZ();
+    // Motor target is sent in lowLevelLoop, together with status and position read.
 }
 
@@ -8,6 +8,7 @@
     #include "miam_utils/trajectory/DrivetrainKinematics.h"
     #include "miam_utils/trajectory/RobotPosition.h"
     #include "miam_utils/trajectory/Trajectory.h"
+    #include "miam_utils/trajectory/TrajectoryQueue.h"
     #include "miam_utils/drivers/L6470Driver.h"
 
     #include <memory>
@@ -83,13 +84,14 @@
             miam::ProtectedPosition currentPosition_; ///< Current robot position, thread-safe.
             BaseSpeed currentBaseSpeed_; ///< Current robot base speed.
             miam::trajectory::TrajectoryPoint trajectoryPoint_; ///< Current trajectory point.
+            miam::trajectory::TrajectoryEvaluationContext trajectoryEvaluation_; ///< Trajectory evaluations of the current tick.
             double currentTime_; ///< Current robot time, counted by low-level thread.
             std::vector<double> motorSpeed_; ///< Current motor speed.
             std::vector<double> motorPosition_; ///< Current motor position.
 
             // Trajectory definition.
             std::vector<std::shared_ptr<miam::trajectory::Trajectory>> newTrajectories_; ///< Vector of new trajectories to follow.
-            std::vector<std::shared_ptr<miam::trajectory::Trajectory>> currentTrajectories_; ///< Current trajectories being followed.
+            miam::trajectory::TrajectoryQueue currentTrajectories_; ///< Current trajectories being followed, stored by value.
 
             // Trajectory following timing.
             double trajectoryStartTime_; ///< Time at which the last trajectory following started.
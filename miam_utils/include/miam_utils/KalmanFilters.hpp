@@ -0,0 +1,477 @@
+/// \file KalmanFilters.hpp
+/// \brief Generic, fixed-size Kalman filters: linear (KF), extended (EKF) and unscented (UKF).
+///
+/// \details The filters are templated on the state size, and measurement sizes are template parameters of the
+///          update functions: all matrices have a compile-time size, and live in the filter object or on the
+///          stack. No memory allocation is ever done, and the filters can be used in a real-time loop.
+///
+///          KalmanFilter covers both the linear and extended filters: prediction takes the transition Jacobian
+///          (and optionally the already propagated state), and measurements are processed one scalar at a time,
+///          which requires no matrix inversion. Measurement noise must thus be uncorrelated (diagonal R), which is the
+///          case of most sensors ; correlated measurements should be decorrelated beforehand. The covariance update
+///          uses the Joseph form, which keeps it symmetric positive definite despite rounding errors.
+///
+///          UnscentedKalmanFilter propagates sigma points through user-provided functions, and does not need any
+///          Jacobian. Its update solves the innovation covariance through a Cholesky decomposition.
+///
+///          Model functions are passed as functors (e.g. lambdas) taking input and output arrays:
+///          <tt>void process(double const (&state)[N], double (&newState)[N])</tt> and
+///          <tt>void measurement(double const (&state)[N], double (&measurement)[M])</tt>.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_KALMAN_FILTERS_HPP
+#define MIAM_KALMAN_FILTERS_HPP
+
+    #include <cmath>
+
+    namespace miam{
+
+        /// \brief Fixed-size matrix, stored row by row.
+        template<int Rows, int Cols>
+        struct FixedMatrix
+        {
+            double data[Rows][Cols]; ///< Matrix coefficients.
+
+            double & operator()(int const& i, int const& j) { return data[i][j]; }
+            double const& operator()(int const& i, int const& j) const { return data[i][j]; }
+
+            /// \brief Set all coefficients to zero.
+            void setZero()
+            {
+                for(int i = 0; i < Rows; i++)
+                    for(int j = 0; j < Cols; j++)
+                        data[i][j] = 0.0;
+            }
+
+            /// \brief Set to identity (zero outside the diagonal).
+            void setIdentity()
+            {
+                setZero();
+                for(int i = 0; i < Rows && i < Cols; i++)
+                    data[i][i] = 1.0;
+            }
+
+            /// \brief Get a zero matrix.
+            static FixedMatrix zero()
+            {
+                FixedMatrix m;
+                m.setZero();
+                return m;
+            }
+
+            /// \brief Get an identity matrix.
+            static FixedMatrix identity()
+            {
+                FixedMatrix m;
+                m.setIdentity();
+                return m;
+            }
+        };
+
+        /// \brief Cholesky decomposition of a symmetric positive definite matrix, in place.
+        /// \details On success, the lower triangle contains L such that A = L L^T ; the upper triangle is set to zero.
+        ///
+        /// \param[in, out] A Matrix to decompose.
+        /// \return False if the matrix is not positive definite.
+        template<int N>
+        bool choleskyDecomposition(double (&A)[N][N])
+        {
+            for(int j = 0; j < N; j++)
+            {
+                double diagonal = A[j][j];
+                for(int k = 0; k < j; k++)
+                    diagonal -= A[j][k] * A[j][k];
+                if(diagonal <= 0.0)
+                    return false;
+                diagonal = std::sqrt(diagonal);
+                A[j][j] = diagonal;
+                for(int i = j + 1; i < N; i++)
+                {
+                    double value = A[i][j];
+                    for(int k = 0; k < j; k++)
+                        value -= A[i][k] * A[j][k];
+                    A[i][j] = value / diagonal;
+                    A[j][i] = 0.0;
+                }
+            }
+            return true;
+        }
+
+        /// \brief Linear and extended Kalman filter.
+        /// \tparam N State size.
+        template<int N>
+        class KalmanFilter
+        {
+            public:
+                typedef FixedMatrix<N, N> Matrix; ///< State-sized square matrix.
+
+                /// \brief Constructor: zero state and identity covariance.
+                KalmanFilter()
+                {
+                    for(int i = 0; i < N; i++)
+                        x_[i] = 0.0;
+                    P_.setIdentity();
+                }
+
+                /// \brief Reset the filter.
+                ///
+                /// \param[in] state Initial state.
+                /// \param[in] covariance Initial covariance.
+                void reset(double const (&state)[N], Matrix const& covariance)
+                {
+                    for(int i = 0; i < N; i++)
+                        x_[i] = state[i];
+                    P_ = covariance;
+                }
+
+                /// \brief Linear prediction: x = F x, P = F P F^T + Q.
+                ///
+                /// \param[in] F State transition matrix.
+                /// \param[in] Q Process noise covariance.
+                void predict(Matrix const& F, Matrix const& Q)
+                {
+                    double newState[N];
+                    for(int i = 0; i < N; i++)
+                    {
+                        newState[i] = 0.0;
+                        for(int j = 0; j < N; j++)
+                            newState[i] += F.data[i][j] * x_[j];
+                    }
+                    predict(newState, F, Q);
+                }
+
+                /// \brief Extended prediction: the state is propagated by the user, the covariance with the Jacobian.
+                ///
+                /// \param[in] newState Propagated state, f(x).
+                /// \param[in] F Jacobian of the transition function, evaluated at the previous state.
+                /// \param[in] Q Process noise covariance.
+                void predict(double const (&newState)[N], Matrix const& F, Matrix const& Q)
+                {
+                    for(int i = 0; i < N; i++)
+                        x_[i] = newState[i];
+                    // P = F P F^T + Q, computed as F (F P)^T since P is symmetric.
+                    double FP[N][N];
+                    for(int i = 0; i < N; i++)
+                        for(int j = 0; j < N; j++)
+                        {
+                            FP[i][j] = 0.0;
+                            for(int k = 0; k < N; k++)
+                                FP[i][j] += F.data[i][k] * P_.data[k][j];
+                        }
+                    for(int i = 0; i < N; i++)
+                        for(int j = i; j < N; j++)
+                        {
+                            double value = Q.data[i][j];
+                            for(int k = 0; k < N; k++)
+                                value += FP[i][k] * F.data[j][k];
+                            P_.data[i][j] = value;
+                            P_.data[j][i] = value;
+                        }
+                }
+
+                /// \brief Scalar measurement update.
+                /// \details The measurement is z = h^T x + noise (linear case), or the innovation is computed by the
+                ///          user from a linearized model (extended case).
+                ///
+                /// \param[in] h Measurement row (Jacobian of the measurement function).
+                /// \param[in] innovation Measurement minus predicted measurement.
+                /// \param[in] variance Measurement noise variance.
+                /// \return Squared Mahalanobis distance of the innovation.
+                double updateScalar(double const (&h)[N], double const& innovation, double const& variance)
+                {
+                    // PH = P h, s = h^T P h + r, K = PH / s.
+                    double PH[N];
+                    double s = variance;
+                    for(int i = 0; i < N; i++)
+                    {
+                        PH[i] = 0.0;
+                        for(int j = 0; j < N; j++)
+                            PH[i] += P_.data[i][j] * h[j];
+                        s += h[i] * PH[i];
+                    }
+                    double K[N];
+                    for(int i = 0; i < N; i++)
+                    {
+                        K[i] = PH[i] / s;
+                        x_[i] += K[i] * innovation;
+                    }
+
+                    // Joseph form: P = (I - K h^T) P (I - K h^T)^T + r K K^T.
+                    // First A = (I - K h^T) P = P - K PH^T, then P = A - (A h) K^T + r K K^T.
+                    double A[N][N];
+                    for(int i = 0; i < N; i++)
+                        for(int j = 0; j < N; j++)
+                            A[i][j] = P_.data[i][j] - K[i] * PH[j];
+                    double Ah[N];
+                    for(int i = 0; i < N; i++)
+                    {
+                        Ah[i] = 0.0;
+                        for(int j = 0; j < N; j++)
+                            Ah[i] += A[i][j] * h[j];
+                    }
+                    for(int i = 0; i < N; i++)
+                        for(int j = i; j < N; j++)
+                        {
+                            // Symmetrize, to absorb rounding errors.
+                            double const value = 0.5 * (A[i][j] + A[j][i] - Ah[i] * K[j] - Ah[j] * K[i])
+                                                 + variance * K[i] * K[j];
+                            P_.data[i][j] = value;
+                            P_.data[j][i] = value;
+                        }
+                    return innovation * innovation / s;
+                }
+
+                /// \brief Linear measurement update: z = H x + noise, with uncorrelated noise.
+                /// \details The measurement components are processed sequentially.
+                ///
+                /// \tparam M Measurement size.
+                /// \param[in] H Measurement matrix.
+                /// \param[in] z Measurement.
+                /// \param[in] variances Noise variance of each measurement component (diagonal of R).
+                template<int M>
+                void update(FixedMatrix<M, N> const& H, double const (&z)[M], double const (&variances)[M])
+                {
+                    for(int m = 0; m < M; m++)
+                    {
+                        double innovation = z[m];
+                        for(int j = 0; j < N; j++)
+                            innovation -= H.data[m][j] * x_[j];
+                        updateScalar(H.data[m], innovation, variances[m]);
+                    }
+                }
+
+                /// \brief Extended measurement update: z = h(x) + noise, with uncorrelated noise.
+                /// \details The measurement components are processed sequentially, all around the same linearization
+                ///          point: the innovation of each component accounts for the state correction made by the
+                ///          previous ones.
+                ///
+                /// \tparam M Measurement size.
+                /// \param[in] H Jacobian of h, evaluated at the current state.
+                /// \param[in] predictedMeasurement h(x), evaluated at the current state.
+                /// \param[in] z Measurement.
+                /// \param[in] variances Noise variance of each measurement component (diagonal of R).
+                template<int M>
+                void update(FixedMatrix<M, N> const& H,
+                            double const (&predictedMeasurement)[M],
+                            double const (&z)[M],
+                            double const (&variances)[M])
+                {
+                    double linearizationState[N];
+                    for(int i = 0; i < N; i++)
+                        linearizationState[i] = x_[i];
+                    for(int m = 0; m < M; m++)
+                    {
+                        double innovation = z[m] - predictedMeasurement[m];
+                        for(int j = 0; j < N; j++)
+                            innovation -= H.data[m][j] * (x_[j] - linearizationState[j]);
+                        updateScalar(H.data[m], innovation, variances[m]);
+                    }
+                }
+
+                /// \brief Get the state.
+                double const (&getState() const)[N] { return x_; }
+
+                /// \brief Get the state covariance.
+                Matrix const& getCovariance() const { return P_; }
+
+            private:
+                double x_[N]; ///< State.
+                Matrix P_; ///< State covariance.
+        };
+
+        /// \brief Unscented Kalman filter, using scaled sigma points.
+        /// \tparam N State size.
+        template<int N>
+        class UnscentedKalmanFilter
+        {
+            public:
+                typedef FixedMatrix<N, N> Matrix; ///< State-sized square matrix.
+                static int const N_SIGMA = 2 * N + 1; ///< Number of sigma points.
+
+                /// \brief Constructor: zero state and identity covariance.
+                /// \details See Van der Merwe's scaled unscented transform for the meaning of the parameters.
+                ///
+                /// \param[in] alpha Spread of the sigma points around the mean.
+                /// \param[in] beta Prior knowledge of the distribution (2 is optimal for gaussians).
+                /// \param[in] kappa Secondary scaling parameter.
+                UnscentedKalmanFilter(double const& alpha = 1.0, double const& beta = 2.0, double const& kappa = 0.0)
+                {
+                    for(int i = 0; i < N; i++)
+                        x_[i] = 0.0;
+                    P_.setIdentity();
+                    double const lambda = alpha * alpha * (N + kappa) - N;
+                    scale_ = std::sqrt(N + lambda);
+                    meanWeights_[0] = lambda / (N + lambda);
+                    covarianceWeights_[0] = meanWeights_[0] + 1.0 - alpha * alpha + beta;
+                    for(int i = 1; i < N_SIGMA; i++)
+                    {
+                        meanWeights_[i] = 0.5 / (N + lambda);
+                        covarianceWeights_[i] = meanWeights_[i];
+                    }
+                }
+
+                /// \brief Reset the filter.
+                ///
+                /// \param[in] state Initial state.
+                /// \param[in] covariance Initial covariance.
+                void reset(double const (&state)[N], Matrix const& covariance)
+                {
+                    for(int i = 0; i < N; i++)
+                        x_[i] = state[i];
+                    P_ = covariance;
+                }
+
+                /// \brief Prediction step.
+                ///
+                /// \param[in] process Transition function, called once per sigma point.
+                /// \param[in] Q Process noise covariance.
+                /// \return False if the covariance is not positive definite: the filter is left unchanged.
+                template<typename Process>
+                bool predict(Process const& process, Matrix const& Q)
+                {
+                    if(!computeSigmaPoints())
+                        return false;
+                    double propagated[N_SIGMA][N];
+                    for(int s = 0; s < N_SIGMA; s++)
+                        process(sigmaPoints_[s], propagated[s]);
+                    computeMean<N>(propagated, x_);
+                    for(int i = 0; i < N; i++)
+                        for(int j = i; j < N; j++)
+                        {
+                            double value = Q.data[i][j];
+                            for(int s = 0; s < N_SIGMA; s++)
+                                value += covarianceWeights_[s] * (propagated[s][i] - x_[i]) * (propagated[s][j] - x_[j]);
+                            P_.data[i][j] = value;
+                            P_.data[j][i] = value;
+                        }
+                    return true;
+                }
+
+                /// \brief Measurement update, with uncorrelated noise.
+                ///
+                /// \tparam M Measurement size.
+                /// \param[in] measurement Measurement function, called once per sigma point.
+                /// \param[in] z Measurement.
+                /// \param[in] variances Noise variance of each measurement component (diagonal of R).
+                /// \return False if a covariance is not positive definite: the filter is left unchanged.
+                template<int M, typename Measurement>
+                bool update(Measurement const& measurement, double const (&z)[M], double const (&variances)[M])
+                {
+                    if(!computeSigmaPoints())
+                        return false;
+                    double predicted[N_SIGMA][M];
+                    for(int s = 0; s < N_SIGMA; s++)
+                        measurement(sigmaPoints_[s], predicted[s]);
+                    double meanMeasurement[M];
+                    computeMean<M>(predicted, meanMeasurement);
+
+                    // Innovation covariance S, and state-measurement cross covariance C.
+                    double S[M][M];
+                    double C[N][M];
+                    for(int i = 0; i < M; i++)
+                        for(int j = i; j < M; j++)
+                        {
+                            double value = (i == j ? variances[i] : 0.0);
+                            for(int s = 0; s < N_SIGMA; s++)
+                                value += covarianceWeights_[s] * (predicted[s][i] - meanMeasurement[i])
+                                                               * (predicted[s][j] - meanMeasurement[j]);
+                            S[i][j] = value;
+                            S[j][i] = value;
+                        }
+                    for(int i = 0; i < N; i++)
+                        for(int j = 0; j < M; j++)
+                        {
+                            C[i][j] = 0.0;
+                            for(int s = 0; s < N_SIGMA; s++)
+                                C[i][j] += covarianceWeights_[s] * (sigmaPoints_[s][i] - x_[i])
+                                                                 * (predicted[s][j] - meanMeasurement[j]);
+                        }
+
+                    // Gain K = C S^-1: with S = L L^T, solve L U^T = C^T, then K = U L^-1, i.e. K L^T = U.
+                    // The covariance update K S K^T is then simply U U^T.
+                    if(!choleskyDecomposition<M>(S))
+                        return false;
+                    double U[N][M];
+                    double K[N][M];
+                    for(int i = 0; i < N; i++)
+                    {
+                        for(int j = 0; j < M; j++)
+                        {
+                            double value = C[i][j];
+                            for(int k = 0; k < j; k++)
+                                value -= U[i][k] * S[j][k];
+                            U[i][j] = value / S[j][j];
+                        }
+                        for(int j = M - 1; j >= 0; j--)
+                        {
+                            double value = U[i][j];
+                            for(int k = j + 1; k < M; k++)
+                                value -= K[i][k] * S[k][j];
+                            K[i][j] = value / S[j][j];
+                        }
+                    }
+
+                    for(int i = 0; i < N; i++)
+                        for(int j = 0; j < M; j++)
+                            x_[i] += K[i][j] * (z[j] - meanMeasurement[j]);
+                    for(int i = 0; i < N; i++)
+                        for(int j = i; j < N; j++)
+                        {
+                            double value = P_.data[i][j];
+                            for(int k = 0; k < M; k++)
+                                value -= U[i][k] * U[j][k];
+                            P_.data[i][j] = value;
+                            P_.data[j][i] = value;
+                        }
+                    return true;
+                }
+
+                /// \brief Get the state.
+                double const (&getState() const)[N] { return x_; }
+
+                /// \brief Get the state covariance.
+                Matrix const& getCovariance() const { return P_; }
+
+            private:
+                /// \brief Compute the sigma points from the current state and covariance.
+                bool computeSigmaPoints()
+                {
+                    double L[N][N];
+                    for(int i = 0; i < N; i++)
+                        for(int j = 0; j < N; j++)
+                            L[i][j] = P_.data[i][j];
+                    if(!choleskyDecomposition<N>(L))
+                        return false;
+                    for(int i = 0; i < N; i++)
+                    {
+                        sigmaPoints_[0][i] = x_[i];
+                        for(int k = 0; k < N; k++)
+                        {
+                            sigmaPoints_[1 + k][i] = x_[i] + scale_ * L[i][k];
+                            sigmaPoints_[1 + N + k][i] = x_[i] - scale_ * L[i][k];
+                        }
+                    }
+                    return true;
+                }
+
+                /// \brief Weighted mean of transformed sigma points.
+                template<int M>
+                void computeMean(double const (&points)[N_SIGMA][M], double (&mean)[M]) const
+                {
+                    for(int i = 0; i < M; i++)
+                    {
+                        mean[i] = 0.0;
+                        for(int s = 0; s < N_SIGMA; s++)
+                            mean[i] += meanWeights_[s] * points[s][i];
+                    }
+                }
+
+                double x_[N]; ///< State.
+                Matrix P_; ///< State covariance.
+                double sigmaPoints_[N_SIGMA][N]; ///< Sigma points of the current step.
+                double meanWeights_[N_SIGMA]; ///< Weights for the mean.
+                double covarianceWeights_[N_SIGMA]; ///< Weights for the covariance.
+                double scale_; ///< Sigma point spread, sqrt(N + lambda).
+        };
+    }
+#endif
@@ -0,0 +1,222 @@
+/// \file LidarLocalization.h
+/// \brief Robot localization, by matching lidar scans against a map of the table.
+///
+/// \details The table borders and fixed elements are described as line segments. DistanceFieldMap precomputes, on a
+///          grid, the closest of these segments to any point of the table (i.e. a discretized distance field).
+///
+///          ScanMatcher then looks for the robot position that brings all scan points closest to the map elements,
+///          starting from the odometry position: this is a point-to-line ICP, where the correspondence search is
+///          replaced by a grid lookup per point. A robust (Huber) cost reduces the influence of points
+///          that do not belong to the map (other robots, game elements), and points far from any map element are
+///          ignored. The odometry position is used as a prior, to keep the problem well-posed when only a few
+///          elements are visible.
+///
+///          LidarLocalization runs the matching in its own thread, and publishes timestamped position corrections,
+///          meant to be fed to a filter (see PoseEKF::updatePosition).
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_LIDAR_LOCALIZATION
+#define MIAM_LIDAR_LOCALIZATION
+
+    #include <stdint.h>
+    #include <atomic>
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+
+    #include "miam_utils/trajectory/RobotPosition.h"
+
+    namespace miam{
+
+        /// \brief Map of the table, with the precomputed closest element to each point.
+        class DistanceFieldMap
+        {
+            public:
+                /// \brief Constructor.
+                /// \details The map covers [0, width] x [0, height], and is initially empty: add segments, then call
+                ///          build.
+                ///
+                /// \param[in] width Map width (x axis), in mm.
+                /// \param[in] height Map height (y axis), in mm.
+                /// \param[in] resolution Grid resolution, in mm.
+                /// \param[in] maxDistance Points further away from any map element have no closest element, in mm.
+                ///                        The grid also extends this far outside of the map.
+                DistanceFieldMap(double const& width,
+                                 double const& height,
+                                 double const& resolution = 10.0,
+                                 double const& maxDistance = 200.0);
+
+                /// \brief Add a segment to the map.
+                /// \param[in] start Segment start (angle is ignored).
+                /// \param[in] end Segment end (angle is ignored).
+                void addSegment(RobotPosition const& start, RobotPosition const& end);
+
+                /// \brief Add a rectangle, as its four sides.
+                /// \param[in] corner Lower corner of the rectangle.
+                /// \param[in] width Rectangle width (x axis), in mm.
+                /// \param[in] height Rectangle height (y axis), in mm.
+                void addRectangle(RobotPosition const& corner, double const& width, double const& height);
+
+                /// \brief Compute the distance grid.
+                void build();
+
+                /// \brief Get the line of the map element closest to a point.
+                /// \details The closest element is looked up in the grid: the line is that of the closest element to
+                ///          the center of the cell containing the point.
+                ///
+                /// \param[in] x Point x coordinate, in mm.
+                /// \param[in] y Point y coordinate, in mm.
+                /// \param[out] normalX Line normal, x coordinate.
+                /// \param[out] normalY Line normal, y coordinate.
+                /// \param[out] offset Line offset: the line is normalX * x + normalY * y = offset.
+                /// \return False if no map element is closer than the maximum distance.
+                bool getClosestLine(double const& x,
+                                    double const& y,
+                                    double & normalX,
+                                    double & normalY,
+                                    double & offset) const;
+
+                /// \brief Get the maximum distance stored in the map, in mm.
+                double getMaxDistance() const;
+
+            private:
+                /// \brief Line supporting a segment.
+                struct Line{
+                    double normalX; ///< Normal, x coordinate.
+                    double normalY; ///< Normal, y coordinate.
+                    double offset; ///< Offset along the normal.
+                };
+
+                double resolution_; ///< Grid resolution.
+                double maxDistance_; ///< Maximum distance of an element for a cell.
+                double margin_; ///< The grid extends this far outside the map, in mm.
+                int nColumns_; ///< Number of cells along x.
+                int nRows_; ///< Number of cells along y.
+                std::vector<RobotPosition> segments_; ///< Segments, as consecutive start and end points.
+                std::vector<Line> lines_; ///< Line of each segment.
+                std::vector<int16_t> grid_; ///< Index of the closest segment to each cell center, row by row ; -1 if none.
+        };
+
+        /// \brief Scan matching parameters.
+        struct ScanMatcherParameters{
+            ScanMatcherParameters():
+                maxIterations(15),
+                huberThreshold(20.0),
+                inlierDistance(40.0),
+                pointStd(15.0),
+                priorPositionStd(100.0),
+                priorAngleStd(0.1),
+                minInliers(40),
+                minInlierRatio(0.3)
+            {}
+
+            int maxIterations; ///< Maximum number of Gauss-Newton iterations.
+            double huberThreshold; ///< Distance above which a point weight decreases, in mm.
+            double inlierDistance; ///< Points further away from the map at the end of the matching are outliers, in mm.
+            double pointStd; ///< Standard deviation of a scan point distance to the map, in mm.
+            double priorPositionStd; ///< Standard deviation of the odometry position, in mm.
+            double priorAngleStd; ///< Standard deviation of the odometry angle, in rad.
+            int minInliers; ///< Minimum number of inliers for a valid match.
+            double minInlierRatio; ///< Minimum ratio of inliers, among the points close to the map, for a valid match.
+        };
+
+        /// \brief Result of a scan matching.
+        struct ScanMatch{
+            ScanMatch():
+                position(),
+                positionStd(0.0),
+                angleStd(0.0),
+                nInliers(0),
+                meanError(0.0),
+                isValid(false)
+            {}
+
+            RobotPosition position; ///< Matched robot position.
+            double positionStd; ///< Estimated standard deviation of the position, in mm.
+            double angleStd; ///< Estimated standard deviation of the angle, in rad.
+            int nInliers; ///< Number of points matching the map.
+            double meanError; ///< Mean distance of the inliers to the map, in mm.
+            bool isValid; ///< Whether the match can be trusted.
+        };
+
+        class ScanMatcher
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] parameters Matching parameters.
+                ScanMatcher(ScanMatcherParameters const& parameters = ScanMatcherParameters());
+
+                /// \brief Find the robot position best matching a scan.
+                ///
+                /// \param[in] map Distance field of the table.
+                /// \param[in] points Scan points, in the robot frame (angle is ignored), in mm.
+                /// \param[in] prior Robot position from odometry, used as starting point and prior.
+                /// \return Matching result.
+                ScanMatch match(DistanceFieldMap const& map,
+                                std::vector<RobotPosition> const& points,
+                                RobotPosition const& prior) const;
+
+            private:
+                ScanMatcherParameters parameters_; ///< Matching parameters.
+        };
+
+        /// \brief Position correction, computed from a lidar scan.
+        struct PoseCorrection{
+            double timestamp; ///< Time of the scan.
+            ScanMatch match; ///< Matching result.
+        };
+
+        /// \brief Scan matching, running in a background thread.
+        /// \details Scans are matched one at a time: if a new scan is submitted while the previous one is still being
+        ///          processed, only the most recent one is kept.
+        class LidarLocalization
+        {
+            public:
+                /// \brief Constructor: start the matching thread.
+                ///
+                /// \param[in] map Distance field of the table. It must be built, and outlive this object.
+                /// \param[in] parameters Matching parameters.
+                LidarLocalization(DistanceFieldMap const& map,
+                                  ScanMatcherParameters const& parameters = ScanMatcherParameters());
+
+                /// \brief Destructor: stop the matching thread.
+                ~LidarLocalization();
+
+                /// \brief Submit a scan for matching.
+                ///
+                /// \param[in] timestamp Time of the scan, in s.
+                /// \param[in] points Scan points, in the robot frame, in mm.
+                /// \param[in] odometryPosition Robot position at the time of the scan, from odometry.
+                void submitScan(double const& timestamp,
+                                std::vector<RobotPosition> const& points,
+                                RobotPosition const& odometryPosition);
+
+                /// \brief Get the last correction computed, if not already obtained.
+                ///
+                /// \param[out] correction Last correction.
+                /// \return True if a new correction was available.
+                bool getCorrection(PoseCorrection & correction);
+
+            private:
+                /// \brief Matching thread.
+                void matchingThread();
+
+                DistanceFieldMap const& map_; ///< Table map.
+                ScanMatcher matcher_; ///< Scan matcher.
+
+                std::vector<RobotPosition> pendingPoints_; ///< Scan waiting to be matched.
+                double pendingTimestamp_; ///< Time of the pending scan.
+                RobotPosition pendingPosition_; ///< Odometry position of the pending scan.
+                bool hasPendingScan_; ///< Whether a scan is waiting to be matched.
+
+                PoseCorrection correction_; ///< Last correction.
+                bool hasCorrection_; ///< Whether the last correction was not obtained yet.
+
+                std::atomic<bool> isRunning_; ///< False to stop the thread.
+                std::mutex mutex_; ///< Protects the pending scan and the correction.
+                std::condition_variable condition_; ///< Signals a new scan.
+                std::thread thread_; ///< Matching thread.
+        };
+    }
+#endif
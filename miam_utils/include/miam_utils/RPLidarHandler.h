@@ -17,6 +17,7 @@
     #include <iostream>
     #include <cmath>
     #include <deque>
+    #include <vector>
     #include "miam_utils/Metronome.h"
 
     // Constant parameters.
@@ -25,6 +26,7 @@
     const double LIDAR_RPM = 600.0;    ///< Lidar velocity, in rpm.
     const double MAX_DISTANCE = 1700.0; ///< Maximum distance for processing, in mm: points above that distance are discarded.
     const double MIN_DISTANCE = 50.0; ///< Minimum distance for processing, in mm: points below that distance are discarded.
+    const double MAX_SCAN_DISTANCE = 3600.0; ///< Maximum distance of the points kept in full scans (see getScan), in mm.
 
     const double BLOB_THICKNESS = 40.0;///< Distance between two adjacent points to consider that they belong to the same blob, in mm.
     const double BLOB_MIN_SIZE = 40.0; ///< Minimum size of the blob to consider it as a robot.
@@ -130,6 +132,15 @@
             /// \return Number of points recieved.
             int update();
 
+            /// \brief Get the last complete scan (i.e. lidar revolution).
+            /// \details Only points within [MIN_DISTANCE, MAX_SCAN_DISTANCE] are kept. The angle of the points is in the
+            ///          robot frame (mounting offset included).
+            ///
+            /// \param[out] scan Last complete scan.
+            /// \param[out] timestamp Time of the middle of the scan, in s, relative to the handler creation.
+            /// \return True if this scan was not already obtained.
+            bool getScan(std::vector<LidarPoint> & scan, double & timestamp);
+
             // For debugging - display of the last scan data.
             LidarPoint debuggingBuffer_[DEBUGGING_BUFFER_LENGTH];
             int debuggingBufferPosition_; ///< Position in the debugging buffer.
@@ -154,6 +165,12 @@
 
             double mountingOffset_; ///< Lidar mounting offset.
 
+            std::vector<LidarPoint> currentScan_; ///< Points of the scan being acquired.
+            double currentScanStartTime_; ///< Time at which the current scan started.
+            std::vector<LidarPoint> lastScan_; ///< Last complete scan.
+            double lastScanTimestamp_; ///< Time of the middle of the last complete scan.
+            bool hasNewScan_; ///< Whether the last complete scan was not obtained yet.
+
             Metronome timeHandler_; ///< Metronome - for getting relative time.
     };
 #endif
@@ -2,6 +2,10 @@
 /// \brief Functions concerning the Beaglebone GPIOs.
 ///
 /// \details This file allows configuration and interface to the Beaglebone GPIOs.
+///          Digital reads and writes access the AM335x GPIO registers directly, through /dev/mem (root access
+///          required). If this memory is not available, they fall back to the sysfs interface. In both cases, the
+///          direction of each pin is read once from sysfs then cached: it is updated by gpio_exportPin, but a change
+///          done outside of this file is not seen.
 ///    \note     All functions in this header should be prefixed with gpio_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
@@ -26,6 +30,12 @@
     /// \return 0 on success, -1 on file access error.
     int gpio_exportPin(int const& pin, std::string const& direction);
 
+    /// \brief Map the GPIO registers in memory.
+    /// \details This function is called automatically on the first digital read or write.
+    ///
+    /// \return true if registers are accessible, false if the slower sysfs interface is used instead.
+    bool gpio_enableMemoryAccess();
+
     /// \brief Read a digital input.
     /// \details The pin must be configured as an input for the return value to make sense.
     ///
@@ -46,6 +56,19 @@
     ///            Negative value on failure: -1: reading error (probably pin not enabled). -2: pin enabled but not an output.
     int gpio_digitalWrite(int const& pin, int const& value);
 
+    /// \brief Write to several digital outputs of the same bank at once.
+    /// \details Pin number i of the mask corresponds to pin 32 * bank + i in kernel representation. With register
+    ///          access, all pins are changed in a single write (two if both masks are non-zero).
+    ///
+    /// \param[in] bank GPIO bank, from 0 to 3.
+    /// \param[in] setMask Pins to set high.
+    /// \param[in] clearMask Pins to set low. A pin present in both masks is set high.
+    ///
+    /// \return 0 on success
+    ///            Negative value on failure: -1: reading error (probably pin not enabled). -2: a pin is not an output.
+    ///            If a pin is not an output, no pin is changed.
+    int gpio_digitalWriteMultiple(int const& bank, uint32_t const& setMask, uint32_t const& clearMask);
+
     /// \brief Init reader for analog port.
     ///
     /// \details To speed up reading, in_voltage files remain open: this function opens them. It should be called
@@ -11,17 +11,45 @@
 
     #include <stdint.h>
     #include <string>
+    #include <memory>
+
+    #include "miam_utils/drivers/SPITransport.h"
 
 
     /// L6470 structure.
     typedef struct
     {
         std::string portName;    ///< String representing the name (in the file system) of the SPI port. This must be set by hand before using the structure.
-        int port;            ///< File descriptor of the SPI port.
+        int port;            ///< File descriptor of the SPI port. Unused: the port is handled by the transport.
         int frequency;        ///< SPI clock frequency, in Hz. This is set by default to 800kHz (100000byte/s), but can be changed if needed.
         double resolution;    ///< Sensor resolution, in mm/counts.
+        std::shared_ptr<miam::SPITransport> transport;    ///< SPI transport used to talk to the sensor (e.g. a client of an SPIBusManager).
     }ADNS9800;
 
+    /// Number of bytes of a motion burst.
+    #define ADNS9800_MOTION_BURST_LENGTH 14
+    /// Motion register: motion occurred since the last report.
+    #define ADNS9800_MOTION_MOT 0x80
+    /// Motion register: laser power settings are valid.
+    #define ADNS9800_MOTION_LP_VALID 0x20
+    /// Motion register: laser fault detected.
+    #define ADNS9800_MOTION_FAULT 0x10
+
+    /// Content of a motion burst, i.e. a full motion report.
+    typedef struct
+    {
+        uint8_t motion;        ///< Motion register, see ADNS9800_MOTION_* flags.
+        uint8_t observation;    ///< Observation register.
+        int deltaX;            ///< Position increment on X axis since last report, in mouse counts.
+        int deltaY;            ///< Position increment on Y axis since last report, in mouse counts.
+        uint8_t squal;        ///< Surface quality: number of valid features is 4 * squal.
+        uint8_t pixelSum;    ///< Average pixel value, divided by 512.
+        uint8_t maxPixel;    ///< Maximum pixel value.
+        uint8_t minPixel;    ///< Minimum pixel value.
+        uint16_t shutter;    ///< Shutter time, in clock cycles: this increases as the surface gets darker or further away.
+        uint16_t framePeriod;    ///< Frame period, in clock cycles.
+    }ADNS9800MotionBurst;
+
     /// \brief Initialize the ANDS9800.
     /// \details This function checks that the sensor is present, configure its registers, and write the firmware.
     ///
@@ -30,6 +58,28 @@
     /// \return true on success, false on failure.
     bool ANDS9800_init(ADNS9800 *a, std::string const& portName);
 
+    /// \brief Initialize the ANDS9800, using a given SPI transport.
+    /// \details Use this function to share the SPI bus with other drivers, through an SPIBusManager.
+    ///
+    /// \param[inout] a An ANDS9800 structure to use to talk to the sensor.
+    /// \param[in] transport SPI transport to use.
+    /// \return true on success, false on failure.
+    bool ANDS9800_init(ADNS9800 *a, std::shared_ptr<miam::SPITransport> transport);
+
+    /// \brief Read a full motion report: motion, delta x/y, surface quality, shutter...
+    /// \details All registers are read in a single SPI transaction, using the sensor motion burst mode: this is the
+    ///          cheapest way to poll the sensor at a high rate.
+    ///
+    /// \param[in] a An ANDS9800 structure to use to talk to the sensor.
+    /// \param[out] burst Motion report. Delta x/y are set to 0 if no motion occured.
+    /// \return false on SPI failure.
+    bool ADNS9800_readMotionBurst(ADNS9800 a, ADNS9800MotionBurst *burst);
+
+    /// \brief Decode the raw bytes of a motion burst.
+    /// \param[in] data ADNS9800_MOTION_BURST_LENGTH bytes, as read from the sensor.
+    /// \param[out] burst Decoded motion report.
+    void ADNS9800_decodeMotionBurst(unsigned char const *data, ADNS9800MotionBurst *burst);
+
     /// \brief Get the motion of the mouse since the last call, in mouse counts.
     /// \param[in] a An ANDS9800 structure to use to talk to the sensor.
     /// \param[out] deltaX Position increment on X axis since last call, in mouse counts.
@@ -3,6 +3,11 @@
 ///
 /// \details This file implements helper functions to make I2C communication both easier and thread safe.
 ///             All these functions will write debug messages on the terminal on transfert failure.
+///
+///             When the adapter supports it, register access uses the I2C_RDWR ioctl: a register read (address
+///             write followed by data read, with a repeated start) is then a single bus transaction and a single
+///             system call. Otherwise, the slave address is set with I2C_SLAVE, and cached to avoid an ioctl when
+///             talking to the same device as the previous call.
 ///    \warning As several threads may require bus access at the same time, it is important that all I2C access
 ///             are done with these functions only.
 ///    \note     All functions in this header should be prefixed with i2c_.
@@ -17,8 +22,19 @@
     typedef struct{
         int file;    ///< The file descriptor of the port number to use.
         std::mutex portMutex; ///< A mutex used internally to guarantee a thread-safe implementation.
+        int currentSlave; ///< Address of the slave currently selected with I2C_SLAVE, -1 if unknown. Set by i2c_open.
+        bool isRdwrSupported; ///< Whether the adapter supports combined I2C_RDWR transactions. Set by i2c_open.
     }I2CAdapter;
 
+    ///< Request for a register read, for i2c_readRegistersBatch.
+    typedef struct{
+        unsigned char address; ///< Address of the device to talk to.
+        unsigned char registerAddress; ///< Address of the first register to read.
+        int length; ///< Number of registers to read.
+        unsigned char *output; ///< Char array of all the register read. Memory must have already been alocated.
+        bool success; ///< Output: whether the read succeeded.
+    }I2CReadRequest;
+
     /// \brief Open an I2C port.
     ///
     /// \param[in] adapter An I2CAdapter structure to fill.
@@ -67,6 +83,19 @@
     /// \param[out] output Char array of all the register read. Memory must have already been alocated.
     bool i2c_readRegisters(I2CAdapter *adapter, unsigned char const& address, unsigned char const& registerAddress, int const& length, unsigned char *output);
 
+    /// \brief Read registers from several devices (or several register blocks) at once.
+    /// \details When I2C_RDWR is supported, all the reads are performed in a single ioctl (or in as few ioctl as
+    ///          possible given the kernel limit on the number of messages per call), and the bus is locked only once.
+    ///          If the combined transaction fails (e.g. one device not acknowledging), each read is retried
+    ///          individually, so that the success flag of each request is meaningful.
+    /// \note This function performs no memory allocation.
+    ///
+    /// \param[in] adapter The I2CAdapter structure to use: this structure defines the port being used.
+    /// \param[in, out] requests Read requests. The success flag of each request is set.
+    /// \param[in] nRequests Number of requests.
+    /// \returns true if all reads succeeded, false otherwise.
+    bool i2c_readRegistersBatch(I2CAdapter *adapter, I2CReadRequest *requests, int const& nRequests);
+
     /// \brief Close an I2C port.
     ///
     /// \param[in] port File descriptor of the I2C port.
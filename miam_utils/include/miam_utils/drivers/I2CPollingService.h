@@ -0,0 +1,207 @@
+/// \file drivers/I2CPollingService.h
+/// \brief Asynchronous polling of I2C sensors, publishing the latest value of each sensor.
+///
+/// \details An I2CPollingService runs a single thread for an I2C adapter. This thread calls the read function of
+///          each registered sensor at its configured rate, and publishes the result, with its timestamp, in a
+///          SensorSlot. Consumers (e.g. the control loop) read the latest sample from the slot, without locking
+///          and without ever touching the bus: a slow or NACKing device thus no longer stalls them.
+///
+///          Health counters are kept for each sensor. A sensor failing repeatedly is polled at a lower rate, so
+///          that it does not eat the bus time of the other sensors, until it answers again.
+///
+///          Example, for an IMU:
+///          \code
+///          I2CPollingService service(&adapter);
+///          std::shared_ptr<SensorSlot<IMUData>> imuSlot = service.addSensor<IMUData>("imu", 0.005,
+///              [&imu](IMUData & data){ imu.getData(data.gyro, data.accel); return true; });
+///          service.start();
+///          ...
+///          SensorSample<IMUData> sample;
+///          if(imuSlot->read(sample)) ...
+///          \endcode
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_I2C_POLLING_SERVICE
+#define MIAM_I2C_POLLING_SERVICE
+
+    #include <stdint.h>
+    #include <atomic>
+    #include <condition_variable>
+    #include <functional>
+    #include <memory>
+    #include <mutex>
+    #include <string>
+    #include <thread>
+    #include <type_traits>
+    #include <vector>
+
+    #include "miam_utils/drivers/I2C-Wrapper.h"
+
+    namespace miam{
+
+        /// \brief A sample published by the polling service.
+        template<typename T>
+        struct SensorSample{
+            T value; ///< Sensor value.
+            double timestamp; ///< Time at which the value was read, in s, see I2CPollingService::getCurrentTime.
+            uint64_t sampleNumber; ///< Number of the sample, starting at 1: a consumer can detect new samples.
+        };
+
+        /// \brief Latest value of a sensor, written by a single thread and read by any number of threads.
+        /// \details This is a sequence lock: the writer increments a counter before and after writing, the reader
+        ///          retries if the counter changed (or was odd) during its copy. Neither side ever blocks, and
+        ///          a read costs a copy of the sample. T must be trivially copyable.
+        template<typename T>
+        class SensorSlot
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "SensorSlot value must be trivially copyable.");
+
+            public:
+                SensorSlot():
+                    sequence_(0),
+                    nSamples_(0)
+                {}
+
+                /// \brief Publish a new value.
+                /// \details Must only be called by a single thread.
+                /// \param[in] value Value.
+                /// \param[in] timestamp Time of the measurement.
+                void publish(T const& value, double const& timestamp)
+                {
+                    uint32_t const sequence = sequence_.load(std::memory_order_relaxed);
+                    sequence_.store(sequence + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    sample_.value = value;
+                    sample_.timestamp = timestamp;
+                    sample_.sampleNumber = ++nSamples_;
+                    sequence_.store(sequence + 2, std::memory_order_release);
+                }
+
+                /// \brief Read the latest value.
+                /// \param[out] sample Latest sample.
+                /// \return false if no sample was published yet.
+                bool read(SensorSample<T> & sample) const
+                {
+                    uint32_t before, after;
+                    do
+                    {
+                        before = sequence_.load(std::memory_order_acquire);
+                        sample = sample_;
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        after = sequence_.load(std::memory_order_relaxed);
+                    } while((before & 1) || before != after);
+                    return before > 0;
+                }
+
+            private:
+                std::atomic<uint32_t> sequence_; ///< Sequence counter: odd during a write.
+                SensorSample<T> sample_; ///< Latest sample.
+                uint64_t nSamples_; ///< Number of samples published, only accessed by the writer.
+        };
+
+        /// \brief Health of a polled sensor.
+        struct I2CSensorHealth{
+            std::string name; ///< Sensor name.
+            uint64_t nReads; ///< Number of read attempts.
+            uint64_t nErrors; ///< Number of failed reads.
+            int nConsecutiveErrors; ///< Number of failed reads since the last successful one.
+            double lastSuccessTime; ///< Time of the last successful read, in s ; -1 if none.
+            double lastReadDuration; ///< Duration of the last read, in s.
+            double maxReadDuration; ///< Maximum duration of a read, in s.
+            bool isHealthy; ///< false if the sensor is failing, and thus polled at a lower rate.
+
+            I2CSensorHealth():
+                name(""),
+                nReads(0),
+                nErrors(0),
+                nConsecutiveErrors(0),
+                lastSuccessTime(-1.0),
+                lastReadDuration(0.0),
+                maxReadDuration(0.0),
+                isHealthy(true)
+            {}
+        };
+
+        class I2CPollingService
+        {
+            public:
+                /// \brief Constructor.
+                /// \details The adapter is only used to identify the bus: all access is done by the read functions.
+                /// \param[in] adapter I2C adapter polled by this service. Must have been opened beforehand.
+                /// \param[in] maxConsecutiveErrors Number of consecutive errors after which a sensor is considered
+                ///                                 unhealthy.
+                /// \param[in] unhealthyPeriodFactor Period multiplier applied to unhealthy sensors.
+                I2CPollingService(I2CAdapter *adapter, int const& maxConsecutiveErrors = 5,
+                                  double const& unhealthyPeriodFactor = 10.0);
+
+                /// \brief Destructor: stop the polling thread.
+                ~I2CPollingService();
+
+                /// \brief Register a sensor.
+                /// \details Sensors can only be added while the service is stopped.
+                ///
+                /// \param[in] name Sensor name, for health report.
+                /// \param[in] period Polling period, in s.
+                /// \param[in] readFunction Function reading the sensor, returning false on failure.
+                /// \return Slot containing the latest value, or nullptr if the service is running.
+                template<typename T>
+                std::shared_ptr<SensorSlot<T>> addSensor(std::string const& name, double const& period,
+                                                         std::function<bool(T&)> const& readFunction)
+                {
+                    std::shared_ptr<SensorSlot<T>> slot = std::make_shared<SensorSlot<T>>();
+                    std::function<bool(double const&)> poll = [slot, readFunction](double const& timestamp)
+                        {
+                            T value;
+                            if(!readFunction(value))
+                                return false;
+                            slot->publish(value, timestamp);
+                            return true;
+                        };
+                    if(!addPollFunction(name, period, poll))
+                        return nullptr;
+                    return slot;
+                }
+
+                /// \brief Start the polling thread.
+                void start();
+
+                /// \brief Stop the polling thread, waiting for the current read to complete.
+                void stop();
+
+                /// \brief Get the health of all sensors, in registration order.
+                std::vector<I2CSensorHealth> getHealth();
+
+                /// \brief Get the adapter polled by this service.
+                I2CAdapter *getAdapter() const;
+
+                /// \brief Get current time, in the time base of the sample timestamps.
+                /// \return Time, in s (CLOCK_MONOTONIC).
+                static double getCurrentTime();
+
+            private:
+                /// \brief A registered sensor.
+                struct PolledSensor{
+                    std::function<bool(double const&)> poll; ///< Read and publish function.
+                    double period; ///< Nominal polling period, in s.
+                    double nextPollTime; ///< Time of the next poll, in s.
+                    I2CSensorHealth health; ///< Sensor health.
+                };
+
+                /// \brief Type-erased sensor registration.
+                bool addPollFunction(std::string const& name, double const& period,
+                                     std::function<bool(double const&)> const& poll);
+
+                /// \brief Polling thread.
+                void pollingLoop();
+
+                I2CAdapter *adapter_; ///< I2C adapter.
+                int maxConsecutiveErrors_; ///< Number of consecutive errors for a sensor to be considered unhealthy.
+                double unhealthyPeriodFactor_; ///< Period multiplier for unhealthy sensors.
+                std::vector<PolledSensor> sensors_; ///< Registered sensors.
+                std::thread thread_; ///< Polling thread.
+                bool isRunning_; ///< Whether the polling thread should run.
+                std::mutex mutex_; ///< Mutex protecting sensor health and running state.
+                std::condition_variable condition_; ///< Used to wake the polling thread when stopping.
+        };
+    }
+#endif
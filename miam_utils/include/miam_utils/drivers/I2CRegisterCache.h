@@ -0,0 +1,145 @@
+/// \file drivers/I2CRegisterCache.h
+/// \brief Shadow copy of the registers of an I2C device, to avoid redundant bus transactions.
+///
+/// \details Many I2C chips (IO expanders, PWM drivers...) are driven by writing configuration and output registers,
+///          whose content only changes when written by this program. Instead of reading them back before each
+///          modification, or rewriting them one at a time, I2CRegisterCache keeps a copy of their value:
+///           - modifying some bits of a register is done on the copy, without a bus read.
+///           - writing a register with its current value does nothing.
+///           - modified registers are staged, then written by flush: contiguous registers are written in a single
+///             transaction, using the chip register auto-increment.
+///
+///          Input and status registers must not go through the cache: use read, which always accesses the device.
+///
+///          The device itself is accessed through I2CRegisterDevice: I2CAdapterDevice talks to a real chip through
+///          the I2C wrapper, while other implementations can emulate a chip for testing.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_I2C_REGISTER_CACHE
+#define MIAM_I2C_REGISTER_CACHE
+
+    #include <stdint.h>
+    #include <memory>
+    #include <mutex>
+
+    #include "miam_utils/drivers/I2C-Wrapper.h"
+
+    namespace miam{
+
+        /// \brief Register-level access to an I2C device.
+        class I2CRegisterDevice
+        {
+            public:
+                virtual ~I2CRegisterDevice(){}
+
+                /// \brief Write consecutive registers, in a single transaction.
+                ///
+                /// \param[in] registerAddress Address of the first register to write.
+                /// \param[in] length Number of registers to write.
+                /// \param[in] values Values to write.
+                /// \return false on failure.
+                virtual bool writeRegisters(uint8_t const& registerAddress, int const& length, uint8_t const *values) = 0;
+
+                /// \brief Read consecutive registers, in a single transaction.
+                ///
+                /// \param[in] registerAddress Address of the first register to read.
+                /// \param[in] length Number of registers to read.
+                /// \param[out] values Values read.
+                /// \return false on failure.
+                virtual bool readRegisters(uint8_t const& registerAddress, int const& length, uint8_t *values) = 0;
+        };
+
+        /// \brief Device on an I2C adapter, accessed through the I2C wrapper.
+        class I2CAdapterDevice: public I2CRegisterDevice
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] adapter I2C adapter, as opened by i2c_open.
+                /// \param[in] address I2C slave address.
+                I2CAdapterDevice(I2CAdapter *adapter, uint8_t const& address);
+
+                bool writeRegisters(uint8_t const& registerAddress, int const& length, uint8_t const *values) override;
+                bool readRegisters(uint8_t const& registerAddress, int const& length, uint8_t *values) override;
+
+            private:
+                I2CAdapter *adapter_; ///< I2C adapter.
+                uint8_t address_; ///< Slave address.
+        };
+
+        class I2CRegisterCache
+        {
+            public:
+                /// \brief Constructor.
+                /// \details All registers are initially unknown.
+                ///
+                /// \param[in] device Device to access.
+                /// \param[in] autoIncrementFlag Flag added to the register address to enable auto-increment on a
+                ///                              multi-register access (e.g. 0x80 for the PCA9635), 0 if not needed.
+                /// \param[in] maximumGap Maximum number of unmodified registers between two modified ones for both to
+                ///                       be written in the same transaction (the unmodified registers are then
+                ///                       rewritten with their current value).
+                I2CRegisterCache(std::shared_ptr<I2CRegisterDevice> device,
+                                 uint8_t const& autoIncrementFlag = 0,
+                                 int const& maximumGap = 2);
+
+                /// \brief Stage a register value, to be written at the next flush.
+                /// \details Nothing is staged if the register is known to already hold this value.
+                void set(uint8_t const& registerAddress, uint8_t const& value);
+
+                /// \brief Stage a modification of some bits of a register.
+                /// \details The register is read from the device if its value is unknown.
+                ///
+                /// \param[in] registerAddress Register address.
+                /// \param[in] mask Bits to modify.
+                /// \param[in] value New value of these bits (other bits are ignored).
+                /// \return false if the register value is unknown and could not be read.
+                bool setBits(uint8_t const& registerAddress, uint8_t const& mask, uint8_t const& value);
+
+                /// \brief Write all staged registers.
+                /// \details Registers that fail to be written become unknown.
+                /// \return false if a transaction failed.
+                bool flush();
+
+                /// \brief Stage a single register, and flush.
+                bool write(uint8_t const& registerAddress, uint8_t const& value);
+
+                /// \brief Stage consecutive registers, and flush.
+                bool write(uint8_t const& registerAddress, int const& length, uint8_t const *values);
+
+                /// \brief Get the value of a register.
+                /// \details The register is read from the device only if its value is unknown.
+                /// \return false if the register value is unknown and could not be read.
+                bool get(uint8_t const& registerAddress, uint8_t & value);
+
+                /// \brief Read registers from the device, bypassing the cache.
+                /// \details Use this for input or status registers, whose value may change by itself.
+                bool read(uint8_t const& registerAddress, int const& length, uint8_t *values);
+
+                /// \brief Write registers to the device, bypassing the cache.
+                /// \details The cache content of these registers is unchanged: use assume to update it.
+                bool writeDirect(uint8_t const& registerAddress, int const& length, uint8_t const *values);
+
+                /// \brief Record that a register holds a given value, without writing it.
+                void assume(uint8_t const& registerAddress, uint8_t const& value);
+
+                /// \brief Mark all registers as unknown, e.g. after a device reset.
+                void invalidate();
+
+            private:
+                /// \brief Get a register value, reading it if needed. Lock must be held.
+                bool getLocked(uint8_t const& registerAddress, uint8_t & value);
+
+                /// \brief Write all staged registers. Lock must be held.
+                bool flushLocked();
+
+                std::shared_ptr<I2CRegisterDevice> device_; ///< Device.
+                uint8_t autoIncrementFlag_; ///< Auto-increment flag of the register address.
+                int maximumGap_; ///< Maximum number of unmodified registers in a transaction.
+                uint8_t values_[256]; ///< Register values.
+                bool isKnown_[256]; ///< Whether the register value is known.
+                bool isStaged_[256]; ///< Whether the register must be written at the next flush.
+                bool hasStaged_; ///< Whether any register is staged.
+                std::mutex mutex_; ///< Protects the cache.
+        };
+    }
+#endif
@@ -0,0 +1,236 @@
+/// \file drivers/IMUFifo.h
+/// \brief High-rate IMU sampling through the sensor FIFO.
+///
+/// \details Instead of reading one sample each time the control loop runs (the loop rate then becoming the sampling
+///          rate, with its jitter), the IMU is configured to store its samples in its on-chip FIFO, at a fixed
+///          output data rate. The FIFO is then drained in bulk, once per control tick.
+///
+///          IMUFifoSource is the raw FIFO access: it is implemented by the IMUV5 driver (LSM6DS33), by
+///          IMUFifoReplay, which replays recorded FIFO content for testing, and by IMUFifoRecorder, which records
+///          the content read from another source.
+///
+///          IMUFifoSampler drains a source: it aligns and decodes the FIFO words into samples, timestamps them
+///          evenly from the output data rate, integrates the gyroscope heading between two calls, and provides
+///          gyroscope bias estimation.
+///
+///          FIFO content is expected to be a repetition of a 6-word pattern: gyroscope x, y, z, then accelerometer
+///          x, y, z (LSM6DS33 pattern when both sensors run at the FIFO rate).
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_IMU_FIFO_H
+#define MIAM_IMU_FIFO_H
+
+    #include <stdint.h>
+    #include <fstream>
+    #include <memory>
+    #include <string>
+    #include <vector>
+
+    #ifndef IMUVECTOR
+        #define IMUVECTOR
+        ///< Basic structure holding a vector in R3.
+        struct vector3D{
+            vector3D():
+                x(0.0),
+                y(0.0),
+                z(0.0)
+            {}
+
+            double x;
+            double y;
+            double z;
+        };
+    #endif
+
+    namespace miam{
+
+        /// Number of FIFO words per sample: gyroscope x, y, z, accelerometer x, y, z.
+        int const IMU_FIFO_PATTERN_LENGTH = 6;
+
+        /// \brief Raw access to an IMU FIFO.
+        class IMUFifoSource
+        {
+            public:
+                virtual ~IMUFifoSource(){}
+
+                /// \brief Read FIFO status.
+                /// \param[out] nUnreadWords Number of 16-bit words in the FIFO.
+                /// \param[out] pattern Position, in the pattern, of the next word to be read.
+                /// \param[out] isOverrun Whether the FIFO overflowed (i.e. samples were lost).
+                /// \return false on communication failure.
+                virtual bool readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun) = 0;
+
+                /// \brief Read words from the FIFO.
+                /// \param[out] words Words read.
+                /// \param[in] nWords Number of words to read: must not exceed the number of unread words.
+                /// \return false on communication failure.
+                virtual bool readFifoWords(int16_t *words, int const& nWords) = 0;
+
+                /// \brief Get the FIFO output data rate, i.e. the sample rate, in Hz.
+                virtual double getOutputDataRate() const = 0;
+
+                /// \brief Get gyroscope scaling, from counts to rad/s.
+                virtual double getGyroScaling() const = 0;
+
+                /// \brief Get accelerometer scaling, from counts to m/s2.
+                virtual double getAccelScaling() const = 0;
+        };
+
+        /// \brief Replay of a recorded FIFO content, for hardware-free testing.
+        /// \details Words become available at the output data rate, as time is advanced by advance().
+        class IMUFifoReplay: public IMUFifoSource
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] words Recorded FIFO words. The first word is the first word of a pattern.
+                /// \param[in] outputDataRate Sample rate, in Hz.
+                /// \param[in] gyroScaling Gyroscope scaling, from counts to rad/s.
+                /// \param[in] accelScaling Accelerometer scaling, from counts to m/s2.
+                /// \param[in] fifoCapacity FIFO capacity, in words: older words are lost (overrun) beyond it.
+                IMUFifoReplay(std::vector<int16_t> const& words,
+                              double const& outputDataRate,
+                              double const& gyroScaling,
+                              double const& accelScaling,
+                              int const& fifoCapacity = 4096);
+
+                /// \brief Load a recording written by IMUFifoRecorder.
+                /// \param[in] filename Recording file name.
+                /// \param[out] words Recorded words.
+                /// \param[out] outputDataRate Sample rate, in Hz.
+                /// \param[out] gyroScaling Gyroscope scaling, from counts to rad/s.
+                /// \param[out] accelScaling Accelerometer scaling, from counts to m/s2.
+                /// \return false if the file could not be read.
+                static bool loadRecording(std::string const& filename,
+                                          std::vector<int16_t> & words,
+                                          double & outputDataRate,
+                                          double & gyroScaling,
+                                          double & accelScaling);
+
+                /// \brief Advance replay time: the samples acquired during this time are pushed in the FIFO.
+                /// \param[in] dt Time step, in s.
+                void advance(double const& dt);
+
+                /// \brief Return true when all recorded words have been pushed in the FIFO.
+                bool isFinished() const;
+
+                bool readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun) override;
+                bool readFifoWords(int16_t *words, int const& nWords) override;
+                double getOutputDataRate() const override;
+                double getGyroScaling() const override;
+                double getAccelScaling() const override;
+
+            private:
+                std::vector<int16_t> words_; ///< Recorded words.
+                double outputDataRate_; ///< Sample rate.
+                double gyroScaling_; ///< Gyroscope scaling.
+                double accelScaling_; ///< Accelerometer scaling.
+                int fifoCapacity_; ///< FIFO capacity, in words.
+                double time_; ///< Replay time.
+                int readIndex_; ///< Index of the next word to read.
+                int writeIndex_; ///< Index of the next word to push in the FIFO.
+                bool isOverrun_; ///< Whether an overrun occured since the last status read.
+        };
+
+        /// \brief Recording of the content read from a FIFO source, for later replay.
+        /// \details The file contains a header (output data rate and scalings), followed by the raw FIFO words
+        ///          read, starting at the first word of a pattern.
+        class IMUFifoRecorder: public IMUFifoSource
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] source Source to record.
+                /// \param[in] filename Name of the recording file.
+                IMUFifoRecorder(std::shared_ptr<IMUFifoSource> source, std::string const& filename);
+
+                bool readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun) override;
+                bool readFifoWords(int16_t *words, int const& nWords) override;
+                double getOutputDataRate() const override;
+                double getGyroScaling() const override;
+                double getAccelScaling() const override;
+
+            private:
+                std::shared_ptr<IMUFifoSource> source_; ///< Recorded source.
+                std::ofstream file_; ///< Recording file.
+                int pattern_; ///< Position, in the pattern, of the next word read.
+                bool isAligned_; ///< Whether recording has started, i.e. a pattern start was read.
+        };
+
+        /// \brief An IMU sample.
+        struct IMUSample{
+            double timestamp; ///< Sample time, in s.
+            vector3D gyro; ///< Gyroscope readings, in rad/s, bias not removed.
+            vector3D accel; ///< Accelerometer readings, in m/s2.
+        };
+
+        /// \brief Drains an IMU FIFO into evenly timestamped samples, and integrates the heading.
+        class IMUFifoSampler
+        {
+            public:
+                /// \brief Constructor.
+                /// \details All memory is allocated here: update() performs no allocation.
+                /// \param[in] source FIFO source.
+                /// \param[in] maxBurstSamples Maximum number of samples read in a single bus transaction.
+                /// \param[in] maxSamplesPerUpdate Maximum number of samples read in a single call to update.
+                IMUFifoSampler(std::shared_ptr<IMUFifoSource> source,
+                               int const& maxBurstSamples = 32,
+                               int const& maxSamplesPerUpdate = 682);
+
+                /// \brief Drain the FIFO.
+                /// \details The newest sample is assumed to have been acquired just before currentTime: this anchors
+                ///          the timestamps, which are then spaced by the sample period. Timestamps are re-anchored on
+                ///          overrun, or if they drift away from currentTime.
+                ///
+                /// \param[in] currentTime Current time, in s.
+                /// \return Number of new samples, or -1 on communication failure.
+                int update(double const& currentTime);
+
+                /// \brief Get the samples read by the last call to update.
+                std::vector<IMUSample> const& getLastSamples() const;
+
+                /// \brief Get the heading variation since the last call to this function.
+                /// \details This is the integral of the (bias-corrected) z gyroscope reading.
+                /// \return Heading variation, in rad.
+                double getHeadingIncrement();
+
+                /// \brief Get the heading integrated since construction, in rad.
+                double getHeading() const;
+
+                /// \brief Start estimating the gyroscope bias.
+                /// \details The IMU must remain still until stopBiasEstimation is called: the bias is the mean of the
+                ///          gyroscope readings in between.
+                void startBiasEstimation();
+
+                /// \brief Stop estimating the gyroscope bias, and apply the estimate.
+                /// \return false if no sample was received during the estimation: the bias is then unchanged.
+                bool stopBiasEstimation();
+
+                /// \brief Get the gyroscope bias, in rad/s.
+                vector3D getGyroBias() const;
+
+                /// \brief Set the gyroscope bias, in rad/s.
+                void setGyroBias(vector3D const& bias);
+
+                /// \brief Get the number of FIFO overruns detected.
+                int getNumberOfOverruns() const;
+
+            private:
+                std::shared_ptr<IMUFifoSource> source_; ///< FIFO source.
+                int maxBurstSamples_; ///< Maximum number of samples per bus transaction.
+                int maxSamplesPerUpdate_; ///< Maximum number of samples per update.
+                std::vector<int16_t> buffer_; ///< Raw word buffer.
+                std::vector<IMUSample> samples_; ///< Samples of the last update.
+
+                bool isTimeAnchored_; ///< Whether timestamps have been anchored.
+                double firstSampleTime_; ///< Timestamp of the sample number 0.
+                uint64_t nSamples_; ///< Number of samples since the last anchoring.
+                int nOverruns_; ///< Number of overruns.
+
+                double heading_; ///< Integrated heading.
+                double headingAtLastIncrement_; ///< Heading at the last call to getHeadingIncrement.
+                vector3D gyroBias_; ///< Gyroscope bias.
+                bool isEstimatingBias_; ///< Whether bias estimation is running.
+                vector3D biasSum_; ///< Sum of the gyroscope readings during bias estimation.
+                int nBiasSamples_; ///< Number of samples in biasSum_.
+        };
+    }
+#endif
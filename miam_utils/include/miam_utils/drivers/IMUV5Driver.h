@@ -3,12 +3,15 @@
 ///
 /// \details This file contains all the functions related to communication
 ///             with the IMU, via I2C.
+///          In FIFO mode, samples are stored in the sensor FIFO at a fixed output data rate, and read in bulk
+///          through the IMUFifoSource interface (see IMUFifo.h).
 /// \note    Sensor precision setting is hardcoded, see source code directly.
 /// \author Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef IMUV3DRIVER_H
     #define IMUV3DRIVER_H
     #include <miam_utils/drivers/I2C-Wrapper.h>
+    #include <miam_utils/drivers/IMUFifo.h>
 
 #ifndef IMUVECTOR
     #define IMUVECTOR
@@ -26,7 +29,7 @@
     };
 #endif
 
-    class IMUV5{
+    class IMUV5: public miam::IMUFifoSource{
         public:
             /// \brief Constructor.
             IMUV5();
@@ -55,6 +58,24 @@
             /// \brief Get data from both sensors in a single transaction for more performance.
             void getData(vector3D& gyro, vector3D& accel);
 
+            /// \brief Enable FIFO mode.
+            /// \details Gyroscope and accelerometer are set to the given output data rate, and their samples are
+            ///          stored in the FIFO (continuous mode: the oldest samples are overwritten if the FIFO is not
+            ///          read in time). The FIFO is emptied.
+            ///
+            /// \param[in] outputDataRate Output data rate, in Hz: 104, 208, 416, 833 or 1660.
+            /// \return false if the rate is not supported, or on communication failure.
+            bool enableFifo(int const& outputDataRate = 833);
+
+            /// \brief Disable FIFO mode (bypass mode).
+            void disableFifo();
+
+            bool readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun) override;
+            bool readFifoWords(int16_t *words, int const& nWords) override;
+            double getOutputDataRate() const override;
+            double getGyroScaling() const override;
+            double getAccelScaling() const override;
+
         private:
             I2CAdapter *adapter_;
             unsigned char gyroAddress_; ///< Gyroscope and accelerometer I2C address.
@@ -65,5 +86,6 @@
             double magnetoScaling_; ///< Magnetometer scaling, from counts to mgauss.
 
             bool isInit_;   ///< Status of initialization.
+            double outputDataRate_; ///< Output data rate, in Hz.
     };
 #endif
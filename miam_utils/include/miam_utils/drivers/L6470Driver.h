@@ -1,10 +1,14 @@
-/// \file drivers/dualL6470Driver.h
-/// \brief Driver for two L6470 stepper motor drivers daisy-chained on a single SPI port.
+/// \file drivers/L6470Driver.h
+/// \brief Driver for several L6470 stepper motor drivers daisy-chained on a single SPI port.
 ///
 /// \details Several L6470 drivers can be daisy chained together - this file implements communication
-///          with exactly two L6470 (as is the case for instance for the X-NUCLEO-IHM02A1).
+///          with up to L6470_MAX_DEVICES L6470 (two for instance for the X-NUCLEO-IHM02A1).
 ///          The API is targetted toward driving a robot chassis, thus constraining some symmetry
-///          between both drivers. All functions are thread-safe.
+///          between all drivers. All functions are thread-safe.
+///
+///          Two flavors of the API are provided: a std::vector-based one, for convenience, and an array-based one,
+///          where the caller provides a buffer of at least getNumberOfDevices() elements. The array-based functions
+///          perform no heap allocation, and should be used in the control loop.
 ///    \note     All functions in this header should be prefixed with dualL6470_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
@@ -13,11 +17,20 @@
 #ifndef dualL6470_DRIVER
 #define dualL6470_DRIVER
 
+    #include <stdint.h>
+    #include <string>
     #include <vector>
     #include <mutex>
+    #include <memory>
+
+    #include "miam_utils/drivers/SPITransport.h"
 
     namespace miam{
 
+        int const L6470_MAX_DEVICES = 8; ///< Maximum number of daisy-chained devices handled by the driver.
+        int const L6470_MAX_FRAME_LENGTH = 4; ///< Maximum length of a command sent to one device: command byte and 3 bytes of parameter.
+        int const L6470_MAX_EXCHANGE_LENGTH = 11; ///< Maximum number of bytes sent to one device in a single transaction (see L6470::exchange).
+
         enum L6470_STEP_MODE{
             FULL=0,
             HALF=1,
@@ -38,10 +51,17 @@
                 /// \details This function only builds the object, but does not perform any operation on the
                 ///          SPI port.
                 /// \param[in] portName Name of the port, in the file system (i.e. a string "/dev/spidevx").
-                /// \param[in] numberOfSlaves Number of devices to drive.
+                /// \param[in] numberOfDevices Number of devices to drive, clamped to L6470_MAX_DEVICES.
                 /// \param[in] speed Bus clock frequency. Default: 4Mhz.
                 L6470(std::string const& portName, int const& numberOfDevices, int const& busFrequency = 4000000);
 
+                /// \brief Constructor, using a custom SPI transport.
+                /// \details This enables using the driver through a shared bus, or with an emulator (see L6470Emulator).
+                /// \param[in] transport SPI transport to use.
+                /// \param[in] numberOfDevices Number of devices to drive, clamped to L6470_MAX_DEVICES.
+                /// \param[in] speed Bus clock frequency. Default: 4Mhz.
+                L6470(std::shared_ptr<SPITransport> transport, int const& numberOfDevices, int const& busFrequency = 4000000);
+
                 /// \brief Assignment operator.
                 L6470& operator=(L6470 const& l);
 
@@ -87,6 +107,16 @@
                 /// \return Vector of parameter value from each device.
                 std::vector<uint32_t> getParam(uint8_t const& param);
 
+                /// \brief Read a parameter register, without memory allocation.
+                ///
+                /// \param[in] param The parameter to read.
+                /// \param[out] parameterValues Value of the parameter for each device, array of size getNumberOfDevices().
+                void getParam(uint8_t const& param, uint32_t *parameterValues);
+
+                /// \brief Get the number of daisy-chained devices.
+                /// \return Number of devices.
+                int getNumberOfDevices() const;
+
                 /// \brief Perform a soft motor stop on both motors.
                 /// \details A soft stop means that the motor will decelerate at given deceleration until it stops (contrary to a
                 ///             hard stop where the motor stops instantaneously). Only soft stop is exposed to prevent damage to the
@@ -110,11 +140,21 @@
                 /// \return Vector of position of the each motor, in full steps (can be float when microstepping).
                 std::vector<double> getPosition();
 
+                /// \brief Get current position of all motors, without memory allocation.
+                ///
+                /// \param[out] positions Position of each motor, in full steps, array of size getNumberOfDevices().
+                void getPosition(double *positions);
+
                 /// \brief Get current motor velocity (unsigned, i.e. always positive).
                 ///
                 /// \return Vector of velocity of the each motor, in steps/s.
                 std::vector<double> getSpeed();
 
+                /// \brief Get current motor velocity (unsigned), without memory allocation.
+                ///
+                /// \param[out] speeds Velocity of each motor, in steps/s, array of size getNumberOfDevices().
+                void getSpeed(double *speeds);
+
                 /// \brief Set current motor speed.
                 ///
                 /// \param[in] motorSpeeds Vector of motors speeds, in steps/s (between -15625 and 15625).
@@ -123,6 +163,11 @@
                 ///            devices.
                 void setSpeed(std::vector<double> const& motorSpeeds);
 
+                /// \brief Set current motor speed, without memory allocation.
+                ///
+                /// \param[in] motorSpeeds Motor speeds, in steps/s, array of size getNumberOfDevices().
+                void setSpeed(double const *motorSpeeds);
+
                 /// \brief Set motor max speed and acceleration. The same value is used for all motors.
                 ///
                 /// \param[in] maxSpeed Maximum motor speed, in steps/s (from 15.25 to 15610, resolution 15.25 step/s).
@@ -137,6 +182,17 @@
                 /// \return Vector of errors from devices.
                 std::vector<uint32_t> getError();
 
+                /// \brief Get the last error from all devices, without memory allocation.
+                /// \details Same as getError(), errors being written in the given array.
+                ///
+                /// \param[out] errors Error of each device, array of size getNumberOfDevices().
+                void getError(uint32_t *errors);
+
+                /// \brief Get the device status, also clearing the corresponding flags.
+                ///
+                /// \param[out] status Raw STATUS register of each device, array of size getNumberOfDevices().
+                void getStatus(uint32_t *status);
+
                 /// \brief Check if at least one of the motor is running.
                 /// \details Note that this function clears the status error flags.
                 ///
@@ -150,6 +206,25 @@
                 ///                   This value is given in full steps (can be float when microstepping).
                 void moveNSteps(std::vector<double> nSteps);
 
+                /// \brief Perform the periodic communication with the motors, in a single SPI transaction.
+                /// \details This function is meant to be called once per control loop iteration. It concatenates,
+                ///          into a single SPI_IOC_MESSAGE call, the status read (if errors is not NULL), the position
+                ///          read (if positions is not NULL) and the speed commands (if motorSpeeds is not NULL).
+                ///          Speed commands are only sent to devices whose target register value or direction changed
+                ///          since the last speed command: other devices receive NOP. If no speed changed, the run
+                ///          command is not sent at all. Any other command (stop, high impedance, parameter change...)
+                ///          or error reported by the status forces the next speed command to be sent.
+                ///
+                ///          This function performs no heap allocation. Its timing is as follows: status and position
+                ///          are read just before the new speed is applied.
+                ///
+                /// \param[in] motorSpeeds Target motor speeds, in steps/s, array of size getNumberOfDevices(), or NULL.
+                /// \param[out] positions Motor positions, in full steps, array of size getNumberOfDevices(), or NULL.
+                /// \param[out] errors Error of each device, as in getError(), array of size getNumberOfDevices(),
+                ///                    or NULL. Reading errors clears the status error flags.
+                /// \return <0 on SPI error.
+                int exchange(double const *motorSpeeds, double *positions, uint32_t *errors);
+
 
             private:
 
@@ -160,15 +235,15 @@
                 int spiReadWrite(uint8_t* data, uint8_t const& len);
 
                 /// \brief Send a command to the devices, and read corresponding response.
-                ///    \details If the length of one of the two input vectors is not numberOfDevices_, this function
-                ///          returns immediately.
                 ///
-                /// \param[in] command Command to send.
-                /// \param[in] parameters Parameters for each device.
+                /// \param[in] commands Command to send to each device, array of size numberOfDevices_.
+                /// \param[in] parameters Parameters for each device, array of size numberOfDevices_. Ignored if
+                ///                       paramLength is 0.
                 /// \param[in] paramLength Length of parameters, in bytes. This length should be the max of the length
                 ///                        of all parameters.
-                /// \return Vector of response from the devices. Possibly full of zeros if no response is aquired.
-                std::vector<uint32_t> sendCommand(std::vector<uint8_t> const& commands, std::vector<uint32_t> const& parameters, uint8_t paramLength);
+                /// \param[out] response Response from each device, array of size numberOfDevices_. Full of zeros
+                ///                      if no response is aquired. May be NULL.
+                void sendCommand(uint8_t const *commands, uint32_t const *parameters, uint8_t const& paramLength, uint32_t *response);
 
 
                 /// \brief Send a command without parameters to all devices.
@@ -177,18 +252,50 @@
                 /// \param[in] command Command to send.
                 void sendCommand(uint8_t const& command);
 
-                /// \brief Get the device status, also clearing the corresponding flags.
+                /// \brief Write a command to the transmit buffer, in daisy-chain order.
+                /// \details The buffer is filled with (1 + paramLength) * numberOfDevices_ bytes.
                 ///
-                /// \return Vector of errors from devices.
-                std::vector<uint32_t> getStatus();
+                /// \param[out] data Transmit buffer.
+                /// \param[in] commands Command to send to each device.
+                /// \param[in] parameters Parameters for each device.
+                /// \param[in] paramLength Length of parameters, in bytes.
+                void packCommand(uint8_t *data, uint8_t const *commands, uint32_t const *parameters, uint8_t const& paramLength);
 
-                std::string portName_;
+                /// \brief Decode the response to a command from the receive buffer.
+                ///
+                /// \param[in] data Receive buffer, starting at the command byte.
+                /// \param[in] paramLength Length of parameters, in bytes.
+                /// \param[out] response Response from each device.
+                void unpackResponse(uint8_t const *data, uint8_t const& paramLength, uint32_t *response);
+
+                /// \brief Convert a motor speed to a run command and speed register value.
+                ///
+                /// \param[in] speed Motor speed, in steps/s.
+                /// \param[out] command Run command, including direction.
+                /// \param[out] registerValue Speed register value.
+                void speedToRunCommand(double const& speed, uint8_t & command, uint32_t & registerValue);
+
+                /// \brief Decode status registers into error codes, printing errors in the terminal.
+                ///
+                /// \param[in] status Status register of each device.
+                /// \param[out] errors Error of each device.
+                void decodeErrors(uint32_t const *status, uint32_t *errors);
+
+                /// \brief Force the next speed command to be sent to all devices.
+                void invalidateSpeedCache();
+
+                std::shared_ptr<SPITransport> transport_; ///< SPI bus.
                 uint numberOfDevices_;
                 int frequency_;
                 std::recursive_mutex mutex_;    ///< Mutex, for thread safety. recursive_mutex that can be locked several
                                                 /// times by the same thread: is this to prevent deadlock when sending a kill signal to the code.
 
                 double stepModeMultiplier_; ///< Number of steps in one full step.
+
+                // Last speed command sent, to avoid sending the same command again.
+                bool isSpeedCacheValid_; ///< True if lastRunCommand_ and lastRunSpeed_ reflect the state of the devices.
+                uint8_t lastRunCommand_[L6470_MAX_DEVICES]; ///< Last run command (with direction) sent to each device.
+                uint32_t lastRunSpeed_[L6470_MAX_DEVICES]; ///< Last speed register value sent to each device.
         };
     }
 #endif
@@ -0,0 +1,160 @@
+/// \file drivers/L6470Emulator.h
+/// \brief Software emulation of a chain of L6470 stepper motor drivers, at the SPI level.
+///
+/// \details This class implements the SPITransport interface, and can thus be given to the L6470 driver in place
+///          of a real SPI port. It emulates the daisy-chain shift registers, the L6470 command set used by the driver
+///          (SetParam, GetParam, Run, Move, SoftStop, HardStop, SoftHiZ, HardHiZ, GetStatus, ResetPos, ResetDevice),
+///          the device registers, and a simple motion model (velocity ramp at ACC / DEC up to MAX_SPEED).
+///
+///          Time is not taken from the system clock: the motion model is advanced explicitly with update(), which
+///          makes tests deterministic. Bus usage statistics are kept to estimate the SPI cost of a driver call.
+///
+///          Device i of the emulator is the device receiving byte i of each frame, i.e. the same indexing as
+///          the L6470 driver (device 0 being the last one of the physical chain).
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_L6470_EMULATOR
+#define MIAM_L6470_EMULATOR
+
+    #include <stdint.h>
+    #include <vector>
+    #include <mutex>
+
+    #include "miam_utils/drivers/SPITransport.h"
+
+    namespace miam{
+
+        /// \brief Statistics on the SPI traffic seen by the emulator.
+        struct L6470EmulatorStatistics{
+            int nMessages; ///< Number of SPI messages, i.e. of SPI_IOC_MESSAGE calls.
+            int nFrames; ///< Number of frames, i.e. of chip select cycles.
+            int nBytes; ///< Number of bytes clocked on the bus.
+            double busTime; ///< Estimated bus time, in s: clock time and inter-frame delays.
+
+            L6470EmulatorStatistics():
+                nMessages(0),
+                nFrames(0),
+                nBytes(0),
+                busTime(0.0)
+            {}
+        };
+
+        /// \brief Emulation of a single L6470 device: registers, command decoding and motion.
+        class L6470EmulatedDevice
+        {
+            public:
+                /// \brief Constructor: device in its power-up state.
+                L6470EmulatedDevice();
+
+                /// \brief Reset the device, as with the ResetDevice command.
+                void reset();
+
+                /// \brief Process a byte received on chip select rising edge.
+                /// \param[in] input Byte received by the device.
+                /// \return Byte that the device will shift out during the next frame.
+                uint8_t processByte(uint8_t const& input);
+
+                /// \brief Advance the motion model.
+                /// \param[in] dt Time step, in s.
+                void update(double const& dt);
+
+                /// \brief Get register value.
+                /// \param[in] address Register address.
+                /// \return Register value.
+                uint32_t getRegister(uint8_t const& address) const;
+
+                /// \brief Get motor position, in microsteps.
+                double getPosition() const;
+
+                /// \brief Get signed motor speed, in full steps/s.
+                double getSpeed() const;
+
+                /// \brief Return true if the bridges are in high impedance.
+                bool isHighZ() const;
+
+                /// \brief Set (i.e. latch) flags in the status register, as if the corresponding event had occured.
+                /// \param[in] eventMask Bits of the status register to trigger ; active-low bits are cleared, active-high
+                ///                      bits are set.
+                void triggerStatusEvent(uint16_t const& eventMask);
+
+            private:
+                enum MotionMode{
+                    STOPPED, ///< Motor holding position.
+                    HIGH_Z, ///< Bridges disabled.
+                    RUN, ///< Running at constant target speed.
+                    MOVE, ///< Going to a target position.
+                    SOFT_STOP, ///< Decelerating to a stop.
+                    SOFT_HIGH_Z ///< Decelerating, then disabling the bridges.
+                };
+
+                /// \brief Decode and execute a command byte.
+                void decodeCommand(uint8_t const& command);
+
+                /// \brief Execute a command once all its parameter bytes have been received.
+                void executeCommand();
+
+                /// \brief Update status and read-only registers from the motion state.
+                void updateRegisters();
+
+                /// \brief Flag the last command as invalid.
+                void flagWrongCommand();
+
+                /// \brief Flag the last command as not performed.
+                void flagCommandNotPerformed();
+
+                uint32_t registers_[32]; ///< Register map.
+
+                // Command decoding.
+                uint8_t currentCommand_; ///< Command waiting for parameter bytes.
+                int parameterBytesLeft_; ///< Number of parameter bytes still to receive.
+                uint32_t parameter_; ///< Parameter being received.
+                uint8_t response_[3]; ///< Response being sent.
+                int responseLength_; ///< Length of the response.
+                int responseIndex_; ///< Index of the next response byte to send.
+
+                // Motion.
+                MotionMode mode_; ///< Current motion mode.
+                double position_; ///< Position, in microsteps.
+                double speed_; ///< Signed speed, in full steps/s.
+                double acceleration_; ///< Signed acceleration during the last update, in full steps/s^2.
+                double runSpeed_; ///< Signed target speed in RUN mode, in full steps/s.
+                double targetPosition_; ///< Target position in MOVE mode, in microsteps.
+                bool isForward_; ///< Current direction of motion.
+        };
+
+
+        class L6470Emulator: public SPITransport
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] numberOfDevices Number of devices in the chain.
+                L6470Emulator(int const& numberOfDevices);
+
+                int transfer(struct spi_ioc_transfer *transfers, int const& nTransfers) override;
+
+                /// \brief Advance the motion model of all devices.
+                /// \param[in] dt Time step, in s.
+                void update(double const& dt);
+
+                /// \brief Get the number of devices in the chain.
+                int getNumberOfDevices() const;
+
+                /// \brief Access a device, for inspection or fault injection.
+                /// \param[in] device Index of the device.
+                /// \return The device.
+                L6470EmulatedDevice & getDevice(int const& device);
+
+                /// \brief Get bus statistics since construction or last reset.
+                L6470EmulatorStatistics getStatistics();
+
+                /// \brief Reset bus statistics.
+                void resetStatistics();
+
+            private:
+                std::vector<L6470EmulatedDevice> devices_; ///< Devices, in driver order.
+                std::vector<uint8_t> shiftRegisters_; ///< Shift register of each device, in driver order.
+                L6470EmulatorStatistics statistics_; ///< Bus statistics.
+                std::mutex mutex_; ///< Mutex, for thread safety.
+        };
+    }
+#endif
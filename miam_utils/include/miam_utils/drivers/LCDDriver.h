@@ -2,6 +2,8 @@
 /// \brief Driver for Adafruit RBG LCD shield.
 ///
 /// \details This shield is made of an MCP23017 I2C IO expander, wired to an HD44780-compatible LCD screen.
+///          A copy of the screen content is kept: on update, only the characters that changed are sent, and all the
+///          pin changes (data nibbles and enable strobes) are packed in a single I2C transaction.
 ///    \note     All functions in this header should be prefixed with lcd_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
@@ -9,6 +11,9 @@
     #define LCD_DRIVER_H
     #include "miam_utils/drivers/MPC23017Driver.h"
 
+    #include <string>
+    #include <vector>
+
     ///< Mapping of board buttons.
     typedef enum
     {
@@ -20,6 +25,50 @@
     }LCDButton;
 
 
+    namespace miam{
+        /// \brief Shadow copy of the LCD content, generating minimal updates.
+        /// \details The output is the sequence of MPC23017 port values (see mpc_writeSequence) that drives the
+        ///          HD44780 4-bit interface: for each byte, data is set, then enable is pulsed, for both nibbles.
+        class LCDFramebuffer
+        {
+            public:
+                /// \brief Constructor: the screen is assumed to be blank.
+                LCDFramebuffer();
+
+                /// \brief Forget the screen content, so that the next update rewrites everything.
+                void invalidate();
+
+                /// \brief Compute the port values needed to display the given text.
+                /// \details Only changed characters are written. A cursor move command is inserted before each
+                ///          group of changed characters, unless rewriting the unchanged characters in between is
+                ///          cheaper.
+                ///
+                /// \param[in] lines Text of both lines. Text is truncated, or padded with spaces, to 16 characters.
+                /// \param[in] basePortValue Value of the port pins not used by the LCD (e.g. backlight).
+                /// \param[out] portValues Port values to write, appended to this vector.
+                /// \return Number of bytes (characters and commands) sent to the LCD.
+                int update(std::string const lines[2], unsigned int const& basePortValue, std::vector<unsigned int> & portValues);
+
+                /// \brief Append the port values needed to send one byte to the LCD.
+                ///
+                /// \param[in] data Byte to send.
+                /// \param[in] isCharacter true for a character, false for a command.
+                /// \param[in] basePortValue Value of the port pins not used by the LCD (e.g. backlight).
+                /// \param[out] portValues Port values to write, appended to this vector.
+                static void appendByte(unsigned char const& data,
+                                       bool const& isCharacter,
+                                       unsigned int const& basePortValue,
+                                       std::vector<unsigned int> & portValues);
+
+                /// \brief Mask of the port pins used by the LCD.
+                static unsigned int getLCDPinMask();
+
+            private:
+                char screen_[2][16]; ///< Current screen content.
+                bool isValid_[2][16]; ///< Whether the screen content of each cell is known.
+        };
+    }
+
     ///< LCD class
     class LCD{
         public:
@@ -38,7 +87,8 @@
 
             /// \brief Set the text of a given LCD line, centering it.
             ///        This function operates asyncronously and retuns immediately.
-            /// \note  Writing a full line to the LCD currently takes about 70ms.
+            /// \note  Writing a full line to the LCD currently takes about 20ms at 100kHz: only the characters that
+            ///        changed are written.
             ///
             /// \param[in] text Text to display. Only the first 16 characters will fit the screen.
             ///                 The string should be null-terminated, otherwise it will not be centered correctly,
@@ -60,13 +110,12 @@
             bool isButtonPressed(LCDButton button);
 
         private:
-            void pulseEnable();
-            void sendData(unsigned char const& data, unsigned char const& rsValue);
             void sendCommand(unsigned char value);
-            void sendChar(unsigned char value);
 
             MPC mpc_;
             std::mutex mutex_;
+            miam::LCDFramebuffer framebuffer_;  ///< Screen content.
+            unsigned int basePortValue_;    ///< Value of the port pins not used by the LCD, i.e. backlight.
 
             std::string lines_[2];  ///< Buffer: lines to send to the screen.
             int backlight_;         ///< Buffer: backlight to set.
@@ -75,15 +124,6 @@
 
             /// \brief Background thread handling communication with LCD screen.
             void lcdLoop();
-
-            /// \brief Set the text of a given LCD line, left-aligned.
-            /// \note  Writing a full line to the LCD currently takes about 70ms.
-            ///
-            /// \param[in] text Text to display. Only the first 16 characters will fit the screen.
-            ///                 The string should be null-terminated, otherwise random garbage will be displayed.
-            ///                    The text is left-aligned and padded by spaces to clear the display line.
-            /// \param[in] line Line number (0 or 1).
-            void setText(std::string const& text, int line);
     };
 
 #endif
@@ -4,17 +4,23 @@
 /// \details This chip controls 16 digital I/O from a I2C signal. It is used in Adafruit LCD shield.
 ///             The functions is this file are named to emulate Arduino IO operations.
 ///             The interrupt functionnality of the MPC are not implemented.
+///             Configuration and output registers are cached (see I2CRegisterCache.h): changing a pin does not
+///             read the chip, and does nothing if the pin already has the requested state.
 ///    \note     All functions in this header should be prefixed with mpc_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef MPC_DRIVER_H
     #define MPC_DRIVER_H
     #include "miam_utils/drivers/I2C-Wrapper.h"
+    #include "miam_utils/drivers/I2CRegisterCache.h"
+
+    #include <memory>
 
     /// MPC structure.
     typedef struct {
         I2CAdapter *adapter; ///< Pointer to the I2C port being used.
         int address;    ///< I2C slave address.
+        std::shared_ptr<miam::I2CRegisterCache> registers;  ///< Register cache, shared by all copies of the structure.
     }MPC;
 
     typedef enum{
@@ -35,6 +41,15 @@
     bool mpc_init(MPC *mpc, I2CAdapter *adapter, unsigned int const& slaveAddress);
 
 
+    /// \brief Initialize MPC structure, using a given register-level device.
+    /// \details Use this function to talk to an emulated chip.
+    ///
+    /// \param[inout] mpc The MPC structure, to be used whenever communication with the chip.
+    /// \param[in] device Device to use.
+    /// \returns   true on success, false otherwise.
+    bool mpc_init(MPC *mpc, std::shared_ptr<miam::I2CRegisterDevice> device);
+
+
     /// \brief Calls mpc_init with the default sensor I2C addresses.
     ///
     static inline bool mpc_initDefault(MPC *mpc, I2CAdapter *adapter){return mpc_init(mpc, adapter, 0x20);}
@@ -65,6 +80,15 @@
     void mpc_digitalWrite(MPC mpc, unsigned int pin, unsigned int const& value);
 
 
+    /// \brief Set and clear several pins at once.
+    /// \details Only the port(s) actually modified are written, in a single transaction.
+    ///
+    /// \param[in] mpc The MPC chip to talk to.
+    /// \param[in] setMask Pins to set high.
+    /// \param[in] clearMask Pins to set low. A pin present in both masks is set high.
+    void mpc_writePins(MPC mpc, unsigned int const& setMask, unsigned int const& clearMask);
+
+
     /// \brief Write to all output pins at once.
     /// \details This enables for much faster communication.
     ///
@@ -72,6 +96,18 @@
     /// \param[in] value Value to give to each pin. Note that writing to an input pin has no effect.
     void mpc_writeAll(MPC mpc, unsigned int const& value);
 
+    /// \brief Write a sequence of values to all output pins, in a single I2C transaction.
+    /// \details The chip is temporarily switched to byte mode (IOCON.SEQOP), where consecutive writes alternate
+    ///          between GPIOA and GPIOB instead of incrementing the register address: each value is then applied
+    ///          on the pins in turn, one every 18 bit periods (180us at 100kHz). This is used to bit-bang a
+    ///          protocol (e.g. strobe signals) at the bus speed, without one transaction per edge.
+    ///
+    /// \param[in] mpc The MPC chip to talk to.
+    /// \param[in] values Values to give to each pin, applied in this order.
+    /// \param[in] nValues Number of values.
+    /// \returns true on success, false on failure.
+    bool mpc_writeSequence(MPC mpc, unsigned int const *values, int const& nValues);
+
     /// \brief Read all pins at once.
     /// \details This enables for much faster communication.
     ///
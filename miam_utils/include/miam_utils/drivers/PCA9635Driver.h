@@ -2,18 +2,24 @@
 /// \brief Driver for the PCA9635 led driver.
 ///
 /// \details This file implements all the functions to work with the led driver.
+///          Registers are cached (see I2CRegisterCache.h): only modified registers are written, and consecutive
+///          registers are written in a single transaction.
 ///    \note     All functions in this header should be prefixed with ledDriver_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef PCA9635_DRIVER
     #define PCA9635_DRIVER
     #include "miam_utils/drivers/I2C-Wrapper.h"
+    #include "miam_utils/drivers/I2CRegisterCache.h"
+
+    #include <memory>
 
     /// Led driver structure.
     typedef struct {
         I2CAdapter *adapter;        ///< I2C port file descriptor.
         int address;    ///< Led driver address.
         unsigned char ledState[4];    ///< Current state of the leds: on, off or under PWM control.
+        std::shared_ptr<miam::I2CRegisterCache> registers;  ///< Register cache.
     }PCA9635;
 
 
@@ -28,6 +34,14 @@
     /// \returns   true on success, false otherwise.
     bool ledDriver_init(PCA9635 *driver, I2CAdapter *adapter, unsigned char address);
 
+    /// \brief Initialize Led driver, using a given register-level device.
+    /// \details Use this function to talk to an emulated chip.
+    ///
+    /// \param[out] driver The PCA9635 structure, to be used whenever communication with the led driver.
+    /// \param[in] device Device to use.
+    /// \returns   true on success, false otherwise.
+    bool ledDriver_init(PCA9635 *driver, std::shared_ptr<miam::I2CRegisterDevice> device);
+
     /// \brief Set brightness of a single LED.
     ///
     /// \param[in,out] driver The PCA9635 structure (as a pointer as the ledState variable might be modified).
@@ -35,9 +49,20 @@
     /// \param[in] brightness Led brightness. 0 turns the led 0, 255 is the maximum value.
     void ledDriver_setLedBrightness(PCA9635 *driver, int pin, int brightness);
 
+    /// \brief Set brightness of several consecutive LEDs.
+    /// \details This takes at most two transactions (one for brightness, one for led state), whatever the number
+    ///          of LEDs.
+    ///
+    /// \param[in,out] driver The PCA9635 structure.
+    /// \param[in] firstPin The number of the first pin to change (from 0 to 15).
+    /// \param[in] nPins Number of pins to change.
+    /// \param[in] brightness Brightness of each led. 0 turns the led 0, 255 is the maximum value.
+    void ledDriver_setLedsBrightness(PCA9635 *driver, int firstPin, int nPins, int const *brightness);
+
     /// \brief Set brightness of a RGB LED.
     ///    \note This is equivalent to three successive calls of ledDriver_setLedBrightness, but it uses
-    ///          predefined (hardcoded) constants to match the RGB leds on the output PCB.
+    ///          predefined (hardcoded) constants to match the RGB leds on the output PCB. All three leds are
+    ///          written together.
     ///
     /// \param[in,out] driver The PCA9635 structure.
     /// \param[in] pin The number of RGB led (from 1 to 3).
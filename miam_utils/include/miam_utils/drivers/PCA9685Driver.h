@@ -2,12 +2,18 @@
 /// \brief Driver for the PCA9685 led driver.
 ///
 /// \details This file implements all the functions to work with the led driver.
+///          Registers are cached (see I2CRegisterCache.h): only modified registers are written, and consecutive
+///          registers are written in a single transaction (the chip is configured in auto-increment mode).
 ///    \note     All functions in this header should be prefixed with ledDriver_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef PCA9685_DRIVER
     #define PCA9685_DRIVER
     #include "miam_utils/drivers/I2C-Wrapper.h"
+    #include "miam_utils/drivers/I2CRegisterCache.h"
+
+    #include <memory>
+    #include <vector>
 
     class PCA9685{
         public:
@@ -17,15 +23,27 @@
             /// \return True if communication was successful.
             bool init(I2CAdapter *device, unsigned char const& address = 0x40);
 
+            /// \brief Init and test communication with driver, using a given register-level device.
+            /// \details Use this function to talk to an emulated chip.
+            /// \return True if communication was successful.
+            bool init(std::shared_ptr<miam::I2CRegisterDevice> device);
+
             /// \brief Set led brightness.
             /// \param[in] led Led number (0-15)
             /// \param[in] brightness Led brightness, from 0 to 1;
             void setBrightness(int const& led, double const& brightness);
 
+            /// \brief Set brightness of several consecutive leds, in a single transaction.
+            /// \param[in] brightness Led brightness, from 0 to 1.
+            /// \param[in] firstLed Number of the led corresponding to the first element of brightness.
+            void setBrightness(std::vector<double> const& brightness, int const& firstLed = 0);
+
 
         private:
-            I2CAdapter *adapter_;       ///< I2C port file descriptor.
-            unsigned char address_;    ///< Led driver address.
+            /// \brief Stage the registers of a led, without writing them.
+            void stageBrightness(int const& led, double const& brightness);
+
+            std::shared_ptr<miam::I2CRegisterCache> registers_;  ///< Register cache.
 
             bool isInit_;   ///< Status of initialization.
     };
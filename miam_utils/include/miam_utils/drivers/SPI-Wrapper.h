@@ -1,9 +1,9 @@
 /// \file drivers/SPI-Wrapper.h
 /// \brief Wrapper for SPI communication.
 ///
-/// \details This file implements SPI file opening and closing. Communication itself isn't handled yet,
-///             but it should probably be there instead of in each driver (L6470 and ADNS9800 implement it separately for
-///             now).
+/// \details This file implements SPI file opening and closing. Communication itself is done through an
+///             SPITransport (see SPITransport.h), possibly shared between several drivers with an SPIBusManager
+///             (see SPIBusManager.h).
 ///    \note     All functions in this header should be prefixed with spi_.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
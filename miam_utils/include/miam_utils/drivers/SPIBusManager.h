@@ -0,0 +1,198 @@
+/// \file drivers/SPIBusManager.h
+/// \brief Arbitration of SPI ports shared by several drivers.
+///
+/// \details The SPIBusManager owns the spidev file descriptors of the SPI ports, and serializes the messages of
+///          several clients (e.g. the L6470 chain and the ADNS9800 sensor). Each client is an SPITransport, and can
+///          thus be given directly to the drivers.
+///
+///          Pending messages are served by decreasing client priority (FIFO for equal priority): motor commands
+///          should thus use a higher priority than sensor reads. There is no dedicated thread: the calling thread
+///          that finds the bus idle performs the highest-priority pending message, possibly on behalf of another
+///          client, until its own message has been performed.
+///
+///          Consecutive pending messages targeting the same port with the same SPI mode are merged into a single
+///          SPI_IOC_MESSAGE call, each transfer being sent at the clock frequency of its client. The SPI mode is
+///          a property of the file descriptor, it is thus only changed (between two calls) when needed.
+///
+///          Per-client statistics (number of messages, latency from submission to completion) are kept.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_SPI_BUS_MANAGER
+#define MIAM_SPI_BUS_MANAGER
+
+    #include <stdint.h>
+    #include <string>
+    #include <vector>
+    #include <map>
+    #include <memory>
+    #include <mutex>
+    #include <condition_variable>
+    #include <chrono>
+
+    #include "miam_utils/drivers/SPITransport.h"
+
+    namespace miam{
+
+        /// Maximum number of transfers merged in a single SPI_IOC_MESSAGE call.
+        int const SPI_BUS_MAX_BATCH_TRANSFERS = 32;
+        /// Maximum number of bytes merged in a single SPI_IOC_MESSAGE call (default spidev buffer size). A larger
+        /// message is still performed, but alone.
+        int const SPI_BUS_MAX_BATCH_BYTES = 4096;
+
+        /// \brief Configuration of a client of the SPIBusManager.
+        struct SPIClientConfiguration{
+            std::string name; ///< Client name, for statistics.
+            std::string portName; ///< Name of the port, in the file system (i.e. a string "/dev/spidevx").
+            int frequency; ///< Maximum bus clock frequency for this client, in Hz.
+            uint8_t mode; ///< SPI mode (SPI_MODE_0 to SPI_MODE_3).
+            int priority; ///< Client priority: higher priority messages are served first.
+
+            SPIClientConfiguration():
+                name(""),
+                portName(""),
+                frequency(1000000),
+                mode(SPI_MODE_3),
+                priority(0)
+            {}
+        };
+
+        /// \brief Statistics of a client of the SPIBusManager.
+        struct SPIClientStatistics{
+            int nMessages; ///< Number of messages performed.
+            int nErrors; ///< Number of messages that failed.
+            int nMergedMessages; ///< Number of messages sent in the same SPI_IOC_MESSAGE call as another message.
+            double totalLatency; ///< Sum of the latencies, in s.
+            double maxLatency; ///< Maximum latency, in s.
+            double lastLatency; ///< Latency of the last message, in s.
+
+            SPIClientStatistics():
+                nMessages(0),
+                nErrors(0),
+                nMergedMessages(0),
+                totalLatency(0.0),
+                maxLatency(0.0),
+                lastLatency(0.0)
+            {}
+
+            /// \brief Get the mean latency, from submission to completion of a message, in s.
+            double getMeanLatency() const
+            {
+                return (nMessages > 0 ? totalLatency / nMessages : 0.0);
+            }
+        };
+
+        class SPIBusManager;
+
+        /// \brief A client of the SPIBusManager: an SPITransport with a given port, speed, mode and priority.
+        /// \details Clients are created by SPIBusManager::addClient. The manager must outlive its clients.
+        class SPIBusClient: public SPITransport
+        {
+            public:
+                /// \brief Constructor - see SPIBusManager::addClient.
+                SPIBusClient(SPIBusManager *manager, int const& clientId);
+
+                int transfer(struct spi_ioc_transfer *transfers, int const& nTransfers) override;
+
+                /// \brief Get the statistics of this client.
+                SPIClientStatistics getStatistics();
+
+                /// \brief Reset the statistics of this client.
+                void resetStatistics();
+
+            private:
+                SPIBusManager *manager_; ///< Bus manager.
+                int clientId_; ///< Index of this client in the manager.
+        };
+
+
+        class SPIBusManager
+        {
+            public:
+                /// \brief Constructor.
+                /// \details No port is opened at this stage: ports are opened at their first use, and remain open
+                ///          until the manager is destroyed.
+                SPIBusManager();
+
+                /// \brief Destructor: close all ports.
+                virtual ~SPIBusManager();
+
+                /// \brief Register a new client.
+                /// \param[in] configuration Client configuration.
+                /// \return The client, to give to the driver.
+                std::shared_ptr<SPIBusClient> addClient(SPIClientConfiguration const& configuration);
+
+                /// \brief Perform a message on behalf of a client.
+                /// \details The calling thread is blocked until the message has been performed.
+                ///
+                /// \param[in] clientId Index of the client.
+                /// \param[in, out] transfers Transfers to perform.
+                /// \param[in] nTransfers Number of transfers.
+                /// \return <0 on error.
+                int transfer(int const& clientId, struct spi_ioc_transfer *transfers, int const& nTransfers);
+
+                /// \brief Get the statistics of a client.
+                SPIClientStatistics getStatistics(int const& clientId);
+
+                /// \brief Reset the statistics of a client.
+                void resetStatistics(int const& clientId);
+
+                /// \brief Print the statistics of all clients on the terminal.
+                void printStatistics();
+
+            protected:
+                /// \brief Open a port.
+                /// \param[in] portName Name of the port.
+                /// \param[in] frequency Default clock frequency.
+                /// \return File descriptor, or -1 on failure.
+                virtual int openPort(std::string const& portName, int const& frequency);
+
+                /// \brief Close a port.
+                /// \param[in] port File descriptor.
+                virtual void closePort(int const& port);
+
+                /// \brief Set the SPI mode of a port.
+                /// \param[in] port File descriptor.
+                /// \param[in] mode SPI mode.
+                /// \return <0 on error.
+                virtual int setPortMode(int const& port, uint8_t const& mode);
+
+                /// \brief Perform an SPI_IOC_MESSAGE on a port.
+                /// \param[in] port File descriptor.
+                /// \param[in, out] transfers Transfers to perform.
+                /// \param[in] nTransfers Number of transfers.
+                /// \return <0 on error.
+                virtual int performMessage(int const& port, struct spi_ioc_transfer *transfers, int const& nTransfers);
+
+            private:
+                /// \brief A message waiting to be performed.
+                struct PendingMessage{
+                    int clientId;
+                    struct spi_ioc_transfer *transfers;
+                    int nTransfers;
+                    std::chrono::steady_clock::time_point submissionTime;
+                    uint64_t sequenceNumber;
+                    bool isDone;
+                    int result;
+                };
+
+                /// \brief State of an open port.
+                struct PortState{
+                    int fileDescriptor; ///< File descriptor, -1 if not open.
+                    int mode; ///< Current SPI mode, -1 if unknown.
+                };
+
+                /// \brief Perform the highest-priority pending messages, merging compatible ones.
+                /// \details Called with the lock held and the bus free ; the lock is released during the transfer.
+                void serveNextBatch(std::unique_lock<std::mutex> & lock);
+
+                std::vector<SPIClientConfiguration> clients_; ///< Client configurations.
+                std::vector<SPIClientStatistics> statistics_; ///< Client statistics.
+                std::map<std::string, PortState> ports_; ///< State of each port.
+                std::vector<PendingMessage*> pendingMessages_; ///< Messages waiting to be performed.
+                uint64_t sequenceNumber_; ///< Counter used to keep FIFO order among equal priority messages.
+                bool isBusBusy_; ///< Whether a thread is currently performing a message.
+                std::mutex mutex_; ///< Mutex, for thread safety.
+                std::condition_variable condition_; ///< Signals completion of messages.
+        };
+    }
+#endif
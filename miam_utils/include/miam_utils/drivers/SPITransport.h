@@ -0,0 +1,54 @@
+/// \file drivers/SPITransport.h
+/// \brief Abstraction of an SPI bus, to decouple drivers from the spidev interface.
+///
+/// \details An SPITransport performs a full-duplex SPI message, described as a list of spi_ioc_transfer
+///          (see linux/spi/spidev.h). The default implementation, SpidevTransport, forwards the message to the
+///          kernel, but other implementations may emulate the devices (for testing) or arbitrate the bus between
+///          several drivers.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_SPI_TRANSPORT
+#define MIAM_SPI_TRANSPORT
+
+    #include <linux/spi/spidev.h>
+    #include <string>
+
+    namespace miam{
+
+        class SPITransport
+        {
+            public:
+                virtual ~SPITransport(){}
+
+                /// \brief Perform an SPI message, i.e. a list of transfers, in a single transaction.
+                /// \details The semantics of each transfer, in particular of cs_change, is the one of SPI_IOC_MESSAGE.
+                ///          Received data is written in each rx_buf.
+                ///
+                /// \param[in, out] transfers Transfers to perform.
+                /// \param[in] nTransfers Number of transfers.
+                /// \return <0 on error.
+                virtual int transfer(struct spi_ioc_transfer *transfers, int const& nTransfers) = 0;
+        };
+
+
+        /// \brief SPI transport using a spidev file.
+        /// \details The port is opened and closed for each message, so that other processes (or other drivers in
+        ///          the same process) can use it in between.
+        class SpidevTransport: public SPITransport
+        {
+            public:
+                /// \brief Constructor.
+                /// \details This function only builds the object, but does not perform any operation on the
+                ///          SPI port.
+                /// \param[in] portName Name of the port, in the file system (i.e. a string "/dev/spidevx").
+                /// \param[in] frequency Maximum bus clock frequency, in Hz.
+                SpidevTransport(std::string const& portName, int const& frequency);
+
+                int transfer(struct spi_ioc_transfer *transfers, int const& nTransfers) override;
+
+            private:
+                std::string portName_; ///< Name of the port.
+                int frequency_; ///< Maximum bus frequency.
+        };
+    }
+#endif
@@ -0,0 +1,109 @@
+/// \file drivers/VL53L0XArray.h
+/// \brief Management of several VL53L0X range sensors on the same I2C bus.
+///
+/// \details All VL53L0X share the same default I2C address. At startup, all sensors are held in reset through their
+///          XSHUT pin, then brought up one at a time: each is initialized at the default address, then moved to its
+///          own address.
+///
+///          Sensors are then run in timed continuous mode, all with the same period, but started at evenly spaced
+///          instants: measurements (and thus laser emission and I2C reads) are staggered over the period instead
+///          of happening all at once.
+///
+///          A thread collects the ranges as they become available, and publishes them in lock-free slots (see
+///          I2CPollingService.h): reading a range never touches the bus. If the GPIO1 (interrupt) pin of a sensor is
+///          wired, its level is checked first, so that the bus is only used when a measurement is ready.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_VL53L0X_ARRAY_H
+#define MIAM_VL53L0X_ARRAY_H
+
+    #include <stdint.h>
+    #include <functional>
+    #include <memory>
+    #include <mutex>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+    #include "miam_utils/drivers/I2C-Wrapper.h"
+    #include "miam_utils/drivers/I2CPollingService.h"
+    #include "miam_utils/drivers/VL53L0XDriver.h"
+
+    namespace miam{
+
+        /// \brief Configuration of a sensor of the array.
+        struct VL53L0XArraySensor{
+            std::string name; ///< Sensor name.
+            uint8_t address; ///< I2C address given to the sensor. Must be unique, and not the default 0x29.
+            /// Function setting the XSHUT pin: false to hold the sensor in reset, true to enable it.
+            /// For instance, on the Raspberry Pi: [](bool enable){ RPi_writeGPIO(pin, enable); }
+            std::function<void(bool)> setEnabled;
+            /// Optional: function returning true if the GPIO1 pin signals a measurement ready (active low by default).
+            /// If empty, the data-ready flag is read over I2C.
+            std::function<bool()> isDataReady;
+        };
+
+        /// \brief Health of a sensor of the array.
+        struct VL53L0XArrayStatus{
+            std::string name; ///< Sensor name.
+            bool isInit; ///< Whether the sensor was successfully brought up.
+            uint64_t nMeasurements; ///< Number of measurements read.
+            uint64_t nPolls; ///< Number of times the sensor was checked for a new measurement.
+        };
+
+        class VL53L0XArray
+        {
+            public:
+                /// \brief Constructor, does nothing.
+                VL53L0XArray();
+
+                /// \brief Destructor: stop the collection thread.
+                ~VL53L0XArray();
+
+                /// \brief Bring up all the sensors, and start ranging.
+                /// \details Sensors failing to initialize are reported by getStatus, and ignored afterward.
+                ///
+                /// \param[in] adapter I2C adapter.
+                /// \param[in] sensors Sensor configuration.
+                /// \param[in] periodMs Measurement period of each sensor, in ms.
+                /// \param[in] timingBudgetUs Measurement timing budget, in us. Must be smaller than the period.
+                /// \param[in] pollPeriodUs Period at which sensors are checked for new measurements, in us.
+                /// \return true if all sensors were brought up.
+                bool init(I2CAdapter *adapter,
+                          std::vector<VL53L0XArraySensor> const& sensors,
+                          uint32_t const& periodMs = 25,
+                          uint32_t const& timingBudgetUs = 20000,
+                          uint32_t const& pollPeriodUs = 2000);
+
+                /// \brief Stop ranging and the collection thread.
+                void stop();
+
+                /// \brief Get the number of sensors.
+                int getNumberOfSensors() const;
+
+                /// \brief Get the latest range of a sensor.
+                /// \details This function is lock-free and never accesses the bus.
+                ///
+                /// \param[in] sensor Sensor index.
+                /// \param[out] range Latest range, in mm, with its timestamp (see I2CPollingService::getCurrentTime).
+                /// \return false if no measurement is available for this sensor.
+                bool getRange(int const& sensor, SensorSample<int> & range) const;
+
+                /// \brief Get the status of all sensors.
+                std::vector<VL53L0XArrayStatus> getStatus();
+
+            private:
+                /// \brief Collection thread.
+                void collectionLoop();
+
+                std::vector<VL53L0XArraySensor> configuration_; ///< Sensor configuration.
+                std::vector<std::shared_ptr<VL53L0X>> sensors_; ///< Sensor drivers.
+                std::vector<std::shared_ptr<SensorSlot<int>>> ranges_; ///< Latest range of each sensor.
+                std::vector<VL53L0XArrayStatus> status_; ///< Sensor status.
+                uint32_t pollPeriodUs_; ///< Polling period.
+                bool isRunning_; ///< Whether the collection thread should run.
+                std::thread thread_; ///< Collection thread.
+                std::mutex mutex_; ///< Protects the status and the running flag.
+        };
+    }
+#endif
@@ -3,6 +3,12 @@
 ///
 /// \details This driver is a simplified transcript of the code presented by pololu at
 ///          https://github.com/pololu/vl53l0x-arduino
+///
+///          The sensor is used in continuous mode: either back-to-back (a new measurement starts as soon as the
+///          previous one ends) or timed (one measurement every period). Results are then obtained without blocking
+///          through readRangeIfReady: a single I2C read returns both the data-ready flag and the range. When the
+///          GPIO1 (interrupt) pin of the sensor is wired, data-ready can even be checked without any I2C access.
+///          getMeasurement is kept as a blocking wrapper.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef VL53L0X_DRIVER_H
@@ -23,25 +29,61 @@
             /// \param[in] adapter Pointer to a valid I2CAdapter to choose the I2C port (as returned by the i2c_open function,
             ///                    see I2C-Wrapper.h).
             /// \param[in] slaveAddress Address of the I2C slave.
+            /// \param[in] startRanging If true, start back-to-back continuous ranging at the end of the init.
             /// \returns   true on success, false otherwise.
-            bool init(I2CAdapter *adapter, int const& slaveAddress = 0b0101001);
+            bool init(I2CAdapter *adapter, int const& slaveAddress = 0b0101001, bool const& startRanging = true);
 
             /// \brief Get range measurement.
+            /// \details This function blocks until a measurement is available (or a timeout occurs): prefer
+            ///          readRangeIfReady in a periodic loop.
             ///
             /// \return Range measurement, in mm.
             int getMeasurement();
 
+            /// \brief Start continuous ranging.
+            ///
+            /// \param[in] periodMs Inter-measurement period, in ms, for timed ranging. If 0, ranging is done back
+            ///                     to back. The period should be larger than the timing budget.
+            void startContinuous(uint32_t const& periodMs = 0);
+
+            /// \brief Stop continuous ranging.
+            void stopContinuous();
+
+            /// \brief Check whether a new measurement is available (one I2C register read).
+            bool isMeasurementReady();
+
+            /// \brief Read the latest range, if a new measurement is available, and acknowledge it.
+            /// \details This function does not block: it performs one I2C read (status and result), followed,
+            ///          if a measurement was ready, by the interrupt clear.
+            ///
+            /// \param[out] range Range measurement, in mm. Unchanged if no measurement was ready.
+            /// \return true if a new measurement was read.
+            bool readRangeIfReady(int *range);
+
+            /// \brief Change the I2C address of the sensor.
+            /// \details The new address is lost when the sensor is reset (XSHUT low or power loss).
+            /// \param[in] newAddress New 7-bit address.
+            void setAddress(uint8_t newAddress);
+
+            /// \brief Get the I2C address of the sensor.
+            inline uint8_t getAddress(void) { return address_; }
+
+            /// \brief Set the measurement timing budget, i.e. the duration of a measurement.
+            /// \details A longer timing budget allows for more accurate measurements. Defaults to about 33ms, the
+            ///          minimum is 20ms.
+            /// \param[in] budget_us Budget, in us.
+            /// \return true on success.
+            bool setMeasurementTimingBudget(uint32_t budget_us);
+
+            /// \brief Get the measurement timing budget, in us.
+            uint32_t getMeasurementTimingBudget(void);
+
         private:
      enum vcselPeriodType { VcselPeriodPreRange, VcselPeriodFinalRange };
 
         uint8_t last_status; // status of last I2C transmission
 
 
-        void setAddress(uint8_t new_addr);
-        inline uint8_t getAddress(void) { return address; }
-
-        bool init(bool io_2v8 = true);
-
         void writeReg(uint8_t reg, uint8_t value);
         void writeReg16Bit(uint8_t reg, uint16_t value);
         void writeReg32Bit(uint8_t reg, uint32_t value);
@@ -51,9 +93,6 @@
         void writeMulti(uint8_t reg, uint8_t const * src, uint8_t count);
         void readMulti(uint8_t reg, uint8_t * dst, uint8_t count);
 
-        bool setMeasurementTimingBudget(uint32_t budget_us);
-        uint32_t getMeasurementTimingBudget(void);
-
         bool setVcselPulsePeriod(vcselPeriodType type, uint8_t period_pclks);
         uint8_t getVcselPulsePeriod(vcselPeriodType type);
 
@@ -77,7 +116,6 @@
           uint32_t msrc_dss_tcc_us,    pre_range_us,    final_range_us;
         };
 
-        uint8_t address;
         uint16_t io_timeout;
         bool did_timeout;
         uint16_t timeout_start_ms;
@@ -10,6 +10,7 @@
 
     #include <miam_utils/AbstractRobot.h>
     #include <miam_utils/KalmanFilter.h>
+    #include <miam_utils/KalmanFilters.hpp>
     #include <miam_utils/Logger.h>
     #include <miam_utils/Metronome.h>
     #include <miam_utils/PID.h>
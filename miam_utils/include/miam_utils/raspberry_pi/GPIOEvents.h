@@ -0,0 +1,99 @@
+/// \file raspberry_pi/GPIOEvents.h
+/// \brief Edge events on GPIO inputs, through the Linux GPIO character device.
+///
+/// \details RPi_readGPIO only gives the current level of a pin: detecting an edge requires polling it, and edges
+///          shorter than the polling period are lost. Instead, GPIOEventLine asks the kernel to monitor the pin
+///          (/dev/gpiochip line events): each edge is queued with a kernel timestamp, and is read from a file
+///          descriptor. Callers can thus block until an edge occurs, check for edges without blocking, or add the
+///          file descriptor to their own poll/select loop.
+///
+///          The GPIO v2 interface (kernel 5.10 onward) is used when available, with debouncing performed by the
+///          kernel. Otherwise, the v1 interface is used, and debouncing is done in software: an edge is ignored
+///          if it follows the previous reported edge by less than the debounce period.
+///
+///          Event timestamps use CLOCK_MONOTONIC (CLOCK_REALTIME for the v1 interface on kernels older than 5.7).
+///          Pull-up / pull-down resistors are not changed: configure them first with RPi_setupGPIO.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_GPIO_EVENTS
+#define MIAM_GPIO_EVENTS
+
+    #include <stdint.h>
+    #include <string>
+
+    namespace miam{
+
+        /// \brief Edges to monitor.
+        enum class GPIOEdge
+        {
+            RISING = 1, ///< Low to high transition.
+            FALLING = 2, ///< High to low transition.
+            BOTH = 3 ///< Both transitions.
+        };
+
+        /// \brief An edge event.
+        struct GPIOEvent{
+            GPIOEdge edge; ///< Edge type: RISING or FALLING.
+            uint64_t timestampNs; ///< Kernel timestamp of the edge, in ns.
+        };
+
+        /// \brief A GPIO input monitored for edges.
+        class GPIOEventLine
+        {
+            public:
+                /// \brief Constructor, does nothing.
+                GPIOEventLine();
+
+                /// \brief Destructor: release the line.
+                ~GPIOEventLine();
+
+                GPIOEventLine(GPIOEventLine const&) = delete;
+                GPIOEventLine& operator=(GPIOEventLine const&) = delete;
+
+                /// \brief Start monitoring a GPIO.
+                ///
+                /// \param[in] gpioPin GPIO number (i.e. line offset on the chip).
+                /// \param[in] edges Edges to monitor.
+                /// \param[in] debounceUs Debounce period, in us. 0 to disable debouncing.
+                /// \param[in] chipName GPIO chip device.
+                /// \return false if the line could not be requested.
+                bool open(unsigned int const& gpioPin,
+                          GPIOEdge const& edges,
+                          uint32_t const& debounceUs = 0,
+                          std::string const& chipName = "/dev/gpiochip0");
+
+                /// \brief Stop monitoring the GPIO, and release the line.
+                void close();
+
+                /// \brief Get the file descriptor of the line.
+                /// \details This descriptor becomes readable (POLLIN) when an event is pending: it can be added to a
+                ///          poll/select loop, readEvent is then called to get the event.
+                /// \return File descriptor, -1 if the line is not open.
+                int getFileDescriptor() const;
+
+                /// \brief Wait for an edge.
+                ///
+                /// \param[out] event Event received.
+                /// \param[in] timeoutMs Timeout, in ms. -1 to wait forever, 0 to return immediately.
+                /// \return 1 if an event was received, 0 on timeout, -1 on error.
+                int waitForEvent(GPIOEvent & event, int const& timeoutMs = -1);
+
+                /// \brief Read a pending event, without blocking.
+                ///
+                /// \param[out] event Event received.
+                /// \return true if an event was read, false if no event is pending.
+                bool readEvent(GPIOEvent & event);
+
+                /// \brief Read the current level of the GPIO.
+                /// \return The current pin status, false on error.
+                bool getValue();
+
+            private:
+                int fd_; ///< Line file descriptor.
+                bool isV2_; ///< Whether the GPIO v2 interface is used.
+                uint64_t debounceNs_; ///< Software debounce period, for the v1 interface.
+                uint64_t lastEventNs_; ///< Timestamp of the last reported event, for software debouncing.
+                bool hasEvent_; ///< Whether an event was already reported.
+        };
+    }
+#endif
@@ -33,6 +33,7 @@
                     /// \param[in] backward If robot should move backward along the trajectory.
                     /// \param[in] maxVelocity Max velocity. Only absolute value is taken into account.
                     /// \param[in] maxAcceleration Max acceleration. Only absolute value is taken into account.
+                    /// \param[in] maxJerk Max jerk, zero for a velocity trapezoid. Only absolute value is taken into account.
                     ArcCircle(RobotPosition const& startPoint,
                              double const& radius,
                              rotationside const& side,
@@ -41,7 +42,8 @@
                              double const& endVelocity=0.0,
                              bool const& backward = false,
                              double maxVelocity=config::maxWheelVelocity,
-                             double maxAcceleration=config::maxWheelAcceleration);
+                             double maxAcceleration=config::maxWheelAcceleration,
+                             double maxJerk=config::maxWheelJerk);
 
                     TrajectoryPoint getCurrentPoint(double const& currentTime);
 
@@ -61,6 +63,7 @@
                     double endVelocity_; ///< End velocity.
                     double maxVelocity_; ///< Maximum velocity.
                     double maxAcceleration_; ///< Maximum acceleration.
+                    double maxJerk_; ///< Maximum jerk.
             };
         }
     }
@@ -93,6 +93,31 @@
             ///                        Otherwise, use the motor parameters. Default: true
             void integratePosition(WheelSpeed const& wheelSpeedIn, miam::RobotPosition & positionInOut, bool const& useEncoders = true);
 
+            /// \brief Integrate a wheel displacement into a robot position, assuming a circular arc motion.
+            /// \details Unlike integratePosition, which moves along the final heading, this is the exact solution
+            ///          when both wheels rotate at constant speed during the displacement: the error no longer
+            ///          depends on the displacement size, allowing larger integration steps for the same accuracy.
+            ///
+            /// \param[in] wheelSpeedIn Input wheel displacement (in rad).
+            /// \param[in] positionInOut The position from which to integrate ; contains the integration result.
+            /// \param[in] useEncoders If true, compute kinematics using the encoders.
+            ///                        Otherwise, use the motor parameters. Default: true
+            void integratePositionArc(WheelSpeed const& wheelSpeedIn, miam::RobotPosition & positionInOut, bool const& useEncoders = true);
+
+            /// \brief Integrate several successive wheel displacements, each one as a circular arc.
+            /// \details This is meant for encoder samples acquired at a higher rate than the control loop: they can
+            ///          all be integrated in a single call at each tick.
+            ///
+            /// \param[in] wheelSpeedIn Array of successive wheel displacements (in rad).
+            /// \param[in] nSamples Number of displacements.
+            /// \param[in] positionInOut The position from which to integrate ; contains the integration result.
+            /// \param[in] useEncoders If true, compute kinematics using the encoders.
+            ///                        Otherwise, use the motor parameters. Default: true
+            void integratePositionArc(WheelSpeed const *wheelSpeedIn,
+                                      int const& nSamples,
+                                      miam::RobotPosition & positionInOut,
+                                      bool const& useEncoders = true);
+
         private:
             double motorWheelRadius_; ///< Radius of the motor wheel, in mm.
             double motorWheelSpacing_; ///< Distance between the center of the robot and the motor wheel, in mm.
@@ -0,0 +1,144 @@
+/// \file trajectory/HolonomicControl.hpp
+/// \brief Odometry, trajectory and pose control of an omnidirectional robot.
+///
+/// \details HolonomicOdometry integrates timestamped base speed measurements into a position. HolonomicTrajectory
+///          goes through a list of waypoints, translating and rotating at the same time. HolonomicPoseController
+///          computes the base speed to follow such a trajectory.
+///
+///          Unlike the two-wheel trajectories of miam::trajectory, the robot heading is independent of its motion
+///          direction: trajectory points thus carry a full velocity (vx, vy, omega), expressed in the table frame.
+///          All distances are in m, like omni::BaseSpeed.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_HOLONOMIC_CONTROL_HPP
+#define MIAM_HOLONOMIC_CONTROL_HPP
+
+    #include "miam_utils/trajectory/ThreeWheelsKinematics.hpp"
+    #include "miam_utils/trajectory/Trapezoid.h"
+
+    #include <vector>
+
+    namespace omni
+    {
+        /// \brief Integrate base speed measurements into a robot position.
+        class HolonomicOdometry
+        {
+            public:
+                /// \brief Constructor.
+                HolonomicOdometry();
+
+                /// \brief Reset the position.
+                ///
+                /// \param[in] position New position.
+                /// \param[in] timestamp Current time, in s.
+                void reset(miam::RobotPosition const& position, double const& timestamp);
+
+                /// \brief Integrate a new speed measurement.
+                /// \details The speed is assumed to vary linearly since the previous measurement: the mean speed
+                ///          over the interval is integrated exactly.
+                ///
+                /// \param[in] baseSpeed Measured base speed, in the robot frame.
+                /// \param[in] timestamp Measurement time, in s.
+                void update(BaseSpeed const& baseSpeed, double const& timestamp);
+
+                /// \brief Get the current position.
+                miam::RobotPosition getPosition() const;
+
+                /// \brief Get the last measured speed.
+                BaseSpeed getSpeed() const;
+
+            private:
+                miam::RobotPosition position_; ///< Current position.
+                BaseSpeed lastSpeed_; ///< Last speed measurement.
+                double lastTimestamp_; ///< Time of the last measurement.
+                bool isInitialized_; ///< False until the first timestamp is known.
+        };
+
+        /// \brief A trajectory point of an omnidirectional robot.
+        struct HolonomicTrajectoryPoint
+        {
+            HolonomicTrajectoryPoint()
+            : position_(),
+              velocity_()
+            {}
+
+            miam::RobotPosition position_; ///< Target position.
+            BaseSpeed velocity_; ///< Target velocity, in the table frame.
+        };
+
+        /// \brief Trajectory through a list of waypoints, stopping at each one.
+        /// \details Between two waypoints, the robot moves in straight line while rotating, both motions being
+        ///          synchronized along a velocity trapezoid, limited by both linear and angular constraints.
+        class HolonomicTrajectory
+        {
+            public:
+                /// \brief Constructor.
+                ///
+                /// \param[in] waypoints Waypoints to go through, including the starting position.
+                /// \param[in] maxVelocity Maximum linear velocity, in m/s.
+                /// \param[in] maxAcceleration Maximum linear acceleration, in m/s2.
+                /// \param[in] maxAngularVelocity Maximum angular velocity, in rad/s.
+                /// \param[in] maxAngularAcceleration Maximum angular acceleration, in rad/s2.
+                HolonomicTrajectory(std::vector<miam::RobotPosition> const& waypoints,
+                                    double const& maxVelocity,
+                                    double const& maxAcceleration,
+                                    double const& maxAngularVelocity,
+                                    double const& maxAngularAcceleration);
+
+                /// \brief Get trajectory point at a given time.
+                ///
+                /// \param[in] currentTime Time relative to trajectory start, in s.
+                /// \return The trajectory point ; the last waypoint, with zero velocity, after the end.
+                HolonomicTrajectoryPoint getCurrentPoint(double const& currentTime);
+
+                /// \brief Get trajectory duration, in s.
+                double getDuration() const;
+
+            private:
+                /// \brief Straight line segment between two waypoints.
+                struct Segment
+                {
+                    miam::RobotPosition start_; ///< Start position.
+                    miam::RobotPosition delta_; ///< Displacement from start to end.
+                    miam::trajectory::Trapezoid trapezoid_; ///< Progress along the segment, from 0 to 1.
+                    double startTime_; ///< Time at which the segment starts.
+                };
+
+                std::vector<Segment> segments_; ///< Trajectory segments.
+                miam::RobotPosition endPosition_; ///< Last waypoint.
+                double duration_; ///< Trajectory duration.
+        };
+
+        /// \brief Pose controller for an omnidirectional robot.
+        /// \details The command is the target velocity, plus a proportional correction of the position and
+        ///          heading errors. It is expressed in the robot frame and saturated.
+        class HolonomicPoseController
+        {
+            public:
+                /// \brief Constructor.
+                ///
+                /// \param[in] Kp Position gain, in 1/s.
+                /// \param[in] Ktheta Heading gain, in 1/s.
+                /// \param[in] maxVelocity Maximum linear velocity command, in m/s.
+                /// \param[in] maxAngularVelocity Maximum angular velocity command, in rad/s.
+                HolonomicPoseController(double const& Kp,
+                                        double const& Ktheta,
+                                        double const& maxVelocity,
+                                        double const& maxAngularVelocity);
+
+                /// \brief Compute base speed command.
+                ///
+                /// \param[in] currentPosition Current robot position.
+                /// \param[in] target Target trajectory point.
+                /// \return Base speed command, in the robot frame.
+                BaseSpeed computeCommand(miam::RobotPosition const& currentPosition,
+                                         HolonomicTrajectoryPoint const& target) const;
+
+            private:
+                double Kp_; ///< Position gain.
+                double Ktheta_; ///< Heading gain.
+                double maxVelocity_; ///< Maximum linear velocity.
+                double maxAngularVelocity_; ///< Maximum angular velocity.
+        };
+    }
+#endif // MIAM_HOLONOMIC_CONTROL_HPP
@@ -0,0 +1,114 @@
+/// \file trajectory/OpticalFlowOdometry.h
+/// \brief Odometry from an optical flow (mouse) sensor, such as the ADNS9800.
+///
+/// \details The sensor measures the displacement of the floor under it, in its own frame. This class converts these
+///          counts into a displacement of the robot center, expressed in the robot frame, to complement wheel
+///          encoders: unlike them, the sensor is not affected by wheel slip.
+///
+///          A single sensor cannot distinguish a rotation from a translation: the heading increment must thus be
+///          provided by another source (gyroscope, encoders), and is used to remove the lever-arm effect of the
+///          sensor offset.
+///
+///          update is meant to be called at a high rate (each motion burst read), while getDisplacement returns,
+///          at the control loop rate, the displacement accumulated since its last call.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_OPTICAL_FLOW_ODOMETRY
+#define MIAM_OPTICAL_FLOW_ODOMETRY
+
+    #include "miam_utils/drivers/ADNS9800Driver.h"
+    #include "miam_utils/trajectory/RobotPosition.h"
+
+    namespace miam{
+
+        /// \brief Mounting and quality parameters of an optical flow sensor.
+        struct OpticalFlowSensorConfiguration{
+            OpticalFlowSensorConfiguration():
+                x(0.0),
+                y(0.0),
+                angle(0.0),
+                resolution(25.4 / 1800.0),
+                minimumSqual(16),
+                maximumShutter(20000)
+            {}
+
+            double x; ///< Sensor position, along the robot x axis, in mm.
+            double y; ///< Sensor position, along the robot y axis, in mm.
+            double angle; ///< Angle between the robot x axis and the sensor x axis, in rad.
+            double resolution; ///< Sensor resolution, in mm/count (see ADNS9800::resolution). Calibrate it on the actual floor.
+            int minimumSqual; ///< Reports with a lower surface quality are considered invalid.
+            int maximumShutter; ///< Reports with a higher shutter time are considered invalid (sensor lifted, or no surface).
+        };
+
+        /// \brief Displacement of the robot, measured by an optical flow sensor.
+        struct OpticalFlowDisplacement{
+            OpticalFlowDisplacement():
+                dx(0.0),
+                dy(0.0),
+                isValid(true),
+                nReports(0),
+                nInvalidReports(0),
+                minimumSqual(255)
+            {}
+
+            double dx; ///< Displacement along the robot x axis, in mm.
+            double dy; ///< Displacement along the robot y axis, in mm.
+            bool isValid; ///< False if any report was invalid: the displacement should then not be trusted.
+            int nReports; ///< Number of reports integrated.
+            int nInvalidReports; ///< Number of invalid reports (their motion is ignored).
+            int minimumSqual; ///< Lowest surface quality among the reports.
+        };
+
+        class OpticalFlowOdometry
+        {
+            public:
+                /// \brief Constructor.
+                /// \param[in] configuration Sensor configuration.
+                OpticalFlowOdometry(OpticalFlowSensorConfiguration const& configuration = OpticalFlowSensorConfiguration());
+
+                /// \brief Integrate a sensor report.
+                ///
+                /// \param[in] deltaX Sensor motion along its x axis, in counts.
+                /// \param[in] deltaY Sensor motion along its y axis, in counts.
+                /// \param[in] headingIncrement Robot rotation since the last report, in rad.
+                /// \param[in] isValid Whether the report is valid (see isReportValid).
+                /// \param[in] squal Surface quality of the report.
+                void update(int const& deltaX,
+                            int const& deltaY,
+                            double const& headingIncrement,
+                            bool const& isValid = true,
+                            int const& squal = 255);
+
+                /// \brief Integrate an ADNS9800 motion burst.
+                /// \param[in] burst Motion burst.
+                /// \param[in] headingIncrement Robot rotation since the last report, in rad.
+                void update(ADNS9800MotionBurst const& burst, double const& headingIncrement);
+
+                /// \brief Check the quality of a motion burst.
+                /// \details A report is valid if the laser is working, the surface quality is high enough, and the
+                ///          shutter time is not too long.
+                bool isReportValid(ADNS9800MotionBurst const& burst) const;
+
+                /// \brief Get the displacement accumulated since the last call to this function.
+                /// \details The displacement is expressed in the robot frame at the time of the previous call.
+                OpticalFlowDisplacement getDisplacement();
+
+                /// \brief Apply a displacement to a robot position.
+                ///
+                /// \param[in] position Robot position when the displacement started.
+                /// \param[in] displacement Displacement, in the robot frame.
+                /// \param[in] headingIncrement Rotation during the displacement, in rad.
+                /// \return New robot position.
+                static RobotPosition integrate(RobotPosition const& position,
+                                               OpticalFlowDisplacement const& displacement,
+                                               double const& headingIncrement);
+
+            private:
+                OpticalFlowSensorConfiguration configuration_; ///< Sensor configuration.
+                double cosAngle_; ///< Cosine of the sensor mounting angle.
+                double sinAngle_; ///< Sine of the sensor mounting angle.
+                OpticalFlowDisplacement displacement_; ///< Displacement accumulated since the last getDisplacement.
+                double heading_; ///< Heading variation since the last getDisplacement.
+        };
+    }
+#endif
@@ -21,10 +21,12 @@
                     /// \param[in] endAngle Ending angle - it will be taken modulo 2 pi.
                     /// \param[in] maxVelocity Max wheel velocity. Only absolute value is taken into account.
                     /// \param[in] maxAcceleration Max acceleration. Only absolute value is taken into account.
+                    /// \param[in] maxJerk Max jerk, zero for a velocity trapezoid. Only absolute value is taken into account.
                     PointTurn(RobotPosition const& startPoint,
                               double const& endAngle,
                               double maxVelocity=config::maxWheelVelocity,
-                              double maxAcceleration=config::maxWheelAcceleration);
+                              double maxAcceleration=config::maxWheelAcceleration,
+                              double maxJerk=config::maxWheelJerk);
 
                     TrajectoryPoint getCurrentPoint(double const& currentTime);
 
@@ -39,6 +41,7 @@
                     double endAngle_;     ///< End angle.
                     double maxVelocity_; ///< Maximum velocity.
                     double maxAcceleration_; ///< Maximum acceleration.
+                    double maxJerk_; ///< Maximum jerk.
             };
         }
     }
@@ -0,0 +1,207 @@
+/// \file trajectory/PoseEKF.h
+/// \brief Extended Kalman filter estimating the robot position from odometry, gyroscope and lidar observations.
+///
+/// \details The state is (x, y, theta, gyro bias). It is predicted at each control loop tick from the encoders and
+///          the gyroscope, and corrected whenever an absolute observation is available: a lidar beacon (range and
+///          bearing of a known point), or a full position fix (e.g. from scan matching).
+///
+///          Prediction uses the encoder linear displacement, and the gyroscope for the heading: unlike the encoder
+///          heading, it is not affected by wheel slip. The difference between the encoder and gyroscope rotation
+///          is then used to estimate the gyroscope bias. Without gyroscope, the encoder heading is used instead.
+///
+///          Lidar observations arrive late, and not necessarily in order: the filter thus keeps a fixed-length
+///          history of its past states and inputs. An observation is applied to the state of the tick closest to
+///          its timestamp, and stored with it: the following ticks are then replayed, with their own observations.
+///          Observations older than the history are rejected.
+///
+///          Everything is fixed-size: no memory allocation is done after construction.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_POSE_EKF
+#define MIAM_POSE_EKF
+
+    #include "miam_utils/trajectory/RobotPosition.h"
+
+    namespace miam{
+
+        /// \brief Noise parameters of the filter.
+        struct PoseEKFParameters{
+            PoseEKFParameters():
+                distanceNoise(0.02),
+                distanceNoiseDensity(1.0),
+                encoderAngleNoise(0.02),
+                encoderAngleNoiseDensity(0.01),
+                gyroNoiseDensity(0.002),
+                biasRandomWalk(0.0002),
+                initialBiasStd(0.05),
+                estimateGyroBias(true),
+                mahalanobisThreshold(16.0)
+            {}
+
+            double distanceNoise; ///< Encoder distance error, relative to the distance traveled.
+            double distanceNoiseDensity; ///< Encoder distance error, independent of motion, in mm/sqrt(s).
+            double encoderAngleNoise; ///< Encoder heading error, relative to the rotation.
+            double encoderAngleNoiseDensity; ///< Encoder heading error, independent of motion, in rad/sqrt(s).
+            double gyroNoiseDensity; ///< Gyroscope noise density, in rad/s/sqrt(Hz).
+            double biasRandomWalk; ///< Gyroscope bias random walk, in rad/s/sqrt(s).
+            double initialBiasStd; ///< Initial gyroscope bias standard deviation, in rad/s.
+            bool estimateGyroBias; ///< If false, the gyroscope bias is kept at 0.
+            double mahalanobisThreshold; ///< Observations with a larger squared Mahalanobis distance are rejected. 0 to disable.
+        };
+
+        class PoseEKF
+        {
+            public:
+                static int const STATE_SIZE = 4; ///< State size: x, y, theta, gyro bias.
+                static int const HISTORY_LENGTH = 64; ///< Number of ticks kept for out-of-order observations.
+                static int const MAX_OBSERVATIONS = 8; ///< Maximum number of observations applied to a single tick.
+
+                /// \brief Constructor.
+                /// \param[in] parameters Filter parameters.
+                PoseEKF(PoseEKFParameters const& parameters = PoseEKFParameters());
+
+                /// \brief Reset the filter to a given position.
+                /// \details The history is cleared: older observations will be rejected.
+                ///
+                /// \param[in] timestamp Current time, in s.
+                /// \param[in] position Initial position.
+                /// \param[in] positionStd Standard deviation of the position, in mm.
+                /// \param[in] angleStd Standard deviation of the angle, in rad.
+                void reset(double const& timestamp,
+                           RobotPosition const& position,
+                           double const& positionStd = 1.0,
+                           double const& angleStd = 0.01);
+
+                /// \brief Prediction step, using encoders and gyroscope.
+                ///
+                /// \param[in] timestamp Current time, in s. Must be increasing.
+                /// \param[in] distance Linear displacement measured by the encoders since the last tick, in mm.
+                /// \param[in] encoderAngle Rotation measured by the encoders since the last tick, in rad.
+                /// \param[in] gyroRate Mean angular velocity measured by the gyroscope since the last tick, in rad/s.
+                void predict(double const& timestamp,
+                             double const& distance,
+                             double const& encoderAngle,
+                             double const& gyroRate);
+
+                /// \brief Prediction step, using encoders only.
+                ///
+                /// \param[in] timestamp Current time, in s. Must be increasing.
+                /// \param[in] distance Linear displacement measured by the encoders since the last tick, in mm.
+                /// \param[in] encoderAngle Rotation measured by the encoders since the last tick, in rad.
+                void predict(double const& timestamp, double const& distance, double const& encoderAngle);
+
+                /// \brief Correction step, using the observation of a beacon at a known position.
+                ///
+                /// \param[in] timestamp Time of the observation, in s.
+                /// \param[in] beacon Beacon position on the table (angle is ignored).
+                /// \param[in] range Measured distance between the robot center and the beacon, in mm.
+                /// \param[in] bearing Measured angle of the beacon, in the robot frame, in rad.
+                /// \param[in] rangeStd Standard deviation of the range, in mm.
+                /// \param[in] bearingStd Standard deviation of the bearing, in rad.
+                /// \return false if the observation was rejected (too old, too many observations, or outlier).
+                bool updateBeacon(double const& timestamp,
+                                  RobotPosition const& beacon,
+                                  double const& range,
+                                  double const& bearing,
+                                  double const& rangeStd,
+                                  double const& bearingStd);
+
+                /// \brief Correction step, using an observation of the full position.
+                ///
+                /// \param[in] timestamp Time of the observation, in s.
+                /// \param[in] position Observed position.
+                /// \param[in] positionStd Standard deviation of the position, in mm.
+                /// \param[in] angleStd Standard deviation of the angle, in rad.
+                /// \return false if the observation was rejected (too old, too many observations, or outlier).
+                bool updatePosition(double const& timestamp,
+                                    RobotPosition const& position,
+                                    double const& positionStd,
+                                    double const& angleStd);
+
+                /// \brief Get the current position estimate.
+                RobotPosition getPosition() const;
+
+                /// \brief Get the current gyroscope bias estimate, in rad/s.
+                double getGyroBias() const;
+
+                /// \brief Get the current state covariance.
+                /// \param[out] covariance State covariance.
+                void getCovariance(double covariance[STATE_SIZE][STATE_SIZE]) const;
+
+                /// \brief Get the time of the last tick, in s.
+                double getTimestamp() const;
+
+            private:
+                /// \brief Absolute observation: a beacon (range, bearing), or a position (x, y, theta).
+                struct Observation{
+                    int size; ///< Measurement size: 2 for a beacon, 3 for a position.
+                    RobotPosition beacon; ///< Beacon position.
+                    double z[3]; ///< Measurement.
+                    double R[3]; ///< Measurement variance.
+                };
+
+                /// \brief State, input and observations at a given tick.
+                struct Tick{
+                    double timestamp; ///< Tick time.
+                    double distance; ///< Encoder distance since the previous tick.
+                    double encoderAngle; ///< Encoder rotation since the previous tick.
+                    double gyroRate; ///< Gyroscope angular velocity since the previous tick.
+                    bool hasGyro; ///< Whether gyroRate is valid.
+                    Observation observations[MAX_OBSERVATIONS]; ///< Observations applied to this tick.
+                    int nObservations; ///< Number of observations.
+                    double state[STATE_SIZE]; ///< State after this tick.
+                    double P[STATE_SIZE][STATE_SIZE]; ///< Covariance after this tick.
+                };
+
+                /// \brief Add a tick to the history, and propagate the state.
+                void addTick(double const& timestamp,
+                             double const& distance,
+                             double const& encoderAngle,
+                             double const& gyroRate,
+                             bool const& hasGyro);
+
+                /// \brief Propagate the state of the previous tick into the given tick, and apply its observations.
+                void propagate(Tick const& previous, Tick & tick) const;
+
+                /// \brief Apply an observation to a tick.
+                /// \return false if the observation was rejected.
+                bool apply(Observation const& observation, Tick & tick) const;
+
+                /// \brief Store an observation and apply it, replaying the following ticks.
+                /// \return false if the observation was rejected.
+                bool addObservation(double const& timestamp, Observation const& observation);
+
+                /// \brief Apply a measurement to a tick.
+                /// \details Measurement model: z = h(x) + v, linearized around the tick state.
+                ///
+                /// \param[in, out] tick Tick to update.
+                /// \param[in] size Measurement size (at most 3).
+                /// \param[in] innovation z - h(x).
+                /// \param[in] H Jacobian of h, size x STATE_SIZE.
+                /// \param[in] R Measurement noise variance (diagonal), of length size.
+                /// \param[in] useGating Whether to reject outliers.
+                /// \return false if the measurement was rejected.
+                bool correct(Tick & tick,
+                             int const& size,
+                             double const *innovation,
+                             double const H[][STATE_SIZE],
+                             double const *R,
+                             bool const& useGating) const;
+
+                /// \brief Find the index of the tick on which to apply an observation, -1 if it is too old.
+                int findTick(double const& timestamp) const;
+
+                /// \brief Replay the ticks following a given index.
+                void replayFrom(int const& index);
+
+                /// \brief Get the history element of a given index (0 being the oldest tick).
+                Tick & tickAt(int const& index);
+                Tick const& tickAt(int const& index) const;
+
+                PoseEKFParameters parameters_; ///< Filter parameters.
+                Tick history_[HISTORY_LENGTH]; ///< Circular buffer of the past ticks.
+                int historyStart_; ///< Index, in history_, of the oldest tick.
+                int historySize_; ///< Number of ticks in the history.
+        };
+    }
+#endif
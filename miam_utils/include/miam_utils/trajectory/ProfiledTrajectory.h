@@ -0,0 +1,260 @@
+/// \file trajectory/ProfiledTrajectory.h
+/// \brief A whole path (chain of lines, arcs, clothoids and splines), followed with a single time-optimal velocity
+///        profile.
+///
+/// \details Chaining independent primitives (see computeTrajectoryRoundedCorner) forces a fixed velocity at each
+///          junction, chosen beforehand. Here, the geometry of the whole path is described first, as a GeometricPath.
+///          ProfiledTrajectory then computes the fastest velocity profile along it that respects the wheel limits:
+///          on a curve of curvature k, the outer wheel moves at v (1 + |k| w), w being the distance from wheel to
+///          robot center, which limits both the velocity and the acceleration of the robot.
+///
+///          The path is discretized in stations, with a constant acceleration between two stations. The profile is
+///          obtained by a forward pass (maximum acceleration from the start), then a backward pass (maximum
+///          deceleration toward the end), both clipped to the velocity limit of each station.
+///
+///          If a maximum jerk J is given, the acceleration of this profile is then averaged over a sliding window of
+///          duration T = 2 A / J, A being the maximum acceleration: the acceleration becomes continuous, and varies
+///          by at most 2 A over T. The averaged motion at time t is the mean of the profile over [t - T, t], so it
+///          lies within v T of every point of this window: the velocity and acceleration limits of each station are
+///          thus taken over this whole distance, so that they remain valid after averaging. The profile is computed
+///          on a path shortened by the distance added by the window, and the motion ends T later.
+///
+///          Only forward motion is supported. At a line/arc junction, curvature jumps and the wheel velocities change
+///          instantaneously, by v |dk| w. Clothoids (curvature varying linearly with abscissa) and quintic splines
+///          keep curvature continuous: they are evaluated from a table of poses, precomputed at a fixed abscissa step.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_TRAJECTORY_PROFILED_TRAJECTORY
+#define MIAM_TRAJECTORY_PROFILED_TRAJECTORY
+
+    #include "miam_utils/trajectory/Trajectory.h"
+    #include <vector>
+
+    namespace miam{
+        namespace trajectory{
+
+            /// \brief A continuous path, made of straight lines, arcs of circle, clothoids and splines.
+            class GeometricPath
+            {
+                public:
+                    /// \brief Constructor: empty path.
+                    ///
+                    /// \param[in] start Path start position and heading.
+                    /// \param[in] tableStep Abscissa step of the tables of clothoids and splines, in mm.
+                    GeometricPath(RobotPosition const& start = RobotPosition(), double const& tableStep = 2.0);
+
+                    /// \brief Append a straight line, along the current end heading.
+                    /// \param[in] length Line length, in mm.
+                    void addLine(double const& length);
+
+                    /// \brief Append an arc of circle, tangent to the current end heading.
+                    ///
+                    /// \param[in] radius Circle radius, in mm.
+                    /// \param[in] angle Rotation along the arc, in rad: positive to turn left, negative to turn right.
+                    void addArc(double const& radius, double const& angle);
+
+                    /// \brief Append a clothoid, tangent to the current end heading.
+                    /// \details Curvature varies linearly from the current end curvature to the given one.
+                    ///
+                    /// \param[in] length Clothoid length, in mm.
+                    /// \param[in] endCurvature Signed curvature at the end of the clothoid, in 1/mm.
+                    void addClothoid(double const& length, double const& endCurvature);
+
+                    /// \brief Append a quintic spline, from the current end to a given pose.
+                    /// \details Heading and curvature are continuous at both ends of the spline.
+                    ///
+                    /// \param[in] end Spline end point and heading.
+                    /// \param[in] endCurvature Signed curvature at the end of the spline, in 1/mm.
+                    void addQuinticSpline(RobotPosition const& end, double const& endCurvature = 0.0);
+
+                    /// \brief Get path length, in mm.
+                    double getLength() const;
+
+                    /// \brief Get path end position.
+                    RobotPosition getEndPosition() const;
+
+                    /// \brief Get path curvature at its end.
+                    double getEndCurvature() const;
+
+                    /// \brief Get position along the path.
+                    ///
+                    /// \param[in] abscissa Curvilinear abscissa, in mm, clamped to [0, getLength()].
+                    /// \return Position at this abscissa.
+                    RobotPosition getPosition(double const& abscissa) const;
+
+                    /// \brief Get path curvature.
+                    ///
+                    /// \param[in] abscissa Curvilinear abscissa, in mm. At a junction, the curvature of the next
+                    ///                     element is returned.
+                    /// \return Signed curvature, in 1/mm (positive when turning left).
+                    double getCurvature(double const& abscissa) const;
+
+                    /// \brief Get the largest absolute curvature over an abscissa range.
+                    /// \details Along clothoids and splines, curvature is interpolated linearly between table entries:
+                    ///          the entries within the range are taken into account, so that a curvature peak inside
+                    ///          the range is not missed.
+                    ///
+                    /// \param[in] startAbscissa Range start, in mm.
+                    /// \param[in] endAbscissa Range end, in mm.
+                    /// \return Largest absolute curvature, in 1/mm.
+                    double getMaxCurvature(double const& startAbscissa, double const& endAbscissa) const;
+
+                    /// \brief A path element: line (zero curvature) or arc.
+                    struct Element{
+                        RobotPosition start; ///< Element start.
+                        double startAbscissa; ///< Curvilinear abscissa of the element start.
+                        double length; ///< Element length.
+                        double curvature; ///< Signed curvature (at the element start, for clothoids and splines).
+                        int tableIndex; ///< First entry in the pose table, -1 for lines and arcs (closed form).
+                    };
+
+                    /// \brief Get the path elements.
+                    std::vector<Element> const& getElements() const;
+
+                private:
+                    /// \brief Index of the element containing a given abscissa.
+                    int findElement(double const& abscissa) const;
+
+                    /// \brief Position along a given element.
+                    RobotPosition getPosition(Element const& element, double const& distance) const;
+
+                    /// \brief Curvature along a given element.
+                    double getCurvature(Element const& element, double const& distance) const;
+
+                    /// \brief Append an element evaluated from the pose table.
+                    /// \details The table entries of the element must already be appended to table_.
+                    void addTabulatedElement(int const& tableIndex, double const& length);
+
+                    /// \brief An entry of the pose table.
+                    struct TableEntry{
+                        RobotPosition position; ///< Pose at this abscissa.
+                        double curvature; ///< Signed curvature at this abscissa.
+                    };
+
+                    RobotPosition start_; ///< Path start.
+                    std::vector<Element> elements_; ///< Path elements.
+                    std::vector<TableEntry> table_; ///< Poses along clothoids and splines, every tableStep_.
+                    double tableStep_; ///< Abscissa step of the table.
+            };
+
+            /// \brief Build a path going through a list of points, with rounded corners.
+            /// \details Like computeTrajectoryRoundedCorner, this is a polyline whose corners are replaced by arcs
+            ///          of circle. The path starts heading to the second point: a point turn must be added before if
+            ///          needed. The radius is reduced at sharp corners, so that arcs do not overlap.
+            ///
+            /// \param[in] positions Points to go through. Angles are not taken into account.
+            /// \param[in] radius Arc radius, in mm.
+            /// \return The path.
+            GeometricPath computeRoundedCornerPath(std::vector<RobotPosition> const& positions, double const& radius);
+
+            /// \brief Build a path going exactly through a list of points, with continuous curvature.
+            /// \details Consecutive points are joined by quintic splines. At each intermediate point, the heading
+            ///          is parallel to the line joining its neighbours, and the curvature is the one of the circle
+            ///          through the three points. The path starts heading to the second point, and ends with a
+            ///          zero curvature, along the last segment direction. A point followed by its predecessor is
+            ///          reached with a U-turn to the left.
+            ///
+            /// \param[in] positions Points to go through. Angles are not taken into account.
+            /// \return The path.
+            GeometricPath computeSmoothPath(std::vector<RobotPosition> const& positions);
+
+            /// \brief Trajectory along a GeometricPath, with a time-optimal velocity profile.
+            class ProfiledTrajectory: public Trajectory
+            {
+                public:
+                    /// \brief Constructor.
+                    ///
+                    /// \param[in] path Path to follow.
+                    /// \param[in] startVelocity Start velocity, in mm/s.
+                    /// \param[in] endVelocity End velocity, in mm/s.
+                    /// \param[in] maxWheelVelocity Maximum wheel velocity, in mm/s.
+                    /// \param[in] maxWheelAcceleration Maximum wheel acceleration, in mm/s2.
+                    /// \param[in] wheelSpacing Distance from wheel to robot center, in mm.
+                    /// \param[in] stationSpacing Maximum distance between two stations of the discretization, in mm.
+                    /// \param[in] maxWheelJerk Maximum jerk of the robot linear motion, in mm/s3, zero for no jerk
+                    ///                         limitation.
+                    ProfiledTrajectory(GeometricPath const& path,
+                                       double const& startVelocity = 0.0,
+                                       double const& endVelocity = 0.0,
+                                       double maxWheelVelocity = config::maxWheelVelocity,
+                                       double maxWheelAcceleration = config::maxWheelAcceleration,
+                                       double wheelSpacing = config::robotWheelSpacing,
+                                       double const& stationSpacing = 5.0,
+                                       double maxWheelJerk = config::maxWheelJerk);
+
+                    TrajectoryPoint getCurrentPoint(double const& currentTime);
+
+                    /// \brief Replanify the trajectory from the given time.
+                    /// \details The profile is recomputed along the rest of the path, starting at rest.
+                    void replanify(double const& replanificationTime);
+
+                    /// \brief Get the path.
+                    GeometricPath const& getPath() const;
+
+                private:
+                    /// \brief Compute the velocity profile, from a given abscissa.
+                    void make(double const& startAbscissa, double const& startVelocity);
+
+                    /// \brief Compute the (not averaged) profile between two abscissas.
+                    ///
+                    /// \param[in] startAbscissa Profile start.
+                    /// \param[in] endAbscissa Profile end.
+                    /// \param[in] startVelocity Start velocity.
+                    /// \param[in] endVelocity End velocity.
+                    /// \param[in] margin Distance around each interval over which its limits are taken.
+                    void computeProfile(double const& startAbscissa,
+                                        double const& endAbscissa,
+                                        double const& startVelocity,
+                                        double const& endVelocity,
+                                        double const& margin);
+
+                    /// \brief Place the stations between two abscissas, with one at each element junction.
+                    ///
+                    /// \param[in] startAbscissa First station.
+                    /// \param[in] endAbscissa Last station.
+                    /// \param[out] curvatures Largest absolute curvature over each interval between stations.
+                    void placeStations(double const& startAbscissa,
+                                       double const& endAbscissa,
+                                       std::vector<double>& curvatures);
+
+                    /// \brief State of the profile at a given time, extended at constant velocity outside of it.
+                    ///
+                    /// \param[in] time Time.
+                    /// \param[in,out] cursor Station of the last lookup.
+                    /// \param[out] abscissa Abscissa.
+                    /// \param[out] velocity Velocity.
+                    /// \param[out] integral Integral of the abscissa over time, since the profile start.
+                    void getProfileState(double const& time,
+                                         int& cursor,
+                                         double& abscissa,
+                                         double& velocity,
+                                         double& integral) const;
+
+                    /// \brief Abscissa and velocity of the robot (averaged profile, if jerk is limited).
+                    void getState(double const& time, double& abscissa, double& velocity);
+
+                    /// \brief A point of the discretization.
+                    struct Station{
+                        double abscissa; ///< Curvilinear abscissa.
+                        double velocity; ///< Velocity at the station.
+                        double time; ///< Time at which the station is reached.
+                        double acceleration; ///< Acceleration until the next station.
+                        double integral; ///< Integral of the abscissa over time, from the first station.
+                    };
+
+                    GeometricPath path_; ///< Path.
+                    std::vector<Station> stations_; ///< Velocity profile.
+                    int cursor_; ///< Station of the last lookup.
+                    int lagCursor_; ///< Station of the last lookup at the start of the averaging window.
+                    double filterDuration_; ///< Duration of the averaging window, zero without jerk limitation.
+
+                    double endVelocity_; ///< End velocity.
+                    double maxWheelVelocity_; ///< Maximum wheel velocity.
+                    double maxWheelAcceleration_; ///< Maximum wheel acceleration.
+                    double wheelSpacing_; ///< Distance from wheel to robot center.
+                    double stationSpacing_; ///< Maximum distance between two stations.
+                    double maxWheelJerk_; ///< Maximum jerk.
+            };
+        }
+    }
+#endif
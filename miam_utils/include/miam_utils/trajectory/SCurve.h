@@ -0,0 +1,94 @@
+/// \file trajectory/SCurve.h
+/// \brief Jerk-limited (seven-segment, or "S-curve") velocity profile.
+///
+/// \details Like a Trapezoid, an SCurve goes from 0 to a given distance, from a start to an end velocity, with
+///          bounded velocity and acceleration. The acceleration is however continuous: it ramps up and down with
+///          bounded jerk, instead of changing instantaneously at each phase change. The profile is made of up to
+///          seven constant-jerk segments: jerk up, constant acceleration, jerk down, constant velocity, and
+///          symmetrically for the deceleration. The velocity reached between both phases is the maximum velocity if
+///          the distance allows it, and is otherwise found by bisection; each segment is then evaluated in closed
+///          form (cubic polynomial in time).
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_TRAJECTORY_SCURVE
+#define MIAM_TRAJECTORY_SCURVE
+
+    namespace miam{
+        namespace trajectory{
+            /// \brief State along a velocity profile, Trapezoid or SCurve (position and velocity).
+            struct TrapezoidState{
+                double position; ///< Current position in trapezoid.
+                double velocity; ///< Current velocity in trapezoid.
+
+                /// \brief Default constructor.
+                TrapezoidState():
+                    position(0.0),
+                    velocity(0.0)
+                {}
+            };
+
+            /// \brief A jerk-limited velocity profile.
+            /// \details When the end velocity cannot be reached within the given distance, the closest reachable
+            ///          end velocity is used instead (see getEndVelocity).
+            class SCurve
+            {
+                public:
+                    /// \brief Default constructor: zero length profile.
+                    SCurve();
+
+                    /// \brief Constructor.
+                    ///
+                    /// \param[in] distance Profile length. Only absolute value is taken into account.
+                    /// \param[in] startVelocity Start velocity, cropped to [0, maxVelocity].
+                    /// \param[in] endVelocity End velocity, cropped to [0, maxVelocity].
+                    /// \param[in] maxVelocity Max velocity. Only absolute value is taken into account.
+                    /// \param[in] maxAcceleration Max acceleration. Only absolute value is taken into account.
+                    /// \param[in] maxJerk Max jerk (derivative of acceleration). Only absolute value is taken into account.
+                    SCurve(double const& distance,
+                           double const& startVelocity,
+                           double const& endVelocity,
+                           double maxVelocity,
+                           double maxAcceleration,
+                           double maxJerk);
+
+                    /// \brief Get state along the profile, at a given time.
+                    ///
+                    /// \param[in] currentTime Time, in s, since profile following started.
+                    /// \return State along the profile.
+                    TrapezoidState getState(double const& currentTime) const;
+
+                    /// \brief Get acceleration along the profile, at a given time.
+                    ///
+                    /// \param[in] currentTime Time, in s, since profile following started.
+                    /// \return Acceleration.
+                    double getAcceleration(double const& currentTime) const;
+
+                    /// \brief Get the time at which a given position is reached.
+                    ///
+                    /// \param[in] position Position along the profile, clamped to [0, length].
+                    /// \return First time at which this position is reached.
+                    double getTime(double const& position) const;
+
+                    /// \brief Get profile duration, in seconds.
+                    double getDuration() const;
+
+                    /// \brief Get the end velocity, which is the requested one unless it could not be reached.
+                    double getEndVelocity() const;
+
+                    static int const N_SEGMENTS = 7; ///< Number of constant-jerk segments.
+
+                private:
+                    /// \brief Index of the segment containing a given time, in [0, N_SEGMENTS - 1].
+                    int findSegment(double const& currentTime) const;
+
+                    double length_; ///< Profile length.
+                    double endVelocity_; ///< Velocity at the end of the profile.
+                    double startTime_[N_SEGMENTS + 1]; ///< Start time of each segment; the last one is the duration.
+                    double startPosition_[N_SEGMENTS + 1]; ///< Position at the start of each segment.
+                    double startVelocity_[N_SEGMENTS]; ///< Velocity at the start of each segment.
+                    double startAcceleration_[N_SEGMENTS]; ///< Acceleration at the start of each segment.
+                    double jerk_[N_SEGMENTS]; ///< Jerk along each segment.
+            };
+        }
+    }
+#endif
@@ -1,11 +1,18 @@
 /// \file trajectory/SampledTrajectory.h
 /// \brief A trajectory defined by a set of TrajectoryPoints & linear interpolation between points.
+///
+/// \details SampledTrajectory assumes uniform sampling, and owns a copy of its points.
+///          TimedSampledTrajectory supports arbitrary sample times: this allows sparse sampling, e.g. as produced
+///          by sampleTrajectory, which only keeps the samples needed to reproduce a trajectory within a given
+///          error. Its samples are either shared with other trajectories, or borrowed from the caller: they are
+///          never copied.
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #ifndef MIAM_TRAJECTORY_SAMPLED_TRAJECTORY
 #define MIAM_TRAJECTORY_SAMPLED_TRAJECTORY
 
     #include "miam_utils/trajectory/Trajectory.h"
+    #include <memory>
     #include <vector>
 
     namespace miam{
@@ -19,7 +26,7 @@
                     /// \param[in] start_time Time at the first point of the trajectory.
                     /// \param[in] end_time Time at the last point of the trajectory.
                     SampledTrajectory(
-                        std::vector<TrajectoryPoint > sampledTrajectory,
+                        std::vector<TrajectoryPoint > const& sampledTrajectory,
                         double duration
                         );
 
@@ -28,6 +35,87 @@
                 private:
                     std::vector<TrajectoryPoint > sampledTrajectory_; ///< Vector of trajectory waypoints.
             };
+
+            /// \brief A trajectory point, with its time.
+            struct TimedTrajectoryPoint{
+                double time; ///< Time of the point, in s.
+                TrajectoryPoint point; ///< Trajectory point.
+
+                /// \brief Default constructor.
+                TimedTrajectoryPoint():
+                    time(0.0),
+                    point()
+                {}
+
+                /// \brief Constructor.
+                TimedTrajectoryPoint(double const& timeIn, TrajectoryPoint const& pointIn):
+                    time(timeIn),
+                    point(pointIn)
+                {}
+            };
+
+            typedef std::vector<TimedTrajectoryPoint> TrajectorySamples; ///< Samples of a trajectory, by increasing time.
+
+            /// \brief A trajectory defined by samples at arbitrary times, with linear interpolation between them.
+            /// \details Lookup is done by binary search. The index of the last lookup is kept: as the trajectory is
+            ///          usually evaluated at increasing times, the next lookup is most often in the same, or in the
+            ///          next, interval, and is then done in constant time.
+            ///
+            ///          Angles are interpolated along the shortest direction.
+            class TimedSampledTrajectory: public Trajectory
+            {
+                public:
+                    /// \brief Constructor, sharing the samples.
+                    /// \details Time 0 of the trajectory is the time of the first sample.
+                    ///
+                    /// \param[in] samples Trajectory samples, by strictly increasing time. Must not be empty.
+                    TimedSampledTrajectory(std::shared_ptr<TrajectorySamples const> const& samples);
+
+                    /// \brief Constructor, borrowing the samples.
+                    /// \details The samples are not copied: they must outlive this object, and not be modified.
+                    ///
+                    /// \param[in] samples Trajectory samples, by strictly increasing time.
+                    /// \param[in] nSamples Number of samples. Must be positive.
+                    TimedSampledTrajectory(TimedTrajectoryPoint const *samples, int const& nSamples);
+
+                    TrajectoryPoint getCurrentPoint(double const& currentTime);
+
+                    /// \brief Replanify the trajectory from the given time.
+                    /// \details The samples are kept: the trajectory simply restarts from the point at
+                    ///          replanificationTime, which becomes time 0. Unlike analytic trajectories, the velocity
+                    ///          at the new start is thus not zero.
+                    void replanify(double const& replanificationTime);
+
+                    /// \brief Get the number of samples.
+                    int getNumberOfSamples() const;
+
+                private:
+                    /// \brief Find the interval containing a given sample time.
+                    /// \return Index i such that samples_[i].time <= time < samples_[i + 1].time.
+                    int findInterval(double const& time);
+
+                    std::shared_ptr<TrajectorySamples const> storage_; ///< Shared samples ; null if borrowed.
+                    TimedTrajectoryPoint const *samples_; ///< Samples.
+                    int nSamples_; ///< Number of samples.
+                    double startTime_; ///< Sample time corresponding to time 0 of the trajectory.
+                    int cursor_; ///< Interval of the last lookup.
+            };
+
+            /// \brief Sample a trajectory, keeping only the samples needed for a given accuracy.
+            /// \details The trajectory is first evaluated every timestep. Samples are then removed (Douglas-Peucker
+            ///          algorithm) as long as linear interpolation between the remaining ones reproduces all the initial
+            ///          samples within the given errors: a straight line at constant velocity only keeps its ends,
+            ///          while curves and acceleration phases keep more samples.
+            ///
+            /// \param[in] trajectory Trajectory to sample.
+            /// \param[in] timestep Initial sampling period, in s.
+            /// \param[in] maxPositionError Maximum position error, in mm.
+            /// \param[in] maxAngleError Maximum angle error, in rad.
+            /// \return Trajectory samples, starting at time 0.
+            TrajectorySamples sampleTrajectory(Trajectory & trajectory,
+                                               double const& timestep = 0.001,
+                                               double const& maxPositionError = 0.5,
+                                               double const& maxAngleError = 0.002);
         }
     }
 #endif
@@ -24,13 +24,15 @@
                     /// \param[in] backward If robot should move backward along the straight line.
                     /// \param[in] maxVelocity Max velocity. Only absolute value is taken into account.
                     /// \param[in] maxAcceleration Max acceleration. Only absolute value is taken into account.
+                    /// \param[in] maxJerk Max jerk, zero for a velocity trapezoid. Only absolute value is taken into account.
                     StraightLine(RobotPosition const& startPoint,
                                  RobotPosition const& endPoint,
                                  double const& startVelocity = 0.0,
                                  double const& endVelocity = 0.0,
                                  bool const& backward = false,
                                  double maxVelocity=config::maxWheelVelocity,
-                                 double maxAcceleration=config::maxWheelAcceleration);
+                                 double maxAcceleration=config::maxWheelAcceleration,
+                                 double maxJerk=config::maxWheelJerk);
 
                     TrajectoryPoint getCurrentPoint(double const& currentTime);
 
@@ -44,6 +46,8 @@
                     void make(RobotPosition const& startPoint, double const& startVelocity); ///< Build (or rebuild) the trajectory.
 
                     RobotPosition startPoint_; ///< Point where the trajectory started.
+                    double directionX_; ///< Motion direction, x coordinate (including motionSign_), precomputed.
+                    double directionY_; ///< Motion direction, y coordinate (including motionSign_), precomputed.
                     int motionSign_; ///< 1 or -1, to indicate direction of motion.
                     Trapezoid trapezoid_; ///< Velocity trapezoid.
 
@@ -52,6 +56,7 @@
                     bool backward_;     ///< True if going backward.
                     double maxVelocity_; ///< Maximum velocity.
                     double maxAcceleration_; ///< Maximum acceleration.
+                    double maxJerk_; ///< Maximum jerk.
             };
         }
     }
@@ -75,6 +75,19 @@ namespace omni
             /// \return Corresponding wheel speed.
             WheelSpeed inverseKinematics(BaseSpeed const& baseSpeed) const;
 
+            /// \brief Integrate a constant base speed into a robot position.
+            /// \details This is the exact solution (SE(2) exponential) for a constant base speed: the robot moves
+            ///          along a circular arc while translating sideways. The position is expressed in the unit of
+            ///          the speed (i.e. in m).
+            ///
+            /// \param[in] position Starting position.
+            /// \param[in] baseSpeed Base speed, in the robot frame.
+            /// \param[in] dt Integration time, in s.
+            /// \return Position after dt.
+            static miam::RobotPosition integratePosition(miam::RobotPosition const& position,
+                                                         BaseSpeed const& baseSpeed,
+                                                         double const& dt);
+
         private:
             double robotRadius_; ///< Radius of the robot: distance from center of the robot to the wheel, in m.
             double wheelRadius_; ///< Radius of the wheel, in m.
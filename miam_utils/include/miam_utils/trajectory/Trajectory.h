@@ -20,6 +20,7 @@
                 extern double maxWheelVelocity;     ///< Maximum wheel velocity along a trajectory, mm/s.
                 extern double maxWheelAcceleration; ///< Maximum wheel acceleration of a trajectory, mm/s2.
                 extern double robotWheelSpacing;     ///< Distance from wheel to robot center, in mm. Used to compute velocity of external wheel while along a curve.
+                extern double maxWheelJerk;         ///< Maximum wheel jerk of a trajectory, mm/s3. Zero for no jerk limitation (velocity trapezoid).
             }
 
             /// \brief Set the velocity and dimension value of the config parameters.
@@ -29,9 +30,11 @@
             /// \param[in] maxWheelVelocity Maximum wheel velocity, mm/s.
             /// \param[in] maxWheelAcceleration Maximum wheel acceleration, mm/s2.
             /// \param[in] robotWheelSpacing Distance from wheel to robot center, in mm.
+            /// \param[in] maxWheelJerk Maximum wheel jerk, mm/s3, zero to disable jerk limitation.
             void setTrajectoryGenerationConfig(double const& maxWheelVelocity,
                                                double const& maxWheelAcceleration,
-                                               double const& robotWheelSpacing);
+                                               double const& robotWheelSpacing,
+                                               double const& maxWheelJerk = 0.0);
 
             /// \brief A trajectory point, containing everything for servoing along this trajectory.
             struct TrajectoryPoint{
@@ -76,6 +79,49 @@
                 protected:
                     double duration_; ///< Trajectory duration.
             };
+
+            /// \brief Memoization of trajectory evaluations, within a control loop tick.
+            /// \details The control loop typically evaluates the same trajectory at the same time several times per
+            ///          tick (avoidance, end detection, servoing). This context keeps the last few evaluations, so
+            ///          that repeated queries are only computed once.
+            ///
+            ///          Entries are identified by the trajectory address and the exact query time: the context must
+            ///          thus be cleared at each tick, and whenever a trajectory is modified (e.g. replanified) or
+            ///          deleted.
+            class TrajectoryEvaluationContext
+            {
+                public:
+                    static int const CACHE_SIZE = 4; ///< Number of evaluations kept.
+
+                    /// \brief Constructor.
+                    TrajectoryEvaluationContext();
+
+                    /// \brief Forget all evaluations.
+                    void clear();
+
+                    /// \brief Get trajectory point, computing it only if not already known.
+                    ///
+                    /// \param[in] trajectory Trajectory to evaluate.
+                    /// \param[in] currentTime Time relative to trajectory start, in seconds.
+                    /// \return The trajectory point, as given by trajectory->getCurrentPoint(currentTime).
+                    TrajectoryPoint getCurrentPoint(Trajectory *trajectory, double const& currentTime);
+
+                    /// \brief Get the number of evaluations actually computed since construction.
+                    int getNumberOfEvaluations() const;
+
+                private:
+                    /// \brief A memoized evaluation.
+                    struct Entry{
+                        Trajectory *trajectory; ///< Evaluated trajectory.
+                        double time; ///< Query time.
+                        TrajectoryPoint point; ///< Result.
+                    };
+
+                    Entry entries_[CACHE_SIZE]; ///< Memoized evaluations.
+                    int nEntries_; ///< Number of valid entries.
+                    int nextEntry_; ///< Entry to overwrite next, once the cache is full.
+                    int nEvaluations_; ///< Number of evaluations computed.
+            };
         }
     }
 #endif
@@ -0,0 +1,151 @@
+/// \file trajectory/TrajectoryLibrary.h
+/// \brief Binary storage of precomputed trajectories, loaded by memory mapping.
+///
+/// \details A trajectory library is a file containing named TrajectoryVector. Each trajectory of the vector is
+///          stored as a segment: its primitive type, duration, and samples (as computed by sampleTrajectory).
+///          Libraries are written offline with TrajectoryLibraryWriter. At runtime, TrajectoryLibrary maps the file
+///          in memory: trajectories are then TimedSampledTrajectory reading their samples directly from the
+///          mapping, without parsing nor copying them.
+///
+///          File layout, in native byte order (little endian on both PC and Raspberry Pi):
+///           - header: magic "MIAMTRJ\0", version (uint32), number of trajectories (uint32).
+///           - one entry per trajectory: name (48 chars, null-terminated), first segment and number of segments
+///             (uint32).
+///           - one entry per segment: type (uint32), number of samples (uint32), offset of the samples from the
+///             start of the file (uint64), duration (double).
+///           - samples, as arrays of TimedTrajectoryPoint.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_TRAJECTORY_TRAJECTORY_LIBRARY
+#define MIAM_TRAJECTORY_TRAJECTORY_LIBRARY
+
+    #include "miam_utils/trajectory/SampledTrajectory.h"
+    #include "miam_utils/trajectory/Utilities.h"
+
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+
+    namespace miam{
+        namespace trajectory{
+
+            /// \brief Type of a trajectory primitive, as stored in a library.
+            enum class TrajectoryType : uint32_t {
+                UNKNOWN = 0,
+                STRAIGHT_LINE = 1,
+                ARC_CIRCLE = 2,
+                POINT_TURN = 3,
+                PROFILED = 4,
+                SAMPLED = 5
+            };
+
+            /// \brief Get the primitive type of a trajectory.
+            TrajectoryType getTrajectoryType(Trajectory const& trajectory);
+
+            /// \brief Build a trajectory library file.
+            class TrajectoryLibraryWriter
+            {
+                public:
+                    /// \brief Constructor.
+                    /// \details Parameters are those of sampleTrajectory, used for all trajectories.
+                    ///
+                    /// \param[in] timestep Sampling timestep, in s.
+                    /// \param[in] maxPositionError Maximum position error, in mm.
+                    /// \param[in] maxAngleError Maximum angle error, in rad.
+                    TrajectoryLibraryWriter(double const& timestep = 0.001,
+                                            double const& maxPositionError = 0.5,
+                                            double const& maxAngleError = 0.002);
+
+                    /// \brief Add a trajectory to the library.
+                    ///
+                    /// \param[in] name Trajectory name, at most 47 characters.
+                    /// \param[in] trajectories Trajectories to store, sampled immediately.
+                    /// \return False if the name is invalid or already used.
+                    bool add(std::string const& name, TrajectoryVector const& trajectories);
+
+                    /// \brief Write the library to a file.
+                    ///
+                    /// \param[in] filename Output file.
+                    /// \return True on success.
+                    bool write(std::string const& filename) const;
+
+                private:
+                    /// \brief A trajectory of the library.
+                    struct Entry{
+                        std::string name; ///< Trajectory name.
+                        std::vector<TrajectoryType> types; ///< Type of each segment.
+                        std::vector<double> durations; ///< Duration of each segment.
+                        std::vector<TrajectorySamples> samples; ///< Samples of each segment.
+                    };
+
+                    std::vector<Entry> entries_; ///< Library content.
+                    double timestep_; ///< Sampling timestep.
+                    double maxPositionError_; ///< Maximum position error of the samples.
+                    double maxAngleError_; ///< Maximum angle error of the samples.
+            };
+
+            /// \brief A trajectory library file, mapped in memory.
+            class TrajectoryLibrary
+            {
+                public:
+                    /// \brief Constructor: empty library.
+                    TrajectoryLibrary();
+
+                    /// \brief Destructor: unmap the file. Trajectories obtained from the library become invalid.
+                    ~TrajectoryLibrary();
+
+                    TrajectoryLibrary(TrajectoryLibrary const&) = delete;
+                    TrajectoryLibrary& operator=(TrajectoryLibrary const&) = delete;
+
+                    /// \brief Map a library file, replacing the current content.
+                    ///
+                    /// \param[in] filename Library file.
+                    /// \return False if the file could not be mapped, or is not a valid library.
+                    bool load(std::string const& filename);
+
+                    /// \brief Unmap the current file, if any.
+                    void close();
+
+                    /// \brief Get the names of the trajectories of the library.
+                    std::vector<std::string> getNames() const;
+
+                    /// \brief A segment of a trajectory, pointing to the mapped file.
+                    struct Segment{
+                        TrajectoryType type; ///< Primitive type.
+                        double duration; ///< Duration, in s.
+                        TimedTrajectoryPoint const *samples; ///< Samples.
+                        int nSamples; ///< Number of samples.
+                    };
+
+                    /// \brief Get the segments of a trajectory.
+                    ///
+                    /// \param[in] name Trajectory name.
+                    /// \return Segments, empty if the trajectory is not found.
+                    std::vector<Segment> getSegments(std::string const& name) const;
+
+                    /// \brief Get a trajectory.
+                    /// \details The trajectories read their samples from the mapped file: the library must outlive
+                    ///          them.
+                    ///
+                    /// \param[in] name Trajectory name.
+                    /// \return Trajectories, empty if the trajectory is not found.
+                    TrajectoryVector get(std::string const& name) const;
+
+                    struct FileHeader;
+                    struct FileTrajectory;
+                    struct FileSegment;
+
+                private:
+                    /// \brief Index of a trajectory, -1 if not found.
+                    int find(std::string const& name) const;
+
+                    void *map_; ///< Mapped file, or nullptr.
+                    size_t size_; ///< Size of the mapped file.
+                    FileHeader const *header_; ///< File header.
+                    FileTrajectory const *trajectories_; ///< Trajectory entries.
+                    FileSegment const *segments_; ///< Segment entries.
+                    int nSegments_; ///< Total number of segments.
+            };
+        }
+    }
+#endif
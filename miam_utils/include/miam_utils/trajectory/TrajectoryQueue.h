@@ -0,0 +1,139 @@
+/// \file trajectory/TrajectoryQueue.h
+/// \brief Contiguous storage of trajectories by value, for trajectory following.
+///
+/// \details A TrajectoryVector holds one heap-allocated object per trajectory, evaluated through virtual calls.
+///          Here, the usual primitives (StraightLine, ArcCircle, PointTurn) are instead stored by value, in a tagged
+///          union: a queue of trajectories is a single contiguous array, and evaluation is dispatched with a switch
+///          to a direct (non-virtual) call. Any other trajectory type is kept through its shared pointer.
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#ifndef MIAM_TRAJECTORY_TRAJECTORY_QUEUE
+#define MIAM_TRAJECTORY_TRAJECTORY_QUEUE
+
+    #include "miam_utils/trajectory/ArcCircle.h"
+    #include "miam_utils/trajectory/PointTurn.h"
+    #include "miam_utils/trajectory/StraightLine.h"
+    #include "miam_utils/trajectory/Utilities.h"
+
+    #include <memory>
+    #include <type_traits>
+    #include <vector>
+
+    namespace miam{
+        namespace trajectory{
+
+            /// \brief A trajectory, stored by value for known primitive types.
+            class TrajectorySegment
+            {
+                public:
+                    /// \brief Type of the stored trajectory.
+                    enum class Type{
+                        STRAIGHT_LINE,
+                        ARC_CIRCLE,
+                        POINT_TURN,
+                        SHARED ///< Any other type, kept by shared pointer.
+                    };
+
+                    /// \brief Default constructor: empty segment (null shared trajectory, of zero duration).
+                    TrajectorySegment();
+
+                    /// \brief Constructors, copying a primitive.
+                    TrajectorySegment(StraightLine const& line);
+                    TrajectorySegment(ArcCircle const& arc);
+                    TrajectorySegment(PointTurn const& turn);
+
+                    /// \brief Constructor from a shared trajectory.
+                    /// \details StraightLine, ArcCircle and PointTurn (exact types, not derived classes) are copied by
+                    ///          value: the segment is then independent from the original object.
+                    ///
+                    /// \param[in] trajectory Trajectory to store.
+                    TrajectorySegment(std::shared_ptr<Trajectory> const& trajectory);
+
+                    TrajectorySegment(TrajectorySegment const& other);
+                    TrajectorySegment& operator=(TrajectorySegment const& other);
+                    ~TrajectorySegment();
+
+                    /// \brief Get the type of the stored trajectory.
+                    Type getType() const;
+
+                    /// \brief Get the stored trajectory, as a generic trajectory.
+                    /// \details The pointer is valid as long as the segment is neither modified nor destroyed.
+                    Trajectory *get();
+
+                    /// \brief Get trajectory point at current time, see Trajectory::getCurrentPoint.
+                    TrajectoryPoint getCurrentPoint(double const& currentTime);
+
+                    /// \brief Replanify the trajectory, see Trajectory::replanify.
+                    void replanify(double const& replanificationTime);
+
+                    /// \brief Get trajectory duration, in seconds.
+                    double getDuration();
+
+                    /// \brief Get final point of the trajectory.
+                    TrajectoryPoint getEndPoint();
+
+                    /// \brief Get a shared pointer to the trajectory, copying it if stored by value.
+                    std::shared_ptr<Trajectory> toSharedPointer() const;
+
+                private:
+                    /// \brief Copy-construct the trajectory of another segment, storage being empty.
+                    void copyFrom(TrajectorySegment const& other);
+
+                    /// \brief Destroy the stored trajectory.
+                    void destroy();
+
+                    Type type_; ///< Type of the stored trajectory.
+                    typename std::aligned_union<0, StraightLine, ArcCircle, PointTurn>::type storage_; ///< Primitive, if stored by value.
+                    std::shared_ptr<Trajectory> shared_; ///< Trajectory, if of type SHARED.
+            };
+
+            /// \brief A queue of trajectories to follow, with constant-time removal of the first one.
+            /// \details Segments are kept in a single array, removed segments being skipped: memory is reused at the
+            ///          next clear or assign, or when the array is full.
+            class TrajectoryQueue
+            {
+                public:
+                    /// \brief Constructor: empty queue.
+                    TrajectoryQueue();
+
+                    /// \brief Constructor from a vector of trajectories, see assign.
+                    TrajectoryQueue(std::vector<std::shared_ptr<Trajectory>> const& trajectories);
+
+                    /// \brief Replace the content of the queue.
+                    /// \param[in] trajectories Trajectories, stored as TrajectorySegment.
+                    void assign(std::vector<std::shared_ptr<Trajectory>> const& trajectories);
+
+                    /// \brief Append a trajectory at the end of the queue.
+                    void push_back(TrajectorySegment const& segment);
+
+                    /// \brief Remove the first trajectory, in constant time.
+                    void pop_front();
+
+                    /// \brief Access the trajectories, from the first one.
+                    TrajectorySegment& front();
+                    TrajectorySegment& back();
+                    TrajectorySegment& operator[](size_t const& index);
+
+                    /// \brief Number of trajectories.
+                    size_t size() const;
+
+                    /// \brief True if the queue has no trajectory.
+                    bool empty() const;
+
+                    /// \brief Remove all trajectories.
+                    void clear();
+
+                    /// \brief Get the last point of the last trajectory.
+                    TrajectoryPoint getEndPoint();
+
+                    /// \brief Get the content of the queue as a TrajectoryVector.
+                    /// \details Primitives stored by value are copied in new objects.
+                    TrajectoryVector toTrajectoryVector() const;
+
+                private:
+                    std::vector<TrajectorySegment> segments_; ///< Segments; the first head_ ones have been removed.
+                    size_t head_; ///< Index of the first trajectory in segments_.
+            };
+        }
+    }
+#endif
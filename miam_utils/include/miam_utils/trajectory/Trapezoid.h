@@ -4,28 +4,18 @@
 /// \copyright GNU GPLv3
 #ifndef MIAM_TRAJECTORY_TRAPEZOID
 #define MIAM_TRAJECTORY_TRAPEZOID
+    #include "miam_utils/trajectory/SCurve.h"
     #include "miam_utils/trajectory/Trajectory.h"
 
     namespace miam{
         namespace trajectory{
-            /// \brief State along the trapezoid (position and velocity).
-            struct TrapezoidState{
-                double position; ///< Current position in trapezoid.
-                double velocity; ///< Current velocity in trapezoid.
-
-                /// \brief Default constructor.
-                TrapezoidState():
-                    position(0.0),
-                    velocity(0.0)
-                {}
-            };
-
-
             /// \brief Define a velocity trapezoid path go to to a specif point.
             /// \details Given a distance, start and end velocity, performs a velocity trapezoid for going from
             ///          0 to the given distance. This is done with constraints on max velocity and acceleration:
             ///          in the case where the trajectory is unfeasible (too much difference between start and end
             ///          velocities), the best attemp (i.e. constant max acceleration) is made.
+            ///          If a max jerk is given, a jerk-limited profile (see SCurve) is used instead: acceleration is
+            ///          then continuous, at the cost of a slightly longer motion for the same acceleration.
             class Trapezoid
             {
                 public:
@@ -39,11 +29,14 @@
                     /// \param[in] endVelocity End velocity, cropped to [0, maxVelocity].
                     /// \param[in] maxVelocity Max velocity along the trapezoid. Only absolute value is taken into account.
                     /// \param[in] maxAcceleration Max acceleration along the trapezoid. Only absolute value is taken into account.
+                    /// \param[in] maxJerk Max jerk. If zero, jerk is not limited; otherwise, start velocity is
+                    ///                    cropped to [0, maxVelocity].
                     Trapezoid(double const& distance,
                               double const& startVelocity,
                               double const& endVelocity,
                               double maxVelocity = config::maxWheelVelocity,
-                              double maxAcceleration = config::maxWheelAcceleration);
+                              double maxAcceleration = config::maxWheelAcceleration,
+                              double maxJerk = 0.0);
 
                     /// \brief Get point along the trapezoid curve, at a given time.
                     ///
@@ -64,6 +57,9 @@
                     double timeToStopAccelerating_; ///< When to stop accelerating.
                     double timeToStartDecelerating_; ///< When to start decelerating.
                     double accelerationDistance_;    ///< Distance traveled during acceleration phase.
+                    double decelerationStartPosition_; ///< Position at which deceleration starts, precomputed.
+                    bool isJerkLimited_; ///< If set, sCurve_ is used instead.
+                    SCurve sCurve_; ///< Jerk-limited profile.
             };
         }
     }
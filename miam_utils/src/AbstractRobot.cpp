@@ -7,6 +7,7 @@ AbstractRobot::AbstractRobot():
     currentPosition_(),
     currentBaseSpeed_(),
     trajectoryPoint_(),
+    trajectoryEvaluation_(),
     currentTime_(0.0),
     newTrajectories_(),
     currentTrajectories_(),
@@ -0,0 +1,326 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/LidarLocalization.h"
+#include "miam_utils/trajectory/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+
+    // Invert a 3x3 symmetric matrix, return false if it is singular.
+    static bool invertMatrix(double const A[3][3], double inverse[3][3])
+    {
+        inverse[0][0] = A[1][1] * A[2][2] - A[1][2] * A[2][1];
+        inverse[0][1] = A[0][2] * A[2][1] - A[0][1] * A[2][2];
+        inverse[0][2] = A[0][1] * A[1][2] - A[0][2] * A[1][1];
+        double const determinant = A[0][0] * inverse[0][0] + A[1][0] * inverse[0][1] + A[2][0] * inverse[0][2];
+        // Relative threshold, the matrix elements having very different scales.
+        double const scale = A[0][0] * A[1][1] * A[2][2];
+        if(scale <= 0 || std::abs(determinant) < 1e-9 * scale)
+            return false;
+        inverse[1][0] = A[1][2] * A[2][0] - A[1][0] * A[2][2];
+        inverse[1][1] = A[0][0] * A[2][2] - A[0][2] * A[2][0];
+        inverse[1][2] = A[0][2] * A[1][0] - A[0][0] * A[1][2];
+        inverse[2][0] = A[1][0] * A[2][1] - A[1][1] * A[2][0];
+        inverse[2][1] = A[0][1] * A[2][0] - A[0][0] * A[2][1];
+        inverse[2][2] = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+        for(int i = 0; i < 3; i++)
+            for(int j = 0; j < 3; j++)
+                inverse[i][j] /= determinant;
+        return true;
+    }
+
+
+    DistanceFieldMap::DistanceFieldMap(double const& width,
+                                       double const& height,
+                                       double const& resolution,
+                                       double const& maxDistance):
+        resolution_(resolution),
+        maxDistance_(maxDistance),
+        margin_(maxDistance),
+        nColumns_(static_cast<int>(std::ceil((width + 2 * maxDistance) / resolution))),
+        nRows_(static_cast<int>(std::ceil((height + 2 * maxDistance) / resolution))),
+        segments_(),
+        lines_(),
+        grid_(nColumns_ * nRows_, -1)
+    {
+    }
+
+
+    void DistanceFieldMap::addSegment(RobotPosition const& start, RobotPosition const& end)
+    {
+        RobotPosition direction = end - start;
+        if(direction.norm() < 1e-6)
+            return;
+        direction.normalize();
+        Line line;
+        line.normalX = -direction.y;
+        line.normalY = direction.x;
+        line.offset = line.normalX * start.x + line.normalY * start.y;
+        segments_.push_back(start);
+        segments_.push_back(end);
+        lines_.push_back(line);
+    }
+
+
+    void DistanceFieldMap::addRectangle(RobotPosition const& corner, double const& width, double const& height)
+    {
+        RobotPosition const a(corner.x, corner.y, 0);
+        RobotPosition const b(corner.x + width, corner.y, 0);
+        RobotPosition const c(corner.x + width, corner.y + height, 0);
+        RobotPosition const d(corner.x, corner.y + height, 0);
+        addSegment(a, b);
+        addSegment(b, c);
+        addSegment(c, d);
+        addSegment(d, a);
+    }
+
+
+    void DistanceFieldMap::build()
+    {
+        for(int j = 0; j < nRows_; j++)
+            for(int i = 0; i < nColumns_; i++)
+            {
+                double const x = (i + 0.5) * resolution_ - margin_;
+                double const y = (j + 0.5) * resolution_ - margin_;
+                double bestDistance = maxDistance_;
+                int16_t bestSegment = -1;
+                for(unsigned int k = 0; k < lines_.size(); k++)
+                {
+                    // Distance to the segment: projection, clamped to the segment ends.
+                    RobotPosition const& a = segments_[2 * k];
+                    RobotPosition const& b = segments_[2 * k + 1];
+                    double const dx = b.x - a.x;
+                    double const dy = b.y - a.y;
+                    double t = ((x - a.x) * dx + (y - a.y) * dy) / (dx * dx + dy * dy);
+                    t = std::max(0.0, std::min(1.0, t));
+                    double const distance = std::hypot(x - a.x - t * dx, y - a.y - t * dy);
+                    if(distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestSegment = k;
+                    }
+                }
+                grid_[j * nColumns_ + i] = bestSegment;
+            }
+    }
+
+
+    bool DistanceFieldMap::getClosestLine(double const& x,
+                                          double const& y,
+                                          double & normalX,
+                                          double & normalY,
+                                          double & offset) const
+    {
+        int const i = static_cast<int>(std::floor((x + margin_) / resolution_));
+        int const j = static_cast<int>(std::floor((y + margin_) / resolution_));
+        if(i < 0 || i >= nColumns_ || j < 0 || j >= nRows_)
+            return false;
+        int16_t const segment = grid_[j * nColumns_ + i];
+        if(segment < 0)
+            return false;
+        normalX = lines_[segment].normalX;
+        normalY = lines_[segment].normalY;
+        offset = lines_[segment].offset;
+        return true;
+    }
+
+
+    double DistanceFieldMap::getMaxDistance() const
+    {
+        return maxDistance_;
+    }
+
+
+    ScanMatcher::ScanMatcher(ScanMatcherParameters const& parameters):
+        parameters_(parameters)
+    {
+    }
+
+
+    ScanMatch ScanMatcher::match(DistanceFieldMap const& map,
+                                 std::vector<RobotPosition> const& points,
+                                 RobotPosition const& prior) const
+    {
+        ScanMatch result;
+        RobotPosition position = prior;
+        double const pointWeight = 1.0 / (parameters_.pointStd * parameters_.pointStd);
+        double const priorWeight[3] = {1.0 / (parameters_.priorPositionStd * parameters_.priorPositionStd),
+                                       1.0 / (parameters_.priorPositionStd * parameters_.priorPositionStd),
+                                       1.0 / (parameters_.priorAngleStd * parameters_.priorAngleStd)};
+        // Hessian of the scan points only, without prior.
+        double dataHessian[3][3];
+
+        for(int iteration = 0; iteration < parameters_.maxIterations; iteration++)
+        {
+            double H[3][3] = {{0.0}};
+            double g[3] = {0.0, 0.0, 0.0};
+            double const c = std::cos(position.theta);
+            double const s = std::sin(position.theta);
+            for(RobotPosition const& point : points)
+            {
+                // Point on the table: its derivative with respect to the robot angle is (-ry, rx).
+                double const rx = c * point.x - s * point.y;
+                double const ry = s * point.x + c * point.y;
+                double const x = position.x + rx;
+                double const y = position.y + ry;
+                double nx, ny, offset;
+                if(!map.getClosestLine(x, y, nx, ny, offset))
+                    continue;
+                double const residual = nx * x + ny * y - offset;
+                // Huber weight.
+                double weight = pointWeight;
+                if(std::abs(residual) > parameters_.huberThreshold)
+                    weight *= parameters_.huberThreshold / std::abs(residual);
+                double const J[3] = {nx, ny, ny * rx - nx * ry};
+                for(int i = 0; i < 3; i++)
+                {
+                    g[i] += weight * J[i] * residual;
+                    for(int j = 0; j < 3; j++)
+                        H[i][j] += weight * J[i] * J[j];
+                }
+            }
+            for(int i = 0; i < 3; i++)
+                for(int j = 0; j < 3; j++)
+                    dataHessian[i][j] = H[i][j];
+
+            // Odometry prior.
+            double const priorError[3] = {position.x - prior.x,
+                                          position.y - prior.y,
+                                          trajectory::moduloTwoPi(position.theta - prior.theta)};
+            for(int i = 0; i < 3; i++)
+            {
+                H[i][i] += priorWeight[i];
+                g[i] += priorWeight[i] * priorError[i];
+            }
+
+            // Gauss-Newton step.
+            double Hinv[3][3];
+            if(!invertMatrix(H, Hinv))
+                return result;
+            double step[3] = {0.0, 0.0, 0.0};
+            for(int i = 0; i < 3; i++)
+                for(int j = 0; j < 3; j++)
+                    step[i] -= Hinv[i][j] * g[j];
+            position.x += step[0];
+            position.y += step[1];
+            position.theta += step[2];
+            if(std::abs(step[0]) < 0.01 && std::abs(step[1]) < 0.01 && std::abs(step[2]) < 1e-5)
+                break;
+        }
+        result.position = position;
+
+        // Match quality.
+        double const c = std::cos(position.theta);
+        double const s = std::sin(position.theta);
+        int nPointsNearMap = 0;
+        for(RobotPosition const& point : points)
+        {
+            double const x = position.x + c * point.x - s * point.y;
+            double const y = position.y + s * point.x + c * point.y;
+            double nx, ny, offset;
+            if(!map.getClosestLine(x, y, nx, ny, offset))
+                continue;
+            nPointsNearMap++;
+            double const error = std::abs(nx * x + ny * y - offset);
+            if(error < parameters_.inlierDistance)
+            {
+                result.nInliers++;
+                result.meanError += error;
+            }
+        }
+        if(result.nInliers > 0)
+            result.meanError /= result.nInliers;
+
+        // Uncertainty, from the scan points only: the prior is already known by the user of the correction.
+        double covariance[3][3];
+        if(!invertMatrix(dataHessian, covariance))
+            return result;
+        result.positionStd = std::sqrt(std::max(covariance[0][0], covariance[1][1]));
+        result.angleStd = std::sqrt(covariance[2][2]);
+        result.isValid = result.nInliers >= parameters_.minInliers
+                         && result.nInliers >= parameters_.minInlierRatio * nPointsNearMap;
+        return result;
+    }
+
+
+    LidarLocalization::LidarLocalization(DistanceFieldMap const& map, ScanMatcherParameters const& parameters):
+        map_(map),
+        matcher_(parameters),
+        pendingPoints_(),
+        pendingTimestamp_(0.0),
+        pendingPosition_(),
+        hasPendingScan_(false),
+        correction_(),
+        hasCorrection_(false),
+        isRunning_(true),
+        mutex_(),
+        condition_(),
+        thread_(&LidarLocalization::matchingThread, this)
+    {
+    }
+
+
+    LidarLocalization::~LidarLocalization()
+    {
+        isRunning_ = false;
+        condition_.notify_all();
+        thread_.join();
+    }
+
+
+    void LidarLocalization::submitScan(double const& timestamp,
+                                       std::vector<RobotPosition> const& points,
+                                       RobotPosition const& odometryPosition)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingPoints_.assign(points.begin(), points.end());
+        pendingTimestamp_ = timestamp;
+        pendingPosition_ = odometryPosition;
+        hasPendingScan_ = true;
+        condition_.notify_one();
+    }
+
+
+    bool LidarLocalization::getCorrection(PoseCorrection & correction)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!hasCorrection_)
+            return false;
+        correction = correction_;
+        hasCorrection_ = false;
+        return true;
+    }
+
+
+    void LidarLocalization::matchingThread()
+    {
+        // Scan being processed: swapped with the pending one, so that no allocation is done once both buffers
+        // have reached the scan size.
+        std::vector<RobotPosition> points;
+        while(true)
+        {
+            double timestamp;
+            RobotPosition odometryPosition;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]{return hasPendingScan_ || !isRunning_;});
+                if(!isRunning_)
+                    return;
+                std::swap(points, pendingPoints_);
+                timestamp = pendingTimestamp_;
+                odometryPosition = pendingPosition_;
+                hasPendingScan_ = false;
+            }
+
+            PoseCorrection correction;
+            correction.timestamp = timestamp;
+            correction.match = matcher_.match(map_, points, odometryPosition);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            correction_ = correction;
+            hasCorrection_ = true;
+        }
+    }
+}
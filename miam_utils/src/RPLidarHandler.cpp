@@ -29,7 +29,12 @@ RPLidarHandler::RPLidarHandler(double mountingOffset) :
     pointsNotAddedToBlob_(),
     pointsInBlob_(),
     timeHandler_(1.0),
-    mountingOffset_(mountingOffset)
+    mountingOffset_(mountingOffset),
+    currentScan_(),
+    currentScanStartTime_(0.0),
+    lastScan_(),
+    lastScanTimestamp_(0.0),
+    hasNewScan_(false)
 {
 }
 
@@ -115,6 +120,18 @@ int RPLidarHandler::update()
         // If new point is not in order (recall scan is done in decreasing angle), just discard the new data point.
         if (newPoint.isOlder(lastPointAngle_))
             continue;
+
+        // Angle increasing: a new revolution has started, the current scan is complete.
+        if (newPoint.theta > lastPointAngle_)
+        {
+            std::swap(currentScan_, lastScan_);
+            currentScan_.clear();
+            lastScanTimestamp_ = (currentScanStartTime_ + time) / 2.0;
+            currentScanStartTime_ = time;
+            hasNewScan_ = true;
+        }
+        if (newPoint.r > MIN_DISTANCE && newPoint.r < MAX_SCAN_DISTANCE)
+            currentScan_.push_back(newPoint);
         lastPointAngle_ = newPoint.theta;
 
         // Determine if the current point is to be added to the blob or not.
@@ -167,6 +184,15 @@ int RPLidarHandler::update()
     return nPoint;
 }
 
+bool RPLidarHandler::getScan(std::vector<LidarPoint> & scan, double & timestamp)
+{
+    scan = lastScan_;
+    timestamp = lastScanTimestamp_;
+    bool const isNew = hasNewScan_;
+    hasNewScan_ = false;
+    return isNew;
+}
+
 void RPLidarHandler::stop()
 {
     if (!isInit_)
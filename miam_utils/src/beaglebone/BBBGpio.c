@@ -2,9 +2,44 @@
 /// \copyright GNU GPLv3
 #include "miam_utils/beaglebone/BBBGpio.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+
+// AM335x GPIO banks, see AM335x Technical Reference Manual, p.180 and p.4990 onward.
+#define GPIO_N_BANKS 4
+#define GPIO_N_PINS (32 * GPIO_N_BANKS)
+#define GPIO_BANK_SIZE 0x1000
+unsigned int const GPIO_BANK_ADDRESS[GPIO_N_BANKS] = {0x44E07000, 0x4804C000, 0x481AC000, 0x481AE000};
+
+// Register offsets, in 32-bit words.
+#define GPIO_OE (0x134 / 4)
+#define GPIO_DATAIN (0x138 / 4)
+#define GPIO_CLEARDATAOUT (0x190 / 4)
+#define GPIO_SETDATAOUT (0x194 / 4)
+
+// Pin direction cache.
+#define GPIO_DIRECTION_UNKNOWN 0
+#define GPIO_DIRECTION_IN 1
+#define GPIO_DIRECTION_OUT 2
+
+// Pointers to the bank registers, null if memory access is not available.
+static volatile uint32_t *gpio_bank[GPIO_N_BANKS] = {nullptr, nullptr, nullptr, nullptr};
+static std::once_flag gpio_mmapFlag;
+static bool gpio_isMmapEnabled = false;
+
+// Cached direction and sysfs value file of each pin.
+static std::atomic<int> gpio_direction[GPIO_N_PINS];
+static int gpio_valueFile[GPIO_N_PINS]; // 0 if not open.
+static std::mutex gpio_cacheMutex;
+
 // Internal function : get the content of the first line of the file. Returns TRUE on success, FALSE on error.
 bool getFileContent(std::string const& filename, std::string& output)
 {
@@ -16,59 +51,164 @@ bool getFileContent(std::string const& filename, std::string& output)
     return true;
 }
 
-int gpio_digitalRead(int const& pin)
+// Internal function: map all GPIO banks.
+static void gpio_mapBanks()
 {
-    // Get path to gpio direction file.
-    std::string filename = "/sys/class/gpio/gpio" + std::to_string(pin) + "/direction";
+    int memoryFile = open("/dev/mem", O_RDWR | O_SYNC);
+    if(memoryFile < 0)
+        return;
+    for(int i = 0; i < GPIO_N_BANKS; i++)
+    {
+        void *map = mmap(NULL, GPIO_BANK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFile, GPIO_BANK_ADDRESS[i]);
+        if(map == MAP_FAILED)
+        {
+            for(int j = 0; j < i; j++)
+            {
+                munmap((void *)gpio_bank[j], GPIO_BANK_SIZE);
+                gpio_bank[j] = nullptr;
+            }
+            close(memoryFile);
+            return;
+        }
+        gpio_bank[i] = (volatile uint32_t *)map;
+    }
+    // The mapping remains valid after closing the file.
+    close(memoryFile);
+    gpio_isMmapEnabled = true;
+}
+
+bool gpio_enableMemoryAccess()
+{
+    std::call_once(gpio_mmapFlag, gpio_mapBanks);
+    return gpio_isMmapEnabled;
+}
+
+// Internal function: get the direction of a pin, reading it from sysfs on first access.
+// Going through sysfs once also ensures the pin is exported, thus that the bank clock is enabled: accessing the
+// registers of a disabled bank would crash the program.
+static int gpio_getDirection(int const& pin)
+{
+    if(pin < 0 || pin >= GPIO_N_PINS)
+        return GPIO_DIRECTION_UNKNOWN;
+    int direction = gpio_direction[pin].load();
+    if(direction != GPIO_DIRECTION_UNKNOWN)
+        return direction;
+
+    std::lock_guard<std::mutex> lock(gpio_cacheMutex);
     std::string filecontent;
-    bool returnCode = getFileContent(filename, filecontent);
-    if(returnCode == false)
+    if(!getFileContent("/sys/class/gpio/gpio" + std::to_string(pin) + "/direction", filecontent))
+        return GPIO_DIRECTION_UNKNOWN;
+    direction = (filecontent == "in" ? GPIO_DIRECTION_IN : GPIO_DIRECTION_OUT);
+    if(!gpio_enableMemoryAccess() && gpio_valueFile[pin] <= 0)
+    {
+        // Sysfs fallback: keep the value file open.
+        std::string filename = "/sys/class/gpio/gpio" + std::to_string(pin) + "/value";
+        gpio_valueFile[pin] = open(filename.c_str(), (direction == GPIO_DIRECTION_IN ? O_RDONLY : O_RDWR));
+        if(gpio_valueFile[pin] < 0)
+        {
+            gpio_valueFile[pin] = 0;
+            return GPIO_DIRECTION_UNKNOWN;
+        }
+    }
+    gpio_direction[pin].store(direction);
+    return direction;
+}
+
+// Internal function: invalidate the cache of a pin, e.g. when its direction changes.
+static void gpio_invalidateCache(int const& pin)
+{
+    if(pin < 0 || pin >= GPIO_N_PINS)
+        return;
+    std::lock_guard<std::mutex> lock(gpio_cacheMutex);
+    gpio_direction[pin].store(GPIO_DIRECTION_UNKNOWN);
+    if(gpio_valueFile[pin] > 0)
+        close(gpio_valueFile[pin]);
+    gpio_valueFile[pin] = 0;
+}
+
+int gpio_digitalRead(int const& pin)
+{
+    int direction = gpio_getDirection(pin);
+    if(direction == GPIO_DIRECTION_UNKNOWN)
         return -1;
 
     // Check file is an input.
-    if (filecontent != "in")
+    if (direction != GPIO_DIRECTION_IN)
         return -2;
 
-    // Read gpio value.
-    filename = "/sys/class/gpio/gpio" + std::to_string(pin) + "/value";
-    returnCode = getFileContent(filename, filecontent);
-    if(returnCode == false)
-        return -1;
+    if(gpio_isMmapEnabled)
+        return (gpio_bank[pin / 32][GPIO_DATAIN] >> (pin % 32)) & 1;
 
-    int value = -1;
-    try
-    {
-        value = std::stoi(filecontent);
-    }
-    catch(...) {}
-    return value;
+    // Read gpio value: sysfs files must be read from the start.
+    char value = 0;
+    if(pread(gpio_valueFile[pin], &value, 1, 0) != 1)
+        return -1;
+    return (value == '0' ? 0 : 1);
 }
 
 int gpio_digitalWrite(int const& pin, int const& value)
 {
-    std::string filename = "/sys/class/gpio/gpio" + std::to_string(pin) + "/direction";
-    std::string filecontent;
-    bool returnCode = getFileContent(filename, filecontent);
-    if(returnCode == false)
+    int direction = gpio_getDirection(pin);
+    if(direction == GPIO_DIRECTION_UNKNOWN)
         return -1;
 
     // Check file is an output.
-    if (filecontent != "out")
+    if (direction != GPIO_DIRECTION_OUT)
         return -2;
 
-    filename = "/sys/class/gpio/gpio" + std::to_string(pin) + "/value";
-    std::ofstream file;
-    file.open(filename);
-    if(!file.is_open())
+    if(gpio_isMmapEnabled)
+    {
+        // Set / clear registers only affect the bits written to 1: no read-modify-write needed.
+        gpio_bank[pin / 32][value == 0 ? GPIO_CLEARDATAOUT : GPIO_SETDATAOUT] = 1u << (pin % 32);
+        return 0;
+    }
+
+    char const data = (value == 0 ? '0' : '1');
+    if(pwrite(gpio_valueFile[pin], &data, 1, 0) != 1)
         return -1;
-    file << (value == 0 ? 0 : 1) << std::endl;
-    file.close();
     return 0;
 }
 
+int gpio_digitalWriteMultiple(int const& bank, uint32_t const& setMask, uint32_t const& clearMask)
+{
+    if(bank < 0 || bank >= GPIO_N_BANKS)
+        return -1;
+    // Check that all pins are outputs.
+    uint32_t const mask = setMask | clearMask;
+    for(int i = 0; i < 32; i++)
+    {
+        if((mask & (1u << i)) == 0)
+            continue;
+        int direction = gpio_getDirection(32 * bank + i);
+        if(direction == GPIO_DIRECTION_UNKNOWN)
+            return -1;
+        if(direction != GPIO_DIRECTION_OUT)
+            return -2;
+    }
+
+    if(gpio_isMmapEnabled)
+    {
+        if(setMask != 0)
+            gpio_bank[bank][GPIO_SETDATAOUT] = setMask;
+        if(clearMask != 0)
+            gpio_bank[bank][GPIO_CLEARDATAOUT] = clearMask & ~setMask;
+        return 0;
+    }
+
+    // Sysfs fallback: one write per pin.
+    int result = 0;
+    for(int i = 0; i < 32; i++)
+        if(mask & (1u << i))
+            result = std::min(result, gpio_digitalWrite(32 * bank + i, (setMask & (1u << i)) ? 1 : 0));
+    return result;
+}
+
 
 int gpio_exportPin(int const& pin, std::string const& direction)
 {
+    // The direction changes: cache is no longer valid.
+    gpio_invalidateCache(pin);
+
     // Export pin value.
     std::ofstream file;
     file.open("/sys/class/gpio/export", std::fstream::app);
@@ -2,9 +2,8 @@
 /// \copyright GNU GPLv3
 #include "miam_utils/drivers/ADNS9800Driver.h"
 #include "miam_utils/drivers/ADNS9800Firmware.h"
-#include "miam_utils/drivers/SPI-Wrapper.h"
 #include <stdio.h>
-#include <sys/ioctl.h>
+#include <string.h>
 #include <linux/spi/spidev.h>
 #include <unistd.h>
 
@@ -57,17 +56,22 @@
 
 
 // Internal functions: all functions accessible outside of this file are at the end.
-void ADNS9800_write_register(ADNS9800 a, unsigned char address, unsigned char data)
+int ADNS9800_transfer(ADNS9800 const& a, struct spi_ioc_transfer *spiCtrl, int const& nTransfers)
 {
-    // Open SPI port
-    a.port = spi_open(a.portName, a.frequency);
+    if(!a.transport)
+        return -1;
+    return a.transport->transfer(spiCtrl, nTransfers);
+}
 
+void ADNS9800_write_register(ADNS9800 a, unsigned char address, unsigned char data)
+{
     // Set MSI of addresss to 1 to indicate a read operation.
     address = address | 0x80;
 
     // Send one transmission containing the two-byte write message
     unsigned char message[2] = {address, data};
     struct spi_ioc_transfer spiCtrl;
+    memset(&spiCtrl, 0, sizeof(spiCtrl));
     // First element: send address and wait.
     spiCtrl.tx_buf = (unsigned long)&message;
     spiCtrl.rx_buf = (unsigned long)&message;
@@ -77,23 +81,19 @@ void ADNS9800_write_register(ADNS9800 a, unsigned char address, unsigned char da
     spiCtrl.delay_usecs = 0;
     spiCtrl.cs_change = true;
     // Send the data over spi.
-    int error = ioctl(a.port, SPI_IOC_MESSAGE(1), &spiCtrl);
+    int error = ADNS9800_transfer(a, &spiCtrl, 1);
     if(error <0)
     {
         #ifdef DEBUG
             printf("SPI error when writing: %d\n", error);
         #endif
     }
-    spi_close(a.port);
     // 120us delay after read command
     usleep(120);
 }
 
 unsigned char ADNS9800_read_register(ADNS9800 a, unsigned char address)
 {
-    // Open SPI port
-    a.port = spi_open(a.portName, a.frequency);
-
     // Set MSI of addresss to 0 to indicate a read operation.
     address = address & 0x7f;
     unsigned char response = 0;
@@ -101,6 +101,7 @@ unsigned char ADNS9800_read_register(ADNS9800 a, unsigned char address)
     // We will send two transmissions: thie first one will send the address with a read command.
     // A delay of tsrad delay=100us is then applied, and the response is read by sending zero.
     struct spi_ioc_transfer spiCtrl[2];
+    memset(spiCtrl, 0, sizeof(spiCtrl));
     // First element: send address and wait.
     spiCtrl[0].tx_buf = (unsigned long)&address;
     spiCtrl[0].rx_buf = (unsigned long)&response;
@@ -118,14 +119,13 @@ unsigned char ADNS9800_read_register(ADNS9800 a, unsigned char address)
     spiCtrl[1].delay_usecs = 0;
     spiCtrl[1].cs_change = true;
     // Send the data over spi.
-    int error = ioctl(a.port, SPI_IOC_MESSAGE(2), &spiCtrl);
+    int error = ADNS9800_transfer(a, spiCtrl, 2);
     if(error <0)
     {
         #ifdef DEBUG
             printf("SPI error when reading: %d\n", error);
         #endif
     }
-    spi_close(a.port);
     // 20us delay after read command
     usleep(20);
     return response;
@@ -152,8 +152,8 @@ bool ADNS9800_write_firmware(ADNS9800 a)
         message[x+1] = firmware_data[x];
 
     // Write it in one SPI transaction, starting at address REG_SROM_Load_Burst.
-    a.port = spi_open(a.portName, a.frequency);
     struct spi_ioc_transfer spiCtrl;
+    memset(&spiCtrl, 0, sizeof(spiCtrl));
     // First element: send address and wait.
     spiCtrl.tx_buf = (unsigned long)&message;
     spiCtrl.rx_buf = (unsigned long)&message;
@@ -163,14 +163,13 @@ bool ADNS9800_write_firmware(ADNS9800 a)
     spiCtrl.delay_usecs = 15;
     spiCtrl.cs_change = false;
     // Send the data over spi.
-    int error = ioctl(a.port, SPI_IOC_MESSAGE(1), &spiCtrl);
+    int error = ADNS9800_transfer(a, &spiCtrl, 1);
     if(error <0)
     {
         #ifdef DEBUG
             printf("SPI error when reading: %d\n", error);
         #endif
     }
-    spi_close(a.port);
     // Sleep 160us for SROM reboot
     usleep(160);
 
@@ -185,28 +184,81 @@ bool ADNS9800_write_firmware(ADNS9800 a)
     return true;
 }
 
+// Convert a 16-bit 2's complement register pair to a signed integer.
+int ADNS9800_toSigned(unsigned char const& low, unsigned char const& high)
+{
+    return static_cast<int16_t>((high << 8) | low);
+}
+
+void ADNS9800_decodeMotionBurst(unsigned char const *data, ADNS9800MotionBurst *burst)
+{
+    // Byte order of a motion burst, cf p.30 of the datasheet.
+    burst->motion = data[0];
+    burst->observation = data[1];
+    burst->deltaX = ADNS9800_toSigned(data[2], data[3]);
+    burst->deltaY = ADNS9800_toSigned(data[4], data[5]);
+    burst->squal = data[6];
+    burst->pixelSum = data[7];
+    burst->maxPixel = data[8];
+    burst->minPixel = data[9];
+    burst->shutter = (data[10] << 8) | data[11];
+    burst->framePeriod = (data[12] << 8) | data[13];
+}
+
+bool ADNS9800_readMotionBurst(ADNS9800 a, ADNS9800MotionBurst *burst)
+{
+    // Burst mode was enabled at init by writing to REG_Motion_Burst: the whole motion report is read in a
+    // single transaction, instead of one transaction (and one 20us delay) per register.
+    unsigned char address = REG_Motion_Burst;
+    unsigned char data[ADNS9800_MOTION_BURST_LENGTH];
+    memset(data, 0, sizeof(data));
+
+    struct spi_ioc_transfer spiCtrl[2];
+    memset(spiCtrl, 0, sizeof(spiCtrl));
+    // First element: send address and wait tSRAD_MOTBR.
+    spiCtrl[0].tx_buf = (unsigned long)&address;
+    spiCtrl[0].rx_buf = 0;
+    spiCtrl[0].len = 1;
+    spiCtrl[0].speed_hz = a.frequency;
+    spiCtrl[0].bits_per_word = 8;
+    spiCtrl[0].delay_usecs = 100;
+    spiCtrl[0].cs_change = false;
+    // Second element: read the burst. Raising chip select at the end terminates the burst.
+    spiCtrl[1].tx_buf = 0;
+    spiCtrl[1].rx_buf = (unsigned long)data;
+    spiCtrl[1].len = ADNS9800_MOTION_BURST_LENGTH;
+    spiCtrl[1].speed_hz = a.frequency;
+    spiCtrl[1].bits_per_word = 8;
+    spiCtrl[1].delay_usecs = 0;
+    spiCtrl[1].cs_change = true;
+    int error = ADNS9800_transfer(a, spiCtrl, 2);
+    if(error < 0)
+    {
+        #ifdef DEBUG
+            printf("SPI error when reading motion burst: %d\n", error);
+        #endif
+        return false;
+    }
+    ADNS9800_decodeMotionBurst(data, burst);
+    // Without motion, the delta registers are not meaningful.
+    if((burst->motion & ADNS9800_MOTION_MOT) == 0)
+    {
+        burst->deltaX = 0;
+        burst->deltaY = 0;
+    }
+    return true;
+}
+
 void ADNS9800_getMotionCounts(ADNS9800 a, int *deltaX, int *deltaY)
 {
     // Reset deltaX and deltaY
     *deltaX = 0;
     *deltaY = 0;
-    // Read the motion register : if MSB is 0, no motion occured.
-    if((ADNS9800_read_register(a, REG_Motion) & (1 << 7)) == 0)
+    ADNS9800MotionBurst burst;
+    if(!ADNS9800_readMotionBurst(a, &burst))
         return;
-    // Otherwise, read the new increment
-    unsigned char x_L = ADNS9800_read_register(a, REG_Delta_X_L);
-    unsigned char x_H = ADNS9800_read_register(a, REG_Delta_X_H);
-    unsigned char y_L = ADNS9800_read_register(a, REG_Delta_Y_L);
-    unsigned char y_H = ADNS9800_read_register(a, REG_Delta_Y_H);
-    // Recreate full number
-    *deltaX = (x_H << 8) + x_L;
-    *deltaY = (y_H << 8) + y_L;
-    // Get signed value: the value in the registers are 2's complements.
-    // If MSB is 1, the number is negative: flip it and add one.
-    if((*deltaX & (1 << 15)) > 0)
-        *deltaX = *deltaX | ~((1 << 16) - 1);
-    if((*deltaY & (1 << 15)) > 0)
-        *deltaY = *deltaY | ~((1 << 16) - 1);
+    *deltaX = burst.deltaX;
+    *deltaY = burst.deltaY;
 }
 
 void ADNS9800_getMotion(ADNS9800 a, double *deltaX, double *deltaY)
@@ -223,6 +275,12 @@ void ADNS9800_getMotion(ADNS9800 a, double *deltaX, double *deltaY)
 bool ANDS9800_init(ADNS9800 *a, std::string const& portName)
 {
     a->portName = portName;
+    return ANDS9800_init(a, std::make_shared<miam::SpidevTransport>(portName, 800000));
+}
+
+bool ANDS9800_init(ADNS9800 *a, std::shared_ptr<miam::SPITransport> transport)
+{
+    a->transport = transport;
     // Set bus frequency: default 800kHz
     a->frequency = 800000;
 
@@ -259,6 +317,9 @@ bool ANDS9800_init(ADNS9800 *a, std::string const& portName)
     ADNS9800_write_register(*a, REG_LASER_CTRL0, laser_ctrl0 & 0xf0 );
     ADNS9800_write_register(*a, 0x2E, 0b00011111 );
 
+    // Enable motion burst mode: motion is then read with ADNS9800_readMotionBurst.
+    ADNS9800_write_register(*a, REG_Motion_Burst, 0x00);
+
     // Compute sensor resolution: 200dpi * REG_Configuration_I.
     a->resolution = 25.4 / (200.0 * (ADNS9800_read_register(*a, REG_Configuration_I) & 0b00111111));
     return true;
@@ -4,10 +4,12 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <sys/ioctl.h>
 #include <errno.h>
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
@@ -25,17 +27,49 @@ bool i2c_open(I2CAdapter *adapter, std::string const& portName)
     // TODO check that this has an effect.
     ioctl(adapter->file, I2C_RETRIES, 1);
     ioctl(adapter->file, I2C_TIMEOUT, 1);
+
+    adapter->currentSlave = -1;
+    // Check if combined transactions are supported by the adapter.
+    unsigned long functionalities = 0;
+    adapter->isRdwrSupported = ioctl(adapter->file, I2C_FUNCS, &functionalities) >= 0 &&
+                               (functionalities & I2C_FUNC_I2C);
     return true;
 }
 
 
-void changeSlave(int file, unsigned char address)
+// Select the slave with I2C_SLAVE, unless it is already the current one. Must be called with the port mutex locked.
+void changeSlave(I2CAdapter *adapter, unsigned char address)
 {
-    int result = ioctl(file, I2C_SLAVE, address);
-    #ifdef DEBUG
-        if(result < 0)
+    if(adapter->currentSlave == address)
+        return;
+    int result = ioctl(adapter->file, I2C_SLAVE, address);
+    if(result < 0)
+    {
+        #ifdef DEBUG
             std::cout << "I2C: failed to talk to slave " << address << ": " << std::strerror(errno) << std::endl;
-    #endif
+        #endif
+        adapter->currentSlave = -1;
+    }
+    else
+        adapter->currentSlave = address;
+}
+
+
+// Perform a combined transaction. Must be called with the port mutex locked.
+bool performTransaction(I2CAdapter *adapter, struct i2c_msg *messages, int const& nMessages)
+{
+    struct i2c_rdwr_ioctl_data data;
+    data.msgs = messages;
+    data.nmsgs = nMessages;
+    int result = ioctl(adapter->file, I2C_RDWR, &data);
+    if(result != nMessages)
+    {
+        #ifdef DEBUG
+            std::cout << "I2C: combined transaction failed: " << std::strerror(errno) << std::endl;
+        #endif
+        return false;
+    }
+    return true;
 }
 
 
@@ -64,8 +98,21 @@ bool i2c_writeRegisters(I2CAdapter *adapter, unsigned char const& address, unsig
     }
 
     adapter->portMutex.lock();
-    changeSlave(adapter->file, address);
-    int result = write(adapter->file, txbuf, messageLength);
+    int result = 0;
+    if(adapter->isRdwrSupported)
+    {
+        struct i2c_msg message;
+        message.addr = address;
+        message.flags = 0;
+        message.len = messageLength;
+        message.buf = txbuf;
+        result = (performTransaction(adapter, &message, 1) ? messageLength : -1);
+    }
+    else
+    {
+        changeSlave(adapter, address);
+        result = write(adapter->file, txbuf, messageLength);
+    }
     adapter->portMutex.unlock();
     if(result != messageLength)
     {
@@ -96,7 +143,24 @@ bool i2c_readRegisters(I2CAdapter *adapter, unsigned char const& address, unsign
     }
     bool returnValue = true;
     adapter->portMutex.lock();
-    changeSlave(adapter->file, address);
+    if(adapter->isRdwrSupported)
+    {
+        // Register address write and data read, with a repeated start.
+        unsigned char reg = registerAddress;
+        struct i2c_msg messages[2];
+        messages[0].addr = address;
+        messages[0].flags = 0;
+        messages[0].len = 1;
+        messages[0].buf = &reg;
+        messages[1].addr = address;
+        messages[1].flags = I2C_M_RD;
+        messages[1].len = length;
+        messages[1].buf = output;
+        returnValue = performTransaction(adapter, messages, 2);
+        adapter->portMutex.unlock();
+        return returnValue;
+    }
+    changeSlave(adapter, address);
     int result = write(adapter->file, &registerAddress, 1);
     if(result < 0)
     {
@@ -118,6 +182,70 @@ bool i2c_readRegisters(I2CAdapter *adapter, unsigned char const& address, unsign
     return returnValue;
 }
 
+bool i2c_readRegistersBatch(I2CAdapter *adapter, I2CReadRequest *requests, int const& nRequests)
+{
+    if(adapter->file < 0)
+    {
+        #ifdef DEBUG
+            std::cout << "Error reading from I2C port: invalid file descriptor." << std::endl;
+        #endif
+        return false;
+    }
+    if(!adapter->isRdwrSupported)
+    {
+        bool returnValue = true;
+        for(int i = 0; i < nRequests; i++)
+        {
+            requests[i].success = i2c_readRegisters(adapter, requests[i].address, requests[i].registerAddress,
+                                                    requests[i].length, requests[i].output);
+            returnValue &= requests[i].success;
+        }
+        return returnValue;
+    }
+
+    // Each request needs two messages: split the requests into chunks fitting in a single ioctl.
+    int const MAX_REQUESTS = I2C_RDWR_IOCTL_MAX_MSGS / 2;
+    struct i2c_msg messages[2 * MAX_REQUESTS];
+    unsigned char registers[MAX_REQUESTS];
+
+    bool returnValue = true;
+    adapter->portMutex.lock();
+    for(int start = 0; start < nRequests; start += MAX_REQUESTS)
+    {
+        int const nChunkRequests = std::min(nRequests - start, MAX_REQUESTS);
+        for(int i = 0; i < nChunkRequests; i++)
+        {
+            I2CReadRequest const& request = requests[start + i];
+            registers[i] = request.registerAddress;
+            messages[2 * i].addr = request.address;
+            messages[2 * i].flags = 0;
+            messages[2 * i].len = 1;
+            messages[2 * i].buf = &registers[i];
+            messages[2 * i + 1].addr = request.address;
+            messages[2 * i + 1].flags = I2C_M_RD;
+            messages[2 * i + 1].len = request.length;
+            messages[2 * i + 1].buf = request.output;
+        }
+        if(performTransaction(adapter, messages, 2 * nChunkRequests))
+        {
+            for(int i = 0; i < nChunkRequests; i++)
+                requests[start + i].success = true;
+        }
+        else
+        {
+            // Retry each request on its own, to know which one failed.
+            for(int i = 0; i < nChunkRequests; i++)
+            {
+                requests[start + i].success = performTransaction(adapter, &messages[2 * i], 2);
+                returnValue &= requests[start + i].success;
+            }
+        }
+    }
+    adapter->portMutex.unlock();
+    return returnValue;
+}
+
+
 void i2c_close(int device)
 {
     if(device < 0)
@@ -0,0 +1,146 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/I2CPollingService.h"
+
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+namespace miam{
+
+    I2CPollingService::I2CPollingService(I2CAdapter *adapter, int const& maxConsecutiveErrors,
+                                         double const& unhealthyPeriodFactor):
+        adapter_(adapter),
+        maxConsecutiveErrors_(maxConsecutiveErrors),
+        unhealthyPeriodFactor_(unhealthyPeriodFactor),
+        isRunning_(false)
+    {
+    }
+
+
+    I2CPollingService::~I2CPollingService()
+    {
+        stop();
+    }
+
+
+    bool I2CPollingService::addPollFunction(std::string const& name, double const& period,
+                                            std::function<bool(double const&)> const& poll)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(isRunning_ || period <= 0)
+            return false;
+        PolledSensor sensor;
+        sensor.poll = poll;
+        sensor.period = period;
+        sensor.nextPollTime = 0.0;
+        sensor.health.name = name;
+        sensors_.push_back(sensor);
+        return true;
+    }
+
+
+    void I2CPollingService::start()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(isRunning_)
+            return;
+        isRunning_ = true;
+        double const currentTime = getCurrentTime();
+        for(auto & sensor : sensors_)
+            sensor.nextPollTime = currentTime;
+        thread_ = std::thread(&I2CPollingService::pollingLoop, this);
+    }
+
+
+    void I2CPollingService::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isRunning_ = false;
+        }
+        condition_.notify_all();
+        if(thread_.joinable())
+            thread_.join();
+    }
+
+
+    std::vector<I2CSensorHealth> I2CPollingService::getHealth()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<I2CSensorHealth> health;
+        for(auto const& sensor : sensors_)
+            health.push_back(sensor.health);
+        return health;
+    }
+
+
+    I2CAdapter *I2CPollingService::getAdapter() const
+    {
+        return adapter_;
+    }
+
+
+    double I2CPollingService::getCurrentTime()
+    {
+        struct timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+        return currentTime.tv_sec + currentTime.tv_nsec / 1e9;
+    }
+
+
+    void I2CPollingService::pollingLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while(isRunning_)
+        {
+            // Find the sensor with the earliest deadline.
+            PolledSensor *nextSensor = NULL;
+            for(auto & sensor : sensors_)
+                if(nextSensor == NULL || sensor.nextPollTime < nextSensor->nextPollTime)
+                    nextSensor = &sensor;
+            if(nextSensor == NULL)
+            {
+                condition_.wait(lock);
+                continue;
+            }
+
+            // Sleep until its deadline, unless stopped in the meantime.
+            double const waitTime = nextSensor->nextPollTime - getCurrentTime();
+            if(waitTime > 0)
+            {
+                condition_.wait_for(lock, std::chrono::duration<double>(waitTime));
+                continue;
+            }
+
+            // Perform the read without holding the lock: the sensor list is not modified while running.
+            lock.unlock();
+            double const startTime = getCurrentTime();
+            bool const success = nextSensor->poll(startTime);
+            double const endTime = getCurrentTime();
+            lock.lock();
+
+            I2CSensorHealth & health = nextSensor->health;
+            health.nReads++;
+            health.lastReadDuration = endTime - startTime;
+            health.maxReadDuration = std::max(health.maxReadDuration, health.lastReadDuration);
+            if(success)
+            {
+                health.nConsecutiveErrors = 0;
+                health.lastSuccessTime = startTime;
+            }
+            else
+            {
+                health.nErrors++;
+                health.nConsecutiveErrors++;
+            }
+            health.isHealthy = health.nConsecutiveErrors < maxConsecutiveErrors_;
+
+            // Schedule next read. If running late, skip the missed reads instead of trying to catch up.
+            double const period = nextSensor->period * (health.isHealthy ? 1.0 : unhealthyPeriodFactor_);
+            nextSensor->nextPollTime += period;
+            if(nextSensor->nextPollTime < endTime)
+                nextSensor->nextPollTime = endTime;
+        }
+    }
+}
@@ -0,0 +1,202 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/I2CRegisterCache.h"
+
+namespace miam{
+
+    I2CAdapterDevice::I2CAdapterDevice(I2CAdapter *adapter, uint8_t const& address):
+        adapter_(adapter),
+        address_(address)
+    {
+    }
+
+
+    bool I2CAdapterDevice::writeRegisters(uint8_t const& registerAddress, int const& length, uint8_t const *values)
+    {
+        return i2c_writeRegisters(adapter_, address_, registerAddress, length, values);
+    }
+
+
+    bool I2CAdapterDevice::readRegisters(uint8_t const& registerAddress, int const& length, uint8_t *values)
+    {
+        return i2c_readRegisters(adapter_, address_, registerAddress, length, values);
+    }
+
+
+    I2CRegisterCache::I2CRegisterCache(std::shared_ptr<I2CRegisterDevice> device,
+                                       uint8_t const& autoIncrementFlag,
+                                       int const& maximumGap):
+        device_(device),
+        autoIncrementFlag_(autoIncrementFlag),
+        maximumGap_(maximumGap),
+        hasStaged_(false)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            values_[i] = 0;
+            isKnown_[i] = false;
+            isStaged_[i] = false;
+        }
+    }
+
+
+    void I2CRegisterCache::set(uint8_t const& registerAddress, uint8_t const& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(isKnown_[registerAddress] && values_[registerAddress] == value)
+            return;
+        values_[registerAddress] = value;
+        isKnown_[registerAddress] = true;
+        isStaged_[registerAddress] = true;
+        hasStaged_ = true;
+    }
+
+
+    bool I2CRegisterCache::setBits(uint8_t const& registerAddress, uint8_t const& mask, uint8_t const& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint8_t currentValue;
+        if(!getLocked(registerAddress, currentValue))
+            return false;
+        uint8_t const newValue = (currentValue & ~mask) | (value & mask);
+        if(newValue != currentValue)
+        {
+            values_[registerAddress] = newValue;
+            isStaged_[registerAddress] = true;
+            hasStaged_ = true;
+        }
+        return true;
+    }
+
+
+    bool I2CRegisterCache::flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flushLocked();
+    }
+
+
+    bool I2CRegisterCache::flushLocked()
+    {
+        if(!hasStaged_)
+            return true;
+        bool result = true;
+        int start = 0;
+        while(start < 256)
+        {
+            if(!isStaged_[start])
+            {
+                start++;
+                continue;
+            }
+            // Extend the transaction to the next staged registers, if the gap in between is small and known.
+            int end = start;
+            int next = end + 1;
+            while(next < 256)
+            {
+                if(isStaged_[next])
+                {
+                    end = next;
+                }
+                else if(next - end > maximumGap_ || !isKnown_[next])
+                {
+                    break;
+                }
+                next++;
+            }
+
+            int const length = end - start + 1;
+            uint8_t const address = (length > 1 ? start | autoIncrementFlag_ : start);
+            bool const isWritten = device_->writeRegisters(address, length, &values_[start]);
+            for(int i = start; i <= end; i++)
+            {
+                isStaged_[i] = false;
+                if(!isWritten)
+                    isKnown_[i] = false;
+            }
+            result &= isWritten;
+            start = end + 1;
+        }
+        hasStaged_ = false;
+        return result;
+    }
+
+
+    bool I2CRegisterCache::write(uint8_t const& registerAddress, uint8_t const& value)
+    {
+        return write(registerAddress, 1, &value);
+    }
+
+
+    bool I2CRegisterCache::write(uint8_t const& registerAddress, int const& length, uint8_t const *values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(int i = 0; i < length && registerAddress + i < 256; i++)
+        {
+            int const r = registerAddress + i;
+            if(isKnown_[r] && values_[r] == values[i])
+                continue;
+            values_[r] = values[i];
+            isKnown_[r] = true;
+            isStaged_[r] = true;
+            hasStaged_ = true;
+        }
+        return flushLocked();
+    }
+
+
+    bool I2CRegisterCache::get(uint8_t const& registerAddress, uint8_t & value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return getLocked(registerAddress, value);
+    }
+
+
+    bool I2CRegisterCache::getLocked(uint8_t const& registerAddress, uint8_t & value)
+    {
+        if(!isKnown_[registerAddress])
+        {
+            if(!device_->readRegisters(registerAddress, 1, &values_[registerAddress]))
+                return false;
+            isKnown_[registerAddress] = true;
+        }
+        value = values_[registerAddress];
+        return true;
+    }
+
+
+    bool I2CRegisterCache::read(uint8_t const& registerAddress, int const& length, uint8_t *values)
+    {
+        uint8_t const address = (length > 1 ? registerAddress | autoIncrementFlag_ : registerAddress);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return device_->readRegisters(address, length, values);
+    }
+
+
+    bool I2CRegisterCache::writeDirect(uint8_t const& registerAddress, int const& length, uint8_t const *values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return device_->writeRegisters(registerAddress, length, values);
+    }
+
+
+    void I2CRegisterCache::assume(uint8_t const& registerAddress, uint8_t const& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values_[registerAddress] = value;
+        isKnown_[registerAddress] = true;
+        isStaged_[registerAddress] = false;
+    }
+
+
+    void I2CRegisterCache::invalidate()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(int i = 0; i < 256; i++)
+        {
+            isKnown_[i] = false;
+            isStaged_[i] = false;
+        }
+        hasStaged_ = false;
+    }
+}
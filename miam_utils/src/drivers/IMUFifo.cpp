@@ -0,0 +1,349 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/IMUFifo.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+
+    // Header of a recording file.
+    struct IMUFifoRecordingHeader{
+        char magic[8];
+        double outputDataRate;
+        double gyroScaling;
+        double accelScaling;
+    };
+
+    static char const RECORDING_MAGIC[8] = {'M', 'I', 'A', 'M', 'F', 'I', 'F', 'O'};
+
+
+    IMUFifoReplay::IMUFifoReplay(std::vector<int16_t> const& words,
+                                 double const& outputDataRate,
+                                 double const& gyroScaling,
+                                 double const& accelScaling,
+                                 int const& fifoCapacity):
+        words_(words),
+        outputDataRate_(outputDataRate),
+        gyroScaling_(gyroScaling),
+        accelScaling_(accelScaling),
+        fifoCapacity_(fifoCapacity - fifoCapacity % IMU_FIFO_PATTERN_LENGTH),
+        time_(0.0),
+        readIndex_(0),
+        writeIndex_(0),
+        isOverrun_(false)
+    {
+    }
+
+
+    bool IMUFifoReplay::loadRecording(std::string const& filename,
+                                      std::vector<int16_t> & words,
+                                      double & outputDataRate,
+                                      double & gyroScaling,
+                                      double & accelScaling)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if(!file.good())
+            return false;
+        IMUFifoRecordingHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if(!file.good() || !std::equal(RECORDING_MAGIC, RECORDING_MAGIC + 8, header.magic))
+            return false;
+        outputDataRate = header.outputDataRate;
+        gyroScaling = header.gyroScaling;
+        accelScaling = header.accelScaling;
+
+        words.clear();
+        int16_t word;
+        while(file.read(reinterpret_cast<char*>(&word), sizeof(word)))
+            words.push_back(word);
+        return true;
+    }
+
+
+    void IMUFifoReplay::advance(double const& dt)
+    {
+        time_ += dt;
+        int const nAcquiredSamples = static_cast<int>(std::floor(time_ * outputDataRate_ + 1e-9));
+        writeIndex_ = std::min(static_cast<int>(words_.size()), IMU_FIFO_PATTERN_LENGTH * nAcquiredSamples);
+        // Drop the oldest samples on overrun.
+        if(writeIndex_ - readIndex_ > fifoCapacity_)
+        {
+            int const nLostWords = writeIndex_ - readIndex_ - fifoCapacity_;
+            readIndex_ += IMU_FIFO_PATTERN_LENGTH * ((nLostWords + IMU_FIFO_PATTERN_LENGTH - 1) / IMU_FIFO_PATTERN_LENGTH);
+            isOverrun_ = true;
+        }
+    }
+
+
+    bool IMUFifoReplay::isFinished() const
+    {
+        return writeIndex_ >= static_cast<int>(words_.size());
+    }
+
+
+    bool IMUFifoReplay::readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun)
+    {
+        nUnreadWords = writeIndex_ - readIndex_;
+        pattern = readIndex_ % IMU_FIFO_PATTERN_LENGTH;
+        isOverrun = isOverrun_;
+        isOverrun_ = false;
+        return true;
+    }
+
+
+    bool IMUFifoReplay::readFifoWords(int16_t *words, int const& nWords)
+    {
+        if(nWords > writeIndex_ - readIndex_)
+            return false;
+        std::copy(words_.begin() + readIndex_, words_.begin() + readIndex_ + nWords, words);
+        readIndex_ += nWords;
+        return true;
+    }
+
+
+    double IMUFifoReplay::getOutputDataRate() const
+    {
+        return outputDataRate_;
+    }
+
+
+    double IMUFifoReplay::getGyroScaling() const
+    {
+        return gyroScaling_;
+    }
+
+
+    double IMUFifoReplay::getAccelScaling() const
+    {
+        return accelScaling_;
+    }
+
+
+    IMUFifoRecorder::IMUFifoRecorder(std::shared_ptr<IMUFifoSource> source, std::string const& filename):
+        source_(source),
+        file_(filename, std::ios::binary),
+        pattern_(0),
+        isAligned_(false)
+    {
+        IMUFifoRecordingHeader header;
+        std::copy(RECORDING_MAGIC, RECORDING_MAGIC + 8, header.magic);
+        header.outputDataRate = source_->getOutputDataRate();
+        header.gyroScaling = source_->getGyroScaling();
+        header.accelScaling = source_->getAccelScaling();
+        file_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    }
+
+
+    bool IMUFifoRecorder::readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun)
+    {
+        bool result = source_->readFifoStatus(nUnreadWords, pattern, isOverrun);
+        if(result)
+            pattern_ = pattern;
+        return result;
+    }
+
+
+    bool IMUFifoRecorder::readFifoWords(int16_t *words, int const& nWords)
+    {
+        if(!source_->readFifoWords(words, nWords))
+            return false;
+        // Only record from the start of a pattern, so that the recording is aligned.
+        for(int i = 0; i < nWords; i++)
+        {
+            if(pattern_ == 0)
+                isAligned_ = true;
+            if(isAligned_)
+                file_.write(reinterpret_cast<char const*>(&words[i]), sizeof(int16_t));
+            pattern_ = (pattern_ + 1) % IMU_FIFO_PATTERN_LENGTH;
+        }
+        file_.flush();
+        return true;
+    }
+
+
+    double IMUFifoRecorder::getOutputDataRate() const
+    {
+        return source_->getOutputDataRate();
+    }
+
+
+    double IMUFifoRecorder::getGyroScaling() const
+    {
+        return source_->getGyroScaling();
+    }
+
+
+    double IMUFifoRecorder::getAccelScaling() const
+    {
+        return source_->getAccelScaling();
+    }
+
+
+    IMUFifoSampler::IMUFifoSampler(std::shared_ptr<IMUFifoSource> source,
+                                   int const& maxBurstSamples,
+                                   int const& maxSamplesPerUpdate):
+        source_(source),
+        maxBurstSamples_(std::max(1, maxBurstSamples)),
+        maxSamplesPerUpdate_(std::max(1, maxSamplesPerUpdate)),
+        buffer_(IMU_FIFO_PATTERN_LENGTH * std::max(1, maxBurstSamples)),
+        isTimeAnchored_(false),
+        firstSampleTime_(0.0),
+        nSamples_(0),
+        nOverruns_(0),
+        heading_(0.0),
+        headingAtLastIncrement_(0.0),
+        isEstimatingBias_(false),
+        nBiasSamples_(0)
+    {
+        samples_.reserve(maxSamplesPerUpdate_);
+    }
+
+
+    int IMUFifoSampler::update(double const& currentTime)
+    {
+        samples_.clear();
+
+        int nUnreadWords, pattern;
+        bool isOverrun;
+        if(!source_->readFifoStatus(nUnreadWords, pattern, isOverrun))
+            return -1;
+        if(isOverrun)
+        {
+            // Samples were lost: timestamps can no longer be deduced from the sample count.
+            nOverruns_++;
+            isTimeAnchored_ = false;
+        }
+
+        // Discard a partial pattern, if the FIFO is not aligned.
+        if(pattern != 0 && nUnreadWords > 0)
+        {
+            int const nSkippedWords = std::min(nUnreadWords, IMU_FIFO_PATTERN_LENGTH - pattern);
+            if(!source_->readFifoWords(buffer_.data(), nSkippedWords))
+                return -1;
+            nUnreadWords -= nSkippedWords;
+        }
+
+        int nNewSamples = std::min(nUnreadWords / IMU_FIFO_PATTERN_LENGTH, maxSamplesPerUpdate_);
+        if(nNewSamples == 0)
+            return 0;
+
+        // Timestamps: the newest sample was acquired just before currentTime.
+        double const period = 1.0 / source_->getOutputDataRate();
+        if(isTimeAnchored_)
+        {
+            // Compare the timestamp of the newest sample read to currentTime: the difference should be between 0
+            // and one period, plus the time corresponding to the samples left in the FIFO.
+            double const newestTime = firstSampleTime_ + (nSamples_ + nNewSamples - 1) * period;
+            double const expectedLag = (nUnreadWords / IMU_FIFO_PATTERN_LENGTH - nNewSamples) * period;
+            double const error = currentTime - newestTime - expectedLag;
+            if(error < 0)
+                // Sensor clock faster than nominal: timestamps must not be in the future.
+                firstSampleTime_ += error;
+            else if(error > 10 * period)
+                isTimeAnchored_ = false;
+            else if(error > period)
+                // Sensor clock slower than nominal: slowly catch up.
+                firstSampleTime_ += 0.1 * (error - period);
+        }
+        if(!isTimeAnchored_)
+        {
+            firstSampleTime_ = currentTime - (nUnreadWords / IMU_FIFO_PATTERN_LENGTH - 1) * period;
+            nSamples_ = 0;
+            isTimeAnchored_ = true;
+        }
+
+        double const gyroScaling = source_->getGyroScaling();
+        double const accelScaling = source_->getAccelScaling();
+        int nRemainingSamples = nNewSamples;
+        while(nRemainingSamples > 0)
+        {
+            int const nBurstSamples = std::min(nRemainingSamples, maxBurstSamples_);
+            if(!source_->readFifoWords(buffer_.data(), nBurstSamples * IMU_FIFO_PATTERN_LENGTH))
+                return -1;
+            for(int i = 0; i < nBurstSamples; i++)
+            {
+                int16_t const *words = &buffer_[IMU_FIFO_PATTERN_LENGTH * i];
+                IMUSample sample;
+                sample.timestamp = firstSampleTime_ + nSamples_ * period;
+                sample.gyro.x = words[0] * gyroScaling;
+                sample.gyro.y = words[1] * gyroScaling;
+                sample.gyro.z = words[2] * gyroScaling;
+                sample.accel.x = words[3] * accelScaling;
+                sample.accel.y = words[4] * accelScaling;
+                sample.accel.z = words[5] * accelScaling;
+                samples_.push_back(sample);
+                nSamples_++;
+
+                heading_ += (sample.gyro.z - gyroBias_.z) * period;
+                if(isEstimatingBias_)
+                {
+                    biasSum_.x += sample.gyro.x;
+                    biasSum_.y += sample.gyro.y;
+                    biasSum_.z += sample.gyro.z;
+                    nBiasSamples_++;
+                }
+            }
+            nRemainingSamples -= nBurstSamples;
+        }
+        return nNewSamples;
+    }
+
+
+    std::vector<IMUSample> const& IMUFifoSampler::getLastSamples() const
+    {
+        return samples_;
+    }
+
+
+    double IMUFifoSampler::getHeadingIncrement()
+    {
+        double const increment = heading_ - headingAtLastIncrement_;
+        headingAtLastIncrement_ = heading_;
+        return increment;
+    }
+
+
+    double IMUFifoSampler::getHeading() const
+    {
+        return heading_;
+    }
+
+
+    void IMUFifoSampler::startBiasEstimation()
+    {
+        isEstimatingBias_ = true;
+        biasSum_ = vector3D();
+        nBiasSamples_ = 0;
+    }
+
+
+    bool IMUFifoSampler::stopBiasEstimation()
+    {
+        isEstimatingBias_ = false;
+        if(nBiasSamples_ == 0)
+            return false;
+        gyroBias_.x = biasSum_.x / nBiasSamples_;
+        gyroBias_.y = biasSum_.y / nBiasSamples_;
+        gyroBias_.z = biasSum_.z / nBiasSamples_;
+        return true;
+    }
+
+
+    vector3D IMUFifoSampler::getGyroBias() const
+    {
+        return gyroBias_;
+    }
+
+
+    void IMUFifoSampler::setGyroBias(vector3D const& bias)
+    {
+        gyroBias_ = bias;
+    }
+
+
+    int IMUFifoSampler::getNumberOfOverruns() const
+    {
+        return nOverruns_;
+    }
+}
@@ -5,7 +5,8 @@
 #include <cmath>
 
 IMUV5::IMUV5():
-    isInit_(false)
+    isInit_(false),
+    outputDataRate_(833.0)
 {
     // Empty
 }
@@ -38,6 +39,7 @@ bool IMUV5::init(I2CAdapter *device, bool turnOnMagneto, bool jumperShorted)
     // CTRL2: gyro ODR 833Hz, 250dps scale
     i2c_writeRegister(adapter_, gyroAddress_, 0x11, 0b01110000);
     gyroScaling_ = 0.00875 * M_PI / 180.0;
+    outputDataRate_ = 833.0;
     // CTRL3: enable BDU
     i2c_writeRegister(adapter_, gyroAddress_, 0x12, 0b01000100);
     // CTRL4: accel anti-aliasing configured by CTRL1
@@ -149,3 +151,94 @@ vector3D IMUV5::getMagnetometerReadings()
     return readings;
 }
 
+
+bool IMUV5::enableFifo(int const& outputDataRate)
+{
+    if (!isInit_)
+        return false;
+    // ODR register value, identical for accelerometer, gyroscope and FIFO.
+    unsigned char odr;
+    switch (outputDataRate)
+    {
+        case 104: odr = 0b0100; break;
+        case 208: odr = 0b0101; break;
+        case 416: odr = 0b0110; break;
+        case 833: odr = 0b0111; break;
+        case 1660: odr = 0b1000; break;
+        default: return false;
+    }
+    outputDataRate_ = outputDataRate;
+
+    // Bypass mode: empties the FIFO.
+    i2c_writeRegister(adapter_, gyroAddress_, 0x0A, 0b00000000);
+
+    // CTRL1 / CTRL2: same ranges as in init, new ODR.
+    i2c_writeRegister(adapter_, gyroAddress_, 0x10, odr << 4);
+    i2c_writeRegister(adapter_, gyroAddress_, 0x11, odr << 4);
+
+    // FIFO_CTRL1, FIFO_CTRL2: no threshold, timestamp and pedometer not in FIFO.
+    i2c_writeRegister(adapter_, gyroAddress_, 0x06, 0x00);
+    i2c_writeRegister(adapter_, gyroAddress_, 0x07, 0x00);
+    // FIFO_CTRL3: gyroscope and accelerometer in FIFO, no decimation.
+    i2c_writeRegister(adapter_, gyroAddress_, 0x08, 0b00001001);
+    // FIFO_CTRL4: no third / fourth data set.
+    i2c_writeRegister(adapter_, gyroAddress_, 0x09, 0x00);
+    // FIFO_CTRL5: FIFO ODR, continuous mode.
+    return i2c_writeRegister(adapter_, gyroAddress_, 0x0A, (odr << 3) | 0b110);
+}
+
+
+void IMUV5::disableFifo()
+{
+    if (isInit_)
+        i2c_writeRegister(adapter_, gyroAddress_, 0x0A, 0b00000000);
+}
+
+
+bool IMUV5::readFifoStatus(int & nUnreadWords, int & pattern, bool & isOverrun)
+{
+    if (!isInit_)
+        return false;
+    // FIFO_STATUS1 to FIFO_STATUS4.
+    unsigned char rxbuf[4];
+    if (!i2c_readRegisters(adapter_, gyroAddress_, 0x3A, 4, rxbuf))
+        return false;
+    nUnreadWords = rxbuf[0] + ((rxbuf[1] & 0x0F) << 8);
+    isOverrun = (rxbuf[1] & 0b01000000) > 0;
+    pattern = rxbuf[2] + ((rxbuf[3] & 0x03) << 8);
+    return true;
+}
+
+
+bool IMUV5::readFifoWords(int16_t *words, int const& nWords)
+{
+    if (!isInit_)
+        return false;
+    // Multiple-byte read of FIFO_DATA_OUT: the register address rolls back from FIFO_DATA_OUT_H to
+    // FIFO_DATA_OUT_L, so the whole burst is read in a single transaction.
+    unsigned char *rxbuf = reinterpret_cast<unsigned char*>(words);
+    if (!i2c_readRegisters(adapter_, gyroAddress_, 0x3E, 2 * nWords, rxbuf))
+        return false;
+    // Data is little-endian: convert in place.
+    for (int i = 0; i < nWords; i++)
+        words[i] = static_cast<int16_t>(rxbuf[2 * i] + (rxbuf[2 * i + 1] << 8));
+    return true;
+}
+
+
+double IMUV5::getOutputDataRate() const
+{
+    return outputDataRate_;
+}
+
+
+double IMUV5::getGyroScaling() const
+{
+    return gyroScaling_;
+}
+
+
+double IMUV5::getAccelScaling() const
+{
+    return accelScaling_;
+}
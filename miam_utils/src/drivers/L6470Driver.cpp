@@ -1,38 +1,54 @@
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #include "miam_utils/drivers/L6470Driver.h"
-#include "miam_utils/drivers/SPI-Wrapper.h"
 
-#include <sys/ioctl.h>
-#include <linux/spi/spidev.h>
 #include <errno.h>
 #include <unistd.h>
 #include <cmath>
 
 #include <iostream>
 #include <cstring>
-#include <cmath>
+#include <algorithm>
 
 // Register definition and utility function for parameter length.
 #include "L6470Registers.h"
 
 namespace miam
 {
+    // Convert ABS_POS register value (22 bits, 2s complement) to a signed number of microsteps.
+    static int32_t absPosToSteps(uint32_t const& value)
+    {
+        int32_t v = value;
+        // 2s complement
+        if(v > 0x1FFFFF)
+            v = v + 0xFFC00000;
+        return v;
+    }
+
     L6470::L6470():
-        portName_(""),
+        transport_(),
         numberOfDevices_(0),
         frequency_(0),
-        stepModeMultiplier_(1.0)
+        stepModeMultiplier_(1.0),
+        isSpeedCacheValid_(false)
     {
 
     }
 
 
     L6470::L6470(std::string const& portName, int const& numberOfDevices, int const& busFrequency):
-        portName_(portName),
-        numberOfDevices_(std::abs(numberOfDevices)),
+        L6470(std::make_shared<SpidevTransport>(portName, std::abs(busFrequency)), numberOfDevices, busFrequency)
+    {
+
+    }
+
+
+    L6470::L6470(std::shared_ptr<SPITransport> transport, int const& numberOfDevices, int const& busFrequency):
+        transport_(transport),
+        numberOfDevices_(std::min(std::abs(numberOfDevices), L6470_MAX_DEVICES)),
         frequency_(std::abs(busFrequency)),
-        stepModeMultiplier_(1.0)
+        stepModeMultiplier_(1.0),
+        isSpeedCacheValid_(false)
     {
 
     }
@@ -40,10 +56,11 @@ namespace miam
 
     L6470& L6470::operator=(L6470 const& l)
     {
-        portName_ = l.portName_;
+        transport_ = l.transport_;
         numberOfDevices_ = l.numberOfDevices_;
         frequency_ = l.frequency_;
         stepModeMultiplier_ = l.stepModeMultiplier_;
+        isSpeedCacheValid_ = false;
         return *this;
     }
 
@@ -106,32 +123,54 @@ namespace miam
 
     void L6470::setParam(uint8_t const& param, std::vector<uint32_t> const& parameterValues)
     {
-        std::vector<uint8_t> commands;
+        if(parameterValues.size() != numberOfDevices_)
+            return;
+        uint8_t commands[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
-            commands.push_back(dSPIN_SET_PARAM | param);
-        sendCommand(commands, parameterValues, getParamLength(param));
+            commands[i] = dSPIN_SET_PARAM | param;
+        invalidateSpeedCache();
+        sendCommand(commands, parameterValues.data(), getParamLength(param), NULL);
     }
 
 
     void L6470::setParam(uint8_t const& param, uint32_t const& parameterValue)
     {
-        std::vector<uint32_t> values;
+        uint8_t commands[L6470_MAX_DEVICES];
+        uint32_t values[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
-            values.push_back(parameterValue);
-        setParam(param, values);
+        {
+            commands[i] = dSPIN_SET_PARAM | param;
+            values[i] = parameterValue;
+        }
+        invalidateSpeedCache();
+        sendCommand(commands, values, getParamLength(param), NULL);
     }
 
 
     std::vector<uint32_t> L6470::getParam(uint8_t const& param)
     {
-        std::vector<uint8_t> commands;
-        std::vector<uint32_t> parameterValue;
+        std::vector<uint32_t> parameterValues(numberOfDevices_, 0);
+        getParam(param, parameterValues.data());
+        return parameterValues;
+    }
+
+
+    void L6470::getParam(uint8_t const& param, uint32_t *parameterValues)
+    {
+        uint8_t commands[L6470_MAX_DEVICES];
+        uint32_t parameters[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
         {
-            commands.push_back(dSPIN_GET_PARAM | param);
-            parameterValue.push_back(0.0);
+            commands[i] = dSPIN_GET_PARAM | param;
+            parameters[i] = 0;
         }
-        return sendCommand(commands, parameterValue, getParamLength(param));
+        sendCommand(commands, parameters, getParamLength(param), parameterValues);
+    }
+
+
+    int L6470::getNumberOfDevices() const
+    {
+        return numberOfDevices_;
     }
 
 
@@ -162,58 +201,85 @@ namespace miam
 
     std::vector<double> L6470::getPosition()
     {
-        std::vector<double> positions;
+        std::vector<double> positions(numberOfDevices_, 0.0);
+        getPosition(positions.data());
+        return positions;
+    }
 
-        std::vector<uint32_t> value = getParam(dSPIN_ABS_POS);
-        for(uint i = 0; i < numberOfDevices_; i++)
-        {
-            int32_t v = value[i];
-            // 2s complement
-            if(v > 0x1FFFFF)
-                v = v + 0xFFC00000;
 
-            positions.push_back(v / stepModeMultiplier_);
-        }
-        return positions;
+    void L6470::getPosition(double *positions)
+    {
+        uint32_t value[L6470_MAX_DEVICES];
+        getParam(dSPIN_ABS_POS, value);
+        for(uint i = 0; i < numberOfDevices_; i++)
+            positions[i] = absPosToSteps(value[i]) / stepModeMultiplier_;
     }
 
 
     std::vector<double> L6470::getSpeed()
     {
-        std::vector<uint32_t> value = getParam(dSPIN_SPEED);
+        std::vector<double> speeds(numberOfDevices_, 0.0);
+        getSpeed(speeds.data());
+        return speeds;
+    }
+
+
+    void L6470::getSpeed(double *speeds)
+    {
+        uint32_t value[L6470_MAX_DEVICES];
+        getParam(dSPIN_SPEED, value);
         // Register value to steps/s.
-        std::vector<double> speeds;
         for(uint i = 0; i < numberOfDevices_; i++)
-            speeds.push_back(value[i] / STEPSEC_TO_VELOCITY_REG);
-        return speeds;
+            speeds[i] = value[i] / STEPSEC_TO_VELOCITY_REG;
     }
 
 
     void L6470::setSpeed(std::vector<double> const& motorSpeeds)
     {
-        std::vector<uint8_t> commands;
-        std::vector<uint32_t> parameters;
-        // Fill command and parameters registers.
+        // Pad with zeros if the vector is too short.
+        double speeds[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
         {
-            double speed = 0.0;
+            speeds[i] = 0.0;
             if(i < motorSpeeds.size())
-                speed = motorSpeeds[i];
+                speeds[i] = motorSpeeds[i];
+        }
+        setSpeed(speeds);
+    }
 
-            // Command: run. Direction is indicated there.
-            uint8_t command = dSPIN_RUN;
-            if(speed >= 0.0)
-                command |= 1;
-            commands.push_back(command);
 
-            // Register value.
-            uint32_t registerValue = (std::abs(speed) * STEPSEC_TO_VELOCITY_REG) + 0.5;
-            // Clamp
-            if(registerValue > 0xFFFFF)
-                registerValue = 0xFFFFF;
-            parameters.push_back(registerValue);
+    void L6470::setSpeed(double const *motorSpeeds)
+    {
+        uint8_t commands[L6470_MAX_DEVICES];
+        uint32_t parameters[L6470_MAX_DEVICES];
+        // Fill command and parameters registers.
+        for(uint i = 0; i < numberOfDevices_; i++)
+            speedToRunCommand(motorSpeeds[i], commands[i], parameters[i]);
+
+        mutex_.lock();
+        sendCommand(commands, parameters, getParamLength(dSPIN_SPEED), NULL);
+        for(uint i = 0; i < numberOfDevices_; i++)
+        {
+            lastRunCommand_[i] = commands[i];
+            lastRunSpeed_[i] = parameters[i];
         }
-        sendCommand(commands, parameters, getParamLength(dSPIN_SPEED));
+        isSpeedCacheValid_ = true;
+        mutex_.unlock();
+    }
+
+
+    void L6470::speedToRunCommand(double const& speed, uint8_t & command, uint32_t & registerValue)
+    {
+        // Command: run. Direction is indicated there.
+        command = dSPIN_RUN;
+        if(speed >= 0.0)
+            command |= 1;
+
+        // Register value.
+        registerValue = (std::abs(speed) * STEPSEC_TO_VELOCITY_REG) + 0.5;
+        // Clamp
+        if(registerValue > 0xFFFFF)
+            registerValue = 0xFFFFF;
     }
 
 
@@ -249,71 +315,89 @@ namespace miam
 
     std::vector<uint32_t> L6470::getError()
     {
-        std::vector<uint32_t> status = getStatus();
-        std::vector<uint32_t> errors;
+        std::vector<uint32_t> errors(numberOfDevices_, 0);
+        getError(errors.data());
+        return errors;
+    }
+
+
+    void L6470::getError(uint32_t *errors)
+    {
+        uint32_t status[L6470_MAX_DEVICES];
+        getStatus(status);
+        decodeErrors(status, errors);
+    }
+
+
+    void L6470::decodeErrors(uint32_t const *status, uint32_t *errors)
+    {
         for(uint i = 0; i < numberOfDevices_; i++)
         {
-            uint32_t error = 0.0;
-            std::string errorMessage = "";
+            uint32_t error = 0;
+            // Error messages are stored as static strings, to avoid any allocation when no error is present.
+            char const *errorMessage[5];
+            int nMessages = 0;
 
             // Not perf cmd is active high, not active low.
             if((status[i] & dSPIN_STATUS_NOTPERF_CMD) != 0)
             {
                 error |= dSPIN_ERR_NOEXEC;
-                errorMessage += "Cmd no exec ";
+                errorMessage[nMessages++] = "Cmd no exec ";
             }
 
             // Wrong cmd is active high, not active low.
             if((status[i] & dSPIN_STATUS_WRONG_CMD) != 0)
             {
                 error |= dSPIN_ERR_BADCMD;
-                errorMessage += "Bad cmd ";
+                errorMessage[nMessages++] = "Bad cmd ";
             }
 
             if((status[i] & dSPIN_STATUS_UVLO) == 0)
             {
                 error |= dSPIN_ERR_UVLO;
-                errorMessage += "Undervoltage ";
+                errorMessage[nMessages++] = "Undervoltage ";
             }
 
             if((status[i] & dSPIN_STATUS_TH_SD) == 0)
             {
                 error |= dSPIN_ERR_THSHTD;
-                errorMessage += "Thermal shutdown ";
+                errorMessage[nMessages++] = "Thermal shutdown ";
             }
 
             if((status[i] & dSPIN_STATUS_OCD) == 0)
             {
                 error |= dSPIN_ERR_OVERC;
-                errorMessage += "Overcurrent ";
+                errorMessage[nMessages++] = "Overcurrent ";
             }
 
             if((status[i] & dSPIN_STATUS_STEP_LOSS_A) == 0)
             {
                 // Stall is non-verbose as too frequent.
                 error |= dSPIN_ERR_STALLA;
-                // errorMessage += "Stall A ";
             }
 
             if((status[i] & dSPIN_STATUS_STEP_LOSS_B) == 0)
             {
                 // Stall is non-verbose as too frequent.
                 error |= dSPIN_ERR_STALLB;
-                // errorMessage += "Stall B ";
             }
 
-
-            if(errorMessage.length() > 0)
-                std::cout <<  "dualL6470: " << i << " controller error: " << errorMessage << std::endl;
-            errors.push_back(error);
+            if(nMessages > 0)
+            {
+                std::cout <<  "L6470: " << i << " controller error: ";
+                for(int j = 0; j < nMessages; j++)
+                    std::cout << errorMessage[j];
+                std::cout << std::endl;
+            }
+            errors[i] = error;
         }
-        return errors;
     }
 
 
     bool L6470::isBusy()
     {
-        std::vector<uint32_t> status = getStatus();
+        uint32_t status[L6470_MAX_DEVICES];
+        getStatus(status);
         bool busy = false;
         for(uint i = 0; i < numberOfDevices_; i++)
         {
@@ -330,8 +414,8 @@ namespace miam
 
     void L6470::moveNSteps(std::vector<double> nSteps)
     {
-        std::vector<uint8_t> commands;
-        std::vector<uint32_t> parameters;
+        uint8_t commands[L6470_MAX_DEVICES];
+        uint32_t parameters[L6470_MAX_DEVICES];
         // Fill command and parameters registers.
         for(uint i = 0; i < numberOfDevices_; i++)
         {
@@ -343,111 +427,246 @@ namespace miam
             uint8_t command = dSPIN_MOVE;
             if(nStep >= 0)
                 command |= 1;
-            commands.push_back(command);
+            commands[i] = command;
 
             // Register value.
-            uint32_t registerValue = static_cast<uint32_t>(std::abs(nSteps[i] * stepModeMultiplier_));
+            uint32_t registerValue = static_cast<uint32_t>(std::abs(nStep * stepModeMultiplier_));
             // Clamp
             if(registerValue > 0x3FFFFF)
                 registerValue = 0x3FFFFF;
-            parameters.push_back(registerValue);
+            parameters[i] = registerValue;
         }
-        sendCommand(commands, parameters, getParamLength(dSPIN_ABS_POS));
+        invalidateSpeedCache();
+        sendCommand(commands, parameters, getParamLength(dSPIN_ABS_POS), NULL);
     }
 
 
     int L6470::spiReadWrite(uint8_t* data, uint8_t const& len)
     {
-        // len represent total message size: split it in packets of numberOfDevices_
+        // len represent total message size: split it in packets of numberOfDevices_, each packet containing one byte
+        // for each device of the chain.
+        if(numberOfDevices_ == 0 || !transport_)
+            return -1;
         uint8_t nPackets = len / numberOfDevices_;
+        if(nPackets == 0 || nPackets > L6470_MAX_EXCHANGE_LENGTH)
+            return -1;
         mutex_.lock();
-        int port = spi_open(portName_, frequency_);
-
-        struct spi_ioc_transfer spiCtrl[nPackets];
-        // Transmit data in blocks of 2, since two controllers are daisy-chained.
-        // This can easily be changed to handle more controllers, but this requires API rethinking.
+        struct spi_ioc_transfer spiCtrl[L6470_MAX_EXCHANGE_LENGTH];
+        std::memset(spiCtrl, 0, sizeof(spiCtrl));
         for(int x = 0; x < nPackets; x++)
         {
-            spiCtrl[x].tx_buf        = (unsigned long)&data[2 * x];
-            spiCtrl[x].rx_buf        = (unsigned long)&data[2 * x];
+            spiCtrl[x].tx_buf        = (unsigned long)&data[numberOfDevices_ * x];
+            spiCtrl[x].rx_buf        = (unsigned long)&data[numberOfDevices_ * x];
             spiCtrl[x].len           = numberOfDevices_;
             spiCtrl[x].delay_usecs   = 1;
             spiCtrl[x].speed_hz      = frequency_;
             spiCtrl[x].bits_per_word = 8;
             spiCtrl[x].cs_change = true;
-            spiCtrl[x].pad = 0;
-            spiCtrl[x].tx_nbits = 0;
-            spiCtrl[x].rx_nbits = 0;
         }
-        int res = ioctl(port, SPI_IOC_MESSAGE(nPackets), &spiCtrl);
-        spi_close(port);
+        int res = transport_->transfer(spiCtrl, nPackets);
         mutex_.unlock();
 
         return res;
     }
 
 
-    std::vector<uint32_t> L6470::sendCommand(std::vector<uint8_t> const& commands, std::vector<uint32_t> const& parameters, uint8_t paramLength)
+    void L6470::sendCommand(uint8_t const *commands, uint32_t const *parameters, uint8_t const& paramLength, uint32_t *response)
     {
-        std::vector<uint32_t> response;
-        for(uint i = 0; i < numberOfDevices_; i++)
-            response.push_back(0.0);
+        if(response != NULL)
+            for(uint i = 0; i < numberOfDevices_; i++)
+                response[i] = 0;
 
-        // Check length of input vector
-        if(commands.size() != numberOfDevices_)
-            return response;
-        if(paramLength > 0)
-            if(parameters.size() != numberOfDevices_)
-                return response;
+        // Create data buffer to send.
+        uint8_t data[L6470_MAX_DEVICES * L6470_MAX_FRAME_LENGTH];
+        packCommand(data, commands, parameters, paramLength);
 
-        // Create data vector to send.
-        uint8_t data[numberOfDevices_ * (1 + paramLength)];
+        // Do SPI communication
+        int result = spiReadWrite(data, numberOfDevices_ * (1 + paramLength));
+        #ifdef DEBUG
+            if(result < 0)
+                std::cout << "L6470 SPI error: " << errno << " " << std::strerror(errno) << std::endl;
+        #endif
+        if(result < 0 || response == NULL)
+            return;
+
+        unpackResponse(data, paramLength, response);
+    }
+
+
+    void L6470::packCommand(uint8_t *data, uint8_t const *commands, uint32_t const *parameters, uint8_t const& paramLength)
+    {
         // Fill buffer with given input data
         for(uint i = 0; i < numberOfDevices_; i++)
             data[i] = commands[i];
         for(int i = paramLength - 1; i >= 0; i--)
         {
             for(uint j = 0; j < numberOfDevices_; j++)
-                data[numberOfDevices_ * (paramLength - i) + j] = (parameters.at(j) >> (8 * i)) & 0xFF;
+                data[numberOfDevices_ * (paramLength - i) + j] = (parameters[j] >> (8 * i)) & 0xFF;
         }
+    }
 
-        // Do SPI communication
-        int result = spiReadWrite(data, numberOfDevices_ * (1 + paramLength));
-        #ifdef DEBUG
-            if(result < 0)
-                std::cout << "L6470 SPI error: " << errno << " " << std::strerror(errno) << std::endl;
-        #endif
-        // Decode response.
 
+    void L6470::unpackResponse(uint8_t const *data, uint8_t const& paramLength, uint32_t *response)
+    {
+        for(uint j = 0; j < numberOfDevices_; j++)
+            response[j] = 0;
         for(uint8_t i = 1; i <= paramLength; i++)
         {
             for(uint j = 0; j < numberOfDevices_; j++)
-                response.at(j)  += data[numberOfDevices_ * i + j] << (8 * (paramLength - i));
+                response[j] += data[numberOfDevices_ * i + j] << (8 * (paramLength - i));
         }
-        return response;
     }
 
 
     void L6470::sendCommand(uint8_t const& command)
     {
-        std::vector<uint8_t> commands;
+        uint8_t commands[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
-            commands.push_back(command);
-        std::vector<uint32_t> parameters;
-        sendCommand(commands, parameters, 0.0);
+            commands[i] = command;
+        invalidateSpeedCache();
+        sendCommand(commands, NULL, 0, NULL);
     }
 
 
-    std::vector<uint32_t> L6470::getStatus()
+    void L6470::invalidateSpeedCache()
     {
+        mutex_.lock();
+        isSpeedCacheValid_ = false;
+        mutex_.unlock();
+    }
+
 
-        std::vector<uint8_t> commands;
-        std::vector<uint32_t> params;
+    void L6470::getStatus(uint32_t *status)
+    {
+        uint8_t commands[L6470_MAX_DEVICES];
+        uint32_t params[L6470_MAX_DEVICES];
         for(uint i = 0; i < numberOfDevices_; i++)
         {
-            commands.push_back(dSPIN_GET_STATUS);
-            params.push_back(0);
+            commands[i] = dSPIN_GET_STATUS;
+            params[i] = 0;
+        }
+        sendCommand(commands, params, getParamLength(dSPIN_STATUS), status);
+    }
+
+
+    int L6470::exchange(double const *motorSpeeds, double *positions, uint32_t *errors)
+    {
+        uint8_t const statusLength = getParamLength(dSPIN_STATUS);
+        uint8_t const positionLength = getParamLength(dSPIN_ABS_POS);
+        uint8_t const speedLength = getParamLength(dSPIN_SPEED);
+
+        uint8_t commands[L6470_MAX_DEVICES] = {0};
+        uint32_t parameters[L6470_MAX_DEVICES] = {0};
+        uint8_t data[L6470_MAX_DEVICES * L6470_MAX_EXCHANGE_LENGTH];
+        int length = 0;
+
+        mutex_.lock();
+        // Status read.
+        int statusOffset = -1;
+        if(errors != NULL)
+        {
+            for(uint i = 0; i < numberOfDevices_; i++)
+            {
+                commands[i] = dSPIN_GET_STATUS;
+                parameters[i] = 0;
+            }
+            statusOffset = length;
+            packCommand(&data[length], commands, parameters, statusLength);
+            length += numberOfDevices_ * (1 + statusLength);
         }
-        return sendCommand(commands, params, getParamLength(dSPIN_STATUS));
+
+        // Position read.
+        int positionOffset = -1;
+        if(positions != NULL)
+        {
+            for(uint i = 0; i < numberOfDevices_; i++)
+            {
+                commands[i] = dSPIN_GET_PARAM | dSPIN_ABS_POS;
+                parameters[i] = 0;
+            }
+            positionOffset = length;
+            packCommand(&data[length], commands, parameters, positionLength);
+            length += numberOfDevices_ * (1 + positionLength);
+        }
+
+        // Speed command: only send to the devices that need it, NOP to the others.
+        uint8_t runCommands[L6470_MAX_DEVICES];
+        uint32_t runSpeeds[L6470_MAX_DEVICES];
+        bool shouldSendSpeed = false;
+        if(motorSpeeds != NULL)
+        {
+            for(uint i = 0; i < numberOfDevices_; i++)
+            {
+                speedToRunCommand(motorSpeeds[i], runCommands[i], runSpeeds[i]);
+                if(isSpeedCacheValid_ && runCommands[i] == lastRunCommand_[i] && runSpeeds[i] == lastRunSpeed_[i])
+                {
+                    commands[i] = dSPIN_NOP;
+                    parameters[i] = 0;
+                }
+                else
+                {
+                    commands[i] = runCommands[i];
+                    parameters[i] = runSpeeds[i];
+                    shouldSendSpeed = true;
+                }
+            }
+            if(shouldSendSpeed)
+            {
+                packCommand(&data[length], commands, parameters, speedLength);
+                length += numberOfDevices_ * (1 + speedLength);
+            }
+        }
+
+        int result = 0;
+        if(length > 0)
+            result = spiReadWrite(data, length);
+        #ifdef DEBUG
+            if(result < 0)
+                std::cout << "L6470 SPI error: " << errno << " " << std::strerror(errno) << std::endl;
+        #endif
+
+        if(result < 0)
+        {
+            // State of the devices is unknown: resend speed next time.
+            isSpeedCacheValid_ = false;
+            mutex_.unlock();
+            if(errors != NULL)
+                for(uint i = 0; i < numberOfDevices_; i++)
+                    errors[i] = 0;
+            if(positions != NULL)
+                for(uint i = 0; i < numberOfDevices_; i++)
+                    positions[i] = 0.0;
+            return result;
+        }
+
+        if(shouldSendSpeed)
+        {
+            for(uint i = 0; i < numberOfDevices_; i++)
+            {
+                lastRunCommand_[i] = runCommands[i];
+                lastRunSpeed_[i] = runSpeeds[i];
+            }
+            isSpeedCacheValid_ = true;
+        }
+
+        // Decode responses.
+        uint32_t response[L6470_MAX_DEVICES];
+        if(statusOffset >= 0)
+        {
+            unpackResponse(&data[statusOffset], statusLength, response);
+            decodeErrors(response, errors);
+            // If any device reports an error, the last command might not have been taken into account.
+            for(uint i = 0; i < numberOfDevices_; i++)
+                if((errors[i] & ~(dSPIN_ERR_STALLA | dSPIN_ERR_STALLB)) != 0)
+                    isSpeedCacheValid_ = false;
+        }
+        if(positionOffset >= 0)
+        {
+            unpackResponse(&data[positionOffset], positionLength, response);
+            for(uint i = 0; i < numberOfDevices_; i++)
+                positions[i] = absPosToSteps(response[i]) / stepModeMultiplier_;
+        }
+        mutex_.unlock();
+        return result;
     }
 }
@@ -0,0 +1,504 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/L6470Emulator.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Register definition and utility function for parameter length.
+#include "L6470Registers.h"
+
+namespace miam
+{
+    // Size of each register, in bits (0 for invalid addresses).
+    static int const REGISTER_SIZE[32] = {
+        0, 22, 9, 22, 20, 12, 12, 10, 13, 8, 8, 8, 8, 14, 8, 8,
+        8, 4, 5, 4, 7, 10, 8, 8, 16, 16, 0, 0, 0, 0, 0, 0};
+
+    // Conversion ratios, from physical units to register value.
+    static double const STEPSEC2_TO_ACCELERATION_REG = 0.068728;
+    static double const STEPSEC_TO_MAX_SPEED_REG = 0.065536;
+
+    // Bits of the status register that are latched until a GetStatus command: active-high and active-low ones.
+    static uint32_t const STATUS_LATCHED_HIGH = dSPIN_STATUS_NOTPERF_CMD | dSPIN_STATUS_WRONG_CMD;
+    static uint32_t const STATUS_LATCHED_LOW = dSPIN_STATUS_UVLO | dSPIN_STATUS_TH_WRN | dSPIN_STATUS_TH_SD
+                                               | dSPIN_STATUS_OCD | dSPIN_STATUS_STEP_LOSS_A | dSPIN_STATUS_STEP_LOSS_B;
+
+    // Maximum integration step of the motion model, in s.
+    static double const MAX_INTEGRATION_STEP = 1e-4;
+
+    // Default SPI clock, used for statistics when the transfer does not specify it.
+    static double const DEFAULT_SPI_FREQUENCY = 4e6;
+
+    static int registerLength(uint8_t const& address)
+    {
+        return (REGISTER_SIZE[address & 0x1F] + 7) / 8;
+    }
+
+
+    L6470EmulatedDevice::L6470EmulatedDevice()
+    {
+        reset();
+    }
+
+
+    void L6470EmulatedDevice::reset()
+    {
+        // Power-up values, from the datasheet.
+        std::memset(registers_, 0, sizeof(registers_));
+        registers_[dSPIN_ACC] = 0x08A;
+        registers_[dSPIN_DEC] = 0x08A;
+        registers_[dSPIN_MAX_SPEED] = 0x041;
+        registers_[dSPIN_FS_SPD] = 0x027;
+        registers_[dSPIN_KVAL_HOLD] = 0x29;
+        registers_[dSPIN_KVAL_RUN] = 0x29;
+        registers_[dSPIN_KVAL_ACC] = 0x29;
+        registers_[dSPIN_KVAL_DEC] = 0x29;
+        registers_[dSPIN_INT_SPD] = 0x0408;
+        registers_[dSPIN_ST_SLP] = 0x19;
+        registers_[dSPIN_FN_SLP_ACC] = 0x29;
+        registers_[dSPIN_FN_SLP_DEC] = 0x29;
+        registers_[dSPIN_OCD_TH] = 0x8;
+        registers_[dSPIN_STALL_TH] = 0x40;
+        registers_[dSPIN_STEP_MODE] = 0x7;
+        registers_[dSPIN_ALARM_EN] = 0xFF;
+        registers_[dSPIN_CONFIG] = 0x2E88;
+        registers_[dSPIN_STATUS] = STATUS_LATCHED_LOW;
+
+        currentCommand_ = dSPIN_NOP;
+        parameterBytesLeft_ = 0;
+        parameter_ = 0;
+        responseLength_ = 0;
+        responseIndex_ = 0;
+
+        mode_ = HIGH_Z;
+        position_ = 0.0;
+        speed_ = 0.0;
+        acceleration_ = 0.0;
+        runSpeed_ = 0.0;
+        targetPosition_ = 0.0;
+        isForward_ = true;
+        updateRegisters();
+    }
+
+
+    uint8_t L6470EmulatedDevice::processByte(uint8_t const& input)
+    {
+        // While a response is being sent, input bytes are ignored.
+        if(responseLength_ > 0 && responseIndex_ <= responseLength_)
+        {
+            uint8_t output = 0;
+            if(responseIndex_ < responseLength_)
+                output = response_[responseIndex_];
+            responseIndex_++;
+            return output;
+        }
+        responseLength_ = 0;
+
+        if(parameterBytesLeft_ > 0)
+        {
+            parameter_ = (parameter_ << 8) | input;
+            parameterBytesLeft_--;
+            if(parameterBytesLeft_ == 0)
+                executeCommand();
+            return 0;
+        }
+
+        decodeCommand(input);
+        if(responseLength_ > 0)
+        {
+            responseIndex_ = 1;
+            return response_[0];
+        }
+        return 0;
+    }
+
+
+    void L6470EmulatedDevice::decodeCommand(uint8_t const& command)
+    {
+        currentCommand_ = command;
+        parameter_ = 0;
+
+        // SetParam and GetParam: register address in the 5 LSB.
+        if((command & 0xE0) == dSPIN_SET_PARAM || (command & 0xE0) == dSPIN_GET_PARAM)
+        {
+            uint8_t address = command & 0x1F;
+            // Address 0 with SetParam is NOP.
+            if(command == dSPIN_NOP)
+                return;
+            if(REGISTER_SIZE[address] == 0)
+            {
+                flagWrongCommand();
+                return;
+            }
+            int length = registerLength(address);
+            if((command & 0xE0) == dSPIN_SET_PARAM)
+            {
+                parameterBytesLeft_ = length;
+                return;
+            }
+            updateRegisters();
+            uint32_t value = registers_[address];
+            for(int i = 0; i < length; i++)
+                response_[i] = (value >> (8 * (length - 1 - i))) & 0xFF;
+            responseLength_ = length;
+            return;
+        }
+
+        switch(command)
+        {
+            case dSPIN_RUN:
+            case dSPIN_RUN | 1:
+                parameterBytesLeft_ = getParamLength(dSPIN_SPEED);
+                break;
+            case dSPIN_MOVE:
+            case dSPIN_MOVE | 1:
+                parameterBytesLeft_ = getParamLength(dSPIN_ABS_POS);
+                break;
+            case dSPIN_SOFT_STOP:
+                if(mode_ != STOPPED && mode_ != HIGH_Z)
+                    mode_ = SOFT_STOP;
+                break;
+            case dSPIN_HARD_STOP:
+                mode_ = STOPPED;
+                speed_ = 0.0;
+                break;
+            case dSPIN_SOFT_HIZ:
+                if(mode_ == STOPPED || mode_ == HIGH_Z)
+                    mode_ = HIGH_Z;
+                else
+                    mode_ = SOFT_HIGH_Z;
+                break;
+            case dSPIN_HARD_HIZ:
+                mode_ = HIGH_Z;
+                speed_ = 0.0;
+                break;
+            case dSPIN_RESET_POS:
+                position_ = 0.0;
+                targetPosition_ = 0.0;
+                break;
+            case dSPIN_RESET_DEVICE:
+                reset();
+                break;
+            case dSPIN_GET_STATUS:
+            {
+                updateRegisters();
+                uint32_t status = registers_[dSPIN_STATUS];
+                response_[0] = (status >> 8) & 0xFF;
+                response_[1] = status & 0xFF;
+                responseLength_ = 2;
+                // Reading the status clears the latched flags.
+                registers_[dSPIN_STATUS] = (status & ~STATUS_LATCHED_HIGH) | STATUS_LATCHED_LOW;
+                break;
+            }
+            default:
+                // Other commands (GoTo, GoUntil, StepClock...) are not emulated.
+                flagWrongCommand();
+                break;
+        }
+        updateRegisters();
+    }
+
+
+    void L6470EmulatedDevice::executeCommand()
+    {
+        bool isStopped = (mode_ == STOPPED || mode_ == HIGH_Z);
+
+        if((currentCommand_ & 0xE0) == dSPIN_SET_PARAM)
+        {
+            uint8_t address = currentCommand_ & 0x1F;
+            uint32_t value = parameter_ & ((1u << REGISTER_SIZE[address]) - 1);
+            switch(address)
+            {
+                // Read-only registers.
+                case dSPIN_SPEED:
+                case dSPIN_ADC_OUT:
+                case dSPIN_STATUS:
+                    flagWrongCommand();
+                    return;
+                // Registers writable only when the motor is stopped.
+                case dSPIN_ABS_POS:
+                case dSPIN_EL_POS:
+                case dSPIN_MARK:
+                case dSPIN_ACC:
+                case dSPIN_DEC:
+                case 0x08: // MIN_SPEED
+                case dSPIN_ALARM_EN:
+                    if(!isStopped)
+                    {
+                        flagCommandNotPerformed();
+                        return;
+                    }
+                    break;
+                // Registers writable only in high impedance.
+                case dSPIN_INT_SPD:
+                case dSPIN_ST_SLP:
+                case dSPIN_FN_SLP_ACC:
+                case dSPIN_FN_SLP_DEC:
+                case dSPIN_STEP_MODE:
+                case dSPIN_CONFIG:
+                    if(mode_ != HIGH_Z)
+                    {
+                        flagCommandNotPerformed();
+                        return;
+                    }
+                    break;
+                default: break;
+            }
+            registers_[address] = value;
+            if(address == dSPIN_ABS_POS)
+            {
+                int32_t v = value;
+                if(v > 0x1FFFFF)
+                    v -= 0x400000;
+                position_ = v;
+            }
+            // Changing step mode invalidates the position.
+            if(address == dSPIN_STEP_MODE)
+                position_ = 0.0;
+        }
+        else if((currentCommand_ & 0xFE) == dSPIN_RUN)
+        {
+            double speed = (parameter_ & 0xFFFFF) / STEPSEC_TO_VELOCITY_REG;
+            isForward_ = (currentCommand_ & 1);
+            runSpeed_ = (isForward_ ? speed : -speed);
+            mode_ = RUN;
+        }
+        else if((currentCommand_ & 0xFE) == dSPIN_MOVE)
+        {
+            if(!isStopped)
+            {
+                flagCommandNotPerformed();
+                return;
+            }
+            double nSteps = parameter_ & 0x3FFFFF;
+            isForward_ = (currentCommand_ & 1);
+            // Position is kept as an integer number of microsteps.
+            targetPosition_ = std::round(position_) + (isForward_ ? nSteps : -nSteps);
+            if(nSteps > 0)
+                mode_ = MOVE;
+        }
+        updateRegisters();
+    }
+
+
+    void L6470EmulatedDevice::update(double const& dt)
+    {
+        double const microsteps = 1 << (registers_[dSPIN_STEP_MODE] & 0x07);
+        double const maxSpeed = registers_[dSPIN_MAX_SPEED] / STEPSEC_TO_MAX_SPEED_REG;
+        double const acceleration = std::max(registers_[dSPIN_ACC], 1u) / STEPSEC2_TO_ACCELERATION_REG;
+        double const deceleration = std::max(registers_[dSPIN_DEC], 1u) / STEPSEC2_TO_ACCELERATION_REG;
+
+        double t = 0.0;
+        while(t < dt)
+        {
+            double h = std::min(MAX_INTEGRATION_STEP, dt - t);
+            t += h;
+
+            if(mode_ == STOPPED || mode_ == HIGH_Z)
+            {
+                speed_ = 0.0;
+                acceleration_ = 0.0;
+                continue;
+            }
+
+            // Compute target speed.
+            double targetSpeed = 0.0;
+            if(mode_ == RUN)
+                targetSpeed = std::max(-maxSpeed, std::min(maxSpeed, runSpeed_));
+            else if(mode_ == MOVE)
+            {
+                double remaining = (targetPosition_ - position_) / microsteps;
+                double stoppingDistance = speed_ * speed_ / (2 * deceleration);
+                if(remaining * speed_ > 0 && stoppingDistance >= std::abs(remaining))
+                    targetSpeed = 0.0;
+                else
+                    targetSpeed = (remaining > 0 ? maxSpeed : -maxSpeed);
+            }
+
+            // Ramp speed toward target, using acceleration or deceleration.
+            bool isAccelerating = std::abs(targetSpeed) > std::abs(speed_) && targetSpeed * speed_ >= 0;
+            double maxIncrement = (isAccelerating ? acceleration : deceleration) * h;
+            double newSpeed = speed_ + std::max(-maxIncrement, std::min(maxIncrement, targetSpeed - speed_));
+            double newPosition = position_ + 0.5 * (speed_ + newSpeed) * h * microsteps;
+            acceleration_ = (newSpeed - speed_) / h;
+
+            if(mode_ == MOVE && (targetPosition_ - position_) * (targetPosition_ - newPosition) <= 0)
+            {
+                // Target reached.
+                newPosition = targetPosition_;
+                newSpeed = 0.0;
+                acceleration_ = 0.0;
+                mode_ = STOPPED;
+            }
+            else if((mode_ == SOFT_STOP || mode_ == SOFT_HIGH_Z) && newSpeed == 0.0)
+            {
+                mode_ = (mode_ == SOFT_STOP ? STOPPED : HIGH_Z);
+                acceleration_ = 0.0;
+            }
+            position_ = newPosition;
+            speed_ = newSpeed;
+            if(speed_ != 0.0)
+                isForward_ = speed_ > 0;
+        }
+        updateRegisters();
+    }
+
+
+    void L6470EmulatedDevice::updateRegisters()
+    {
+        int64_t position = static_cast<int64_t>(std::round(position_));
+        registers_[dSPIN_ABS_POS] = position & 0x3FFFFF;
+        registers_[dSPIN_SPEED] = std::min(static_cast<uint32_t>(std::abs(speed_) * STEPSEC_TO_VELOCITY_REG + 0.5), 0xFFFFFu);
+
+        uint32_t status = registers_[dSPIN_STATUS] & (STATUS_LATCHED_HIGH | STATUS_LATCHED_LOW);
+        if(mode_ == HIGH_Z)
+            status |= dSPIN_STATUS_HIZ;
+        // BUSY is active low.
+        bool isBusy = (mode_ == MOVE || mode_ == SOFT_STOP || mode_ == SOFT_HIGH_Z
+                       || (mode_ == RUN && acceleration_ != 0.0));
+        if(!isBusy)
+            status |= dSPIN_STATUS_BUSY;
+        if(isForward_)
+            status |= dSPIN_STATUS_DIR;
+        // Motor status: 0 stopped, 1 acceleration, 2 deceleration, 3 constant speed.
+        uint32_t motorStatus = 0;
+        if(speed_ != 0.0)
+        {
+            if(acceleration_ == 0.0)
+                motorStatus = 3;
+            else if(acceleration_ * speed_ > 0)
+                motorStatus = 1;
+            else
+                motorStatus = 2;
+        }
+        status |= motorStatus << 5;
+        registers_[dSPIN_STATUS] = status;
+    }
+
+
+    void L6470EmulatedDevice::flagWrongCommand()
+    {
+        parameterBytesLeft_ = 0;
+        registers_[dSPIN_STATUS] |= dSPIN_STATUS_WRONG_CMD;
+    }
+
+
+    void L6470EmulatedDevice::flagCommandNotPerformed()
+    {
+        registers_[dSPIN_STATUS] |= dSPIN_STATUS_NOTPERF_CMD;
+    }
+
+
+    void L6470EmulatedDevice::triggerStatusEvent(uint16_t const& eventMask)
+    {
+        registers_[dSPIN_STATUS] |= eventMask & STATUS_LATCHED_HIGH;
+        registers_[dSPIN_STATUS] &= ~(eventMask & STATUS_LATCHED_LOW);
+    }
+
+
+    uint32_t L6470EmulatedDevice::getRegister(uint8_t const& address) const
+    {
+        return registers_[address & 0x1F];
+    }
+
+
+    double L6470EmulatedDevice::getPosition() const
+    {
+        return position_;
+    }
+
+
+    double L6470EmulatedDevice::getSpeed() const
+    {
+        return speed_;
+    }
+
+
+    bool L6470EmulatedDevice::isHighZ() const
+    {
+        return mode_ == HIGH_Z;
+    }
+
+
+    L6470Emulator::L6470Emulator(int const& numberOfDevices):
+        devices_(std::max(numberOfDevices, 1)),
+        shiftRegisters_(std::max(numberOfDevices, 1), 0),
+        statistics_()
+    {
+    }
+
+
+    int L6470Emulator::transfer(struct spi_ioc_transfer *transfers, int const& nTransfers)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int const nDevices = devices_.size();
+        int totalLength = 0;
+        statistics_.nMessages++;
+        for(int i = 0; i < nTransfers; i++)
+        {
+            uint8_t const *tx = reinterpret_cast<uint8_t const *>(transfers[i].tx_buf);
+            uint8_t *rx = reinterpret_cast<uint8_t *>(transfers[i].rx_buf);
+            for(uint32_t b = 0; b < transfers[i].len; b++)
+            {
+                // Shift one byte through the chain: the first byte sent ends up in device 0.
+                uint8_t input = (tx == NULL ? 0 : tx[b]);
+                uint8_t output = shiftRegisters_[0];
+                for(int k = 0; k < nDevices - 1; k++)
+                    shiftRegisters_[k] = shiftRegisters_[k + 1];
+                shiftRegisters_[nDevices - 1] = input;
+                if(rx != NULL)
+                    rx[b] = output;
+            }
+            totalLength += transfers[i].len;
+
+            double frequency = (transfers[i].speed_hz > 0 ? transfers[i].speed_hz : DEFAULT_SPI_FREQUENCY);
+            statistics_.nBytes += transfers[i].len;
+            statistics_.busTime += 8 * transfers[i].len / frequency + transfers[i].delay_usecs * 1e-6;
+
+            // Chip select rising edge: each device latches its byte.
+            if(transfers[i].cs_change || i == nTransfers - 1)
+            {
+                statistics_.nFrames++;
+                for(int k = 0; k < nDevices; k++)
+                    shiftRegisters_[k] = devices_[k].processByte(shiftRegisters_[k]);
+            }
+        }
+        return totalLength;
+    }
+
+
+    void L6470Emulator::update(double const& dt)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(L6470EmulatedDevice & d : devices_)
+            d.update(dt);
+    }
+
+
+    int L6470Emulator::getNumberOfDevices() const
+    {
+        return devices_.size();
+    }
+
+
+    L6470EmulatedDevice & L6470Emulator::getDevice(int const& device)
+    {
+        return devices_.at(device);
+    }
+
+
+    L6470EmulatorStatistics L6470Emulator::getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return statistics_;
+    }
+
+
+    void L6470Emulator::resetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics_ = L6470EmulatorStatistics();
+    }
+}
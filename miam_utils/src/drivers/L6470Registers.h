@@ -24,7 +24,7 @@ typedef enum DSPIN_OVERCURRENT_CONST
 // Default value of the config register.
 #define dSPIN_DEFAULT_CONFIG 11912
 
-double STEPSEC_TO_VELOCITY_REG = 250e-9 * (1<<28); // Conversion ratio from step/s to velocity register value.
+static double const STEPSEC_TO_VELOCITY_REG = 250e-9 * (1<<28); // Conversion ratio from step/s to velocity register value.
 
 typedef enum DSPIN_REG_CONST
 {
@@ -243,7 +243,7 @@ typedef enum dSPIN_ERROR_CODE
 
 
 // Utility function: get parameter length, in bytes, associated to a given register or command.
-uint8_t getParamLength(uint8_t const& param)
+static uint8_t getParamLength(uint8_t const& param)
 {
     switch (param)
     {
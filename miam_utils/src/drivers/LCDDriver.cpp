@@ -51,7 +51,106 @@ int rw_pin = 14;
 int enable_pin = 13;
 int data_pins[4] = {12, 11, 10, 9};
 
-LCD::LCD()
+// Backlight pins: red, green, blue. Leds are on when the pin is low.
+int const backlight_pins[3] = {6, 7, 8};
+
+// Number of characters per line.
+#define LCD_WIDTH 16
+
+namespace miam{
+    LCDFramebuffer::LCDFramebuffer()
+    {
+        for(int line = 0; line < 2; line++)
+            for(int x = 0; x < LCD_WIDTH; x++)
+            {
+                screen_[line][x] = ' ';
+                isValid_[line][x] = true;
+            }
+    }
+
+
+    void LCDFramebuffer::invalidate()
+    {
+        for(int line = 0; line < 2; line++)
+            for(int x = 0; x < LCD_WIDTH; x++)
+                isValid_[line][x] = false;
+    }
+
+
+    unsigned int LCDFramebuffer::getLCDPinMask()
+    {
+        unsigned int mask = (1 << rs_pin) | (1 << rw_pin) | (1 << enable_pin);
+        for(int x = 0; x < 4; x++)
+            mask |= 1 << data_pins[x];
+        return mask;
+    }
+
+
+    void LCDFramebuffer::appendByte(unsigned char const& data,
+                                    bool const& isCharacter,
+                                    unsigned int const& basePortValue,
+                                    std::vector<unsigned int> & portValues)
+    {
+        // RW and enable low, RS set.
+        unsigned int const base = (basePortValue & ~getLCDPinMask()) | ((isCharacter ? 1 : 0) << rs_pin);
+        // Most significant nibble first.
+        for(int nibble = 1; nibble >= 0; nibble--)
+        {
+            unsigned int portValue = base;
+            for (int x = 0; x < 4; x++)
+                portValue |= (((data >> (4 * nibble + x)) & 0x01) << data_pins[x]);
+            // Set data, then pulse enable: each value lasts one port write, i.e. far more than the 450ns pulse
+            // width or 37us command time required.
+            portValues.push_back(portValue);
+            portValues.push_back(portValue | (1 << enable_pin));
+            portValues.push_back(portValue);
+        }
+    }
+
+
+    int LCDFramebuffer::update(std::string const lines[2], unsigned int const& basePortValue, std::vector<unsigned int> & portValues)
+    {
+        int nBytes = 0;
+        for(int line = 0; line < 2; line++)
+        {
+            char target[LCD_WIDTH];
+            for(int x = 0; x < LCD_WIDTH; x++)
+                target[x] = (x < static_cast<int>(lines[line].length()) ? lines[line][x] : ' ');
+
+            // Position of the LCD cursor on this line, -1 if elsewhere.
+            int cursor = -1;
+            for(int x = 0; x < LCD_WIDTH; x++)
+            {
+                if(isValid_[line][x] && screen_[line][x] == target[x])
+                    continue;
+                // Moving the cursor costs one byte: rewrite a single unchanged character instead.
+                if(cursor >= 0 && x - cursor == 1)
+                {
+                    appendByte(target[cursor], true, basePortValue, portValues);
+                    nBytes++;
+                }
+                else if(cursor != x)
+                {
+                    appendByte(LCD_SETDDRAMADDR | (line == 0 ? 0x00 : 0x40) | x, false, basePortValue, portValues);
+                    nBytes++;
+                }
+                appendByte(target[x], true, basePortValue, portValues);
+                nBytes++;
+                screen_[line][x] = target[x];
+                isValid_[line][x] = true;
+                cursor = x + 1;
+            }
+        }
+        return nBytes;
+    }
+}
+
+
+LCD::LCD():
+    basePortValue_(0b111 << 6),
+    backlight_(0),
+    buttons_(0xFFFF),
+    updateScreen_(false)
 {
 }
 
@@ -62,9 +161,8 @@ bool LCD::init(I2CAdapter *adapter, int const& address)
     if(mpc_init(&mpc_, adapter, address) == false)
         return false;
     // Configure MPC I/O.
-    mpc_pinMode(mpc_, 8, MPC_OUTPUT);
-    mpc_pinMode(mpc_, 7, MPC_OUTPUT);
-    mpc_pinMode(mpc_, 6, MPC_OUTPUT);
+    for(int x=0; x < 3; x++)
+        mpc_pinMode(mpc_, backlight_pins[x], MPC_OUTPUT);
 
     mpc_pinMode(mpc_, rs_pin, MPC_OUTPUT);
     mpc_pinMode(mpc_, rw_pin, MPC_OUTPUT);
@@ -74,12 +172,12 @@ bool LCD::init(I2CAdapter *adapter, int const& address)
         mpc_pinMode(mpc_, data_pins[x], MPC_OUTPUT);
 
     // Turn off all legs, set all the other lines to low.
-    unsigned int pinValue = 0;
-    pinValue = pinValue | (0b111 << 6);
-    mpc_writeAll(mpc_, pinValue);
+    basePortValue_ = 0b111 << 6;
+    mpc_writeAll(mpc_, basePortValue_);
 
     // Reset LCD into 4 bit mode : see HD44780 datasheet, figure 24 pg. 46.
     sendCommand(0x33);
+    usleep(5000);
     sendCommand(0x32);
 
     // Set display mode.
@@ -91,6 +189,8 @@ bool LCD::init(I2CAdapter *adapter, int const& address)
 
     // Clear LCD display.
     sendCommand(LCD_CLEARDISPLAY);
+    usleep(2000);
+    framebuffer_ = miam::LCDFramebuffer();
 
     // Start low-level thread.
     std::thread t(&LCD::lcdLoop, this);
@@ -99,24 +199,6 @@ bool LCD::init(I2CAdapter *adapter, int const& address)
 }
 
 
-void LCD::setText(std::string const& text, int line)
-{
-    // If line is not zero, set offset to write to line 1.
-    if(line != 0)
-        line  = 0x40;
-    // Go to beginning of line.
-    sendCommand(LCD_SETDDRAMADDR | line);
-    int stringLength = text.length();
-    if (stringLength > 16)
-        stringLength = 16;
-    for(int x = 0; x < stringLength; x++)
-        sendChar(text[x]);
-    // Pad string with spaces if needed.
-    for(int x = stringLength; x < 16; x++)
-        sendChar(' ');
-}
-
-
 void LCD::setTextCentered(std::string const& text, int line)
 {
     if (line != 0)
@@ -155,59 +237,12 @@ bool LCD::isButtonPressed(LCDButton button)
 }
 
 
-void LCD::pulseEnable()
-{
-    mpc_digitalWrite(mpc_, enable_pin, 1);
-    usleep(1);    // enable pulse must be >450ns
-    mpc_digitalWrite(mpc_, enable_pin, 0);
-    usleep(40);   // commands need > 37us to settle
-}
-
-
-// Send data over 4bits interface, with specific rs pin value.
-void LCD::sendData(unsigned char const& data, unsigned char const& rsValue)
-{
-    unsigned int portValue = mpc_readAll(mpc_);
-
-    // Set RS, RW and enable to 0
-    portValue &= ~(1 << rs_pin);
-    portValue &= ~(1 << rw_pin);
-    portValue &= ~(1 << enable_pin);
-
-    // Set RS pin to right value
-    portValue |= (rsValue << rs_pin);
-
-    // Set data pin : first 4 bits.
-    for (int x = 0; x < 4; x++)
-    {
-        portValue &= ~(1 << data_pins[x]);
-        portValue |= (((data >> (4 + x)) & 0x01) << data_pins[x]);
-    }
-    mpc_writeAll(mpc_, portValue);
-    pulseEnable();
-
-    // Second 4 bits.
-    for (int x = 0; x < 4; x++)
-    {
-        portValue &= ~(1 << data_pins[x]);
-        portValue |= (((data >> (x)) & 0x01) << data_pins[x]);
-    }
-    mpc_writeAll(mpc_, portValue);
-    pulseEnable();
-}
-
-
 // Send a command to the LCD screen, in 4 bits mode
 void LCD::sendCommand(unsigned char value)
 {
-    sendData(value, 0);
-}
-
-
-// Send a character to the LCD screen, in 4 bits mode
-void LCD::sendChar(unsigned char value)
-{
-    sendData(value, 1);
+    std::vector<unsigned int> portValues;
+    miam::LCDFramebuffer::appendByte(value, false, basePortValue_, portValues);
+    mpc_writeSequence(mpc_, portValues.data(), portValues.size());
 }
 
 
@@ -218,6 +253,7 @@ void LCD::lcdLoop()
     int backlight = 0;
     int buttons = 0;
     bool updateScreen = false;
+    std::vector<unsigned int> portValues;
 
     while(true)
     {
@@ -234,13 +270,23 @@ void LCD::lcdLoop()
 
         if (updateScreen)
         {
-            // Update backlight.
-            mpc_digitalWrite(mpc_, 6, ~((backlight & 4) ? 1 : 0) & 0x1);
-            mpc_digitalWrite(mpc_, 7, ~((backlight & 2) ? 1 : 0) & 0x1);
-            mpc_digitalWrite(mpc_, 8, ~((backlight & 1) ? 1 : 0) & 0x1);
-            // Update line content.
-            setText(lines[0], 0);
-            setText(lines[1], 1);
+            // Update backlight: leds are on when the pin is low.
+            unsigned int basePortValue = 0;
+            for(int x = 0; x < 3; x++)
+                if((backlight & (4 >> x)) == 0)
+                    basePortValue |= 1 << backlight_pins[x];
+
+            // Update changed characters, in a single transaction with the backlight.
+            portValues.clear();
+            framebuffer_.update(lines, basePortValue, portValues);
+            if(portValues.empty() && basePortValue != basePortValue_)
+                portValues.push_back(basePortValue);
+            if(!portValues.empty())
+            {
+                if(!mpc_writeSequence(mpc_, portValues.data(), portValues.size()))
+                    framebuffer_.invalidate();
+            }
+            basePortValue_ = basePortValue;
         }
 
         // Update button status.
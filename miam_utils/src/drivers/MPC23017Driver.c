@@ -3,31 +3,46 @@
 #include "miam_utils/drivers/MPC23017Driver.h"
 #include <stdio.h>
 
+// Registers, in BANK = 0 mode: A register is at the given address, B register at the next one.
+#define MPC_IODIR 0x00
+#define MPC_IOCON 0x0A
+#define MPC_GPPU 0x0C
+#define MPC_GPIO 0x12
+#define MPC_OLAT 0x14
+
 bool mpc_init(MPC *mpc, I2CAdapter *adapter, unsigned int const& address)
 {
     if(adapter->file < 0)
         return false;
+    if(!mpc_init(mpc, std::make_shared<miam::I2CAdapterDevice>(adapter, address)))
+        return false;
     mpc->adapter = adapter;
     mpc->address=address;
+    return true;
+}
+
+bool mpc_init(MPC *mpc, std::shared_ptr<miam::I2CRegisterDevice> device)
+{
+    mpc->adapter = nullptr;
+    mpc->address = 0;
+    mpc->registers = std::make_shared<miam::I2CRegisterCache>(device);
     // Test communication and chip.
     // This chip has no who-a-i register, so we will just check we get the right feedback after a write.
 
     // Reset IOCON configuration register, in both bank configuration.
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x0B, 0x00);
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x15, 0x00);
-    // Set all pins as input.
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x00, 0xFF);
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x01, 0xFF);
-    // Reset everything
-    for(int reg = 2; reg < 20; reg++)
-        i2c_writeRegister(mpc->adapter, mpc->address, reg, 0x00);
-
-    // Enable pullup on all ports.
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x0C, 0xFF);
-    i2c_writeRegister(mpc->adapter, mpc->address, 0x0D, 0xFF);
+    unsigned char const zero = 0x00;
+    device->writeRegisters(0x0B, 1, &zero);
+    device->writeRegisters(0x15, 1, &zero);
+    // Set all pins as input, reset everything, and enable pullup on all ports: registers IODIRA to GPPUB.
+    unsigned char configuration[14] = {0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    mpc->registers->write(MPC_IODIR, 14, configuration);
+    // Reset outputs.
+    unsigned char const outputs[2] = {0, 0};
+    mpc->registers->write(MPC_OLAT, 2, outputs);
 
     // Chech writing took effect (i.e chip is there, we hope it's the right one).
-    if(i2c_readRegister(mpc->adapter, mpc->address, 0x00) != 0xFF)
+    unsigned char iodir = 0;
+    if(!mpc->registers->read(MPC_IODIR, 1, &iodir) || iodir != 0xFF)
     {
         #ifdef DEBUG
             printf("Error : MPC23017 (IO expander) not detected\n");
@@ -49,18 +64,14 @@ void mpc_pinMode(MPC mpc, unsigned int pin, MPCPinState state)
         pin -=8;
         port = 1;
     }
-    unsigned char currentState = i2c_readRegister(mpc.adapter, mpc.address, 0x00 + port);
     if(state == 2)
-        i2c_writeRegister(mpc.adapter, mpc.address, 0x00 + port, currentState & ~(1 << pin));
+        mpc.registers->setBits(MPC_IODIR + port, 1 << pin, 0);
     else
     {
-        unsigned char pullupState = i2c_readRegister(mpc.adapter, mpc.address, 0x0C + port);
-        i2c_writeRegister(mpc.adapter, mpc.address, 0x00 + port, currentState | (1 << pin));
-        if(state == 1)
-            i2c_writeRegister(mpc.adapter, mpc.address, 0x0C + port, pullupState | (1 << pin));
-        else
-            i2c_writeRegister(mpc.adapter, mpc.address, 0x0C + port, pullupState & ~(1 << pin));
+        mpc.registers->setBits(MPC_IODIR + port, 1 << pin, 0xFF);
+        mpc.registers->setBits(MPC_GPPU + port, 1 << pin, (state == 1 ? 0xFF : 0));
     }
+    mpc.registers->flush();
 }
 
 int mpc_digitalRead(MPC mpc, unsigned int pin)
@@ -73,7 +84,8 @@ int mpc_digitalRead(MPC mpc, unsigned int pin)
         pin -=8;
         port = 1;
     }
-    unsigned char currentState = i2c_readRegister(mpc.adapter, mpc.address, 0x12 + port);
+    unsigned char currentState = 0;
+    mpc.registers->read(MPC_GPIO + port, 1, &currentState);
     if((currentState & (1 << pin)) > 0)
         return 1;
     else
@@ -84,28 +96,61 @@ void mpc_digitalWrite(MPC mpc, unsigned int pin, unsigned int const& value)
 {
     if(pin < 0 || pin > 15)
         return;
-    int port = 0;
-    if(pin > 7)
-    {
-        pin -=8;
-        port = 1;
-    }
-    unsigned char currentState = i2c_readRegister(mpc.adapter, mpc.address, 0x12 + port);
     if(value == 0)
-        i2c_writeRegister(mpc.adapter, mpc.address, 0x12 + port, currentState & ~(1 << pin));
+        mpc_writePins(mpc, 0, 1 << pin);
     else
-        i2c_writeRegister(mpc.adapter, mpc.address, 0x12 + port, currentState | (1 << pin));
+        mpc_writePins(mpc, 1 << pin, 0);
+}
+
+void mpc_writePins(MPC mpc, unsigned int const& setMask, unsigned int const& clearMask)
+{
+    // Output latches: writing them is equivalent to writing GPIO, but they can be cached.
+    for(int port = 0; port < 2; port++)
+    {
+        unsigned char const set = (setMask >> (8 * port)) & 0xFF;
+        unsigned char const clear = (clearMask >> (8 * port)) & 0xFF;
+        mpc.registers->setBits(MPC_OLAT + port, set | clear, set);
+    }
+    mpc.registers->flush();
 }
 
 void mpc_writeAll(MPC mpc, unsigned int const& value)
 {
-    i2c_writeRegister(mpc.adapter, mpc.address, 0x12, value & 0xFF);
-    i2c_writeRegister(mpc.adapter, mpc.address, 0x13, (value >> 8));
+    mpc.registers->set(MPC_OLAT, value & 0xFF);
+    mpc.registers->set(MPC_OLAT + 1, (value >> 8) & 0xFF);
+    mpc.registers->flush();
+}
+
+bool mpc_writeSequence(MPC mpc, unsigned int const *values, int const& nValues)
+{
+    if(nValues <= 0)
+        return true;
+    unsigned char abValues[2 * nValues];
+    for(int i = 0; i < nValues; i++)
+    {
+        abValues[2 * i] = values[i] & 0xFF;
+        abValues[2 * i + 1] = (values[i] >> 8) & 0xFF;
+    }
+    // Byte mode: the address pointer toggles between GPIOA and GPIOB.
+    if(!mpc.registers->write(MPC_IOCON, 0x20))
+        return false;
+    bool result = mpc.registers->writeDirect(MPC_GPIO, 2 * nValues, abValues);
+    if(result)
+    {
+        // Output latches now hold the last value.
+        mpc.registers->assume(MPC_OLAT, abValues[2 * nValues - 2]);
+        mpc.registers->assume(MPC_OLAT + 1, abValues[2 * nValues - 1]);
+    }
+    else
+        mpc.registers->invalidate();
+    // Back to sequential mode, as set by mpc_init.
+    result &= mpc.registers->write(MPC_IOCON, 0x00);
+    return result;
 }
 
 unsigned int mpc_readAll(MPC mpc)
 {
-    unsigned char abValue[2];
-    i2c_readRegisters(mpc.adapter, mpc.address, 0x12, 2, abValue);
+    unsigned char abValue[2] = {0, 0};
+    mpc.registers->read(MPC_GPIO, 2, abValue);
     return (abValue[1] << 8) + abValue[0];
 }
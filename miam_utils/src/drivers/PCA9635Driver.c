@@ -5,18 +5,40 @@
 #define LEDOUTOFFSET 0x14
 #define PWMOFFSET 2
 
+#define MODE1 0x00
+
+// Auto-increment flag of the register address: all registers.
+#define AUTO_INCREMENT 0x80
+
+// Change a single pin state. The register is only staged: call flush to write it.
 void setPinState(PCA9635 *d, int pin, char ledState)
 {
-    // Change a single pin state.
     if(pin > 15 || pin < 0) return;
 
-    int lastpinstate = d->ledState[pin / 4];
     d->ledState[pin / 4] &= ~(1 << (2 * (pin % 4)));
     d->ledState[pin / 4] &= ~(1 << (2 * (pin % 4) + 1));
     d->ledState[pin / 4] |= ledState << (2 * (pin % 4));
 
-    if(lastpinstate != d->ledState[pin / 4])
-        i2c_writeRegister(d->adapter, d->address, LEDOUTOFFSET + pin / 4, d->ledState[pin / 4]);
+    d->registers->set(LEDOUTOFFSET + pin / 4, d->ledState[pin / 4]);
+}
+
+
+// Set brightness of a pin. The registers are only staged: call flush to write them.
+void stageLedBrightness(PCA9635 *d, int pin, int brightness)
+{
+    if(pin > 15 || pin < 0) return;
+    if(brightness < 0)     brightness = 0;
+    if(brightness > 255)   brightness = 255;
+
+    if(brightness == 0)
+        setPinState(d, pin, 0);
+    else if(brightness == 255)
+        setPinState(d, pin, 1);
+    else
+    {
+        setPinState(d, pin, 2);
+        d->registers->set(PWMOFFSET + pin, brightness);
+    }
 }
 
 
@@ -24,51 +46,62 @@ bool ledDriver_init(PCA9635 *d, I2CAdapter *adapter, unsigned char address)
 {
     if(adapter->file < 0)
         return false;
+    if(!ledDriver_init(d, std::make_shared<miam::I2CAdapterDevice>(adapter, address)))
+        return false;
     d->adapter = adapter;
     d->address = address;
+    return true;
+}
+
+
+bool ledDriver_init(PCA9635 *d, std::shared_ptr<miam::I2CRegisterDevice> device)
+{
+    d->adapter = nullptr;
+    d->address = 0;
+    d->registers = std::make_shared<miam::I2CRegisterCache>(device, AUTO_INCREMENT);
     // At startup, all leds are turned off.
     for(int i = 0; i < 4; i++)
-    {
         d->ledState[i] = 0;
-        i2c_writeRegister(d->adapter, d->address, LEDOUTOFFSET + i, d->ledState[i]);
-    }
+    d->registers->write(LEDOUTOFFSET, 4, d->ledState);
     // Enable driver
-    return i2c_writeRegister(d->adapter, d->address, 0x80, 0x80);
+    return d->registers->write(MODE1, 0x80);
 }
 
 
 void ledDriver_setLedBrightness(PCA9635 *d, int pin, int brightness)
 {
-    if(d->adapter->file < 0)
+    if(!d->registers)
         return;
-    if(pin > 15 || pin < 0) return;
-    if(brightness < 0)     brightness = 0;
-    if(brightness > 255)   brightness = 255;
+    stageLedBrightness(d, pin, brightness);
+    d->registers->flush();
+}
 
-    if(brightness == 0)
-        setPinState(d, pin, 0);
-    else if(brightness == 255)
-        setPinState(d, pin, 1);
-    else
-    {
-        setPinState(d, pin, 2);
-        i2c_writeRegister(d->adapter, d->address, PWMOFFSET + pin, brightness);
-    }
+
+void ledDriver_setLedsBrightness(PCA9635 *d, int firstPin, int nPins, int const *brightness)
+{
+    if(!d->registers)
+        return;
+    for(int i = 0; i < nPins; i++)
+        stageLedBrightness(d, firstPin + i, brightness[i]);
+    d->registers->flush();
 }
 
 
 void ledDriver_setRGBledBrightness(PCA9635 *d, int led, int r, int g, int b)
 {
+    if(!d->registers)
+        return;
     switch(led)
     {
-        case 1: ledDriver_setLedBrightness(d,1,r);
-                ledDriver_setLedBrightness(d,0,g);
-                ledDriver_setLedBrightness(d,2,b); break;
-        case 2: ledDriver_setLedBrightness(d,13,r);
-                ledDriver_setLedBrightness(d,14,g);
-                ledDriver_setLedBrightness(d,12,b); break;
-        case 3: ledDriver_setLedBrightness(d,4,r);
-                ledDriver_setLedBrightness(d,3,g);
-                ledDriver_setLedBrightness(d,5,b); break;
+        case 1: stageLedBrightness(d,1,r);
+                stageLedBrightness(d,0,g);
+                stageLedBrightness(d,2,b); break;
+        case 2: stageLedBrightness(d,13,r);
+                stageLedBrightness(d,14,g);
+                stageLedBrightness(d,12,b); break;
+        case 3: stageLedBrightness(d,4,r);
+                stageLedBrightness(d,3,g);
+                stageLedBrightness(d,5,b); break;
     }
+    d->registers->flush();
 }
@@ -2,8 +2,7 @@
 #include "miam_utils/drivers/PCA9685Driver.h"
 
 PCA9685::PCA9685():
-    adapter_(nullptr),
-    address_(0),
+    registers_(),
     isInit_(false)
 {
 
@@ -11,50 +10,87 @@ PCA9685::PCA9685():
 
 bool PCA9685::init(I2CAdapter *device, unsigned char const& address)
 {
-    adapter_ = device;
-    address_ = address;
+    return init(std::make_shared<miam::I2CAdapterDevice>(device, address));
+}
+
+
+bool PCA9685::init(std::shared_ptr<miam::I2CRegisterDevice> device)
+{
+    // Each led has 4 registers: allow a gap of 3, so that the same register of consecutive leds is written at once.
+    registers_ = std::make_shared<miam::I2CRegisterCache>(device, 0, 3);
 
-    // Configuration: enable oscillator, set correct logic (no external drivers)
-    i2c_writeRegister(adapter_, address_, 0x00, 0b00100000);
-    i2c_writeRegister(adapter_, address_, 0x01, 0b00010110);
+    // Configuration: enable oscillator and auto-increment, set correct logic (no external drivers)
+    registers_->write(0x00, 0b00100000);
+    registers_->write(0x01, 0b00010110);
 
     // Set prescaler:
-    i2c_writeRegister(adapter_, address_, 0xFE, 0x03);
+    registers_->write(0xFE, 0x03);
 
     // Reset all
     unsigned char values[4] = {0x00, 0x00, 0x00, 0x10};
-    i2c_writeRegisters(adapter_, address_, 0xFA, 4, values);
+    registers_->writeDirect(0xFA, 4, values);
+
+    // The ALL_LED registers turned off all leds.
+    for(int led = 0; led < 16; led++)
+    {
+        registers_->assume(0x06 + 4 * led, 0x00);
+        registers_->assume(0x07 + 4 * led, 0x00);
+        registers_->assume(0x08 + 4 * led, 0x00);
+        registers_->assume(0x09 + 4 * led, 0x10);
+    }
 
     // Test back communication
-    isInit_ = i2c_readRegister(adapter_, address_, 0x01) == 0b00010110;
+    unsigned char mode2 = 0;
+    isInit_ = registers_->read(0x01, 1, &mode2) && mode2 == 0b00010110;
     return isInit_;
 }
 
 
-void PCA9685::setBrightness(int const& led, double const& brightness)
+void PCA9685::stageBrightness(int const& led, double const& brightness)
 {
-    if (isInit_ && led >= 0 && led < 16)
+    if (led >= 0 && led < 16)
     {
-        // We only write 3 bytes since the first one is always set to zero (no delay)
-        unsigned char register_values[3] = {0};
+        // The first byte is always set to zero (no delay)
+        unsigned char register_values[4] = {0};
         if(brightness < 0)
         {
-            // Full on.
-            register_values[2] = 0x10;
+            // Full off.
+            register_values[3] = 0x10;
         }
         else if (brightness > 1)
         {
             // Full on.
-            register_values[0] = 0x10;
+            register_values[1] = 0x10;
         }
         else
         {
             // Convert to int
             int value = static_cast<int>(brightness * 4096);
-            register_values[1] = value & 0xFF;
-            register_values[2] = (value >> 8) & 0x0F;
+            register_values[2] = value & 0xFF;
+            register_values[3] = (value >> 8) & 0x0F;
         }
-        i2c_writeRegisters(adapter_, address_, 0x07 + 4 * led, 3, register_values);
+        for(int i = 0; i < 4; i++)
+            registers_->set(0x06 + 4 * led + i, register_values[i]);
+    }
+}
+
+
+void PCA9685::setBrightness(int const& led, double const& brightness)
+{
+    if (isInit_)
+    {
+        stageBrightness(led, brightness);
+        registers_->flush();
     }
+}
 
-}
\ No newline at end of file
+
+void PCA9685::setBrightness(std::vector<double> const& brightness, int const& firstLed)
+{
+    if (isInit_)
+    {
+        for(unsigned int i = 0; i < brightness.size(); i++)
+            stageBrightness(firstLed + i, brightness[i]);
+        registers_->flush();
+    }
+}
@@ -0,0 +1,269 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/SPIBusManager.h"
+#include "miam_utils/drivers/SPI-Wrapper.h"
+
+#include <sys/ioctl.h>
+#include <algorithm>
+#include <iostream>
+
+namespace miam{
+
+    SPIBusClient::SPIBusClient(SPIBusManager *manager, int const& clientId):
+        manager_(manager),
+        clientId_(clientId)
+    {
+    }
+
+
+    int SPIBusClient::transfer(struct spi_ioc_transfer *transfers, int const& nTransfers)
+    {
+        return manager_->transfer(clientId_, transfers, nTransfers);
+    }
+
+
+    SPIClientStatistics SPIBusClient::getStatistics()
+    {
+        return manager_->getStatistics(clientId_);
+    }
+
+
+    void SPIBusClient::resetStatistics()
+    {
+        manager_->resetStatistics(clientId_);
+    }
+
+
+    SPIBusManager::SPIBusManager():
+        sequenceNumber_(0),
+        isBusBusy_(false)
+    {
+    }
+
+
+    SPIBusManager::~SPIBusManager()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto & port : ports_)
+            if(port.second.fileDescriptor >= 0)
+                closePort(port.second.fileDescriptor);
+    }
+
+
+    std::shared_ptr<SPIBusClient> SPIBusManager::addClient(SPIClientConfiguration const& configuration)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.push_back(configuration);
+        statistics_.push_back(SPIClientStatistics());
+        if(ports_.find(configuration.portName) == ports_.end())
+        {
+            PortState state;
+            state.fileDescriptor = -1;
+            state.mode = -1;
+            ports_[configuration.portName] = state;
+        }
+        return std::make_shared<SPIBusClient>(this, clients_.size() - 1);
+    }
+
+
+    int SPIBusManager::transfer(int const& clientId, struct spi_ioc_transfer *transfers, int const& nTransfers)
+    {
+        if(nTransfers <= 0 || nTransfers > SPI_BUS_MAX_BATCH_TRANSFERS)
+            return -1;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(clientId < 0 || clientId >= static_cast<int>(clients_.size()))
+            return -1;
+
+        PendingMessage message;
+        message.clientId = clientId;
+        message.transfers = transfers;
+        message.nTransfers = nTransfers;
+        message.submissionTime = std::chrono::steady_clock::now();
+        message.sequenceNumber = sequenceNumber_++;
+        message.isDone = false;
+        message.result = -1;
+        pendingMessages_.push_back(&message);
+
+        while(!message.isDone)
+        {
+            if(isBusBusy_)
+                condition_.wait(lock);
+            else
+                serveNextBatch(lock);
+        }
+        return message.result;
+    }
+
+
+    void SPIBusManager::serveNextBatch(std::unique_lock<std::mutex> & lock)
+    {
+        // Sort pending messages: highest priority first, then oldest first.
+        std::sort(pendingMessages_.begin(), pendingMessages_.end(),
+            [this](PendingMessage const* a, PendingMessage const* b)
+            {
+                int priorityA = clients_[a->clientId].priority;
+                int priorityB = clients_[b->clientId].priority;
+                if(priorityA != priorityB)
+                    return priorityA > priorityB;
+                return a->sequenceNumber < b->sequenceNumber;
+            });
+
+        // Build the batch: the first message, followed by the next messages for the same port and mode, as long
+        // as they fit.
+        PendingMessage *batch[SPI_BUS_MAX_BATCH_TRANSFERS];
+        int nMessages = 0;
+        int nTransfers = 0;
+        int nBytes = 0;
+        SPIClientConfiguration const& first = clients_[pendingMessages_[0]->clientId];
+        for(unsigned int i = 0; i < pendingMessages_.size(); i++)
+        {
+            PendingMessage *message = pendingMessages_[i];
+            SPIClientConfiguration const& client = clients_[message->clientId];
+            if(client.portName != first.portName || client.mode != first.mode)
+                continue;
+            int messageBytes = 0;
+            for(int j = 0; j < message->nTransfers; j++)
+                messageBytes += message->transfers[j].len;
+            if(nMessages > 0 && (nTransfers + message->nTransfers > SPI_BUS_MAX_BATCH_TRANSFERS ||
+                                 nBytes + messageBytes > SPI_BUS_MAX_BATCH_BYTES))
+                break;
+            batch[nMessages] = message;
+            nMessages++;
+            nTransfers += message->nTransfers;
+            nBytes += messageBytes;
+        }
+        for(int i = 0; i < nMessages; i++)
+            pendingMessages_.erase(std::find(pendingMessages_.begin(), pendingMessages_.end(), batch[i]));
+
+        // Copy the transfers, applying the speed of each client.
+        struct spi_ioc_transfer transfers[SPI_BUS_MAX_BATCH_TRANSFERS];
+        int currentTransfer = 0;
+        for(int i = 0; i < nMessages; i++)
+        {
+            int const frequency = clients_[batch[i]->clientId].frequency;
+            for(int j = 0; j < batch[i]->nTransfers; j++)
+            {
+                transfers[currentTransfer] = batch[i]->transfers[j];
+                if(transfers[currentTransfer].speed_hz == 0 ||
+                   transfers[currentTransfer].speed_hz > static_cast<uint32_t>(frequency))
+                    transfers[currentTransfer].speed_hz = frequency;
+                currentTransfer++;
+            }
+            // Release chip select between two messages.
+            if(i < nMessages - 1)
+                transfers[currentTransfer - 1].cs_change = true;
+        }
+
+        // Get the port, opening it if needed. Open ports are never closed, so the reference remains valid once
+        // the lock is released.
+        PortState & port = ports_[first.portName];
+        std::string const portName = first.portName;
+        uint8_t const mode = first.mode;
+        int const frequency = first.frequency;
+
+        isBusBusy_ = true;
+        lock.unlock();
+
+        int result = 0;
+        if(port.fileDescriptor < 0)
+        {
+            port.fileDescriptor = openPort(portName, frequency);
+            port.mode = -1;
+        }
+        if(port.fileDescriptor < 0)
+            result = -1;
+        if(result >= 0 && port.mode != mode)
+        {
+            result = setPortMode(port.fileDescriptor, mode);
+            port.mode = (result < 0 ? -1 : mode);
+        }
+        if(result >= 0)
+            result = performMessage(port.fileDescriptor, transfers, nTransfers);
+
+        std::chrono::steady_clock::time_point const completionTime = std::chrono::steady_clock::now();
+        lock.lock();
+
+        // Give back received data and result to each client.
+        currentTransfer = 0;
+        for(int i = 0; i < nMessages; i++)
+        {
+            int messageLength = 0;
+            for(int j = 0; j < batch[i]->nTransfers; j++)
+            {
+                messageLength += transfers[currentTransfer].len;
+                currentTransfer++;
+            }
+            batch[i]->result = (result < 0 ? result : messageLength);
+            batch[i]->isDone = true;
+
+            SPIClientStatistics & stats = statistics_[batch[i]->clientId];
+            double const latency = std::chrono::duration<double>(completionTime - batch[i]->submissionTime).count();
+            stats.nMessages++;
+            if(result < 0)
+                stats.nErrors++;
+            if(nMessages > 1)
+                stats.nMergedMessages++;
+            stats.totalLatency += latency;
+            stats.maxLatency = std::max(stats.maxLatency, latency);
+            stats.lastLatency = latency;
+        }
+        isBusBusy_ = false;
+        condition_.notify_all();
+    }
+
+
+    SPIClientStatistics SPIBusManager::getStatistics(int const& clientId)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(clientId < 0 || clientId >= static_cast<int>(statistics_.size()))
+            return SPIClientStatistics();
+        return statistics_[clientId];
+    }
+
+
+    void SPIBusManager::resetStatistics(int const& clientId)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(clientId >= 0 && clientId < static_cast<int>(statistics_.size()))
+            statistics_[clientId] = SPIClientStatistics();
+    }
+
+
+    void SPIBusManager::printStatistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(unsigned int i = 0; i < clients_.size(); i++)
+        {
+            SPIClientStatistics const& stats = statistics_[i];
+            std::cout << "SPI client " << clients_[i].name << " (" << clients_[i].portName << "): "
+                      << stats.nMessages << " messages, " << stats.nErrors << " errors, "
+                      << stats.nMergedMessages << " merged, latency mean "
+                      << stats.getMeanLatency() * 1e6 << "us, max " << stats.maxLatency * 1e6 << "us" << std::endl;
+        }
+    }
+
+
+    int SPIBusManager::openPort(std::string const& portName, int const& frequency)
+    {
+        return spi_open(portName, frequency);
+    }
+
+
+    void SPIBusManager::closePort(int const& port)
+    {
+        spi_close(port);
+    }
+
+
+    int SPIBusManager::setPortMode(int const& port, uint8_t const& mode)
+    {
+        return ioctl(port, SPI_IOC_WR_MODE, &mode);
+    }
+
+
+    int SPIBusManager::performMessage(int const& port, struct spi_ioc_transfer *transfers, int const& nTransfers)
+    {
+        return ioctl(port, SPI_IOC_MESSAGE(nTransfers), transfers);
+    }
+}
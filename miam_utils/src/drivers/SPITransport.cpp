@@ -0,0 +1,25 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/SPITransport.h"
+#include "miam_utils/drivers/SPI-Wrapper.h"
+
+#include <sys/ioctl.h>
+
+namespace miam{
+    SpidevTransport::SpidevTransport(std::string const& portName, int const& frequency):
+        portName_(portName),
+        frequency_(frequency)
+    {
+    }
+
+
+    int SpidevTransport::transfer(struct spi_ioc_transfer *transfers, int const& nTransfers)
+    {
+        int port = spi_open(portName_, frequency_);
+        if(port < 0)
+            return -1;
+        int res = ioctl(port, SPI_IOC_MESSAGE(nTransfers), transfers);
+        spi_close(port);
+        return res;
+    }
+}
@@ -138,10 +138,10 @@ long int millis()
 
 // Public Methods //////////////////////////////////////////////////////////////
 
-void VL53L0X::setAddress(uint8_t new_addr)
+void VL53L0X::setAddress(uint8_t newAddress)
 {
-  writeReg(I2C_SLAVE_DEVICE_ADDRESS, new_addr & 0x7F);
-  address = new_addr;
+    writeReg(I2C_SLAVE_DEVICE_ADDRESS, newAddress & 0x7F);
+    address_ = newAddress & 0x7F;
 }
 
 // Initialize sensor using sequence based on VL53L0X_DataInit(),
@@ -152,20 +152,12 @@ void VL53L0X::setAddress(uint8_t new_addr)
 // enough unless a cover glass is added.
 // If io_2v8 (optional) is true or not given, the sensor is configured for 2V8
 // mode.
-bool VL53L0X::init(I2CAdapter *adapter, int const& slaveAddress)
+bool VL53L0X::init(I2CAdapter *adapter, int const& slaveAddress, bool const& startRanging)
 {
     adapter_ = adapter;
     address_ = slaveAddress;
-    //~ if(i2c_readRegister(adapter_, address_, IDENTIFICATION_MODEL_ID) != 0xEE)
-    writeReg16Bit(IDENTIFICATION_MODEL_ID, 0xAB << 8 + 0xBB);
-    std::cout << "here" << std::endl;
-    std::cout << readReg16Bit(IDENTIFICATION_MODEL_ID) << std::endl;
-    std::cout << 0xDE << 8 + 0xAA << std::endl;
-    std::cout << (readReg16Bit(IDENTIFICATION_MODEL_ID) != (0xDE << 8 + 0xAA)) << std::endl;
-    std::cout << "done" << std::endl;
     if(readReg16Bit(IDENTIFICATION_MODEL_ID) != ((0xEE << 8) + 0xAA))
     {
-        std::cout << "ERROR" << std::endl;
         #ifdef DEBUG
             std::cout << "Error : VL53L0X (range sensor) not detected\n" << std::endl;
         #endif
@@ -388,6 +380,18 @@ bool VL53L0X::init(I2CAdapter *adapter, int const& slaveAddress)
   // VL53L0X_PerformRefCalibration() end
 
     // Start continuous back to back ranging.
+    if(startRanging)
+        startContinuous(0);
+    return true;
+}
+
+
+// Start continuous ranging measurements. If periodMs is 0, continuous back-to-back mode is used (the sensor takes
+// measurements as often as possible); otherwise, continuous timed mode is used, with the given inter-measurement
+// period in milliseconds determining how often the sensor takes a measurement.
+// based on VL53L0X_StartMeasurement()
+void VL53L0X::startContinuous(uint32_t const& periodMs)
+{
     writeReg(0x80, 0x01);
     writeReg(0xFF, 0x01);
     writeReg(0x00, 0x00);
@@ -395,7 +399,55 @@ bool VL53L0X::init(I2CAdapter *adapter, int const& slaveAddress)
     writeReg(0x00, 0x01);
     writeReg(0xFF, 0x00);
     writeReg(0x80, 0x00);
-    writeReg(SYSRANGE_START, 0x02); // VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK
+
+    if(periodMs != 0)
+    {
+        // VL53L0X_SetInterMeasurementPeriodMilliSeconds(): the period is given in oscillator ticks.
+        uint32_t period = periodMs;
+        uint16_t oscillatorCalibration = readReg16Bit(OSC_CALIBRATE_VAL);
+        if(oscillatorCalibration != 0)
+            period *= oscillatorCalibration;
+        writeReg32Bit(SYSTEM_INTERMEASUREMENT_PERIOD, period);
+        writeReg(SYSRANGE_START, 0x04); // VL53L0X_REG_SYSRANGE_MODE_TIMED
+    }
+    else
+        writeReg(SYSRANGE_START, 0x02); // VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK
+}
+
+
+// Stop continuous measurements
+// based on VL53L0X_StopMeasurement()
+void VL53L0X::stopContinuous()
+{
+    writeReg(SYSRANGE_START, 0x01); // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
+    writeReg(0xFF, 0x01);
+    writeReg(0x00, 0x00);
+    writeReg(0x91, 0x00);
+    writeReg(0x00, 0x01);
+    writeReg(0xFF, 0x00);
+}
+
+
+bool VL53L0X::isMeasurementReady()
+{
+    return (readReg(RESULT_INTERRUPT_STATUS) & 0x07) != 0;
+}
+
+
+bool VL53L0X::readRangeIfReady(int *range)
+{
+    // Read interrupt status (0x13) and range result (0x1E - 0x1F) in a single transaction.
+    uint8_t registers[RESULT_RANGE_STATUS + 12 - RESULT_INTERRUPT_STATUS];
+    if(!i2c_readRegisters(adapter_, address_, RESULT_INTERRUPT_STATUS, sizeof(registers), registers))
+        return false;
+    if((registers[0] & 0x07) == 0)
+        return false;
+
+    // assumptions: Linearity Corrective Gain is 1000 (default);
+    // fractional ranging is not enabled
+    int const rangeIndex = RESULT_RANGE_STATUS + 10 - RESULT_INTERRUPT_STATUS;
+    *range = (registers[rangeIndex] << 8) + registers[rangeIndex + 1];
+    writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
     return true;
 }
 
@@ -443,7 +495,12 @@ uint16_t VL53L0X::readReg16Bit(uint8_t reg)
     unsigned char value[2];
     bool success = i2c_readRegisters(adapter_, address_, reg, 2, value);
     if (!success)
-        std::cout << "FAILED" << std::endl;
+    {
+        #ifdef DEBUG
+            std::cout << "VL53L0X: failed to read register " << static_cast<int>(reg) << std::endl;
+        #endif
+        return 0;
+    }
     return (value[0] << 8) + value[1];
 }
 
@@ -806,7 +863,8 @@ uint8_t VL53L0X::getVcselPulsePeriod(vcselPeriodType type)
 int VL53L0X::getMeasurement(void)
 {
   startTimeout();
-  while ((readReg(RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+  int range = 65535;
+  while (!readRangeIfReady(&range))
   {
     if (checkTimeoutExpired())
     {
@@ -814,13 +872,6 @@ int VL53L0X::getMeasurement(void)
       return 65535;
     }
   }
-
-  // assumptions: Linearity Corrective Gain is 1000 (default);
-  // fractional ranging is not enabled
-  uint16_t range = readReg16Bit(RESULT_RANGE_STATUS + 10);
-
-  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
-
   return range;
 }
 
@@ -0,0 +1,165 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/drivers/VL53L0XArray.h"
+
+#include <unistd.h>
+#include <iostream>
+
+namespace miam{
+
+    // Default address of the VL53L0X after reset.
+    int const VL53L0X_DEFAULT_ADDRESS = 0b0101001;
+
+    VL53L0XArray::VL53L0XArray():
+        pollPeriodUs_(2000),
+        isRunning_(false)
+    {
+    }
+
+
+    VL53L0XArray::~VL53L0XArray()
+    {
+        stop();
+    }
+
+
+    bool VL53L0XArray::init(I2CAdapter *adapter,
+                            std::vector<VL53L0XArraySensor> const& sensors,
+                            uint32_t const& periodMs,
+                            uint32_t const& timingBudgetUs,
+                            uint32_t const& pollPeriodUs)
+    {
+        stop();
+        configuration_ = sensors;
+        pollPeriodUs_ = pollPeriodUs;
+        sensors_.clear();
+        ranges_.clear();
+        status_.clear();
+
+        // Hold all sensors in reset.
+        for(auto const& sensor : configuration_)
+            if(sensor.setEnabled)
+                sensor.setEnabled(false);
+        usleep(10000);
+
+        // Bring up each sensor in turn, at the default address, then move it to its own address.
+        bool allInit = true;
+        for(auto const& sensor : configuration_)
+        {
+            VL53L0XArrayStatus status;
+            status.name = sensor.name;
+            status.nMeasurements = 0;
+            status.nPolls = 0;
+
+            if(sensor.setEnabled)
+                sensor.setEnabled(true);
+            // Boot time: 1.2ms max.
+            usleep(2000);
+
+            std::shared_ptr<VL53L0X> driver = std::make_shared<VL53L0X>();
+            status.isInit = driver->init(adapter, VL53L0X_DEFAULT_ADDRESS, false);
+            if(status.isInit)
+            {
+                driver->setAddress(sensor.address);
+                status.isInit = driver->setMeasurementTimingBudget(timingBudgetUs);
+            }
+            if(!status.isInit)
+            {
+                #ifdef DEBUG
+                    std::cout << "VL53L0XArray: failed to init sensor " << sensor.name << std::endl;
+                #endif
+                // Keep it in reset, so that it does not answer at the default address.
+                if(sensor.setEnabled)
+                    sensor.setEnabled(false);
+            }
+            allInit &= status.isInit;
+
+            sensors_.push_back(driver);
+            ranges_.push_back(std::make_shared<SensorSlot<int>>());
+            status_.push_back(status);
+        }
+
+        // Start ranging, evenly spacing the start of each sensor over the period.
+        int const nSensors = sensors_.size();
+        for(int i = 0; i < nSensors; i++)
+        {
+            if(status_[i].isInit)
+                sensors_[i]->startContinuous(periodMs);
+            if(i < nSensors - 1)
+                usleep(1000 * periodMs / nSensors);
+        }
+
+        isRunning_ = true;
+        thread_ = std::thread(&VL53L0XArray::collectionLoop, this);
+        return allInit;
+    }
+
+
+    void VL53L0XArray::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!isRunning_)
+                return;
+            isRunning_ = false;
+        }
+        if(thread_.joinable())
+            thread_.join();
+        for(unsigned int i = 0; i < sensors_.size(); i++)
+            if(status_[i].isInit)
+                sensors_[i]->stopContinuous();
+    }
+
+
+    int VL53L0XArray::getNumberOfSensors() const
+    {
+        return sensors_.size();
+    }
+
+
+    bool VL53L0XArray::getRange(int const& sensor, SensorSample<int> & range) const
+    {
+        if(sensor < 0 || sensor >= static_cast<int>(ranges_.size()))
+            return false;
+        return ranges_[sensor]->read(range);
+    }
+
+
+    std::vector<VL53L0XArrayStatus> VL53L0XArray::getStatus()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return status_;
+    }
+
+
+    void VL53L0XArray::collectionLoop()
+    {
+        int const nSensors = sensors_.size();
+        while(true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(!isRunning_)
+                    return;
+            }
+            for(int i = 0; i < nSensors; i++)
+            {
+                if(!status_[i].isInit)
+                    continue;
+                // Check the interrupt pin first, if available, to avoid a bus access.
+                if(configuration_[i].isDataReady && !configuration_[i].isDataReady())
+                    continue;
+                int range = 0;
+                bool const isNew = sensors_[i]->readRangeIfReady(&range);
+                if(isNew)
+                    ranges_[i]->publish(range, I2CPollingService::getCurrentTime());
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                status_[i].nPolls++;
+                if(isNew)
+                    status_[i].nMeasurements++;
+            }
+            usleep(pollPeriodUs_);
+        }
+    }
+}
@@ -0,0 +1,221 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/raspberry_pi/GPIOEvents.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/gpio.h>
+
+#include <iostream>
+
+namespace miam{
+
+    // Consumer name, visible in gpioinfo.
+    static char const GPIO_CONSUMER[] = "miam_utils";
+
+    // Monotonic time, in ms.
+    static int64_t getMonotonicMs()
+    {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return static_cast<int64_t>(t.tv_sec) * 1000 + t.tv_nsec / 1000000;
+    }
+
+    GPIOEventLine::GPIOEventLine():
+        fd_(-1),
+        isV2_(false),
+        debounceNs_(0),
+        lastEventNs_(0),
+        hasEvent_(false)
+    {
+    }
+
+
+    GPIOEventLine::~GPIOEventLine()
+    {
+        close();
+    }
+
+
+    bool GPIOEventLine::open(unsigned int const& gpioPin,
+                             GPIOEdge const& edges,
+                             uint32_t const& debounceUs,
+                             std::string const& chipName)
+    {
+        close();
+        int chip = ::open(chipName.c_str(), O_RDONLY | O_CLOEXEC);
+        if(chip < 0)
+        {
+            #ifdef DEBUG
+                std::cout << "Error opening " << chipName << ": " << errno << " " << strerror(errno) << std::endl;
+            #endif
+            return false;
+        }
+
+        #ifdef GPIO_V2_GET_LINE_IOCTL
+            // v2 interface: kernel-side debouncing.
+            struct gpio_v2_line_request request;
+            memset(&request, 0, sizeof(request));
+            request.offsets[0] = gpioPin;
+            request.num_lines = 1;
+            strncpy(request.consumer, GPIO_CONSUMER, GPIO_MAX_NAME_SIZE - 1);
+            request.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+            if(edges != GPIOEdge::FALLING)
+                request.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+            if(edges != GPIOEdge::RISING)
+                request.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+            if(debounceUs > 0)
+            {
+                request.config.num_attrs = 1;
+                request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+                request.config.attrs[0].attr.debounce_period_us = debounceUs;
+                request.config.attrs[0].mask = 1;
+            }
+            if(ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request) == 0)
+            {
+                fd_ = request.fd;
+                isV2_ = true;
+            }
+        #endif
+
+        if(fd_ < 0)
+        {
+            // v1 interface: software debouncing.
+            struct gpioevent_request request;
+            memset(&request, 0, sizeof(request));
+            request.lineoffset = gpioPin;
+            request.handleflags = GPIOHANDLE_REQUEST_INPUT;
+            if(edges == GPIOEdge::RISING)
+                request.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+            else if(edges == GPIOEdge::FALLING)
+                request.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+            else
+                request.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+            strncpy(request.consumer_label, GPIO_CONSUMER, sizeof(request.consumer_label) - 1);
+            if(ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &request) == 0)
+            {
+                fd_ = request.fd;
+                isV2_ = false;
+                debounceNs_ = 1000 * static_cast<uint64_t>(debounceUs);
+            }
+        }
+        ::close(chip);
+
+        if(fd_ < 0)
+        {
+            #ifdef DEBUG
+                std::cout << "Error requesting GPIO " << gpioPin << " events: " << errno << " " << strerror(errno) << std::endl;
+            #endif
+            return false;
+        }
+        // Non-blocking reads: blocking is done through poll.
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+        hasEvent_ = false;
+        return true;
+    }
+
+
+    void GPIOEventLine::close()
+    {
+        if(fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+    }
+
+
+    int GPIOEventLine::getFileDescriptor() const
+    {
+        return fd_;
+    }
+
+
+    int GPIOEventLine::waitForEvent(GPIOEvent & event, int const& timeoutMs)
+    {
+        if(fd_ < 0)
+            return -1;
+        int64_t const deadline = getMonotonicMs() + timeoutMs;
+        while(true)
+        {
+            if(readEvent(event))
+                return 1;
+            int remainingMs = -1;
+            if(timeoutMs >= 0)
+            {
+                remainingMs = static_cast<int>(deadline - getMonotonicMs());
+                if(remainingMs < 0)
+                    return 0;
+            }
+            struct pollfd pfd;
+            pfd.fd = fd_;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            int result = poll(&pfd, 1, remainingMs);
+            if(result < 0 && errno != EINTR)
+                return -1;
+            if(result == 0)
+                return 0;
+            // Event pending (or interrupted): loop to read it, as it may also be discarded by debouncing.
+        }
+    }
+
+
+    bool GPIOEventLine::readEvent(GPIOEvent & event)
+    {
+        if(fd_ < 0)
+            return false;
+        while(true)
+        {
+            #ifdef GPIO_V2_GET_LINE_IOCTL
+                if(isV2_)
+                {
+                    struct gpio_v2_line_event data;
+                    if(read(fd_, &data, sizeof(data)) != sizeof(data))
+                        return false;
+                    event.edge = (data.id == GPIO_V2_LINE_EVENT_RISING_EDGE ? GPIOEdge::RISING : GPIOEdge::FALLING);
+                    event.timestampNs = data.timestamp_ns;
+                    return true;
+                }
+            #endif
+            struct gpioevent_data data;
+            if(read(fd_, &data, sizeof(data)) != sizeof(data))
+                return false;
+            // Software debounce: drop edges too close to the previous one.
+            if(hasEvent_ && data.timestamp - lastEventNs_ < debounceNs_)
+                continue;
+            hasEvent_ = true;
+            lastEventNs_ = data.timestamp;
+            event.edge = (data.id == GPIOEVENT_EVENT_RISING_EDGE ? GPIOEdge::RISING : GPIOEdge::FALLING);
+            event.timestampNs = data.timestamp;
+            return true;
+        }
+    }
+
+
+    bool GPIOEventLine::getValue()
+    {
+        if(fd_ < 0)
+            return false;
+        #ifdef GPIO_V2_GET_LINE_IOCTL
+            if(isV2_)
+            {
+                struct gpio_v2_line_values values;
+                memset(&values, 0, sizeof(values));
+                values.mask = 1;
+                if(ioctl(fd_, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+                    return false;
+                return (values.bits & 1) != 0;
+            }
+        #endif
+        struct gpiohandle_data values;
+        memset(&values, 0, sizeof(values));
+        if(ioctl(fd_, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &values) < 0)
+            return false;
+        return values.values[0] != 0;
+    }
+}
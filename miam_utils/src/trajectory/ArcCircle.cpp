@@ -16,14 +16,16 @@ namespace miam{
                              double const& endVelocity,
                              bool const& backward,
                              double maxVelocity,
-                             double maxAcceleration):
+                             double maxAcceleration,
+                             double maxJerk):
              radius_(std::abs(radius)),
              side_(side),
              endAngle_(endAngle),
              endVelocity_(endVelocity),
              movingBackward_(1.0),
              maxVelocity_(maxVelocity),
-             maxAcceleration_(maxAcceleration)
+             maxAcceleration_(maxAcceleration),
+             maxJerk_(maxJerk)
         {
             if (backward)
                 movingBackward_ = -1.0;
@@ -79,7 +81,9 @@ namespace miam{
             // Compute trapezoid.
             double maxAngularVelocity = maxVelocity_ / (radius_ + config::robotWheelSpacing);
             double maxAngularAcceleration = maxAcceleration_ / (radius_ + config::robotWheelSpacing);
-            trapezoid_ = Trapezoid(travelAngle, startVelocity, endVelocity_, maxAngularVelocity, maxAngularAcceleration);
+            double maxAngularJerk = maxJerk_ / (radius_ + config::robotWheelSpacing);
+            trapezoid_ = Trapezoid(travelAngle, startVelocity, endVelocity_, maxAngularVelocity, maxAngularAcceleration,
+                                   maxAngularJerk);
 
             duration_ = trapezoid_.getDuration();
         }
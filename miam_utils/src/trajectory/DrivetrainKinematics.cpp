@@ -53,3 +53,36 @@ void DrivetrainKinematics::integratePosition(WheelSpeed const& wheelSpeedIn, mia
     positionInOut.x += std::cos(positionInOut.theta) * speed.linear;
     positionInOut.y += std::sin(positionInOut.theta) * speed.linear;
 }
+
+
+void DrivetrainKinematics::integratePositionArc(WheelSpeed const& wheelSpeedIn, miam::RobotPosition & positionInOut, bool const& useEncoders)
+{
+    integratePositionArc(&wheelSpeedIn, 1, positionInOut, useEncoders);
+}
+
+
+void DrivetrainKinematics::integratePositionArc(WheelSpeed const *wheelSpeedIn,
+                                                int const& nSamples,
+                                                miam::RobotPosition & positionInOut,
+                                                bool const& useEncoders)
+{
+    double const wheelRadius = (useEncoders ? encoderWheelRadius_ : motorWheelRadius_);
+    double const wheelSpacing = (useEncoders ? encoderWheelSpacing_ : motorWheelSpacing_);
+
+    for(int i = 0; i < nSamples; i++)
+    {
+        double const linear = (wheelSpeedIn[i].right + wheelSpeedIn[i].left) / 2.0 * wheelRadius;
+        double const angular = (wheelSpeedIn[i].right - wheelSpeedIn[i].left) / 2.0 * wheelRadius / wheelSpacing;
+
+        // On an arc, the chord has length linear * sin(h) / h, with h half the rotation, and is directed along
+        // the mid-arc heading. For small angles, use a series expansion of sin(h) / h.
+        double const h = angular / 2.0;
+        double const h2 = h * h;
+        double const chordRatio = (std::abs(h) < 1e-2 ? 1.0 - h2 / 6.0 * (1.0 - h2 / 20.0) : std::sin(h) / h);
+        double const chord = linear * chordRatio;
+        double const theta = positionInOut.theta + h;
+        positionInOut.x += std::cos(theta) * chord;
+        positionInOut.y += std::sin(theta) * chord;
+        positionInOut.theta += angular;
+    }
+}
@@ -0,0 +1,161 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/HolonomicControl.hpp"
+#include "miam_utils/trajectory/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace omni
+{
+    HolonomicOdometry::HolonomicOdometry():
+        position_(),
+        lastSpeed_(),
+        lastTimestamp_(0.0),
+        isInitialized_(false)
+    {
+    }
+
+
+    void HolonomicOdometry::reset(miam::RobotPosition const& position, double const& timestamp)
+    {
+        position_ = position;
+        lastTimestamp_ = timestamp;
+        isInitialized_ = true;
+    }
+
+
+    void HolonomicOdometry::update(BaseSpeed const& baseSpeed, double const& timestamp)
+    {
+        if(isInitialized_ && timestamp > lastTimestamp_)
+        {
+            BaseSpeed meanSpeed((lastSpeed_.vx_ + baseSpeed.vx_) / 2.0,
+                                (lastSpeed_.vy_ + baseSpeed.vy_) / 2.0,
+                                (lastSpeed_.omega_ + baseSpeed.omega_) / 2.0);
+            position_ = ThreeWheelsKinematics::integratePosition(position_, meanSpeed, timestamp - lastTimestamp_);
+        }
+        lastSpeed_ = baseSpeed;
+        lastTimestamp_ = std::max(lastTimestamp_, timestamp);
+        isInitialized_ = true;
+    }
+
+
+    miam::RobotPosition HolonomicOdometry::getPosition() const
+    {
+        return position_;
+    }
+
+
+    BaseSpeed HolonomicOdometry::getSpeed() const
+    {
+        return lastSpeed_;
+    }
+
+
+    HolonomicTrajectory::HolonomicTrajectory(std::vector<miam::RobotPosition> const& waypoints,
+                                             double const& maxVelocity,
+                                             double const& maxAcceleration,
+                                             double const& maxAngularVelocity,
+                                             double const& maxAngularAcceleration):
+        segments_(),
+        endPosition_(),
+        duration_(0.0)
+    {
+        if(waypoints.empty())
+            return;
+        endPosition_ = waypoints.back();
+        for(unsigned int i = 1; i < waypoints.size(); i++)
+        {
+            Segment segment;
+            segment.start_ = waypoints[i - 1];
+            segment.delta_ = waypoints[i] - waypoints[i - 1];
+            double const length = segment.delta_.norm();
+            double const rotation = std::abs(segment.delta_.theta);
+            if(length < 1e-6 && rotation < 1e-6)
+                continue;
+
+            // The segment is parametrized by its progress, from 0 to 1: its maximum velocity and acceleration are
+            // limited by both the linear and the angular constraints.
+            double maxProgressVelocity = std::numeric_limits<double>::max();
+            double maxProgressAcceleration = std::numeric_limits<double>::max();
+            if(length >= 1e-6)
+            {
+                maxProgressVelocity = maxVelocity / length;
+                maxProgressAcceleration = maxAcceleration / length;
+            }
+            if(rotation >= 1e-6)
+            {
+                maxProgressVelocity = std::min(maxProgressVelocity, maxAngularVelocity / rotation);
+                maxProgressAcceleration = std::min(maxProgressAcceleration, maxAngularAcceleration / rotation);
+            }
+            segment.trapezoid_ = miam::trajectory::Trapezoid(1.0, 0.0, 0.0, maxProgressVelocity, maxProgressAcceleration);
+            segment.startTime_ = duration_;
+            duration_ += segment.trapezoid_.getDuration();
+            segments_.push_back(segment);
+        }
+    }
+
+
+    HolonomicTrajectoryPoint HolonomicTrajectory::getCurrentPoint(double const& currentTime)
+    {
+        HolonomicTrajectoryPoint point;
+        point.position_ = endPosition_;
+        for(Segment & segment : segments_)
+        {
+            if(currentTime < segment.startTime_ + segment.trapezoid_.getDuration())
+            {
+                miam::trajectory::TrapezoidState state = segment.trapezoid_.getState(currentTime - segment.startTime_);
+                point.position_ = segment.start_ + state.position * segment.delta_;
+                point.velocity_ = BaseSpeed(state.velocity * segment.delta_.x,
+                                            state.velocity * segment.delta_.y,
+                                            state.velocity * segment.delta_.theta);
+                break;
+            }
+        }
+        return point;
+    }
+
+
+    double HolonomicTrajectory::getDuration() const
+    {
+        return duration_;
+    }
+
+
+    HolonomicPoseController::HolonomicPoseController(double const& Kp,
+                                                     double const& Ktheta,
+                                                     double const& maxVelocity,
+                                                     double const& maxAngularVelocity):
+        Kp_(Kp),
+        Ktheta_(Ktheta),
+        maxVelocity_(maxVelocity),
+        maxAngularVelocity_(maxAngularVelocity)
+    {
+    }
+
+
+    BaseSpeed HolonomicPoseController::computeCommand(miam::RobotPosition const& currentPosition,
+                                                      HolonomicTrajectoryPoint const& target) const
+    {
+        // Command in the table frame: feedforward plus proportional correction.
+        double vx = target.velocity_.vx_ + Kp_ * (target.position_.x - currentPosition.x);
+        double vy = target.velocity_.vy_ + Kp_ * (target.position_.y - currentPosition.y);
+        double omega = target.velocity_.omega_
+            + Ktheta_ * miam::trajectory::moduloTwoPi(target.position_.theta - currentPosition.theta);
+
+        // Saturation, keeping the direction of motion.
+        double const velocity = std::sqrt(vx * vx + vy * vy);
+        if(velocity > maxVelocity_)
+        {
+            vx *= maxVelocity_ / velocity;
+            vy *= maxVelocity_ / velocity;
+        }
+        omega = std::max(-maxAngularVelocity_, std::min(maxAngularVelocity_, omega));
+
+        // Express it in the robot frame.
+        double const c = std::cos(currentPosition.theta);
+        double const s = std::sin(currentPosition.theta);
+        return BaseSpeed(c * vx + s * vy, -s * vx + c * vy, omega);
+    }
+}
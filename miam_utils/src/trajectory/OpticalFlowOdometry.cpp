@@ -0,0 +1,87 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/OpticalFlowOdometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+
+    OpticalFlowOdometry::OpticalFlowOdometry(OpticalFlowSensorConfiguration const& configuration):
+        configuration_(configuration),
+        cosAngle_(std::cos(configuration.angle)),
+        sinAngle_(std::sin(configuration.angle)),
+        displacement_(),
+        heading_(0.0)
+    {
+    }
+
+
+    void OpticalFlowOdometry::update(int const& deltaX,
+                                     int const& deltaY,
+                                     double const& headingIncrement,
+                                     bool const& isValid,
+                                     int const& squal)
+    {
+        displacement_.nReports++;
+        displacement_.minimumSqual = std::min(displacement_.minimumSqual, squal);
+        if(isValid)
+        {
+            // Floor displacement under the sensor, in the robot frame.
+            double const sx = configuration_.resolution * (cosAngle_ * deltaX - sinAngle_ * deltaY);
+            double const sy = configuration_.resolution * (sinAngle_ * deltaX + cosAngle_ * deltaY);
+            // Remove the motion of the sensor due to the robot rotation around its center.
+            double const dx = sx + headingIncrement * configuration_.y;
+            double const dy = sy - headingIncrement * configuration_.x;
+            // Express it in the frame of the last getDisplacement, using the mid-report heading.
+            double const theta = heading_ + headingIncrement / 2.0;
+            double const c = std::cos(theta);
+            double const s = std::sin(theta);
+            displacement_.dx += c * dx - s * dy;
+            displacement_.dy += s * dx + c * dy;
+        }
+        else
+        {
+            displacement_.isValid = false;
+            displacement_.nInvalidReports++;
+        }
+        heading_ += headingIncrement;
+    }
+
+
+    void OpticalFlowOdometry::update(ADNS9800MotionBurst const& burst, double const& headingIncrement)
+    {
+        update(burst.deltaX, burst.deltaY, headingIncrement, isReportValid(burst), burst.squal);
+    }
+
+
+    bool OpticalFlowOdometry::isReportValid(ADNS9800MotionBurst const& burst) const
+    {
+        if((burst.motion & ADNS9800_MOTION_FAULT) || !(burst.motion & ADNS9800_MOTION_LP_VALID))
+            return false;
+        return burst.squal >= configuration_.minimumSqual && burst.shutter <= configuration_.maximumShutter;
+    }
+
+
+    OpticalFlowDisplacement OpticalFlowOdometry::getDisplacement()
+    {
+        OpticalFlowDisplacement displacement = displacement_;
+        displacement_ = OpticalFlowDisplacement();
+        heading_ = 0.0;
+        return displacement;
+    }
+
+
+    RobotPosition OpticalFlowOdometry::integrate(RobotPosition const& position,
+                                                 OpticalFlowDisplacement const& displacement,
+                                                 double const& headingIncrement)
+    {
+        RobotPosition result = position;
+        double const c = std::cos(position.theta);
+        double const s = std::sin(position.theta);
+        result.x += c * displacement.dx - s * displacement.dy;
+        result.y += s * displacement.dx + c * displacement.dy;
+        result.theta += headingIncrement;
+        return result;
+    }
+}
@@ -11,10 +11,12 @@ namespace miam{
         PointTurn::PointTurn(RobotPosition const& startPoint,
                              double const& endAngle,
                              double maxVelocity,
-                             double maxAcceleration):
+                             double maxAcceleration,
+                             double maxJerk):
              endAngle_(endAngle),
              maxVelocity_(maxVelocity),
-             maxAcceleration_(maxAcceleration)
+             maxAcceleration_(maxAcceleration),
+             maxJerk_(maxJerk)
         {
             make(startPoint);
         }
@@ -43,8 +45,10 @@ namespace miam{
             // Compute max angular velocity and acceleration, taking into account wheel spacing.
             double maxRobotAngularVelocity = maxVelocity_ / config::robotWheelSpacing;
             double maxRobotAngularAcceleration = maxAcceleration_ / config::robotWheelSpacing;
+            double maxRobotAngularJerk = maxJerk_ / config::robotWheelSpacing;
 
-            trapezoid_ = Trapezoid(length, 0.0, 0.0, maxRobotAngularVelocity, maxRobotAngularAcceleration);
+            trapezoid_ = Trapezoid(length, 0.0, 0.0, maxRobotAngularVelocity, maxRobotAngularAcceleration,
+                                   maxRobotAngularJerk);
             duration_ = trapezoid_.getDuration();
 
         }
@@ -0,0 +1,429 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/PoseEKF.h"
+#include "miam_utils/trajectory/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+
+    int const PoseEKF::STATE_SIZE;
+    int const PoseEKF::HISTORY_LENGTH;
+    int const PoseEKF::MAX_OBSERVATIONS;
+
+    // Invert a symmetric positive definite matrix of size 1 to 3, by Gauss-Jordan elimination.
+    static bool invertMatrix(int const& size, double const S[3][3], double inverse[3][3])
+    {
+        double A[3][3];
+        for(int i = 0; i < size; i++)
+            for(int j = 0; j < size; j++)
+            {
+                A[i][j] = S[i][j];
+                inverse[i][j] = (i == j ? 1.0 : 0.0);
+            }
+        for(int i = 0; i < size; i++)
+        {
+            // No pivoting needed: the matrix is positive definite.
+            if(A[i][i] < 1e-12)
+                return false;
+            double const pivot = 1.0 / A[i][i];
+            for(int j = 0; j < size; j++)
+            {
+                A[i][j] *= pivot;
+                inverse[i][j] *= pivot;
+            }
+            for(int k = 0; k < size; k++)
+            {
+                if(k == i)
+                    continue;
+                double const factor = A[k][i];
+                for(int j = 0; j < size; j++)
+                {
+                    A[k][j] -= factor * A[i][j];
+                    inverse[k][j] -= factor * inverse[i][j];
+                }
+            }
+        }
+        return true;
+    }
+
+
+    PoseEKF::PoseEKF(PoseEKFParameters const& parameters):
+        parameters_(parameters),
+        historyStart_(0),
+        historySize_(0)
+    {
+    }
+
+
+    void PoseEKF::reset(double const& timestamp,
+                        RobotPosition const& position,
+                        double const& positionStd,
+                        double const& angleStd)
+    {
+        historyStart_ = 0;
+        historySize_ = 1;
+        Tick & tick = history_[0];
+        tick.timestamp = timestamp;
+        tick.distance = 0.0;
+        tick.encoderAngle = 0.0;
+        tick.gyroRate = 0.0;
+        tick.hasGyro = false;
+        tick.nObservations = 0;
+        tick.state[0] = position.x;
+        tick.state[1] = position.y;
+        tick.state[2] = position.theta;
+        tick.state[3] = 0.0;
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < STATE_SIZE; j++)
+                tick.P[i][j] = 0.0;
+        tick.P[0][0] = positionStd * positionStd;
+        tick.P[1][1] = positionStd * positionStd;
+        tick.P[2][2] = angleStd * angleStd;
+        if(parameters_.estimateGyroBias)
+            tick.P[3][3] = parameters_.initialBiasStd * parameters_.initialBiasStd;
+    }
+
+
+    void PoseEKF::predict(double const& timestamp,
+                          double const& distance,
+                          double const& encoderAngle,
+                          double const& gyroRate)
+    {
+        addTick(timestamp, distance, encoderAngle, gyroRate, true);
+    }
+
+
+    void PoseEKF::predict(double const& timestamp, double const& distance, double const& encoderAngle)
+    {
+        addTick(timestamp, distance, encoderAngle, 0.0, false);
+    }
+
+
+    void PoseEKF::addTick(double const& timestamp,
+                          double const& distance,
+                          double const& encoderAngle,
+                          double const& gyroRate,
+                          bool const& hasGyro)
+    {
+        if(historySize_ == 0)
+            return;
+        Tick const& previous = tickAt(historySize_ - 1);
+        // When the history is full, the oldest tick is dropped.
+        if(historySize_ < HISTORY_LENGTH)
+            historySize_++;
+        else
+            historyStart_ = (historyStart_ + 1) % HISTORY_LENGTH;
+        Tick & tick = tickAt(historySize_ - 1);
+        tick.timestamp = std::max(timestamp, previous.timestamp);
+        tick.distance = distance;
+        tick.encoderAngle = encoderAngle;
+        tick.gyroRate = gyroRate;
+        tick.hasGyro = hasGyro;
+        tick.nObservations = 0;
+        propagate(previous, tick);
+    }
+
+
+    void PoseEKF::propagate(Tick const& previous, Tick & tick) const
+    {
+        double const dt = tick.timestamp - previous.timestamp;
+        double const d = tick.distance;
+        double const theta = previous.state[2];
+        double const bias = previous.state[3];
+
+        // Rotation, and its derivative with respect to the bias.
+        double angle, angleVariance, dAngleDBias;
+        if(tick.hasGyro)
+        {
+            angle = (tick.gyroRate - bias) * dt;
+            angleVariance = parameters_.gyroNoiseDensity * parameters_.gyroNoiseDensity * dt;
+            dAngleDBias = -dt;
+        }
+        else
+        {
+            angle = tick.encoderAngle;
+            angleVariance = parameters_.encoderAngleNoise * parameters_.encoderAngleNoise * angle * angle
+                + parameters_.encoderAngleNoiseDensity * parameters_.encoderAngleNoiseDensity * dt;
+            dAngleDBias = 0.0;
+        }
+        double const distanceVariance = parameters_.distanceNoise * parameters_.distanceNoise * d * d
+            + parameters_.distanceNoiseDensity * parameters_.distanceNoiseDensity * dt;
+
+        // Motion along the mid-tick heading.
+        double const c = std::cos(theta + angle / 2.0);
+        double const s = std::sin(theta + angle / 2.0);
+        tick.state[0] = previous.state[0] + d * c;
+        tick.state[1] = previous.state[1] + d * s;
+        tick.state[2] = theta + angle;
+        tick.state[3] = bias;
+
+        // Jacobians with respect to the state (F), and to the (distance, angle) input (G).
+        double F[STATE_SIZE][STATE_SIZE] = {{1.0, 0.0, -d * s, -d * s * dAngleDBias / 2.0},
+                                            {0.0, 1.0, d * c, d * c * dAngleDBias / 2.0},
+                                            {0.0, 0.0, 1.0, dAngleDBias},
+                                            {0.0, 0.0, 0.0, 1.0}};
+        double const G[STATE_SIZE][2] = {{c, -d * s / 2.0},
+                                         {s, d * c / 2.0},
+                                         {0.0, 1.0},
+                                         {0.0, 0.0}};
+
+        // P = F P F^T + G Q G^T
+        double FP[STATE_SIZE][STATE_SIZE];
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < STATE_SIZE; j++)
+            {
+                FP[i][j] = 0.0;
+                for(int k = 0; k < STATE_SIZE; k++)
+                    FP[i][j] += F[i][k] * previous.P[k][j];
+            }
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = i; j < STATE_SIZE; j++)
+            {
+                double value = G[i][0] * distanceVariance * G[j][0] + G[i][1] * angleVariance * G[j][1];
+                for(int k = 0; k < STATE_SIZE; k++)
+                    value += FP[i][k] * F[j][k];
+                tick.P[i][j] = value;
+                tick.P[j][i] = value;
+            }
+
+        if(parameters_.estimateGyroBias)
+        {
+            tick.P[3][3] += parameters_.biasRandomWalk * parameters_.biasRandomWalk * dt;
+            // Bias observation: the difference between encoder and gyroscope rotation rates.
+            if(tick.hasGyro && dt > 0)
+            {
+                double const innovation = tick.encoderAngle / dt - tick.gyroRate + bias;
+                double const H[1][STATE_SIZE] = {{0.0, 0.0, 0.0, -1.0}};
+                double const R = (parameters_.encoderAngleNoise * parameters_.encoderAngleNoise
+                                  * tick.encoderAngle * tick.encoderAngle
+                                  + parameters_.encoderAngleNoiseDensity * parameters_.encoderAngleNoiseDensity * dt)
+                                  / (dt * dt) + parameters_.gyroNoiseDensity * parameters_.gyroNoiseDensity / dt;
+                // Gating rejects wheel slip.
+                correct(tick, 1, &innovation, H, &R, true);
+            }
+        }
+
+        for(int i = 0; i < tick.nObservations; i++)
+            apply(tick.observations[i], tick);
+    }
+
+
+    bool PoseEKF::correct(Tick & tick,
+                          int const& size,
+                          double const *innovation,
+                          double const H[][STATE_SIZE],
+                          double const *R,
+                          bool const& useGating) const
+    {
+        // PHt = P H^T, S = H P H^T + R
+        double PHt[STATE_SIZE][3];
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < size; j++)
+            {
+                PHt[i][j] = 0.0;
+                for(int k = 0; k < STATE_SIZE; k++)
+                    PHt[i][j] += tick.P[i][k] * H[j][k];
+            }
+        double S[3][3];
+        for(int i = 0; i < size; i++)
+            for(int j = 0; j < size; j++)
+            {
+                S[i][j] = (i == j ? R[i] : 0.0);
+                for(int k = 0; k < STATE_SIZE; k++)
+                    S[i][j] += H[i][k] * PHt[k][j];
+            }
+        double Sinv[3][3];
+        if(!invertMatrix(size, S, Sinv))
+            return false;
+
+        if(useGating && parameters_.mahalanobisThreshold > 0)
+        {
+            double distance = 0.0;
+            for(int i = 0; i < size; i++)
+                for(int j = 0; j < size; j++)
+                    distance += innovation[i] * Sinv[i][j] * innovation[j];
+            if(distance > parameters_.mahalanobisThreshold)
+                return false;
+        }
+
+        // K = P H^T S^-1, x += K y, P -= K S K^T = K H P
+        double K[STATE_SIZE][3];
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < size; j++)
+            {
+                K[i][j] = 0.0;
+                for(int k = 0; k < size; k++)
+                    K[i][j] += PHt[i][k] * Sinv[k][j];
+            }
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < size; j++)
+                tick.state[i] += K[i][j] * innovation[j];
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = i; j < STATE_SIZE; j++)
+            {
+                double value = tick.P[i][j];
+                for(int k = 0; k < size; k++)
+                    value -= K[i][k] * PHt[j][k];
+                tick.P[i][j] = value;
+                tick.P[j][i] = value;
+            }
+        if(!parameters_.estimateGyroBias)
+            tick.state[3] = 0.0;
+        return true;
+    }
+
+
+    bool PoseEKF::apply(Observation const& observation, Tick & tick) const
+    {
+        double innovation[3];
+        double H[3][STATE_SIZE] = {{0.0}};
+        if(observation.size == 2)
+        {
+            // Beacon: range and bearing.
+            double const dx = observation.beacon.x - tick.state[0];
+            double const dy = observation.beacon.y - tick.state[1];
+            double const q = dx * dx + dy * dy;
+            double const r = std::sqrt(q);
+            if(r < 1e-6)
+                return false;
+            innovation[0] = observation.z[0] - r;
+            innovation[1] = trajectory::moduloTwoPi(observation.z[1] - (std::atan2(dy, dx) - tick.state[2]));
+            H[0][0] = -dx / r;
+            H[0][1] = -dy / r;
+            H[1][0] = dy / q;
+            H[1][1] = -dx / q;
+            H[1][2] = -1.0;
+        }
+        else
+        {
+            // Full position.
+            innovation[0] = observation.z[0] - tick.state[0];
+            innovation[1] = observation.z[1] - tick.state[1];
+            innovation[2] = trajectory::moduloTwoPi(observation.z[2] - tick.state[2]);
+            for(int i = 0; i < 3; i++)
+                H[i][i] = 1.0;
+        }
+        return correct(tick, observation.size, innovation, H, observation.R, true);
+    }
+
+
+    bool PoseEKF::updateBeacon(double const& timestamp,
+                               RobotPosition const& beacon,
+                               double const& range,
+                               double const& bearing,
+                               double const& rangeStd,
+                               double const& bearingStd)
+    {
+        Observation observation;
+        observation.size = 2;
+        observation.beacon = beacon;
+        observation.z[0] = range;
+        observation.z[1] = bearing;
+        observation.R[0] = rangeStd * rangeStd;
+        observation.R[1] = bearingStd * bearingStd;
+        return addObservation(timestamp, observation);
+    }
+
+
+    bool PoseEKF::updatePosition(double const& timestamp,
+                                 RobotPosition const& position,
+                                 double const& positionStd,
+                                 double const& angleStd)
+    {
+        Observation observation;
+        observation.size = 3;
+        observation.z[0] = position.x;
+        observation.z[1] = position.y;
+        observation.z[2] = position.theta;
+        observation.R[0] = positionStd * positionStd;
+        observation.R[1] = positionStd * positionStd;
+        observation.R[2] = angleStd * angleStd;
+        return addObservation(timestamp, observation);
+    }
+
+
+    bool PoseEKF::addObservation(double const& timestamp, Observation const& observation)
+    {
+        int const index = findTick(timestamp);
+        if(index < 0)
+            return false;
+        Tick & tick = tickAt(index);
+        if(tick.nObservations >= MAX_OBSERVATIONS)
+            return false;
+        // Stored even if rejected now: it may be accepted when replaying, after an older observation.
+        tick.observations[tick.nObservations] = observation;
+        tick.nObservations++;
+        bool const isAccepted = apply(observation, tick);
+        if(isAccepted)
+            replayFrom(index);
+        return isAccepted;
+    }
+
+
+    int PoseEKF::findTick(double const& timestamp) const
+    {
+        if(historySize_ == 0 || timestamp < tickAt(0).timestamp)
+            return -1;
+        int index = historySize_ - 1;
+        while(tickAt(index).timestamp > timestamp)
+            index--;
+        if(index < historySize_ - 1
+           && tickAt(index + 1).timestamp - timestamp < timestamp - tickAt(index).timestamp)
+            index++;
+        return index;
+    }
+
+
+    void PoseEKF::replayFrom(int const& index)
+    {
+        for(int i = index + 1; i < historySize_; i++)
+            propagate(tickAt(i - 1), tickAt(i));
+    }
+
+
+    PoseEKF::Tick & PoseEKF::tickAt(int const& index)
+    {
+        return history_[(historyStart_ + index) % HISTORY_LENGTH];
+    }
+
+
+    PoseEKF::Tick const& PoseEKF::tickAt(int const& index) const
+    {
+        return history_[(historyStart_ + index) % HISTORY_LENGTH];
+    }
+
+
+    RobotPosition PoseEKF::getPosition() const
+    {
+        if(historySize_ == 0)
+            return RobotPosition();
+        Tick const& tick = tickAt(historySize_ - 1);
+        return RobotPosition(tick.state[0], tick.state[1], tick.state[2]);
+    }
+
+
+    double PoseEKF::getGyroBias() const
+    {
+        if(historySize_ == 0)
+            return 0.0;
+        return tickAt(historySize_ - 1).state[3];
+    }
+
+
+    void PoseEKF::getCovariance(double covariance[STATE_SIZE][STATE_SIZE]) const
+    {
+        for(int i = 0; i < STATE_SIZE; i++)
+            for(int j = 0; j < STATE_SIZE; j++)
+                covariance[i][j] = (historySize_ == 0 ? 0.0 : tickAt(historySize_ - 1).P[i][j]);
+    }
+
+
+    double PoseEKF::getTimestamp() const
+    {
+        if(historySize_ == 0)
+            return 0.0;
+        return tickAt(historySize_ - 1).timestamp;
+    }
+}
@@ -0,0 +1,662 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/ProfiledTrajectory.h"
+#include "miam_utils/trajectory/Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+    namespace trajectory{
+
+        // Pose after moving by distance from position, with curvature curvature + rate * s. The chord of an arc of
+        // length d and rotation h has length d sin(h/2) / (h/2), and is oriented along the mean heading. The same
+        // formula is used for small clothoid steps, the mean heading including the curvature rate.
+        static RobotPosition advance(RobotPosition const& position, double const& curvature, double const& rate, double const& distance)
+        {
+            // Below 1e-3, the series expansion of sin(x)/x is used (exact for lines).
+            double const halfRotation = (curvature + rate * distance / 2.0) * distance / 2.0;
+            double chordRatio;
+            if(std::abs(halfRotation) < 1e-3)
+                chordRatio = 1.0 - halfRotation * halfRotation / 6.0;
+            else
+                chordRatio = std::sin(halfRotation) / halfRotation;
+            double const meanHeading = position.theta + (curvature / 2.0 + rate * distance / 6.0) * distance;
+            RobotPosition output;
+            output.x = position.x + distance * chordRatio * std::cos(meanHeading);
+            output.y = position.y + distance * chordRatio * std::sin(meanHeading);
+            output.theta = position.theta + 2.0 * halfRotation;
+            return output;
+        }
+
+
+        GeometricPath::GeometricPath(RobotPosition const& start, double const& tableStep):
+            start_(start),
+            elements_(),
+            table_(),
+            tableStep_(tableStep)
+        {
+        }
+
+
+        void GeometricPath::addLine(double const& length)
+        {
+            if(length <= 0.0)
+                return;
+            Element element;
+            element.start = getEndPosition();
+            element.startAbscissa = getLength();
+            element.length = length;
+            element.curvature = 0.0;
+            element.tableIndex = -1;
+            elements_.push_back(element);
+        }
+
+
+        void GeometricPath::addArc(double const& radius, double const& angle)
+        {
+            if(radius <= 0.0 || angle == 0.0)
+                return;
+            Element element;
+            element.start = getEndPosition();
+            element.startAbscissa = getLength();
+            element.length = radius * std::abs(angle);
+            element.curvature = (angle > 0 ? 1.0 : -1.0) / radius;
+            element.tableIndex = -1;
+            elements_.push_back(element);
+        }
+
+
+        void GeometricPath::addClothoid(double const& length, double const& endCurvature)
+        {
+            if(length <= 0.0 || !std::isfinite(length) || !std::isfinite(endCurvature))
+                return;
+            double const startCurvature = getEndCurvature();
+            double const rate = (endCurvature - startCurvature) / length;
+            int const tableIndex = table_.size();
+            int const nSteps = static_cast<int>(std::ceil(length / tableStep_));
+            // Integrate by substeps, for accuracy.
+            int const N_SUBSTEPS = 4;
+            TableEntry entry;
+            entry.position = getEndPosition();
+            entry.curvature = startCurvature;
+            table_.push_back(entry);
+            for(int i = 1; i <= nSteps; i++)
+            {
+                double const startAbscissa = (i - 1) * tableStep_;
+                double const step = (std::min(i * tableStep_, length) - startAbscissa) / N_SUBSTEPS;
+                for(int j = 0; j < N_SUBSTEPS; j++)
+                    entry.position = advance(entry.position, startCurvature + rate * (startAbscissa + j * step), rate, step);
+                entry.curvature = startCurvature + rate * std::min(i * tableStep_, length);
+                table_.push_back(entry);
+            }
+            addTabulatedElement(tableIndex, length);
+        }
+
+
+        void GeometricPath::addQuinticSpline(RobotPosition const& end, double const& endCurvature)
+        {
+            RobotPosition const start = getEndPosition();
+            double const chord = distance(start, end);
+            if(chord < 1e-6)
+                return;
+
+            // Hermite conditions: first derivative along the heading, with norm chord; second derivative
+            // orthogonal to it, for the given curvature. Polynomial coefficients, for both x and y.
+            double const startCurvature = getEndCurvature();
+            double const p0[2] = {start.x, start.y};
+            double const p1[2] = {end.x, end.y};
+            double const v0[2] = {chord * std::cos(start.theta), chord * std::sin(start.theta)};
+            double const v1[2] = {chord * std::cos(end.theta), chord * std::sin(end.theta)};
+            double const a0[2] = {-startCurvature * chord * v0[1], startCurvature * chord * v0[0]};
+            double const a1[2] = {-endCurvature * chord * v1[1], endCurvature * chord * v1[0]};
+            double c[2][6];
+            for(int i = 0; i < 2; i++)
+            {
+                double const delta = p1[i] - p0[i];
+                c[i][0] = p0[i];
+                c[i][1] = v0[i];
+                c[i][2] = a0[i] / 2.0;
+                c[i][3] = 10.0 * delta - 6.0 * v0[i] - 4.0 * v1[i] - 1.5 * a0[i] + 0.5 * a1[i];
+                c[i][4] = -15.0 * delta + 8.0 * v0[i] + 7.0 * v1[i] + 1.5 * a0[i] - a1[i];
+                c[i][5] = 6.0 * delta - 3.0 * v0[i] - 3.0 * v1[i] - 0.5 * a0[i] + 0.5 * a1[i];
+            }
+            // Value, first and second derivative of coordinate i at parameter u.
+            auto evaluate = [&c](int const& i, double const& u, double& value, double& derivative, double& second)
+            {
+                value = c[i][0] + u * (c[i][1] + u * (c[i][2] + u * (c[i][3] + u * (c[i][4] + u * c[i][5]))));
+                derivative = c[i][1] + u * (2.0 * c[i][2] + u * (3.0 * c[i][3] + u * (4.0 * c[i][4] + u * 5.0 * c[i][5])));
+                second = 2.0 * c[i][2] + u * (6.0 * c[i][3] + u * (12.0 * c[i][4] + u * 20.0 * c[i][5]));
+            };
+
+            // Arc length as a function of the parameter, from a dense sampling.
+            int const nSamples = std::max(32, 8 * static_cast<int>(std::ceil(chord / tableStep_)));
+            std::vector<double> abscissa(nSamples + 1, 0.0);
+            double previousX = start.x, previousY = start.y;
+            for(int k = 1; k <= nSamples; k++)
+            {
+                double x, y, dx, dy, ddx, ddy;
+                evaluate(0, static_cast<double>(k) / nSamples, x, dx, ddx);
+                evaluate(1, static_cast<double>(k) / nSamples, y, dy, ddy);
+                abscissa[k] = abscissa[k - 1] + std::hypot(x - previousX, y - previousY);
+                previousX = x;
+                previousY = y;
+            }
+            double const length = abscissa[nSamples];
+            if(!std::isfinite(length))
+                return;
+
+            // Table at a constant abscissa step: parameter interpolated from the sampling.
+            int const tableIndex = table_.size();
+            int const nSteps = static_cast<int>(std::ceil(length / tableStep_));
+            double theta = start.theta;
+            int k = 0;
+            for(int i = 0; i <= nSteps; i++)
+            {
+                double const s = std::min(i * tableStep_, length);
+                while(k + 1 < nSamples && abscissa[k + 1] < s)
+                    k++;
+                double const u = (i == nSteps ? 1.0 :
+                    (k + (s - abscissa[k]) / std::max(abscissa[k + 1] - abscissa[k], 1e-12)) / nSamples);
+                double x, y, dx, dy, ddx, ddy;
+                evaluate(0, u, x, dx, ddx);
+                evaluate(1, u, y, dy, ddy);
+                double const speed = std::max(std::hypot(dx, dy), 1e-12);
+                theta += moduloTwoPi(std::atan2(dy, dx) - theta);
+                TableEntry entry;
+                entry.position = RobotPosition(x, y, theta);
+                entry.curvature = (dx * ddy - dy * ddx) / (speed * speed * speed);
+                table_.push_back(entry);
+            }
+            addTabulatedElement(tableIndex, length);
+        }
+
+
+        void GeometricPath::addTabulatedElement(int const& tableIndex, double const& length)
+        {
+            Element element;
+            element.start = table_[tableIndex].position;
+            element.startAbscissa = getLength();
+            element.length = length;
+            element.curvature = table_[tableIndex].curvature;
+            element.tableIndex = tableIndex;
+            elements_.push_back(element);
+        }
+
+
+        double GeometricPath::getLength() const
+        {
+            if(elements_.empty())
+                return 0.0;
+            return elements_.back().startAbscissa + elements_.back().length;
+        }
+
+
+        RobotPosition GeometricPath::getEndPosition() const
+        {
+            if(elements_.empty())
+                return start_;
+            return getPosition(elements_.back(), elements_.back().length);
+        }
+
+
+        double GeometricPath::getEndCurvature() const
+        {
+            if(elements_.empty())
+                return 0.0;
+            return getCurvature(elements_.back(), elements_.back().length);
+        }
+
+
+        RobotPosition GeometricPath::getPosition(double const& abscissa) const
+        {
+            if(elements_.empty())
+                return start_;
+            Element const& element = elements_[findElement(abscissa)];
+            double const distance = std::max(0.0, std::min(element.length, abscissa - element.startAbscissa));
+            return getPosition(element, distance);
+        }
+
+
+        double GeometricPath::getCurvature(double const& abscissa) const
+        {
+            if(elements_.empty())
+                return 0.0;
+            Element const& element = elements_[findElement(abscissa)];
+            return getCurvature(element, abscissa - element.startAbscissa);
+        }
+
+
+        double GeometricPath::getMaxCurvature(double const& startAbscissa, double const& endAbscissa) const
+        {
+            double maxCurvature = 0.0;
+            for(int i = findElement(startAbscissa); i < static_cast<int>(elements_.size()); i++)
+            {
+                Element const& element = elements_[i];
+                if(element.startAbscissa > endAbscissa)
+                    break;
+                double const start = std::max(0.0, startAbscissa - element.startAbscissa);
+                double const end = std::min(element.length, endAbscissa - element.startAbscissa);
+                if(end < start)
+                    continue;
+                maxCurvature = std::max(maxCurvature, std::max(std::abs(getCurvature(element, start)),
+                                                               std::abs(getCurvature(element, end))));
+                if(element.tableIndex >= 0)
+                {
+                    // Curvature is linear between table entries: only the entries within the range remain.
+                    int const nSteps = static_cast<int>(std::ceil(element.length / tableStep_));
+                    int const last = std::min(nSteps, static_cast<int>(std::floor(end / tableStep_)));
+                    for(int j = static_cast<int>(std::ceil(start / tableStep_)); j <= last; j++)
+                        maxCurvature = std::max(maxCurvature, std::abs(table_[element.tableIndex + j].curvature));
+                }
+            }
+            return maxCurvature;
+        }
+
+
+        std::vector<GeometricPath::Element> const& GeometricPath::getElements() const
+        {
+            return elements_;
+        }
+
+
+        int GeometricPath::findElement(double const& abscissa) const
+        {
+            std::vector<Element>::const_iterator next = std::upper_bound(elements_.begin(), elements_.end(), abscissa,
+                [](double const& s, Element const& element){return s < element.startAbscissa;});
+            return std::max(0, static_cast<int>(next - elements_.begin()) - 1);
+        }
+
+
+        RobotPosition GeometricPath::getPosition(Element const& element, double const& distance) const
+        {
+            if(element.tableIndex < 0)
+                return advance(element.start, element.curvature, 0.0, distance);
+
+            // From the previous table entry, curvature interpolated linearly.
+            int const nSteps = static_cast<int>(std::ceil(element.length / tableStep_));
+            int const step = std::max(0, std::min(nSteps - 1, static_cast<int>(distance / tableStep_)));
+            if(distance >= element.length)
+                return table_[element.tableIndex + nSteps].position;
+            TableEntry const& entry = table_[element.tableIndex + step];
+            TableEntry const& next = table_[element.tableIndex + step + 1];
+            double const stepLength = std::min((step + 1) * tableStep_, element.length) - step * tableStep_;
+            double const rate = (next.curvature - entry.curvature) / stepLength;
+            return advance(entry.position, entry.curvature, rate, distance - step * tableStep_);
+        }
+
+
+        double GeometricPath::getCurvature(Element const& element, double const& distance) const
+        {
+            if(element.tableIndex < 0)
+                return element.curvature;
+            int const nSteps = static_cast<int>(std::ceil(element.length / tableStep_));
+            int const step = std::max(0, std::min(nSteps - 1, static_cast<int>(distance / tableStep_)));
+            TableEntry const& entry = table_[element.tableIndex + step];
+            TableEntry const& next = table_[element.tableIndex + step + 1];
+            double const stepLength = std::min((step + 1) * tableStep_, element.length) - step * tableStep_;
+            double const ratio = std::max(0.0, std::min(1.0, (distance - step * tableStep_) / stepLength));
+            return entry.curvature + ratio * (next.curvature - entry.curvature);
+        }
+
+
+        GeometricPath computeRoundedCornerPath(std::vector<RobotPosition> const& positions, double const& radius)
+        {
+            if(positions.size() < 2)
+                return GeometricPath(positions.empty() ? RobotPosition() : positions.front());
+
+            RobotPosition start = positions.front();
+            start.theta = std::atan2(positions[1].y - start.y, positions[1].x - start.x);
+            GeometricPath path(start);
+
+            // Current end of the path.
+            RobotPosition current = start;
+            for(unsigned int i = 1; i + 1 < positions.size(); i++)
+            {
+                RobotPosition const& corner = positions[i];
+                RobotPosition firstVector = current - corner;
+                RobotPosition secondVector = positions[i + 1] - corner;
+                double const firstNorm = firstVector.norm();
+                double const secondNorm = secondVector.norm();
+                if(firstNorm < 1e-6 || secondNorm < 1e-6)
+                    continue;
+                firstVector.normalize();
+                secondVector.normalize();
+
+                // Rotation at the corner, limited to keep a non-zero radius for U-turns.
+                double const cosine = std::max(-1.0, std::min(1.0, firstVector.dot(secondVector)));
+                double const rotation = std::min(M_PI - std::acos(cosine), M_PI - 1e-6);
+                if(rotation < 1e-6)
+                    continue;
+
+                // Distance from the corner to the arc ends: at most all of the first segment, half of the second one.
+                double const tangent = std::tan(rotation / 2.0);
+                double const circleRadius = std::min(radius, std::min(firstNorm, secondNorm / 2.0) / tangent);
+                double const cornerDistance = circleRadius * tangent;
+
+                path.addLine(firstNorm - cornerDistance);
+                path.addArc(circleRadius, firstVector.cross(secondVector) < 0 ? rotation : -rotation);
+                current = corner + cornerDistance * secondVector;
+            }
+            path.addLine(distance(current, positions.back()));
+            return path;
+        }
+
+
+        GeometricPath computeSmoothPath(std::vector<RobotPosition> const& positions)
+        {
+            // Remove consecutive duplicates.
+            std::vector<RobotPosition> points;
+            for(RobotPosition const& position : positions)
+                if(points.empty() || distance(points.back(), position) > 1e-6)
+                    points.push_back(position);
+            if(points.size() < 2)
+                return GeometricPath(points.empty() ? RobotPosition() : points.front());
+
+            RobotPosition start = points.front();
+            start.theta = std::atan2(points[1].y - start.y, points[1].x - start.x);
+            GeometricPath path(start);
+            for(unsigned int i = 1; i < points.size(); i++)
+            {
+                RobotPosition end = points[i];
+                double curvature = 0.0;
+                if(i + 1 < points.size())
+                {
+                    // Heading along the neighbours, curvature of the circle through the three points.
+                    RobotPosition const before = points[i] - points[i - 1];
+                    RobotPosition const after = points[i + 1] - points[i];
+                    RobotPosition const across = points[i + 1] - points[i - 1];
+                    if(across.norm() < 1e-6)
+                    {
+                        // Going back to the previous point: U-turn to the left, on the circle whose diameter is the
+                        // shortest segment.
+                        end.theta = std::atan2(before.y, before.x) + M_PI_2;
+                        curvature = 2.0 / std::min(before.norm(), after.norm());
+                    }
+                    else
+                    {
+                        end.theta = std::atan2(across.y, across.x);
+                        curvature = 2.0 * before.cross(after) / (before.norm() * after.norm() * across.norm());
+                    }
+                }
+                else
+                    end.theta = std::atan2(end.y - points[i - 1].y, end.x - points[i - 1].x);
+                path.addQuinticSpline(end, curvature);
+            }
+            return path;
+        }
+
+
+        ProfiledTrajectory::ProfiledTrajectory(GeometricPath const& path,
+                                               double const& startVelocity,
+                                               double const& endVelocity,
+                                               double maxWheelVelocity,
+                                               double maxWheelAcceleration,
+                                               double wheelSpacing,
+                                               double const& stationSpacing,
+                                               double maxWheelJerk):
+            Trajectory(),
+            path_(path),
+            stations_(),
+            cursor_(0),
+            lagCursor_(0),
+            filterDuration_(0.0),
+            endVelocity_(std::abs(endVelocity)),
+            maxWheelVelocity_(std::abs(maxWheelVelocity)),
+            maxWheelAcceleration_(std::abs(maxWheelAcceleration)),
+            wheelSpacing_(std::abs(wheelSpacing)),
+            stationSpacing_(stationSpacing),
+            maxWheelJerk_(std::abs(maxWheelJerk))
+        {
+            make(0.0, startVelocity);
+        }
+
+
+        void ProfiledTrajectory::make(double const& startAbscissa, double const& startVelocity)
+        {
+            double const endAbscissa = path_.getLength();
+            double const length = endAbscissa - startAbscissa;
+            double v0 = std::min(std::abs(startVelocity), maxWheelVelocity_);
+            double v1 = std::min(endVelocity_, maxWheelVelocity_);
+            filterDuration_ = 0.0;
+            if(maxWheelJerk_ > 0.0 && length > 0.0)
+            {
+                // Averaging adds (v0 + v1) T / 2 to the distance travelled: keep at least half of the path.
+                filterDuration_ = 2.0 * maxWheelAcceleration_ / maxWheelJerk_;
+                if(v0 + v1 > 0.0)
+                    filterDuration_ = std::min(filterDuration_, length / (v0 + v1));
+            }
+
+            // The shortened path depends on the start and end velocities actually obtained, which may be lower than
+            // the requested ones: iterate until they match.
+            for(int i = 0; i < 3; i++)
+            {
+                computeProfile(startAbscissa + v0 * filterDuration_ / 2.0,
+                               endAbscissa - v1 * filterDuration_ / 2.0,
+                               v0,
+                               v1,
+                               maxWheelVelocity_ * filterDuration_);
+                if(filterDuration_ <= 0.0 || (stations_.front().velocity == v0 && stations_.back().velocity == v1))
+                    break;
+                v0 = stations_.front().velocity;
+                v1 = stations_.back().velocity;
+            }
+            cursor_ = 0;
+            lagCursor_ = 0;
+            duration_ = stations_.back().time + filterDuration_;
+        }
+
+
+        void ProfiledTrajectory::placeStations(double const& startAbscissa,
+                                               double const& endAbscissa,
+                                               std::vector<double>& curvatures)
+        {
+            stations_.clear();
+            curvatures.clear();
+            Station station;
+            station.abscissa = startAbscissa;
+            stations_.push_back(station);
+            for(GeometricPath::Element const& element : path_.getElements())
+            {
+                double const start = std::max(element.startAbscissa, startAbscissa);
+                double const end = std::min(element.startAbscissa + element.length, endAbscissa);
+                if(end <= start + 1e-9)
+                    continue;
+                int const nIntervals = std::max(1, static_cast<int>(std::ceil((end - start) / stationSpacing_)));
+                for(int i = 1; i <= nIntervals; i++)
+                {
+                    // Largest curvature over the interval, taken slightly inside to stay on this element.
+                    double const intervalStart = start + (end - start) * (i - 1) / nIntervals;
+                    station.abscissa = start + (end - start) * i / nIntervals;
+                    double const margin = (station.abscissa - intervalStart) * 1e-3;
+                    curvatures.push_back(path_.getMaxCurvature(intervalStart + margin, station.abscissa - margin));
+                    stations_.push_back(station);
+                }
+            }
+            // A single interval would have both stations at rest on a rest-to-rest motion, hence no motion at all:
+            // split it, so that the middle station can carry velocity.
+            if(curvatures.size() == 1)
+            {
+                station.abscissa = (stations_[0].abscissa + stations_[1].abscissa) / 2.0;
+                stations_.insert(stations_.begin() + 1, station);
+                curvatures.push_back(curvatures[0]);
+            }
+        }
+
+
+        void ProfiledTrajectory::computeProfile(double const& startAbscissa,
+                                                double const& endAbscissa,
+                                                double const& startVelocity,
+                                                double const& endVelocity,
+                                                double const& margin)
+        {
+            // Curvature of the neighbourhood of each interval: sample it first, then take the max over the margin.
+            std::vector<double> curvatures;
+            std::vector<double> sampleAbscissas;
+            std::vector<double> sampleCurvatures;
+            if(margin > 0.0)
+            {
+                placeStations(std::max(0.0, startAbscissa - margin),
+                              std::min(path_.getLength(), endAbscissa + margin),
+                              sampleCurvatures);
+                for(Station const& station : stations_)
+                    sampleAbscissas.push_back(station.abscissa);
+            }
+            placeStations(startAbscissa, endAbscissa, curvatures);
+            int const nStations = stations_.size();
+            if(margin > 0.0)
+            {
+                int first = 0;
+                for(int i = 0; i + 1 < nStations; i++)
+                {
+                    double const low = stations_[i].abscissa - margin;
+                    double const high = stations_[i + 1].abscissa + margin;
+                    while(first + 1 < static_cast<int>(sampleCurvatures.size()) && sampleAbscissas[first + 1] <= low)
+                        first++;
+                    for(int j = first; j < static_cast<int>(sampleCurvatures.size()) && sampleAbscissas[j] < high; j++)
+                        curvatures[i] = std::max(curvatures[i], sampleCurvatures[j]);
+                }
+            }
+
+            // Velocity limit at each station, from the outer wheel velocity on both sides.
+            std::vector<double> maxVelocity(nStations, maxWheelVelocity_);
+            for(int i = 0; i + 1 < nStations; i++)
+            {
+                double const limit = maxWheelVelocity_ / (1.0 + curvatures[i] * wheelSpacing_);
+                maxVelocity[i] = std::min(maxVelocity[i], limit);
+                maxVelocity[i + 1] = std::min(maxVelocity[i + 1], limit);
+            }
+            maxVelocity[nStations - 1] = std::min(maxVelocity[nStations - 1], endVelocity);
+
+            // Forward pass: accelerate as much as possible.
+            stations_[0].velocity = std::min(std::abs(startVelocity), maxVelocity[0]);
+            for(int i = 0; i + 1 < nStations; i++)
+            {
+                double const acceleration = maxWheelAcceleration_ / (1.0 + curvatures[i] * wheelSpacing_);
+                double const ds = stations_[i + 1].abscissa - stations_[i].abscissa;
+                stations_[i + 1].velocity = std::min(maxVelocity[i + 1],
+                    std::sqrt(stations_[i].velocity * stations_[i].velocity + 2.0 * acceleration * ds));
+            }
+            // Backward pass: decelerate as late as possible.
+            for(int i = nStations - 2; i >= 0; i--)
+            {
+                double const acceleration = maxWheelAcceleration_ / (1.0 + curvatures[i] * wheelSpacing_);
+                double const ds = stations_[i + 1].abscissa - stations_[i].abscissa;
+                stations_[i].velocity = std::min(stations_[i].velocity,
+                    std::sqrt(stations_[i + 1].velocity * stations_[i + 1].velocity + 2.0 * acceleration * ds));
+            }
+
+            // Time parametrization: constant acceleration between stations.
+            stations_[0].time = 0.0;
+            stations_[0].integral = 0.0;
+            for(int i = 0; i + 1 < nStations; i++)
+            {
+                double const ds = stations_[i + 1].abscissa - stations_[i].abscissa;
+                double const v0 = stations_[i].velocity;
+                double const v1 = stations_[i + 1].velocity;
+                stations_[i].acceleration = (v1 * v1 - v0 * v0) / (2.0 * ds);
+                double const dt = 2.0 * ds / std::max(v0 + v1, 1e-9);
+                stations_[i + 1].time = stations_[i].time + dt;
+                stations_[i + 1].integral = stations_[i].integral
+                    + dt * (stations_[i].abscissa + dt * (v0 / 2.0 + dt * stations_[i].acceleration / 6.0));
+            }
+            stations_[nStations - 1].acceleration = 0.0;
+        }
+
+
+        void ProfiledTrajectory::getProfileState(double const& time,
+                                                 int& cursor,
+                                                 double& abscissa,
+                                                 double& velocity,
+                                                 double& integral) const
+        {
+            Station const& first = stations_.front();
+            Station const& last = stations_.back();
+            if(time < first.time)
+            {
+                double const dt = time - first.time;
+                abscissa = first.abscissa + first.velocity * dt;
+                velocity = first.velocity;
+                integral = first.integral + dt * (first.abscissa + first.velocity * dt / 2.0);
+                return;
+            }
+            if(time >= last.time)
+            {
+                double const dt = time - last.time;
+                abscissa = last.abscissa + last.velocity * dt;
+                velocity = last.velocity;
+                integral = last.integral + dt * (last.abscissa + last.velocity * dt / 2.0);
+                return;
+            }
+
+            // Find the current station: same or next one as the last lookup, or binary search.
+            if(!(stations_[cursor].time <= time && time < stations_[cursor + 1].time))
+            {
+                if(cursor + 2 < static_cast<int>(stations_.size())
+                   && stations_[cursor + 1].time <= time && time < stations_[cursor + 2].time)
+                    cursor++;
+                else
+                    cursor = std::upper_bound(stations_.begin(), stations_.end(), time,
+                        [](double const& t, Station const& s){return t < s.time;}) - stations_.begin() - 1;
+            }
+            Station const& station = stations_[cursor];
+            double const dt = time - station.time;
+            velocity = station.velocity + station.acceleration * dt;
+            abscissa = station.abscissa + dt * (station.velocity + station.acceleration * dt / 2.0);
+            integral = station.integral
+                + dt * (station.abscissa + dt * (station.velocity / 2.0 + dt * station.acceleration / 6.0));
+        }
+
+
+        void ProfiledTrajectory::getState(double const& time, double& abscissa, double& velocity)
+        {
+            double integral;
+            getProfileState(time, cursor_, abscissa, velocity, integral);
+            if(filterDuration_ > 0.0)
+            {
+                // Mean of the profile over [time - T, time]: abscissa from the integral, velocity from the abscissa.
+                double lagAbscissa, lagVelocity, lagIntegral;
+                getProfileState(time - filterDuration_, lagCursor_, lagAbscissa, lagVelocity, lagIntegral);
+                velocity = (abscissa - lagAbscissa) / filterDuration_;
+                abscissa = (integral - lagIntegral) / filterDuration_;
+            }
+        }
+
+
+        TrajectoryPoint ProfiledTrajectory::getCurrentPoint(double const& currentTime)
+        {
+            TrajectoryPoint output;
+            double abscissa, velocity;
+            getState(std::max(0.0, std::min(currentTime, duration_)), abscissa, velocity);
+            output.position = path_.getPosition(abscissa);
+            if(currentTime >= duration_)
+                return output;
+            output.linearVelocity = velocity;
+            if(filterDuration_ > 0.0)
+                output.angularVelocity = velocity * path_.getCurvature(abscissa);
+            else
+            {
+                // Curvature within the current interval, kept away from its end to avoid junctions.
+                double const stationAbscissa = stations_[cursor_].abscissa;
+                double const nextAbscissa = stations_[cursor_ + 1].abscissa;
+                double const margin = (nextAbscissa - stationAbscissa) * 1e-3;
+                output.angularVelocity = velocity * path_.getCurvature(std::max(stationAbscissa, std::min(abscissa, nextAbscissa - margin)));
+            }
+            return output;
+        }
+
+
+        void ProfiledTrajectory::replanify(double const& replanificationTime)
+        {
+            double abscissa, velocity;
+            getState(std::max(0.0, std::min(replanificationTime, duration_)), abscissa, velocity);
+            make(abscissa, 0.0);
+        }
+
+
+        GeometricPath const& ProfiledTrajectory::getPath() const
+        {
+            return path_;
+        }
+    }
+}
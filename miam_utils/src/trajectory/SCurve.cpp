@@ -0,0 +1,231 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/SCurve.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace miam{
+    namespace trajectory{
+        // Jerk-limited velocity change of deltaVelocity: duration of each jerk phase, and total duration.
+        static void getVelocityChange(double const& deltaVelocity,
+                                      double const& maxAcceleration,
+                                      double const& maxJerk,
+                                      double& jerkTime,
+                                      double& duration)
+        {
+            if(deltaVelocity * maxJerk < maxAcceleration * maxAcceleration)
+            {
+                // Maximum acceleration not reached.
+                jerkTime = std::sqrt(deltaVelocity / maxJerk);
+                duration = 2.0 * jerkTime;
+            }
+            else
+            {
+                jerkTime = maxAcceleration / maxJerk;
+                duration = jerkTime + deltaVelocity / maxAcceleration;
+            }
+        }
+
+        // Distance needed to go from v0 to peakVelocity, then to v1. The acceleration being symmetric within a phase,
+        // the distance of a phase is its duration times its mean velocity.
+        static double getDistance(double const& v0, double const& peakVelocity, double const& v1,
+                                  double const& maxAcceleration, double const& maxJerk)
+        {
+            double jerkTime, accelerationTime, decelerationTime;
+            getVelocityChange(peakVelocity - v0, maxAcceleration, maxJerk, jerkTime, accelerationTime);
+            getVelocityChange(peakVelocity - v1, maxAcceleration, maxJerk, jerkTime, decelerationTime);
+            return (v0 + peakVelocity) / 2.0 * accelerationTime + (peakVelocity + v1) / 2.0 * decelerationTime;
+        }
+
+
+        SCurve::SCurve():
+            length_(0.0),
+            endVelocity_(0.0)
+        {
+            for(int i = 0; i < N_SEGMENTS; i++)
+            {
+                startTime_[i] = 0.0;
+                startPosition_[i] = 0.0;
+                startVelocity_[i] = 0.0;
+                startAcceleration_[i] = 0.0;
+                jerk_[i] = 0.0;
+            }
+            startTime_[N_SEGMENTS] = 0.0;
+            startPosition_[N_SEGMENTS] = 0.0;
+        }
+
+
+        SCurve::SCurve(double const& distance,
+                       double const& startVelocity,
+                       double const& endVelocity,
+                       double maxVelocity,
+                       double maxAcceleration,
+                       double maxJerk):
+            SCurve()
+        {
+            length_ = std::abs(distance);
+            maxVelocity = std::abs(maxVelocity);
+            maxAcceleration = std::abs(maxAcceleration);
+            maxJerk = std::abs(maxJerk);
+            double const v0 = std::max(0.0, std::min(startVelocity, maxVelocity));
+            double v1 = std::max(0.0, std::min(endVelocity, maxVelocity));
+            double const h = length_;
+
+            // Duration of the acceleration and deceleration phases (Ta, Td), of the jerk phases within them (Tj1,
+            // Tj2), and of the constant velocity phase (Tv).
+            double Tj1 = 0.0, Ta = 0.0, Tv = 0.0, Tj2 = 0.0, Td = 0.0;
+            if(h > 0.0 && maxVelocity > 0.0 && maxAcceleration > 0.0 && maxJerk > 0.0)
+            {
+                // If the end velocity cannot be reached, take the closest one that can: the shortest motion goes
+                // directly from v0 to v1.
+                if(getDistance(v0, std::max(v0, v1), v1, maxAcceleration, maxJerk) > h)
+                {
+                    double reachable = v0;
+                    double unreachable = v1;
+                    for(int i = 0; i < 60; i++)
+                    {
+                        double const velocity = (reachable + unreachable) / 2.0;
+                        if(getDistance(v0, std::max(v0, velocity), velocity, maxAcceleration, maxJerk) > h)
+                            unreachable = velocity;
+                        else
+                            reachable = velocity;
+                    }
+                    v1 = reachable;
+                }
+
+                // Peak velocity: maximum velocity if the distance allows it. Otherwise, the distance increases
+                // with the peak velocity, which is found by bisection.
+                double peakVelocity = maxVelocity;
+                if(getDistance(v0, peakVelocity, v1, maxAcceleration, maxJerk) > h)
+                {
+                    double low = std::max(v0, v1);
+                    double high = maxVelocity;
+                    for(int i = 0; i < 60; i++)
+                    {
+                        double const velocity = (low + high) / 2.0;
+                        if(getDistance(v0, velocity, v1, maxAcceleration, maxJerk) > h)
+                            high = velocity;
+                        else
+                            low = velocity;
+                    }
+                    peakVelocity = low;
+                }
+                getVelocityChange(peakVelocity - v0, maxAcceleration, maxJerk, Tj1, Ta);
+                getVelocityChange(peakVelocity - v1, maxAcceleration, maxJerk, Tj2, Td);
+                if(peakVelocity > 0.0)
+                    Tv = std::max(0.0, (h - getDistance(v0, peakVelocity, v1, maxAcceleration, maxJerk)) / peakVelocity);
+            }
+            endVelocity_ = v1;
+
+            // Build the segments, integrating the constant jerk from the start.
+            double const durations[N_SEGMENTS] = {Tj1, Ta - 2.0 * Tj1, Tj1, Tv, Tj2, Td - 2.0 * Tj2, Tj2};
+            double const jerks[N_SEGMENTS] = {maxJerk, 0.0, -maxJerk, 0.0, -maxJerk, 0.0, maxJerk};
+            double position = 0.0;
+            double velocity = v0;
+            double acceleration = 0.0;
+            double time = 0.0;
+            for(int i = 0; i < N_SEGMENTS; i++)
+            {
+                double const dt = std::max(0.0, durations[i]);
+                startTime_[i] = time;
+                startPosition_[i] = position;
+                startVelocity_[i] = velocity;
+                startAcceleration_[i] = acceleration;
+                jerk_[i] = jerks[i];
+
+                position += dt * (velocity + dt * (acceleration / 2.0 + dt * jerks[i] / 6.0));
+                velocity += dt * (acceleration + dt * jerks[i] / 2.0);
+                acceleration += dt * jerks[i];
+                time += dt;
+            }
+            startTime_[N_SEGMENTS] = time;
+            startPosition_[N_SEGMENTS] = length_;
+        }
+
+
+        int SCurve::findSegment(double const& currentTime) const
+        {
+            int segment = 0;
+            while(segment < N_SEGMENTS - 1 && currentTime >= startTime_[segment + 1])
+                segment++;
+            return segment;
+        }
+
+
+        TrapezoidState SCurve::getState(double const& currentTime) const
+        {
+            TrapezoidState output;
+            if(currentTime < 0.0)
+                return output;
+            if(currentTime >= startTime_[N_SEGMENTS])
+            {
+                output.position = length_;
+                return output;
+            }
+            int const i = findSegment(currentTime);
+            double const dt = currentTime - startTime_[i];
+            output.position = startPosition_[i]
+                              + dt * (startVelocity_[i] + dt * (startAcceleration_[i] / 2.0 + dt * jerk_[i] / 6.0));
+            output.velocity = startVelocity_[i] + dt * (startAcceleration_[i] + dt * jerk_[i] / 2.0);
+            return output;
+        }
+
+
+        double SCurve::getAcceleration(double const& currentTime) const
+        {
+            if(currentTime < 0.0 || currentTime >= startTime_[N_SEGMENTS])
+                return 0.0;
+            int const i = findSegment(currentTime);
+            return startAcceleration_[i] + (currentTime - startTime_[i]) * jerk_[i];
+        }
+
+
+        double SCurve::getTime(double const& position) const
+        {
+            if(position <= 0.0)
+                return 0.0;
+            if(position >= length_)
+                return startTime_[N_SEGMENTS];
+
+            // Position is non-decreasing: find the segment, then solve the cubic equation within it by Newton
+            // iterations, falling back to bisection if they leave the segment.
+            int i = 0;
+            while(i < N_SEGMENTS - 1 && position >= startPosition_[i + 1])
+                i++;
+            double low = 0.0;
+            double high = startTime_[i + 1] - startTime_[i];
+            double dt = high / 2.0;
+            for(int n = 0; n < 50; n++)
+            {
+                double const error = startPosition_[i] - position
+                    + dt * (startVelocity_[i] + dt * (startAcceleration_[i] / 2.0 + dt * jerk_[i] / 6.0));
+                if(error > 0.0)
+                    high = dt;
+                else
+                    low = dt;
+                double const velocity = startVelocity_[i] + dt * (startAcceleration_[i] + dt * jerk_[i] / 2.0);
+                double next = (velocity > 0.0 ? dt - error / velocity : low);
+                if(next <= low || next >= high)
+                    next = (low + high) / 2.0;
+                bool const converged = std::abs(next - dt) < 1e-12;
+                dt = next;
+                if(converged)
+                    break;
+            }
+            return startTime_[i] + dt;
+        }
+
+
+        double SCurve::getDuration() const
+        {
+            return startTime_[N_SEGMENTS];
+        }
+
+
+        double SCurve::getEndVelocity() const
+        {
+            return endVelocity_;
+        }
+    }
+}
@@ -1,13 +1,16 @@
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
 #include "miam_utils/trajectory/SampledTrajectory.h"
+#include "miam_utils/trajectory/Utilities.h"
+
+#include <algorithm>
 #include <cmath>
 
 
 namespace miam{
     namespace trajectory{
         SampledTrajectory::SampledTrajectory(
-            std::vector<TrajectoryPoint > sampledTrajectory,
+            std::vector<TrajectoryPoint > const& sampledTrajectory,
             double duration
             ) : Trajectory()
         {
@@ -51,5 +54,148 @@ namespace miam{
             return output;
 
         }
+
+
+        // Linear interpolation between two points, along the shortest angle.
+        static TrajectoryPoint interpolate(TimedTrajectoryPoint const& low,
+                                           TimedTrajectoryPoint const& high,
+                                           double const& time)
+        {
+            double const ratio = (time - low.time) / (high.time - low.time);
+            TrajectoryPoint output;
+            output.position.x = low.point.position.x + ratio * (high.point.position.x - low.point.position.x);
+            output.position.y = low.point.position.y + ratio * (high.point.position.y - low.point.position.y);
+            output.position.theta = low.point.position.theta
+                + ratio * moduloTwoPi(high.point.position.theta - low.point.position.theta);
+            output.linearVelocity = low.point.linearVelocity
+                + ratio * (high.point.linearVelocity - low.point.linearVelocity);
+            output.angularVelocity = low.point.angularVelocity
+                + ratio * (high.point.angularVelocity - low.point.angularVelocity);
+            return output;
+        }
+
+
+        TimedSampledTrajectory::TimedSampledTrajectory(std::shared_ptr<TrajectorySamples const> const& samples):
+            Trajectory(),
+            storage_(samples),
+            samples_(samples->data()),
+            nSamples_(samples->size()),
+            startTime_(samples->front().time),
+            cursor_(0)
+        {
+            duration_ = samples_[nSamples_ - 1].time - startTime_;
+        }
+
+
+        TimedSampledTrajectory::TimedSampledTrajectory(TimedTrajectoryPoint const *samples, int const& nSamples):
+            Trajectory(),
+            storage_(),
+            samples_(samples),
+            nSamples_(nSamples),
+            startTime_(samples[0].time),
+            cursor_(0)
+        {
+            duration_ = samples_[nSamples_ - 1].time - startTime_;
+        }
+
+
+        int TimedSampledTrajectory::findInterval(double const& time)
+        {
+            // Fast path: same interval as the last lookup, or the next one.
+            if(samples_[cursor_].time <= time)
+            {
+                if(time < samples_[cursor_ + 1].time)
+                    return cursor_;
+                if(cursor_ + 2 < nSamples_ && time < samples_[cursor_ + 2].time)
+                    return ++cursor_;
+            }
+            // Binary search: first sample strictly after time.
+            TimedTrajectoryPoint const *next = std::upper_bound(samples_, samples_ + nSamples_, time,
+                [](double const& t, TimedTrajectoryPoint const& sample){return t < sample.time;});
+            cursor_ = next - samples_ - 1;
+            return cursor_;
+        }
+
+
+        TrajectoryPoint TimedSampledTrajectory::getCurrentPoint(double const& currentTime)
+        {
+            double const time = startTime_ + currentTime;
+            if(time <= samples_[0].time)
+                return samples_[0].point;
+            if(time >= samples_[nSamples_ - 1].time)
+                return samples_[nSamples_ - 1].point;
+            int const index = findInterval(time);
+            return interpolate(samples_[index], samples_[index + 1], time);
+        }
+
+
+        void TimedSampledTrajectory::replanify(double const& replanificationTime)
+        {
+            startTime_ = std::min(startTime_ + std::max(replanificationTime, 0.0), samples_[nSamples_ - 1].time);
+            duration_ = samples_[nSamples_ - 1].time - startTime_;
+        }
+
+
+        int TimedSampledTrajectory::getNumberOfSamples() const
+        {
+            return nSamples_;
+        }
+
+
+        TrajectorySamples sampleTrajectory(Trajectory & trajectory,
+                                           double const& timestep,
+                                           double const& maxPositionError,
+                                           double const& maxAngleError)
+        {
+            // Dense sampling, the last sample being exactly at the end of the trajectory.
+            double const duration = trajectory.getDuration();
+            int const nIntervals = std::max(1, static_cast<int>(std::ceil(duration / timestep)));
+            TrajectorySamples dense;
+            dense.reserve(nIntervals + 1);
+            for(int i = 0; i <= nIntervals; i++)
+            {
+                double const time = duration * i / nIntervals;
+                dense.push_back(TimedTrajectoryPoint(time, trajectory.getCurrentPoint(time)));
+            }
+
+            // Douglas-Peucker simplification: keep the sample with the largest error, until all errors are small enough.
+            std::vector<bool> isKept(dense.size(), false);
+            isKept.front() = true;
+            isKept.back() = true;
+            std::vector<std::pair<int, int>> intervals;
+            intervals.push_back(std::make_pair(0, static_cast<int>(dense.size()) - 1));
+            while(!intervals.empty())
+            {
+                int const first = intervals.back().first;
+                int const last = intervals.back().second;
+                intervals.pop_back();
+                double maxError = 1.0;
+                int worstSample = -1;
+                for(int i = first + 1; i < last; i++)
+                {
+                    TrajectoryPoint const approximation = interpolate(dense[first], dense[last], dense[i].time);
+                    double const positionError = distance(approximation.position, dense[i].point.position);
+                    double const angleError = std::abs(moduloTwoPi(approximation.position.theta - dense[i].point.position.theta));
+                    double const error = std::max(positionError / maxPositionError, angleError / maxAngleError);
+                    if(error > maxError)
+                    {
+                        maxError = error;
+                        worstSample = i;
+                    }
+                }
+                if(worstSample > 0)
+                {
+                    isKept[worstSample] = true;
+                    intervals.push_back(std::make_pair(first, worstSample));
+                    intervals.push_back(std::make_pair(worstSample, last));
+                }
+            }
+
+            TrajectorySamples samples;
+            for(unsigned int i = 0; i < dense.size(); i++)
+                if(isKept[i])
+                    samples.push_back(dense[i]);
+            return samples;
+        }
     }
 }
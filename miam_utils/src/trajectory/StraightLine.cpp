@@ -13,12 +13,14 @@ namespace miam{
                                    double const& endVelocity,
                                    bool const& backward_,
                                    double maxVelocity,
-                                   double maxAcceleration):
+                                   double maxAcceleration,
+                                   double maxJerk):
              endPoint_(endPoint),
              endVelocity_(endVelocity),
              backward_(backward_),
              maxVelocity_(maxVelocity),
-             maxAcceleration_(maxAcceleration)
+             maxAcceleration_(maxAcceleration),
+             maxJerk_(maxJerk)
         {
             make(startPoint, startVelocity);
         }
@@ -33,7 +35,7 @@ namespace miam{
                 motionSign_ = -1.0;
             // Create trapezoid.
             double length = distance(startPoint, endPoint_);
-            trapezoid_ = Trapezoid(length, startVelocity, endVelocity_, maxVelocity_, maxAcceleration_);
+            trapezoid_ = Trapezoid(length, startVelocity, endVelocity_, maxVelocity_, maxAcceleration_, maxJerk_);
 
             duration_ = trapezoid_.getDuration();
 
@@ -48,6 +50,9 @@ namespace miam{
                 else
                     startPoint_.theta -= M_PI;
             }
+            // Direction of motion is constant along the line.
+            directionX_ = motionSign_ * std::cos(startPoint_.theta);
+            directionY_ = motionSign_ * std::sin(startPoint_.theta);
         }
 
         TrajectoryPoint StraightLine::getCurrentPoint(double const& currentTime)
@@ -59,8 +64,8 @@ namespace miam{
             output.linearVelocity = motionSign_ * state.velocity;
 
             // Compute position.
-            output.position.x += motionSign_ * state.position * std::cos(startPoint_.theta);
-            output.position.y += motionSign_ * state.position * std::sin(startPoint_.theta);
+            output.position.x += state.position * directionX_;
+            output.position.y += state.position * directionY_;
 
             return output;
         }
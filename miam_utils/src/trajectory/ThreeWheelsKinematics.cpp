@@ -37,4 +37,36 @@ namespace omni
             wheelSpeed.w_[i] /= wheelRadius_;
         return wheelSpeed;
     }
+
+
+    miam::RobotPosition ThreeWheelsKinematics::integratePosition(miam::RobotPosition const& position,
+                                                                 BaseSpeed const& baseSpeed,
+                                                                 double const& dt)
+    {
+        // Displacement in the robot frame: V(angle) * (vx, vy) * dt, with
+        // V = [sin(angle) / angle, -(1 - cos(angle)) / angle; (1 - cos(angle)) / angle, sin(angle) / angle].
+        // For small angles, use a series expansion.
+        double const angle = baseSpeed.omega_ * dt;
+        double const angle2 = angle * angle;
+        double a, b;
+        if(std::abs(angle) < 1e-2)
+        {
+            a = 1.0 - angle2 / 6.0 * (1.0 - angle2 / 20.0);
+            b = angle / 2.0 * (1.0 - angle2 / 12.0);
+        }
+        else
+        {
+            a = std::sin(angle) / angle;
+            b = (1.0 - std::cos(angle)) / angle;
+        }
+        double const dx = (a * baseSpeed.vx_ - b * baseSpeed.vy_) * dt;
+        double const dy = (b * baseSpeed.vx_ + a * baseSpeed.vy_) * dt;
+
+        // Rotate to the table frame.
+        double const c = std::cos(position.theta);
+        double const s = std::sin(position.theta);
+        return miam::RobotPosition(position.x + c * dx - s * dy,
+                                   position.y + s * dx + c * dy,
+                                   position.theta + angle);
+    }
 }
@@ -13,16 +13,19 @@ namespace miam{
             double maxWheelVelocity = 300.0;
             double maxWheelAcceleration = 300.0;
             double robotWheelSpacing = 100.0;
+            double maxWheelJerk = 0.0;
         }
 
 
         void setTrajectoryGenerationConfig(double const& maxWheelVelocity,
                                            double const& maxWheelAcceleration,
-                                           double const& robotWheelSpacing)
+                                           double const& robotWheelSpacing,
+                                           double const& maxWheelJerk)
         {
             config::maxWheelVelocity = std::abs(maxWheelVelocity);
             config::maxWheelAcceleration = std::abs(maxWheelAcceleration);
             config::robotWheelSpacing = std::abs(robotWheelSpacing);
+            config::maxWheelJerk = std::abs(maxWheelJerk);
         }
 
         Trajectory::Trajectory()
@@ -39,5 +42,44 @@ namespace miam{
         {
             return getCurrentPoint(getDuration());
         }
+
+
+        TrajectoryEvaluationContext::TrajectoryEvaluationContext():
+            nEntries_(0),
+            nextEntry_(0),
+            nEvaluations_(0)
+        {
+        }
+
+
+        void TrajectoryEvaluationContext::clear()
+        {
+            nEntries_ = 0;
+            nextEntry_ = 0;
+        }
+
+
+        TrajectoryPoint TrajectoryEvaluationContext::getCurrentPoint(Trajectory *trajectory, double const& currentTime)
+        {
+            for(int i = 0; i < nEntries_; i++)
+                if(entries_[i].trajectory == trajectory && entries_[i].time == currentTime)
+                    return entries_[i].point;
+
+            Entry & entry = entries_[nextEntry_];
+            entry.trajectory = trajectory;
+            entry.time = currentTime;
+            entry.point = trajectory->getCurrentPoint(currentTime);
+            nEvaluations_++;
+            nextEntry_ = (nextEntry_ + 1) % CACHE_SIZE;
+            if(nEntries_ < CACHE_SIZE)
+                nEntries_++;
+            return entry.point;
+        }
+
+
+        int TrajectoryEvaluationContext::getNumberOfEvaluations() const
+        {
+            return nEvaluations_;
+        }
     }
 }
@@ -0,0 +1,305 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/TrajectoryLibrary.h"
+#include "miam_utils/trajectory/ArcCircle.h"
+#include "miam_utils/trajectory/PointTurn.h"
+#include "miam_utils/trajectory/ProfiledTrajectory.h"
+#include "miam_utils/trajectory/StraightLine.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errno.h>
+
+namespace miam{
+    namespace trajectory{
+
+        char const LIBRARY_MAGIC[8] = {'M', 'I', 'A', 'M', 'T', 'R', 'J', '\0'};
+        uint32_t const LIBRARY_VERSION = 1;
+        int const NAME_LENGTH = 48;
+
+        struct TrajectoryLibrary::FileHeader{
+            char magic[8]; ///< LIBRARY_MAGIC.
+            uint32_t version; ///< LIBRARY_VERSION.
+            uint32_t nTrajectories; ///< Number of trajectories.
+        };
+
+        struct TrajectoryLibrary::FileTrajectory{
+            char name[NAME_LENGTH]; ///< Null-terminated name.
+            uint32_t firstSegment; ///< Index of the first segment.
+            uint32_t nSegments; ///< Number of segments.
+        };
+
+        struct TrajectoryLibrary::FileSegment{
+            uint32_t type; ///< TrajectoryType.
+            uint32_t nSamples; ///< Number of samples.
+            uint64_t sampleOffset; ///< Offset of the samples from the start of the file.
+            double duration; ///< Segment duration.
+        };
+
+        // Samples are read in place: they must be plain data, and all blocks keep 8-byte alignment.
+        static_assert(sizeof(TimedTrajectoryPoint) == 6 * sizeof(double), "Unexpected TimedTrajectoryPoint layout");
+        static_assert(sizeof(TrajectoryLibrary::FileHeader) == 16, "Unexpected header layout");
+        static_assert(sizeof(TrajectoryLibrary::FileTrajectory) == 56, "Unexpected trajectory entry layout");
+        static_assert(sizeof(TrajectoryLibrary::FileSegment) == 24, "Unexpected segment entry layout");
+
+
+        TrajectoryType getTrajectoryType(Trajectory const& trajectory)
+        {
+            if(dynamic_cast<StraightLine const*>(&trajectory) != nullptr)
+                return TrajectoryType::STRAIGHT_LINE;
+            if(dynamic_cast<ArcCircle const*>(&trajectory) != nullptr)
+                return TrajectoryType::ARC_CIRCLE;
+            if(dynamic_cast<PointTurn const*>(&trajectory) != nullptr)
+                return TrajectoryType::POINT_TURN;
+            if(dynamic_cast<ProfiledTrajectory const*>(&trajectory) != nullptr)
+                return TrajectoryType::PROFILED;
+            if(dynamic_cast<TimedSampledTrajectory const*>(&trajectory) != nullptr
+               || dynamic_cast<SampledTrajectory const*>(&trajectory) != nullptr)
+                return TrajectoryType::SAMPLED;
+            return TrajectoryType::UNKNOWN;
+        }
+
+
+        TrajectoryLibraryWriter::TrajectoryLibraryWriter(double const& timestep,
+                                                         double const& maxPositionError,
+                                                         double const& maxAngleError):
+            entries_(),
+            timestep_(timestep),
+            maxPositionError_(maxPositionError),
+            maxAngleError_(maxAngleError)
+        {
+        }
+
+
+        bool TrajectoryLibraryWriter::add(std::string const& name, TrajectoryVector const& trajectories)
+        {
+            if(name.empty() || name.size() >= NAME_LENGTH)
+                return false;
+            for(Entry const& entry : entries_)
+                if(entry.name == name)
+                    return false;
+
+            Entry entry;
+            entry.name = name;
+            for(std::shared_ptr<Trajectory> const& trajectory : trajectories)
+            {
+                entry.types.push_back(getTrajectoryType(*trajectory));
+                entry.durations.push_back(trajectory->getDuration());
+                entry.samples.push_back(sampleTrajectory(*trajectory, timestep_, maxPositionError_, maxAngleError_));
+            }
+            entries_.push_back(entry);
+            return true;
+        }
+
+
+        bool TrajectoryLibraryWriter::write(std::string const& filename) const
+        {
+            std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+            if(!file.is_open())
+                return false;
+
+            TrajectoryLibrary::FileHeader header;
+            memcpy(header.magic, LIBRARY_MAGIC, sizeof(header.magic));
+            header.version = LIBRARY_VERSION;
+            header.nTrajectories = entries_.size();
+            file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+            uint32_t nSegments = 0;
+            for(Entry const& entry : entries_)
+            {
+                TrajectoryLibrary::FileTrajectory trajectory;
+                memset(trajectory.name, 0, NAME_LENGTH);
+                strncpy(trajectory.name, entry.name.c_str(), NAME_LENGTH - 1);
+                trajectory.firstSegment = nSegments;
+                trajectory.nSegments = entry.samples.size();
+                nSegments += trajectory.nSegments;
+                file.write(reinterpret_cast<char const*>(&trajectory), sizeof(trajectory));
+            }
+
+            // Samples are stored after all segment entries, in the same order.
+            uint64_t offset = sizeof(TrajectoryLibrary::FileHeader)
+                              + entries_.size() * sizeof(TrajectoryLibrary::FileTrajectory)
+                              + nSegments * sizeof(TrajectoryLibrary::FileSegment);
+            for(Entry const& entry : entries_)
+                for(unsigned int i = 0; i < entry.samples.size(); i++)
+                {
+                    TrajectoryLibrary::FileSegment segment;
+                    segment.type = static_cast<uint32_t>(entry.types[i]);
+                    segment.nSamples = entry.samples[i].size();
+                    segment.sampleOffset = offset;
+                    segment.duration = entry.durations[i];
+                    offset += segment.nSamples * sizeof(TimedTrajectoryPoint);
+                    file.write(reinterpret_cast<char const*>(&segment), sizeof(segment));
+                }
+            for(Entry const& entry : entries_)
+                for(TrajectorySamples const& samples : entry.samples)
+                    file.write(reinterpret_cast<char const*>(samples.data()), samples.size() * sizeof(TimedTrajectoryPoint));
+            file.close();
+            return !file.fail();
+        }
+
+
+        TrajectoryLibrary::TrajectoryLibrary():
+            map_(nullptr),
+            size_(0),
+            header_(nullptr),
+            trajectories_(nullptr),
+            segments_(nullptr),
+            nSegments_(0)
+        {
+        }
+
+
+        TrajectoryLibrary::~TrajectoryLibrary()
+        {
+            close();
+        }
+
+
+        void TrajectoryLibrary::close()
+        {
+            if(map_ != nullptr)
+                munmap(map_, size_);
+            map_ = nullptr;
+            size_ = 0;
+            header_ = nullptr;
+            trajectories_ = nullptr;
+            segments_ = nullptr;
+            nSegments_ = 0;
+        }
+
+
+        bool TrajectoryLibrary::load(std::string const& filename)
+        {
+            close();
+            int file = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if(file < 0)
+            {
+                #ifdef DEBUG
+                    std::cout << "Error opening " << filename << ": " << errno << " " << strerror(errno) << std::endl;
+                #endif
+                return false;
+            }
+            struct stat status;
+            if(fstat(file, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(FileHeader))
+            {
+                ::close(file);
+                return false;
+            }
+            // The mapping remains valid once the file is closed.
+            size_t const size = status.st_size;
+            void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+            ::close(file);
+            if(map == MAP_FAILED)
+            {
+                #ifdef DEBUG
+                    std::cout << "Error mapping " << filename << ": " << errno << " " << strerror(errno) << std::endl;
+                #endif
+                return false;
+            }
+            map_ = map;
+            size_ = size;
+
+            // Check that everything lies within the file.
+            char const *data = static_cast<char const*>(map_);
+            header_ = reinterpret_cast<FileHeader const*>(data);
+            bool isValid = memcmp(header_->magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) == 0
+                           && header_->version == LIBRARY_VERSION
+                           && sizeof(FileHeader) + static_cast<uint64_t>(header_->nTrajectories) * sizeof(FileTrajectory) <= size_;
+            if(isValid)
+            {
+                trajectories_ = reinterpret_cast<FileTrajectory const*>(data + sizeof(FileHeader));
+                uint64_t nSegments = 0;
+                for(uint32_t i = 0; i < header_->nTrajectories && isValid; i++)
+                {
+                    isValid = trajectories_[i].name[NAME_LENGTH - 1] == '\0'
+                              && trajectories_[i].firstSegment == nSegments;
+                    nSegments += trajectories_[i].nSegments;
+                    isValid = isValid && nSegments * sizeof(FileSegment) <= size_;
+                }
+                nSegments_ = nSegments;
+                uint64_t const segmentsEnd = sizeof(FileHeader)
+                                             + static_cast<uint64_t>(header_->nTrajectories) * sizeof(FileTrajectory)
+                                             + nSegments * sizeof(FileSegment);
+                isValid = isValid && segmentsEnd <= size_;
+                if(isValid)
+                    segments_ = reinterpret_cast<FileSegment const*>(data + sizeof(FileHeader)
+                                                                      + header_->nTrajectories * sizeof(FileTrajectory));
+                for(int i = 0; i < nSegments_ && isValid; i++)
+                    isValid = segments_[i].nSamples > 0
+                              && segments_[i].sampleOffset >= segmentsEnd
+                              && segments_[i].sampleOffset % alignof(TimedTrajectoryPoint) == 0
+                              && segments_[i].sampleOffset <= size_
+                              && static_cast<uint64_t>(segments_[i].nSamples) * sizeof(TimedTrajectoryPoint) <= size_ - segments_[i].sampleOffset;
+            }
+            if(!isValid)
+            {
+                #ifdef DEBUG
+                    std::cout << "Invalid trajectory library: " << filename << std::endl;
+                #endif
+                close();
+                return false;
+            }
+            return true;
+        }
+
+
+        std::vector<std::string> TrajectoryLibrary::getNames() const
+        {
+            std::vector<std::string> names;
+            if(header_ == nullptr)
+                return names;
+            for(uint32_t i = 0; i < header_->nTrajectories; i++)
+                names.push_back(std::string(trajectories_[i].name));
+            return names;
+        }
+
+
+        int TrajectoryLibrary::find(std::string const& name) const
+        {
+            if(header_ == nullptr)
+                return -1;
+            for(uint32_t i = 0; i < header_->nTrajectories; i++)
+                if(name == trajectories_[i].name)
+                    return i;
+            return -1;
+        }
+
+
+        std::vector<TrajectoryLibrary::Segment> TrajectoryLibrary::getSegments(std::string const& name) const
+        {
+            std::vector<Segment> segments;
+            int const index = find(name);
+            if(index < 0)
+                return segments;
+            char const *data = static_cast<char const*>(map_);
+            FileTrajectory const& trajectory = trajectories_[index];
+            for(uint32_t i = trajectory.firstSegment; i < trajectory.firstSegment + trajectory.nSegments; i++)
+            {
+                Segment segment;
+                segment.type = static_cast<TrajectoryType>(segments_[i].type);
+                segment.duration = segments_[i].duration;
+                segment.samples = reinterpret_cast<TimedTrajectoryPoint const*>(data + segments_[i].sampleOffset);
+                segment.nSamples = segments_[i].nSamples;
+                segments.push_back(segment);
+            }
+            return segments;
+        }
+
+
+        TrajectoryVector TrajectoryLibrary::get(std::string const& name) const
+        {
+            TrajectoryVector trajectories;
+            for(Segment const& segment : getSegments(name))
+                trajectories.push_back(std::make_shared<TimedSampledTrajectory>(segment.samples, segment.nSamples));
+            return trajectories;
+        }
+    }
+}
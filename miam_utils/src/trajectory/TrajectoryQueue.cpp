@@ -0,0 +1,327 @@
+/// \author MiAM Robotique, Matthieu Vigne
+/// \copyright GNU GPLv3
+#include "miam_utils/trajectory/TrajectoryQueue.h"
+
+#include <new>
+#include <typeinfo>
+
+namespace miam{
+    namespace trajectory{
+
+        TrajectorySegment::TrajectorySegment():
+            type_(Type::SHARED),
+            shared_()
+        {
+        }
+
+
+        TrajectorySegment::TrajectorySegment(StraightLine const& line):
+            type_(Type::STRAIGHT_LINE),
+            shared_()
+        {
+            new (&storage_) StraightLine(line);
+        }
+
+
+        TrajectorySegment::TrajectorySegment(ArcCircle const& arc):
+            type_(Type::ARC_CIRCLE),
+            shared_()
+        {
+            new (&storage_) ArcCircle(arc);
+        }
+
+
+        TrajectorySegment::TrajectorySegment(PointTurn const& turn):
+            type_(Type::POINT_TURN),
+            shared_()
+        {
+            new (&storage_) PointTurn(turn);
+        }
+
+
+        TrajectorySegment::TrajectorySegment(std::shared_ptr<Trajectory> const& trajectory):
+            type_(Type::SHARED),
+            shared_()
+        {
+            // Exact type only: a derived class would be sliced.
+            if(trajectory && typeid(*trajectory) == typeid(StraightLine))
+            {
+                type_ = Type::STRAIGHT_LINE;
+                new (&storage_) StraightLine(static_cast<StraightLine const&>(*trajectory));
+            }
+            else if(trajectory && typeid(*trajectory) == typeid(ArcCircle))
+            {
+                type_ = Type::ARC_CIRCLE;
+                new (&storage_) ArcCircle(static_cast<ArcCircle const&>(*trajectory));
+            }
+            else if(trajectory && typeid(*trajectory) == typeid(PointTurn))
+            {
+                type_ = Type::POINT_TURN;
+                new (&storage_) PointTurn(static_cast<PointTurn const&>(*trajectory));
+            }
+            else
+                shared_ = trajectory;
+        }
+
+
+        TrajectorySegment::TrajectorySegment(TrajectorySegment const& other):
+            type_(Type::SHARED),
+            shared_()
+        {
+            copyFrom(other);
+        }
+
+
+        TrajectorySegment& TrajectorySegment::operator=(TrajectorySegment const& other)
+        {
+            if(this != &other)
+            {
+                destroy();
+                copyFrom(other);
+            }
+            return *this;
+        }
+
+
+        TrajectorySegment::~TrajectorySegment()
+        {
+            destroy();
+        }
+
+
+        void TrajectorySegment::copyFrom(TrajectorySegment const& other)
+        {
+            type_ = other.type_;
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    new (&storage_) StraightLine(*reinterpret_cast<StraightLine const*>(&other.storage_));
+                    break;
+                case Type::ARC_CIRCLE:
+                    new (&storage_) ArcCircle(*reinterpret_cast<ArcCircle const*>(&other.storage_));
+                    break;
+                case Type::POINT_TURN:
+                    new (&storage_) PointTurn(*reinterpret_cast<PointTurn const*>(&other.storage_));
+                    break;
+                case Type::SHARED:
+                    shared_ = other.shared_;
+                    break;
+            }
+        }
+
+
+        void TrajectorySegment::destroy()
+        {
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    reinterpret_cast<StraightLine*>(&storage_)->~StraightLine();
+                    break;
+                case Type::ARC_CIRCLE:
+                    reinterpret_cast<ArcCircle*>(&storage_)->~ArcCircle();
+                    break;
+                case Type::POINT_TURN:
+                    reinterpret_cast<PointTurn*>(&storage_)->~PointTurn();
+                    break;
+                case Type::SHARED:
+                    shared_.reset();
+                    break;
+            }
+            type_ = Type::SHARED;
+        }
+
+
+        TrajectorySegment::Type TrajectorySegment::getType() const
+        {
+            return type_;
+        }
+
+
+        Trajectory *TrajectorySegment::get()
+        {
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    return reinterpret_cast<StraightLine*>(&storage_);
+                case Type::ARC_CIRCLE:
+                    return reinterpret_cast<ArcCircle*>(&storage_);
+                case Type::POINT_TURN:
+                    return reinterpret_cast<PointTurn*>(&storage_);
+                default:
+                    return shared_.get();
+            }
+        }
+
+
+        TrajectoryPoint TrajectorySegment::getCurrentPoint(double const& currentTime)
+        {
+            // Qualified calls: no virtual dispatch.
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    return reinterpret_cast<StraightLine*>(&storage_)->StraightLine::getCurrentPoint(currentTime);
+                case Type::ARC_CIRCLE:
+                    return reinterpret_cast<ArcCircle*>(&storage_)->ArcCircle::getCurrentPoint(currentTime);
+                case Type::POINT_TURN:
+                    return reinterpret_cast<PointTurn*>(&storage_)->PointTurn::getCurrentPoint(currentTime);
+                default:
+                    if(!shared_)
+                        return TrajectoryPoint();
+                    return shared_->getCurrentPoint(currentTime);
+            }
+        }
+
+
+        void TrajectorySegment::replanify(double const& replanificationTime)
+        {
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    reinterpret_cast<StraightLine*>(&storage_)->StraightLine::replanify(replanificationTime);
+                    break;
+                case Type::ARC_CIRCLE:
+                    reinterpret_cast<ArcCircle*>(&storage_)->ArcCircle::replanify(replanificationTime);
+                    break;
+                case Type::POINT_TURN:
+                    reinterpret_cast<PointTurn*>(&storage_)->PointTurn::replanify(replanificationTime);
+                    break;
+                default:
+                    if(shared_)
+                        shared_->replanify(replanificationTime);
+                    break;
+            }
+        }
+
+
+        double TrajectorySegment::getDuration()
+        {
+            Trajectory *trajectory = get();
+            if(trajectory == nullptr)
+                return 0.0;
+            return trajectory->getDuration();
+        }
+
+
+        TrajectoryPoint TrajectorySegment::getEndPoint()
+        {
+            return getCurrentPoint(getDuration());
+        }
+
+
+        std::shared_ptr<Trajectory> TrajectorySegment::toSharedPointer() const
+        {
+            switch(type_)
+            {
+                case Type::STRAIGHT_LINE:
+                    return std::make_shared<StraightLine>(*reinterpret_cast<StraightLine const*>(&storage_));
+                case Type::ARC_CIRCLE:
+                    return std::make_shared<ArcCircle>(*reinterpret_cast<ArcCircle const*>(&storage_));
+                case Type::POINT_TURN:
+                    return std::make_shared<PointTurn>(*reinterpret_cast<PointTurn const*>(&storage_));
+                default:
+                    return shared_;
+            }
+        }
+
+
+        TrajectoryQueue::TrajectoryQueue():
+            segments_(),
+            head_(0)
+        {
+        }
+
+
+        TrajectoryQueue::TrajectoryQueue(std::vector<std::shared_ptr<Trajectory>> const& trajectories):
+            TrajectoryQueue()
+        {
+            assign(trajectories);
+        }
+
+
+        void TrajectoryQueue::assign(std::vector<std::shared_ptr<Trajectory>> const& trajectories)
+        {
+            clear();
+            segments_.reserve(trajectories.size());
+            for(std::shared_ptr<Trajectory> const& trajectory : trajectories)
+                segments_.push_back(TrajectorySegment(trajectory));
+        }
+
+
+        void TrajectoryQueue::push_back(TrajectorySegment const& segment)
+        {
+            // Array full: reuse the space of removed segments rather than growing it.
+            if(head_ > 0 && segments_.size() == segments_.capacity())
+            {
+                segments_.erase(segments_.begin(), segments_.begin() + head_);
+                head_ = 0;
+            }
+            segments_.push_back(segment);
+        }
+
+
+        void TrajectoryQueue::pop_front()
+        {
+            if(empty())
+                return;
+            // Release the trajectory now, its slot is reclaimed later.
+            segments_[head_] = TrajectorySegment();
+            head_++;
+            if(head_ == segments_.size())
+                clear();
+        }
+
+
+        TrajectorySegment& TrajectoryQueue::front()
+        {
+            return segments_[head_];
+        }
+
+
+        TrajectorySegment& TrajectoryQueue::back()
+        {
+            return segments_.back();
+        }
+
+
+        TrajectorySegment& TrajectoryQueue::operator[](size_t const& index)
+        {
+            return segments_[head_ + index];
+        }
+
+
+        size_t TrajectoryQueue::size() const
+        {
+            return segments_.size() - head_;
+        }
+
+
+        bool TrajectoryQueue::empty() const
+        {
+            return size() == 0;
+        }
+
+
+        void TrajectoryQueue::clear()
+        {
+            segments_.clear();
+            head_ = 0;
+        }
+
+
+        TrajectoryPoint TrajectoryQueue::getEndPoint()
+        {
+            if(empty())
+                return TrajectoryPoint();
+            return back().getEndPoint();
+        }
+
+
+        TrajectoryVector TrajectoryQueue::toTrajectoryVector() const
+        {
+            TrajectoryVector trajectories;
+            for(size_t i = head_; i < segments_.size(); i++)
+                trajectories.push_back(segments_[i].toSharedPointer());
+            return trajectories;
+        }
+    }
+}
@@ -25,7 +25,10 @@ namespace miam{
             length_(0.0),
             timeToStopAccelerating_(0.0),
             timeToStartDecelerating_(0.0),
-            accelerationDistance_(0.0)
+            accelerationDistance_(0.0),
+            decelerationStartPosition_(0.0),
+            isJerkLimited_(false),
+            sCurve_()
         {
         }
 
@@ -34,11 +37,21 @@ namespace miam{
                              double const& startVelocity,
                              double const& endVelocity,
                              double maxVelocity,
-                             double maxAcceleration):
-            maxVelocity_(std::abs(maxVelocity)),
-            maxAcceleration_(std::abs(maxAcceleration)),
-            length_(std::abs(distance))
+                             double maxAcceleration,
+                             double maxJerk):
+            Trapezoid()
         {
+            maxVelocity_ = std::abs(maxVelocity);
+            maxAcceleration_ = std::abs(maxAcceleration);
+            length_ = std::abs(distance);
+            if(maxJerk != 0.0)
+            {
+                isJerkLimited_ = true;
+                sCurve_ = SCurve(distance, startVelocity, endVelocity, maxVelocity, maxAcceleration, maxJerk);
+                duration_ = sCurve_.getDuration();
+                return;
+            }
+
             // Crop start and end velocity to the maximum values.
             double vi = crop(startVelocity, -maxVelocity_, maxVelocity_);
             double ve = crop(endVelocity, 0.0, maxVelocity_);
@@ -100,10 +113,14 @@ namespace miam{
                     }
                 }
             }
+            decelerationStartPosition_ = accelerationDistance_ +
+                                         maxVelocity_ * (timeToStartDecelerating_ - timeToStopAccelerating_);
         }
 
         TrapezoidState Trapezoid::getState(double const& currentTime)
         {
+            if(isJerkLimited_)
+                return sCurve_.getState(currentTime);
             TrapezoidState output;
             if(currentTime < 0.0)
                 return output;
@@ -123,11 +140,12 @@ namespace miam{
                 output.position = accelerationDistance_ + maxVelocity_ * (currentTime - timeToStopAccelerating_);
             }
             else
-            {    output.velocity = maxVelocity_ - maxAcceleration_ * (currentTime - timeToStartDecelerating_);
-                output.position = accelerationDistance_ +
-                                           maxVelocity_ * (timeToStartDecelerating_ - timeToStopAccelerating_)
-                                           + maxVelocity_* (currentTime - timeToStartDecelerating_)
-                                           - maxAcceleration_ / 2.0 * (currentTime - timeToStartDecelerating_) * (currentTime - timeToStartDecelerating_);
+            {
+                double const decelerationTime = currentTime - timeToStartDecelerating_;
+                output.velocity = maxVelocity_ - maxAcceleration_ * decelerationTime;
+                output.position = decelerationStartPosition_
+                                  + maxVelocity_ * decelerationTime
+                                  - maxAcceleration_ / 2.0 * decelerationTime * decelerationTime;
             }
             return output;
         }
@@ -0,0 +1,102 @@
+// Testing of the two-wheel drivetrain odometry integration, against an analytic trajectory.
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "miam_utils/trajectory/DrivetrainKinematics.h"
+
+using miam::RobotPosition;
+
+double const WHEEL_RADIUS = 25.0;
+double const WHEEL_SPACING = 100.0;
+
+// Reference trajectory: constant angular velocity, constant linear acceleration, starting from the origin.
+double const V0 = 200.0;
+double const ACCELERATION = 300.0;
+double const OMEGA = 3.0;
+
+RobotPosition getAnalyticPosition(double const& t)
+{
+    double const v = V0 + ACCELERATION * t;
+    double const c = std::cos(OMEGA * t);
+    double const s = std::sin(OMEGA * t);
+    RobotPosition position;
+    position.x = v * s / OMEGA + ACCELERATION * (c - 1.0) / (OMEGA * OMEGA);
+    position.y = (V0 - v * c) / OMEGA + ACCELERATION * s / (OMEGA * OMEGA);
+    position.theta = OMEGA * t;
+    return position;
+}
+
+// Encoder increments between two times.
+WheelSpeed getEncoderIncrement(double const& t0, double const& t1)
+{
+    double const distance = V0 * (t1 - t0) + ACCELERATION * (t1 * t1 - t0 * t0) / 2.0;
+    double const angle = OMEGA * (t1 - t0);
+    return WheelSpeed((distance + WHEEL_SPACING * angle) / WHEEL_RADIUS, (distance - WHEEL_SPACING * angle) / WHEEL_RADIUS);
+}
+
+// Position error after a 2s trajectory, integrated at a given rate.
+double getIntegrationError(double const& rate, bool const& useArc)
+{
+    DrivetrainKinematics kinematics(WHEEL_RADIUS, WHEEL_SPACING, WHEEL_RADIUS, WHEEL_SPACING);
+    RobotPosition position;
+    int const nSteps = static_cast<int>(2.0 * rate);
+    for(int i = 0; i < nSteps; i++)
+    {
+        WheelSpeed const increment = getEncoderIncrement(i / rate, (i + 1) / rate);
+        if(useArc)
+            kinematics.integratePositionArc(increment, position);
+        else
+            kinematics.integratePosition(increment, position);
+    }
+    RobotPosition const error = position - getAnalyticPosition(nSteps / rate);
+    return std::hypot(error.x, error.y);
+}
+
+TEST(DrivetrainKinematicsTest, ArcAccuracy)
+{
+    // Euler integration error is proportional to the time step.
+    double const eulerError100Hz = getIntegrationError(100.0, false);
+    double const eulerError1kHz = getIntegrationError(1000.0, false);
+    ASSERT_GT(eulerError100Hz, 2.0);
+    ASSERT_NEAR(eulerError100Hz / eulerError1kHz, 10.0, 1.0);
+
+    // Arc integration: only the (small) variation of the linear velocity during a step is neglected.
+    double const arcError100Hz = getIntegrationError(100.0, true);
+    double const arcError20Hz = getIntegrationError(20.0, true);
+    ASSERT_LT(arcError100Hz, 0.01);
+    // At 20Hz, better than Euler at 1kHz.
+    ASSERT_LT(arcError20Hz, eulerError1kHz);
+
+    // Constant wheel speeds: exact, whatever the step.
+    DrivetrainKinematics kinematics(WHEEL_RADIUS, WHEEL_SPACING, WHEEL_RADIUS, WHEEL_SPACING);
+    RobotPosition position;
+    kinematics.integratePositionArc(WheelSpeed(8 * M_PI, 0.0), position);
+    // Left wheel not moving: half turn around it.
+    ASSERT_NEAR(position.x, 0.0, 1e-9);
+    ASSERT_NEAR(position.y, 2 * WHEEL_SPACING, 1e-9);
+    ASSERT_NEAR(position.theta, M_PI, 1e-12);
+    // Straight line.
+    position = RobotPosition(0, 0, M_PI / 4);
+    kinematics.integratePositionArc(WheelSpeed(2.0, 2.0), position);
+    ASSERT_NEAR(position.x, 50.0 / std::sqrt(2.0), 1e-9);
+    ASSERT_NEAR(position.y, 50.0 / std::sqrt(2.0), 1e-9);
+}
+
+TEST(DrivetrainKinematicsTest, ArcBatch)
+{
+    // Sub-tick samples integrated in a single call: same result as one call per sample.
+    DrivetrainKinematics kinematics(WHEEL_RADIUS, WHEEL_SPACING, WHEEL_RADIUS, WHEEL_SPACING);
+    std::vector<WheelSpeed> samples;
+    for(int i = 0; i < 10; i++)
+        samples.push_back(getEncoderIncrement(i / 1000.0, (i + 1) / 1000.0));
+    RobotPosition batch, single;
+    kinematics.integratePositionArc(samples.data(), samples.size(), batch);
+    for(WheelSpeed const& sample : samples)
+        kinematics.integratePositionArc(sample, single);
+    ASSERT_DOUBLE_EQ(batch.x, single.x);
+    ASSERT_DOUBLE_EQ(batch.y, single.y);
+    ASSERT_DOUBLE_EQ(batch.theta, single.theta);
+    RobotPosition const error = batch - getAnalyticPosition(0.01);
+    ASSERT_LT(std::hypot(error.x, error.y), 1e-6);
+}
@@ -0,0 +1,114 @@
+// Testing of the I2C polling service, with simulated sensors.
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/I2CPollingService.h"
+
+using miam::I2CPollingService;
+using miam::I2CSensorHealth;
+using miam::SensorSample;
+using miam::SensorSlot;
+
+struct FakeMeasurement{
+    int counter;
+    double values[3];
+};
+
+TEST(I2CPollingServiceTest, PollingAndSnapshot)
+{
+    I2CPollingService service(NULL);
+    std::atomic<int> nFastReads(0);
+    std::atomic<int> nSlowReads(0);
+    std::shared_ptr<SensorSlot<FakeMeasurement>> fastSlot = service.addSensor<FakeMeasurement>("fast", 0.002,
+        [&nFastReads](FakeMeasurement & measurement)
+        {
+            measurement.counter = ++nFastReads;
+            for(int i = 0; i < 3; i++)
+                measurement.values[i] = measurement.counter;
+            return true;
+        });
+    std::shared_ptr<SensorSlot<int>> slowSlot = service.addSensor<int>("slow", 0.020,
+        [&nSlowReads](int & value)
+        {
+            value = ++nSlowReads;
+            return true;
+        });
+    ASSERT_TRUE(fastSlot != nullptr);
+    ASSERT_TRUE(slowSlot != nullptr);
+
+    SensorSample<int> slowSample;
+    ASSERT_FALSE(slowSlot->read(slowSample));
+
+    service.start();
+    // Sensors cannot be added while running.
+    ASSERT_TRUE(service.addSensor<int>("late", 0.1, [](int &){ return true; }) == nullptr);
+
+    // Read continuously: samples must always be consistent, and never go back in time.
+    uint64_t lastSampleNumber = 0;
+    std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while(std::chrono::steady_clock::now() < endTime)
+    {
+        SensorSample<FakeMeasurement> sample;
+        if(fastSlot->read(sample))
+        {
+            ASSERT_EQ(sample.value.values[0], sample.value.counter);
+            ASSERT_EQ(sample.value.values[2], sample.value.counter);
+            ASSERT_EQ(sample.sampleNumber, static_cast<uint64_t>(sample.value.counter));
+            ASSERT_GE(sample.sampleNumber, lastSampleNumber);
+            ASSERT_LE(sample.timestamp, I2CPollingService::getCurrentTime());
+            lastSampleNumber = sample.sampleNumber;
+        }
+    }
+    service.stop();
+
+    // Rates are roughly respected.
+    ASSERT_GT(nFastReads, 50);
+    ASSERT_LT(nFastReads, 110);
+    ASSERT_GT(nSlowReads, 5);
+    ASSERT_LT(nSlowReads, 15);
+    ASSERT_TRUE(slowSlot->read(slowSample));
+    ASSERT_EQ(slowSample.value, nSlowReads);
+
+    std::vector<I2CSensorHealth> health = service.getHealth();
+    ASSERT_EQ(health.size(), 2u);
+    ASSERT_EQ(health[0].name, "fast");
+    ASSERT_EQ(health[0].nReads, static_cast<uint64_t>(nFastReads));
+    ASSERT_EQ(health[0].nErrors, 0u);
+    ASSERT_TRUE(health[0].isHealthy);
+}
+
+TEST(I2CPollingServiceTest, FailingSensor)
+{
+    I2CPollingService service(NULL, 5, 10.0);
+    std::atomic<bool> isAnswering(false);
+    std::atomic<int> nReads(0);
+    std::shared_ptr<SensorSlot<int>> slot = service.addSensor<int>("nack", 0.002,
+        [&](int & value)
+        {
+            nReads++;
+            value = 42;
+            return isAnswering.load();
+        });
+    service.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // After 5 failures, the sensor is polled every 20ms.
+    std::vector<I2CSensorHealth> health = service.getHealth();
+    ASSERT_FALSE(health[0].isHealthy);
+    ASSERT_EQ(health[0].nErrors, health[0].nReads);
+    ASSERT_LT(nReads, 25);
+    SensorSample<int> sample;
+    ASSERT_FALSE(slot->read(sample));
+
+    // Sensor recovers.
+    isAnswering = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    service.stop();
+    health = service.getHealth();
+    ASSERT_TRUE(health[0].isHealthy);
+    ASSERT_EQ(health[0].nConsecutiveErrors, 0);
+    ASSERT_TRUE(slot->read(sample));
+    ASSERT_EQ(sample.value, 42);
+}
@@ -0,0 +1,196 @@
+// Testing of the I2C register cache and of the drivers using it, with an emulated device.
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/I2CRegisterCache.h"
+#include "miam_utils/drivers/MPC23017Driver.h"
+#include "miam_utils/drivers/PCA9635Driver.h"
+#include "miam_utils/drivers/PCA9685Driver.h"
+
+using miam::I2CRegisterCache;
+using miam::I2CRegisterDevice;
+
+// Emulated chip: a bank of 256 registers, with auto-increment, counting bus transactions.
+class FakeI2CDevice: public I2CRegisterDevice
+{
+    public:
+        FakeI2CDevice(uint8_t const& autoIncrementFlag = 0):
+            nWrites_(0),
+            nReads_(0),
+            nBytesWritten_(0),
+            autoIncrementFlag_(autoIncrementFlag)
+        {
+            for(int i = 0; i < 256; i++)
+                registers_[i] = 0;
+        }
+
+        bool writeRegisters(uint8_t const& registerAddress, int const& length, uint8_t const *values) override
+        {
+            nWrites_++;
+            nBytesWritten_ += length;
+            // Without the auto-increment flag, only a single register can be written.
+            if(length > 1 && (registerAddress & autoIncrementFlag_) != autoIncrementFlag_)
+                return false;
+            int const address = registerAddress & ~autoIncrementFlag_;
+            for(int i = 0; i < length; i++)
+                registers_[(address + i) & 0xFF] = values[i];
+            return true;
+        }
+
+        bool readRegisters(uint8_t const& registerAddress, int const& length, uint8_t *values) override
+        {
+            nReads_++;
+            int const address = registerAddress & ~autoIncrementFlag_;
+            for(int i = 0; i < length; i++)
+                values[i] = registers_[(address + i) & 0xFF];
+            return true;
+        }
+
+        void resetCounters()
+        {
+            nWrites_ = 0;
+            nReads_ = 0;
+            nBytesWritten_ = 0;
+        }
+
+        uint8_t registers_[256];
+        int nWrites_;
+        int nReads_;
+        int nBytesWritten_;
+
+    private:
+        uint8_t autoIncrementFlag_;
+};
+
+TEST(I2CRegisterCacheTest, Cache)
+{
+    std::shared_ptr<FakeI2CDevice> device = std::make_shared<FakeI2CDevice>();
+    device->registers_[0x10] = 0xF0;
+    I2CRegisterCache cache(device);
+
+    // Unknown register: read once, then modified without reading.
+    ASSERT_TRUE(cache.setBits(0x10, 0x0F, 0x05));
+    ASSERT_TRUE(cache.setBits(0x10, 0x80, 0x00));
+    ASSERT_EQ(device->nReads_, 1);
+    ASSERT_EQ(device->nWrites_, 0);
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->registers_[0x10], 0x75);
+
+    // Same value: nothing written.
+    ASSERT_TRUE(cache.write(0x10, 0x75));
+    ASSERT_EQ(device->nWrites_, 1);
+
+    // Contiguous registers, and small known gaps, are written in a single transaction.
+    uint8_t values[4] = {1, 2, 3, 4};
+    device->resetCounters();
+    ASSERT_TRUE(cache.write(0x0C, 4, values));
+    ASSERT_EQ(device->nWrites_, 1);
+    device->resetCounters();
+    cache.set(0x0C, 10);
+    cache.set(0x0F, 11);
+    cache.set(0x20, 12);
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(device->nWrites_, 2);
+    ASSERT_EQ(device->nBytesWritten_, 4 + 1);
+    ASSERT_EQ(device->registers_[0x0C], 10);
+    ASSERT_EQ(device->registers_[0x0D], 2);
+    ASSERT_EQ(device->registers_[0x0F], 11);
+    ASSERT_EQ(device->registers_[0x20], 12);
+
+    // Invalidation: values are rewritten.
+    cache.invalidate();
+    device->resetCounters();
+    ASSERT_TRUE(cache.write(0x0C, 4, values));
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->nBytesWritten_, 4);
+}
+
+TEST(I2CRegisterCacheTest, MPC23017)
+{
+    std::shared_ptr<FakeI2CDevice> device = std::make_shared<FakeI2CDevice>();
+    MPC mpc;
+    ASSERT_TRUE(mpc_init(&mpc, device));
+    for(int pin = 0; pin < 16; pin++)
+        mpc_pinMode(mpc, pin, MPC_OUTPUT);
+    ASSERT_EQ(device->registers_[0x00], 0x00);
+    ASSERT_EQ(device->registers_[0x01], 0x00);
+
+    // Writing a pin: no read, a single write.
+    device->resetCounters();
+    mpc_digitalWrite(mpc, 9, 1);
+    ASSERT_EQ(device->nReads_, 0);
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->registers_[0x15], 0x02);
+    // Same value: nothing sent.
+    mpc_digitalWrite(mpc, 9, 1);
+    ASSERT_EQ(device->nWrites_, 1);
+
+    // Several pins, on both ports: a single transaction.
+    device->resetCounters();
+    mpc_writePins(mpc, (1 << 0) | (1 << 15), 1 << 9);
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->nReads_, 0);
+    ASSERT_EQ(device->registers_[0x14], 0x01);
+    ASSERT_EQ(device->registers_[0x15], 0x80);
+
+    device->resetCounters();
+    mpc_writeAll(mpc, 0x8001);
+    ASSERT_EQ(device->nWrites_, 0);
+    mpc_writeAll(mpc, 0x8101);
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->nBytesWritten_, 1);
+}
+
+TEST(I2CRegisterCacheTest, PCA9635)
+{
+    std::shared_ptr<FakeI2CDevice> device = std::make_shared<FakeI2CDevice>(0x80);
+    PCA9635 driver;
+    ASSERT_TRUE(ledDriver_init(&driver, device));
+
+    // All 16 leds: one transaction for brightness, one for led state.
+    int brightness[16];
+    for(int i = 0; i < 16; i++)
+        brightness[i] = 10 * i;
+    device->resetCounters();
+    ledDriver_setLedsBrightness(&driver, 0, 16, brightness);
+    ASSERT_EQ(device->nWrites_, 2);
+    ASSERT_EQ(device->nReads_, 0);
+    for(int i = 1; i < 16; i++)
+        ASSERT_EQ(device->registers_[0x02 + i], 10 * i);
+    // Led 0 is off, others under PWM control.
+    ASSERT_EQ(device->registers_[0x14], 0b10101000);
+    ASSERT_EQ(device->registers_[0x17], 0b10101010);
+
+    // RGB led: a single brightness change.
+    device->resetCounters();
+    ledDriver_setRGBledBrightness(&driver, 3, 40, 30, 100);
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->registers_[0x02 + 5], 100);
+}
+
+TEST(I2CRegisterCacheTest, PCA9685)
+{
+    std::shared_ptr<FakeI2CDevice> device = std::make_shared<FakeI2CDevice>();
+    PCA9685 driver;
+    ASSERT_TRUE(driver.init(device));
+
+    // All 16 channels: a single transaction.
+    device->resetCounters();
+    driver.setBrightness(std::vector<double>(16, 0.5));
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->nBytesWritten_, 4 * 16 - 3);
+    for(int led = 0; led < 16; led++)
+    {
+        ASSERT_EQ(device->registers_[0x08 + 4 * led], 0x00);
+        ASSERT_EQ(device->registers_[0x09 + 4 * led], 0x08);
+    }
+
+    // A single channel: only its modified registers.
+    device->resetCounters();
+    driver.setBrightness(3, 1.5);
+    ASSERT_EQ(device->nWrites_, 1);
+    ASSERT_EQ(device->registers_[0x07 + 4 * 3], 0x10);
+    ASSERT_EQ(device->registers_[0x09 + 4 * 3], 0x00);
+}
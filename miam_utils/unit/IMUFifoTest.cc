@@ -0,0 +1,146 @@
+// Testing of IMU FIFO sampling, using a replayed FIFO.
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/IMUFifo.h"
+
+using miam::IMUFifoRecorder;
+using miam::IMUFifoReplay;
+using miam::IMUFifoSampler;
+using miam::IMUSample;
+
+double const ODR = 833.0;
+double const GYRO_SCALING = 0.00875 * M_PI / 180.0;
+double const ACCEL_SCALING = 0.061 / 1000.0 * 9.81;
+
+// Create a recording: constant rotation around z, with a bias, and gravity on z.
+static std::vector<int16_t> createRecording(int const& nSamples, int16_t const& gyroZ, int16_t const& bias)
+{
+    std::vector<int16_t> words;
+    for(int i = 0; i < nSamples; i++)
+    {
+        int16_t const sample[6] = {bias, static_cast<int16_t>(-bias), static_cast<int16_t>(gyroZ + bias),
+                                   static_cast<int16_t>(i % 100), 0, 16393};
+        words.insert(words.end(), sample, sample + 6);
+    }
+    return words;
+}
+
+TEST(IMUFifoTest, SamplingAndHeading)
+{
+    // 2s of recording: 1000 counts on z, i.e. about 0.153rad/s.
+    std::shared_ptr<IMUFifoReplay> replay = std::make_shared<IMUFifoReplay>(createRecording(2 * ODR, 1000, 0),
+                                                                            ODR, GYRO_SCALING, ACCEL_SCALING);
+    IMUFifoSampler sampler(replay, 16);
+
+    // 10ms control loop.
+    int nSamples = 0;
+    double lastTimestamp = -1.0;
+    for(int tick = 1; tick <= 200; tick++)
+    {
+        replay->advance(0.010);
+        int n = sampler.update(tick * 0.010);
+        ASSERT_GE(n, 8);
+        ASSERT_LE(n, 9);
+        nSamples += n;
+        // Timestamps are evenly spaced, and not in the future. Between two updates, timestamps may be slightly
+        // shifted to remain in the past.
+        for(unsigned int i = 0; i < sampler.getLastSamples().size(); i++)
+        {
+            IMUSample const& sample = sampler.getLastSamples()[i];
+            if(i > 0)
+            {
+                ASSERT_NEAR(sample.timestamp - lastTimestamp, 1 / ODR, 1e-9);
+            }
+            else if(lastTimestamp > 0)
+            {
+                ASSERT_NEAR(sample.timestamp - lastTimestamp, 1 / ODR, 0.1 / ODR);
+            }
+            lastTimestamp = sample.timestamp;
+            ASSERT_LE(sample.timestamp, tick * 0.010 + 1e-9);
+            ASSERT_NEAR(sample.accel.z, 9.81, 0.01);
+        }
+        // Heading increment over a tick.
+        ASSERT_NEAR(sampler.getHeadingIncrement(), n / ODR * 1000 * GYRO_SCALING, 1e-9);
+    }
+    ASSERT_EQ(nSamples, static_cast<int>(2 * ODR));
+    ASSERT_NEAR(sampler.getHeading(), 2 * 1000 * GYRO_SCALING, 1e-3);
+    ASSERT_EQ(sampler.getNumberOfOverruns(), 0);
+}
+
+TEST(IMUFifoTest, BiasEstimation)
+{
+    // First second: still, with bias. Then rotation.
+    std::vector<int16_t> words = createRecording(ODR, 0, 50);
+    std::vector<int16_t> rotation = createRecording(ODR, 1000, 50);
+    words.insert(words.end(), rotation.begin(), rotation.end());
+    std::shared_ptr<IMUFifoReplay> replay = std::make_shared<IMUFifoReplay>(words, ODR, GYRO_SCALING, ACCEL_SCALING);
+    IMUFifoSampler sampler(replay);
+
+    sampler.startBiasEstimation();
+    for(int tick = 1; tick <= 100; tick++)
+    {
+        replay->advance(0.010);
+        sampler.update(tick * 0.010);
+    }
+    ASSERT_TRUE(sampler.stopBiasEstimation());
+    ASSERT_NEAR(sampler.getGyroBias().x, 50 * GYRO_SCALING, 1e-9);
+    ASSERT_NEAR(sampler.getGyroBias().y, -50 * GYRO_SCALING, 1e-9);
+    ASSERT_NEAR(sampler.getGyroBias().z, 50 * GYRO_SCALING, 1e-9);
+
+    sampler.getHeadingIncrement();
+    for(int tick = 101; tick <= 200; tick++)
+    {
+        replay->advance(0.010);
+        sampler.update(tick * 0.010);
+    }
+    // Bias-corrected heading.
+    ASSERT_NEAR(sampler.getHeadingIncrement(), 1000 * GYRO_SCALING, 1e-3);
+}
+
+TEST(IMUFifoTest, AlignmentAndOverrun)
+{
+    std::shared_ptr<IMUFifoReplay> replay = std::make_shared<IMUFifoReplay>(createRecording(ODR, 1000, 0),
+                                                                            ODR, GYRO_SCALING, ACCEL_SCALING, 600);
+    IMUFifoSampler sampler(replay);
+
+    // Read two words: the FIFO is no longer aligned on a sample.
+    replay->advance(0.010);
+    int16_t words[2];
+    ASSERT_TRUE(replay->readFifoWords(words, 2));
+    int n = sampler.update(0.010);
+    ASSERT_EQ(n, 7);
+    for(IMUSample const& sample : sampler.getLastSamples())
+        ASSERT_NEAR(sample.gyro.z, 1000 * GYRO_SCALING, 1e-9);
+
+    // Overrun: FIFO holds 100 samples.
+    replay->advance(0.5);
+    n = sampler.update(0.510);
+    ASSERT_EQ(n, 100);
+    ASSERT_EQ(sampler.getNumberOfOverruns(), 1);
+    ASSERT_NEAR(sampler.getLastSamples().back().timestamp, 0.510, 1e-9);
+}
+
+TEST(IMUFifoTest, RecordAndReplay)
+{
+    std::string const filename = "/tmp/miam_imu_fifo_test.bin";
+    std::vector<int16_t> recording = createRecording(100, 1000, 10);
+    std::shared_ptr<IMUFifoReplay> replay = std::make_shared<IMUFifoReplay>(recording, ODR, GYRO_SCALING, ACCEL_SCALING);
+    {
+        std::shared_ptr<IMUFifoRecorder> recorder = std::make_shared<IMUFifoRecorder>(replay, filename);
+        IMUFifoSampler sampler(recorder);
+        replay->advance(1.0);
+        ASSERT_EQ(sampler.update(1.0), 100);
+    }
+
+    std::vector<int16_t> words;
+    double odr, gyroScaling, accelScaling;
+    ASSERT_TRUE(IMUFifoReplay::loadRecording(filename, words, odr, gyroScaling, accelScaling));
+    ASSERT_EQ(words, recording);
+    ASSERT_EQ(odr, ODR);
+    ASSERT_EQ(gyroScaling, GYRO_SCALING);
+    ASSERT_EQ(accelScaling, ACCEL_SCALING);
+    std::remove(filename.c_str());
+}
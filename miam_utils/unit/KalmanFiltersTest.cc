@@ -0,0 +1,193 @@
+// Testing of the generic Kalman filters.
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include "miam_utils/KalmanFilters.hpp"
+
+using miam::FixedMatrix;
+
+double const DT = 0.01;
+
+// Constant velocity model, state (position, velocity).
+FixedMatrix<2, 2> getTransition()
+{
+    FixedMatrix<2, 2> F = FixedMatrix<2, 2>::identity();
+    F(0, 1) = DT;
+    return F;
+}
+
+FixedMatrix<2, 2> getProcessNoise()
+{
+    FixedMatrix<2, 2> Q = FixedMatrix<2, 2>::zero();
+    Q(0, 0) = 1e-6;
+    Q(1, 1) = 1e-3;
+    return Q;
+}
+
+TEST(KalmanFiltersTest, LinearFilter)
+{
+    // Position and velocity measured: the sequential update gives the same result as the textbook (matrix) update.
+    FixedMatrix<2, 2> const P0 = FixedMatrix<2, 2>::identity();
+    double const x0[2] = {0.0, 0.0};
+    double const z[2] = {0.5, -0.2};
+    double const r[2] = {0.01, 0.04};
+    miam::KalmanFilter<2> kf;
+    kf.reset(x0, P0);
+    kf.update(FixedMatrix<2, 2>::identity(), z, r);
+    // H = I, P = I: K = (I + R)^-1, diagonal.
+    for(int i = 0; i < 2; i++)
+    {
+        ASSERT_NEAR(kf.getState()[i], z[i] / (1.0 + r[i]), 1e-12);
+        ASSERT_NEAR(kf.getCovariance()(i, i), r[i] / (1.0 + r[i]), 1e-12);
+    }
+    ASSERT_NEAR(kf.getCovariance()(0, 1), 0.0, 1e-12);
+
+    // On a linear system, the UKF is exact: both filters give the same estimate.
+    miam::UnscentedKalmanFilter<2> ukf;
+    kf.reset(x0, P0);
+    ukf.reset(x0, P0);
+    FixedMatrix<2, 2> const F = getTransition();
+    FixedMatrix<1, 2> H = FixedMatrix<1, 2>::zero();
+    H(0, 0) = 1.0;
+    auto process = [&F](double const (&x)[2], double (&newX)[2])
+    {
+        newX[0] = F(0, 0) * x[0] + F(0, 1) * x[1];
+        newX[1] = F(1, 0) * x[0] + F(1, 1) * x[1];
+    };
+    auto measurement = [](double const (&x)[2], double (&y)[1]) { y[0] = x[0]; };
+    for(int i = 0; i < 500; i++)
+    {
+        double const t = i * DT;
+        double const position[1] = {std::sin(t)};
+        double const variance[1] = {1e-4};
+        kf.predict(F, getProcessNoise());
+        kf.update(H, position, variance);
+        ASSERT_TRUE(ukf.predict(process, getProcessNoise()));
+        ASSERT_TRUE(ukf.update(measurement, position, variance));
+    }
+    for(int i = 0; i < 2; i++)
+    {
+        ASSERT_NEAR(kf.getState()[i], ukf.getState()[i], 1e-9);
+        for(int j = 0; j < 2; j++)
+            ASSERT_NEAR(kf.getCovariance()(i, j), ukf.getCovariance()(i, j), 1e-12);
+    }
+    // Velocity estimated from the position alone.
+    ASSERT_NEAR(kf.getState()[1], std::cos(500 * DT), 0.1);
+}
+
+TEST(KalmanFiltersTest, NonLinearFilter)
+{
+    // Static target, observed in range and bearing from a moving sensor: EKF and UKF converge to it.
+    double const target[2] = {1.0, 2.0};
+    double const x0[2] = {1.5, 1.5};
+    FixedMatrix<2, 2> P0 = FixedMatrix<2, 2>::identity();
+    P0(0, 0) = 0.25;
+    P0(1, 1) = 0.25;
+    miam::KalmanFilter<2> ekf;
+    miam::UnscentedKalmanFilter<2> ukf;
+    ekf.reset(x0, P0);
+    ukf.reset(x0, P0);
+    double const variances[2] = {1e-4, 1e-4};
+    for(int i = 0; i < 50; i++)
+    {
+        double const sx = std::cos(0.1 * i);
+        double const sy = std::sin(0.1 * i);
+        auto measurement = [sx, sy](double const (&x)[2], double (&y)[2])
+        {
+            y[0] = std::hypot(x[0] - sx, x[1] - sy);
+            y[1] = std::atan2(x[1] - sy, x[0] - sx);
+        };
+        double z[2];
+        measurement(target, z);
+
+        double predicted[2];
+        measurement(ekf.getState(), predicted);
+        double const dx = ekf.getState()[0] - sx;
+        double const dy = ekf.getState()[1] - sy;
+        double const r2 = dx * dx + dy * dy;
+        FixedMatrix<2, 2> H;
+        H(0, 0) = dx / std::sqrt(r2);
+        H(0, 1) = dy / std::sqrt(r2);
+        H(1, 0) = -dy / r2;
+        H(1, 1) = dx / r2;
+        ekf.update(H, predicted, z, variances);
+        ASSERT_TRUE(ukf.update(measurement, z, variances));
+    }
+    // The EKF, linearized far from the target at first, becomes overconfident and converges more slowly.
+    for(int i = 0; i < 2; i++)
+    {
+        ASSERT_NEAR(ekf.getState()[i], target[i], 5e-3);
+        ASSERT_NEAR(ukf.getState()[i], target[i], 1e-3);
+    }
+    ASSERT_LT(ekf.getCovariance()(0, 0), 1e-4);
+}
+
+// Time per predict + update cycle, in us.
+template<int N, int M>
+void benchmark()
+{
+    int const N_ITERATIONS = 100000;
+    FixedMatrix<N, N> F = FixedMatrix<N, N>::identity();
+    for(int i = 0; i + 1 < N; i++)
+        F(i, i + 1) = DT;
+    FixedMatrix<N, N> Q = FixedMatrix<N, N>::identity();
+    FixedMatrix<M, N> H = FixedMatrix<M, N>::zero();
+    for(int i = 0; i < M; i++)
+        H(i, i) = 1.0;
+    double z[M];
+    double variances[M];
+    for(int i = 0; i < M; i++)
+        variances[i] = 1.0;
+
+    miam::KalmanFilter<N> kf;
+    auto start = std::chrono::steady_clock::now();
+    for(int n = 0; n < N_ITERATIONS; n++)
+    {
+        for(int i = 0; i < M; i++)
+            z[i] = std::sin(n + i);
+        kf.predict(F, Q);
+        kf.update(H, z, variances);
+    }
+    double const kfTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    miam::UnscentedKalmanFilter<N> ukf;
+    auto process = [&F](double const (&x)[N], double (&newX)[N])
+    {
+        for(int i = 0; i < N; i++)
+        {
+            newX[i] = 0.0;
+            for(int j = 0; j < N; j++)
+                newX[i] += F(i, j) * x[j];
+        }
+    };
+    auto measurement = [](double const (&x)[N], double (&y)[M])
+    {
+        for(int i = 0; i < M; i++)
+            y[i] = x[i];
+    };
+    start = std::chrono::steady_clock::now();
+    for(int n = 0; n < N_ITERATIONS; n++)
+    {
+        for(int i = 0; i < M; i++)
+            z[i] = std::sin(n + i);
+        ukf.predict(process, Q);
+        ukf.update(measurement, z, variances);
+    }
+    double const ukfTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "State " << N << ", measurement " << M << ": KF " << kfTime / N_ITERATIONS * 1e6 << "us, UKF "
+              << ukfTime / N_ITERATIONS * 1e6 << "us per predict + update" << std::endl;
+    // Keep the results alive.
+    ASSERT_TRUE(std::isfinite(kf.getState()[0]));
+    ASSERT_TRUE(std::isfinite(ukf.getState()[0]));
+}
+
+TEST(KalmanFiltersTest, Benchmark)
+{
+    benchmark<2, 1>();
+    benchmark<4, 2>();
+    benchmark<6, 3>();
+    benchmark<9, 3>();
+}
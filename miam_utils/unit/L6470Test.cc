@@ -0,0 +1,238 @@
+// Testing of the L6470 driver, using the L6470 emulator.
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/L6470Driver.h"
+#include "miam_utils/drivers/L6470Emulator.h"
+
+using miam::L6470;
+using miam::L6470Emulator;
+using miam::L6470EmulatorStatistics;
+
+// Connect a driver to an emulator, and initialize it.
+static void initDriver(L6470 & driver, std::shared_ptr<L6470Emulator> emulator)
+{
+    driver = L6470(emulator, emulator->getNumberOfDevices());
+    // 1000 steps/s, 2000 steps/s^2.
+    bool isInit = driver.init(1000, 2000, 0x30, 0x3B, 0x1430, 0x22, 0x53);
+    EXPECT_TRUE(isInit);
+}
+
+TEST(L6470Test, Init)
+{
+    for (int nDevices = 1; nDevices <= 4; nDevices++)
+    {
+        std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(nDevices);
+        L6470 driver;
+        initDriver(driver, emulator);
+        ASSERT_EQ(driver.getNumberOfDevices(), nDevices);
+        for (int i = 0; i < nDevices; i++)
+        {
+            ASSERT_TRUE(emulator->getDevice(i).isHighZ());
+            ASSERT_EQ(emulator->getDevice(i).getRegister(0x09), 0x30u);
+            ASSERT_EQ(emulator->getDevice(i).getRegister(0x0E), 0x22u);
+        }
+        // A missing device (chain shorter than expected) makes init fail.
+        L6470 wrongDriver(emulator, nDevices + 1);
+        ASSERT_FALSE(wrongDriver.init(1000, 2000, 0x30, 0x3B, 0x1430, 0x22, 0x53));
+    }
+}
+
+TEST(L6470Test, SpeedAndPosition)
+{
+    int const N = 3;
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(N);
+    L6470 driver;
+    initDriver(driver, emulator);
+
+    double speeds[N] = {500.0, -300.0, 0.0};
+    driver.setSpeed(speeds);
+    emulator->update(1.0);
+
+    double measuredSpeeds[N];
+    driver.getSpeed(measuredSpeeds);
+    double positions[N];
+    driver.getPosition(positions);
+    for (int i = 0; i < N; i++)
+    {
+        ASSERT_NEAR(emulator->getDevice(i).getSpeed(), speeds[i], 1.0);
+        ASSERT_NEAR(measuredSpeeds[i], std::abs(speeds[i]), 1.0);
+        ASSERT_NEAR(positions[i], emulator->getDevice(i).getPosition(), 1.0);
+    }
+    // Motor 1 went backward.
+    ASSERT_LT(positions[1], -100);
+
+    // Vector API gives the same result.
+    std::vector<double> positionVector = driver.getPosition();
+    ASSERT_EQ(positionVector.size(), static_cast<unsigned int>(N));
+    for (int i = 0; i < N; i++)
+        ASSERT_EQ(positionVector[i], positions[i]);
+
+    // Stop.
+    driver.hardStop();
+    emulator->update(0.1);
+    for (int i = 0; i < N; i++)
+        ASSERT_EQ(emulator->getDevice(i).getSpeed(), 0.0);
+    ASSERT_FALSE(driver.isBusy());
+}
+
+TEST(L6470Test, MoveNSteps)
+{
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(2);
+    L6470 driver;
+    initDriver(driver, emulator);
+    driver.setStepMode(miam::L6470_STEP_MODE::MICRO_8);
+    driver.hardStop();
+
+    driver.moveNSteps({200, -50});
+    emulator->update(0.01);
+    ASSERT_TRUE(driver.isBusy());
+    emulator->update(2.0);
+    ASSERT_FALSE(driver.isBusy());
+
+    std::vector<double> positions = driver.getPosition();
+    ASSERT_DOUBLE_EQ(positions[0], 200);
+    ASSERT_DOUBLE_EQ(positions[1], -50);
+}
+
+TEST(L6470Test, Errors)
+{
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(2);
+    L6470 driver;
+    initDriver(driver, emulator);
+
+    uint32_t errors[2];
+    driver.getError(errors);
+    ASSERT_EQ(errors[0], 0u);
+    ASSERT_EQ(errors[1], 0u);
+
+    // Overcurrent on second device: reported once, then cleared.
+    emulator->getDevice(1).triggerStatusEvent(0x1000);
+    driver.getError(errors);
+    ASSERT_EQ(errors[0], 0u);
+    ASSERT_NE(errors[1], 0u);
+    driver.getError(errors);
+    ASSERT_EQ(errors[1], 0u);
+
+    // Invalid command is reported.
+    emulator->getDevice(0).triggerStatusEvent(0x0100);
+    driver.getError(errors);
+    ASSERT_NE(errors[0], 0u);
+}
+
+TEST(L6470Test, ExchangeDeduplication)
+{
+    int const N = 2;
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(N);
+    L6470 driver;
+    initDriver(driver, emulator);
+
+    double speeds[N] = {400.0, -400.0};
+    double positions[N];
+    uint32_t errors[N];
+
+    // First exchange: status, position and speed, in a single message.
+    emulator->resetStatistics();
+    driver.exchange(speeds, positions, errors);
+    L6470EmulatorStatistics stats = emulator->getStatistics();
+    ASSERT_EQ(stats.nMessages, 1);
+    ASSERT_EQ(stats.nFrames, 3 + 4 + 4);
+    ASSERT_EQ(emulator->getDevice(0).isHighZ(), false);
+
+    // Same speed: run command is not sent again.
+    emulator->update(0.5);
+    emulator->resetStatistics();
+    driver.exchange(speeds, positions, errors);
+    stats = emulator->getStatistics();
+    ASSERT_EQ(stats.nFrames, 3 + 4);
+    for (int i = 0; i < N; i++)
+        ASSERT_NEAR(positions[i], emulator->getDevice(i).getPosition(), 1.0);
+
+    // Changing a single motor: other motor receives NOP and keeps its speed.
+    speeds[0] = 200.0;
+    emulator->resetStatistics();
+    driver.exchange(speeds, positions, errors);
+    ASSERT_EQ(emulator->getStatistics().nFrames, 3 + 4 + 4);
+    emulator->update(0.5);
+    ASSERT_NEAR(emulator->getDevice(0).getSpeed(), 200.0, 1.0);
+    ASSERT_NEAR(emulator->getDevice(1).getSpeed(), -400.0, 1.0);
+
+    // Any other command forces resending the speed.
+    driver.hardStop();
+    emulator->resetStatistics();
+    driver.exchange(speeds, positions, errors);
+    ASSERT_EQ(emulator->getStatistics().nFrames, 3 + 4 + 4);
+    emulator->update(0.5);
+    ASSERT_NEAR(emulator->getDevice(1).getSpeed(), -400.0, 1.0);
+
+    // An error reported by the status also forces resending the speed at the next call.
+    emulator->getDevice(1).triggerStatusEvent(0x0080);
+    driver.exchange(speeds, positions, errors);
+    ASSERT_NE(errors[1], 0u);
+    emulator->resetStatistics();
+    driver.exchange(speeds, positions, errors);
+    ASSERT_EQ(emulator->getStatistics().nFrames, 3 + 4 + 4);
+
+    // Position-only exchange.
+    emulator->resetStatistics();
+    driver.exchange(NULL, positions, NULL);
+    ASSERT_EQ(emulator->getStatistics().nFrames, 4);
+}
+
+TEST(L6470Test, PerTickCostBenchmark)
+{
+    // Compare the SPI cost of a control loop tick: separate calls versus a single exchange.
+    int const N = 2;
+    int const N_TICKS = 1000;
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(N);
+    L6470 driver;
+    initDriver(driver, emulator);
+
+    double speeds[N] = {0.0, 0.0};
+    double positions[N];
+    uint32_t errors[N];
+
+    // Speed profile: constant speed half of the time, as is typical of trajectory following.
+    auto speedAt = [](int const& tick) { return (tick % 100 < 50 ? 300.0 : 3.0 * (tick % 100)); };
+
+    emulator->resetStatistics();
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < N_TICKS; tick++)
+    {
+        driver.getPosition(positions);
+        driver.getError(errors);
+        speeds[0] = speedAt(tick);
+        speeds[1] = -speedAt(tick);
+        driver.setSpeed(speeds);
+    }
+    double separateCpuTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    L6470EmulatorStatistics separate = emulator->getStatistics();
+
+    emulator->resetStatistics();
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < N_TICKS; tick++)
+    {
+        speeds[0] = speedAt(tick);
+        speeds[1] = -speedAt(tick);
+        driver.exchange(speeds, positions, errors);
+    }
+    double exchangeCpuTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    L6470EmulatorStatistics exchange = emulator->getStatistics();
+
+    std::cout << "Per tick cost, separate calls: " << separate.nMessages / static_cast<double>(N_TICKS) << " messages, "
+              << separate.nFrames / static_cast<double>(N_TICKS) << " frames, "
+              << separate.busTime / N_TICKS * 1e6 << "us bus time, "
+              << separateCpuTime / N_TICKS * 1e6 << "us CPU (emulated)" << std::endl;
+    std::cout << "Per tick cost, exchange: " << exchange.nMessages / static_cast<double>(N_TICKS) << " messages, "
+              << exchange.nFrames / static_cast<double>(N_TICKS) << " frames, "
+              << exchange.busTime / N_TICKS * 1e6 << "us bus time, "
+              << exchangeCpuTime / N_TICKS * 1e6 << "us CPU (emulated)" << std::endl;
+
+    ASSERT_EQ(exchange.nMessages, N_TICKS);
+    ASSERT_EQ(separate.nMessages, 3 * N_TICKS);
+    ASSERT_LT(exchange.nFrames, separate.nFrames);
+    ASSERT_LT(exchange.busTime, separate.busTime);
+}
@@ -0,0 +1,124 @@
+// Testing of the LCD shadow framebuffer, using a simulated HD44780.
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/LCDDriver.h"
+
+using miam::LCDFramebuffer;
+
+// Pins, as wired on the Adafruit shield.
+int const RS_PIN = 15;
+int const ENABLE_PIN = 13;
+int const DATA_PINS[4] = {12, 11, 10, 9};
+
+// Minimal HD44780 model, in 4-bit mode: DDRAM writes and address commands only.
+class LCDSimulator
+{
+    public:
+        LCDSimulator():
+            address_(0),
+            isHighNibble_(true),
+            byte_(0),
+            enable_(false)
+        {
+            ddram_.assign(0x80, ' ');
+        }
+
+        void apply(std::vector<unsigned int> const& portValues)
+        {
+            for(unsigned int portValue : portValues)
+            {
+                bool const enable = portValue & (1 << ENABLE_PIN);
+                // Data is latched on the enable falling edge.
+                if(enable_ && !enable)
+                {
+                    int nibble = 0;
+                    for(int x = 0; x < 4; x++)
+                        nibble |= ((portValue >> DATA_PINS[x]) & 1) << x;
+                    byte_ = (isHighNibble_ ? nibble << 4 : byte_ | nibble);
+                    if(!isHighNibble_)
+                        execute(byte_, portValue & (1 << RS_PIN));
+                    isHighNibble_ = !isHighNibble_;
+                }
+                enable_ = enable;
+            }
+        }
+
+        std::string getLine(int const& line)
+        {
+            return ddram_.substr(line == 0 ? 0 : 0x40, 16);
+        }
+
+    private:
+        void execute(int const& byte, bool const& isCharacter)
+        {
+            if(isCharacter)
+                ddram_[address_++] = byte;
+            else if(byte & 0x80)
+                address_ = byte & 0x7F;
+        }
+
+        std::string ddram_;
+        int address_;
+        bool isHighNibble_;
+        int byte_;
+        bool enable_;
+};
+
+TEST(LCDFramebufferTest, DiffUpdate)
+{
+    LCDFramebuffer framebuffer;
+    LCDSimulator lcd;
+    std::vector<unsigned int> portValues;
+    unsigned int const backlight = 0b101 << 6;
+
+    // First update: only the non-blank characters are written.
+    std::string lines[2] = {"Score: 12", "Battery 12.1V"};
+    int nBytes = framebuffer.update(lines, backlight, portValues);
+    lcd.apply(portValues);
+    ASSERT_EQ(lcd.getLine(0), "Score: 12       ");
+    ASSERT_EQ(lcd.getLine(1), "Battery 12.1V   ");
+    // Line 0: address + 9 characters (the space in "Score: 12" is rewritten). Line 1: address + 13 characters.
+    ASSERT_EQ(nBytes, 24);
+    // Backlight pins are preserved.
+    for(unsigned int portValue : portValues)
+        ASSERT_EQ(portValue & ~LCDFramebuffer::getLCDPinMask(), backlight);
+
+    // No change: nothing is sent.
+    portValues.clear();
+    ASSERT_EQ(framebuffer.update(lines, backlight, portValues), 0);
+    ASSERT_TRUE(portValues.empty());
+
+    // Typical status update: a couple of digits change.
+    lines[0] = "Score: 14";
+    lines[1] = "Battery 12.0V";
+    portValues.clear();
+    nBytes = framebuffer.update(lines, backlight, portValues);
+    lcd.apply(portValues);
+    ASSERT_EQ(nBytes, 4);
+    ASSERT_EQ(lcd.getLine(0), "Score: 14       ");
+    ASSERT_EQ(lcd.getLine(1), "Battery 12.0V   ");
+
+    // Two close changes: the unchanged character in between is rewritten instead of moving the cursor.
+    lines[0] = "Sc0r0: 14";
+    portValues.clear();
+    nBytes = framebuffer.update(lines, backlight, portValues);
+    lcd.apply(portValues);
+    ASSERT_EQ(nBytes, 4);
+    ASSERT_EQ(lcd.getLine(0), "Sc0r0: 14       ");
+
+    // Shorter text: trailing characters are cleared.
+    lines[1] = "Low";
+    portValues.clear();
+    framebuffer.update(lines, backlight, portValues);
+    lcd.apply(portValues);
+    ASSERT_EQ(lcd.getLine(1), "Low             ");
+
+    // Invalidation: everything is rewritten.
+    framebuffer.invalidate();
+    portValues.clear();
+    ASSERT_EQ(framebuffer.update(lines, backlight, portValues), 2 * 17);
+    lcd.apply(portValues);
+    ASSERT_EQ(lcd.getLine(0), "Sc0r0: 14       ");
+}
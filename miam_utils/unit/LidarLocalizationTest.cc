@@ -0,0 +1,113 @@
+// Testing of the lidar scan matching, on a simulated table.
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "miam_utils/LidarLocalization.h"
+
+using miam::RobotPosition;
+
+// Table borders and a few fixed obstacles.
+std::vector<std::vector<RobotPosition>> getTableSegments()
+{
+    std::vector<std::vector<RobotPosition>> segments;
+    segments.push_back({RobotPosition(0, 0, 0), RobotPosition(3000, 0, 0)});
+    segments.push_back({RobotPosition(3000, 0, 0), RobotPosition(3000, 2000, 0)});
+    segments.push_back({RobotPosition(3000, 2000, 0), RobotPosition(0, 2000, 0)});
+    segments.push_back({RobotPosition(0, 2000, 0), RobotPosition(0, 0, 0)});
+    segments.push_back({RobotPosition(1478, 2000, 0), RobotPosition(1478, 1700, 0)});
+    segments.push_back({RobotPosition(1478, 1700, 0), RobotPosition(1522, 1700, 0)});
+    segments.push_back({RobotPosition(1522, 1700, 0), RobotPosition(1522, 2000, 0)});
+    return segments;
+}
+
+// Simulated scan: ray casting against the table segments, one point per degree.
+std::vector<RobotPosition> getScan(RobotPosition const& position)
+{
+    std::vector<std::vector<RobotPosition>> const segments = getTableSegments();
+    std::vector<RobotPosition> points;
+    for(int i = 0; i < 360; i++)
+    {
+        double const angle = i * M_PI / 180.0;
+        double const dx = std::cos(position.theta + angle);
+        double const dy = std::sin(position.theta + angle);
+        double distance = 1e6;
+        for(std::vector<RobotPosition> const& segment : segments)
+        {
+            double const ex = segment[1].x - segment[0].x;
+            double const ey = segment[1].y - segment[0].y;
+            double const determinant = ex * dy - ey * dx;
+            if(std::abs(determinant) < 1e-9)
+                continue;
+            double const px = segment[0].x - position.x;
+            double const py = segment[0].y - position.y;
+            double const t = (ex * py - ey * px) / determinant;
+            double const u = (dx * py - dy * px) / determinant;
+            if(t > 0 && u >= 0 && u <= 1)
+                distance = std::min(distance, t);
+        }
+        // Small deterministic noise.
+        distance += 3.0 * std::sin(7.0 * i);
+        points.push_back(RobotPosition(distance * std::cos(angle), distance * std::sin(angle), 0));
+    }
+    return points;
+}
+
+void buildMap(miam::DistanceFieldMap & map)
+{
+    for(std::vector<RobotPosition> const& segment : getTableSegments())
+        map.addSegment(segment[0], segment[1]);
+    map.build();
+}
+
+TEST(LidarLocalizationTest, ScanMatching)
+{
+    miam::DistanceFieldMap map(3000, 2000);
+    buildMap(map);
+
+    RobotPosition const truePosition(1000, 800, 0.6);
+    std::vector<RobotPosition> points = getScan(truePosition);
+
+    miam::ScanMatcher matcher;
+    miam::ScanMatch match = matcher.match(map, points, RobotPosition(1030, 780, 0.65));
+    ASSERT_TRUE(match.isValid);
+    ASSERT_NEAR(match.position.x, truePosition.x, 3.0);
+    ASSERT_NEAR(match.position.y, truePosition.y, 3.0);
+    ASSERT_NEAR(match.position.theta, truePosition.theta, 0.003);
+    ASSERT_GT(match.nInliers, 300);
+    ASSERT_LT(match.positionStd, 5.0);
+
+    // Points from another robot, close to the robot: rejected as outliers, the match is unchanged.
+    for(int i = 0; i < 30; i++)
+        points.push_back(RobotPosition(300 + i, 100 + 2 * i, 0));
+    match = matcher.match(map, points, RobotPosition(1030, 780, 0.65));
+    ASSERT_TRUE(match.isValid);
+    ASSERT_NEAR(match.position.x, truePosition.x, 3.0);
+    ASSERT_NEAR(match.position.y, truePosition.y, 3.0);
+
+    // Scan not matching the map at all: invalid.
+    match = matcher.match(map, getScan(RobotPosition(2500, 1500, 2.0)), RobotPosition(1000, 800, 0.6));
+    ASSERT_FALSE(match.isValid);
+}
+
+TEST(LidarLocalizationTest, MatchingThread)
+{
+    miam::DistanceFieldMap map(3000, 2000);
+    buildMap(map);
+    miam::LidarLocalization localization(map);
+
+    miam::PoseCorrection correction;
+    ASSERT_FALSE(localization.getCorrection(correction));
+
+    RobotPosition const truePosition(2200, 500, -1.0);
+    localization.submitScan(12.5, getScan(truePosition), RobotPosition(2180, 520, -0.97));
+    for(int i = 0; i < 200 && !localization.getCorrection(correction); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_DOUBLE_EQ(correction.timestamp, 12.5);
+    ASSERT_TRUE(correction.match.isValid);
+    ASSERT_NEAR(correction.match.position.x, truePosition.x, 3.0);
+    ASSERT_NEAR(correction.match.position.y, truePosition.y, 3.0);
+    ASSERT_FALSE(localization.getCorrection(correction));
+}
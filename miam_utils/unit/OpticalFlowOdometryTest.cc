@@ -0,0 +1,146 @@
+// Testing of the ADNS9800 motion burst and of the optical flow odometry.
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/ADNS9800Driver.h"
+#include "miam_utils/trajectory/OpticalFlowOdometry.h"
+
+using miam::OpticalFlowDisplacement;
+using miam::OpticalFlowOdometry;
+using miam::OpticalFlowSensorConfiguration;
+using miam::RobotPosition;
+
+// Transport answering a fixed motion burst.
+class MotionBurstTransport: public miam::SPITransport
+{
+    public:
+        MotionBurstTransport():
+            nMessages_(0)
+        {}
+
+        int transfer(struct spi_ioc_transfer *transfers, int const& nTransfers) override
+        {
+            nMessages_++;
+            if(nTransfers != 2 || transfers[1].len != ADNS9800_MOTION_BURST_LENGTH)
+                return -1;
+            address_ = *reinterpret_cast<unsigned char*>(transfers[0].tx_buf);
+            std::memcpy(reinterpret_cast<unsigned char*>(transfers[1].rx_buf), data_, ADNS9800_MOTION_BURST_LENGTH);
+            return 0;
+        }
+
+        int nMessages_;
+        unsigned char address_;
+        unsigned char data_[ADNS9800_MOTION_BURST_LENGTH];
+};
+
+TEST(OpticalFlowOdometryTest, MotionBurst)
+{
+    std::shared_ptr<MotionBurstTransport> transport = std::make_shared<MotionBurstTransport>();
+    ADNS9800 sensor;
+    sensor.transport = transport;
+    sensor.frequency = 800000;
+
+    // Motion, delta x = -2, delta y = 300, squal 40, shutter 0x0123.
+    unsigned char const data[ADNS9800_MOTION_BURST_LENGTH] = {0xA0, 0x00, 0xFE, 0xFF, 0x2C, 0x01, 40, 10,
+                                                               100, 5, 0x01, 0x23, 0x1F, 0x40};
+    std::memcpy(transport->data_, data, ADNS9800_MOTION_BURST_LENGTH);
+
+    ADNS9800MotionBurst burst;
+    ASSERT_TRUE(ADNS9800_readMotionBurst(sensor, &burst));
+    ASSERT_EQ(transport->nMessages_, 1);
+    ASSERT_EQ(transport->address_, 0x50);
+    ASSERT_EQ(burst.deltaX, -2);
+    ASSERT_EQ(burst.deltaY, 300);
+    ASSERT_EQ(burst.squal, 40);
+    ASSERT_EQ(burst.shutter, 0x0123);
+    ASSERT_EQ(burst.framePeriod, 0x1F40);
+
+    // No motion: deltas are ignored.
+    transport->data_[0] = 0x20;
+    ASSERT_TRUE(ADNS9800_readMotionBurst(sensor, &burst));
+    ASSERT_EQ(burst.deltaX, 0);
+    ASSERT_EQ(burst.deltaY, 0);
+}
+
+TEST(OpticalFlowOdometryTest, Displacement)
+{
+    // Sensor 100mm in front of the center, rotated by 90 degrees, 0.01mm/count.
+    OpticalFlowSensorConfiguration configuration;
+    configuration.x = 100.0;
+    configuration.y = 0.0;
+    configuration.angle = M_PI_2;
+    configuration.resolution = 0.01;
+    OpticalFlowOdometry odometry(configuration);
+
+    // Forward motion: along the sensor -y axis.
+    for(int i = 0; i < 10; i++)
+        odometry.update(0, -100, 0.0);
+    OpticalFlowDisplacement displacement = odometry.getDisplacement();
+    ASSERT_TRUE(displacement.isValid);
+    ASSERT_EQ(displacement.nReports, 10);
+    ASSERT_NEAR(displacement.dx, 10.0, 1e-9);
+    ASSERT_NEAR(displacement.dy, 0.0, 1e-9);
+
+    // Pure rotation: the sensor moves sideways, the center does not.
+    double const dTheta = 0.01;
+    int const counts = static_cast<int>(std::round(100.0 * dTheta / 0.01));
+    for(int i = 0; i < 10; i++)
+        odometry.update(counts, 0, dTheta);
+    displacement = odometry.getDisplacement();
+    ASSERT_NEAR(displacement.dx, 0.0, 1e-9);
+    ASSERT_NEAR(displacement.dy, 0.0, 1e-9);
+
+    // Arc: constant forward motion while turning, compared to the exact arc.
+    double const radius = 500.0;
+    double const step = 1.0;
+    // Sensor motion in robot frame: (step, step * x / radius).
+    int const countsX = static_cast<int>(std::round(step * 100.0 / radius / 0.01));
+    int const countsY = static_cast<int>(std::round(-step / 0.01));
+    for(int i = 0; i < 100; i++)
+        odometry.update(countsX, countsY, step / radius);
+    displacement = odometry.getDisplacement();
+    double const angle = 100 * step / radius;
+    ASSERT_NEAR(displacement.dx, radius * std::sin(angle), 1e-3);
+    ASSERT_NEAR(displacement.dy, radius * (1 - std::cos(angle)), 1e-3);
+
+    RobotPosition position = OpticalFlowOdometry::integrate(RobotPosition(0, 0, M_PI_2), displacement, angle);
+    ASSERT_NEAR(position.x, -radius * (1 - std::cos(angle)), 1e-3);
+    ASSERT_NEAR(position.y, radius * std::sin(angle), 1e-3);
+    ASSERT_NEAR(position.theta, M_PI_2 + angle, 1e-9);
+}
+
+TEST(OpticalFlowOdometryTest, Quality)
+{
+    OpticalFlowSensorConfiguration configuration;
+    configuration.minimumSqual = 20;
+    OpticalFlowOdometry odometry(configuration);
+
+    ADNS9800MotionBurst burst;
+    std::memset(&burst, 0, sizeof(burst));
+    burst.motion = ADNS9800_MOTION_MOT | ADNS9800_MOTION_LP_VALID;
+    burst.deltaX = 100;
+    burst.squal = 50;
+    burst.shutter = 1000;
+    ASSERT_TRUE(odometry.isReportValid(burst));
+    odometry.update(burst, 0.0);
+
+    // Lifted sensor: low quality, long shutter. Motion is discarded.
+    burst.squal = 5;
+    burst.shutter = 30000;
+    ASSERT_FALSE(odometry.isReportValid(burst));
+    odometry.update(burst, 0.0);
+
+    OpticalFlowDisplacement displacement = odometry.getDisplacement();
+    ASSERT_FALSE(displacement.isValid);
+    ASSERT_EQ(displacement.nInvalidReports, 1);
+    ASSERT_EQ(displacement.minimumSqual, 5);
+    ASSERT_NEAR(displacement.dx, 100 * configuration.resolution, 1e-9);
+
+    // Laser fault.
+    burst.squal = 50;
+    burst.shutter = 1000;
+    burst.motion |= ADNS9800_MOTION_FAULT;
+    ASSERT_FALSE(odometry.isReportValid(burst));
+}
@@ -0,0 +1,170 @@
+// Testing of the pose extended Kalman filter, on a simulated robot.
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "miam_utils/trajectory/PoseEKF.h"
+
+using miam::PoseEKF;
+using miam::RobotPosition;
+
+double const DT = 0.01;
+double const GYRO_BIAS = 0.02;
+
+// Odometry input of a tick.
+struct OdometryInput{
+    double distance;
+    double encoderAngle;
+    double gyroRate;
+};
+
+// Beacon observation, as produced by the lidar.
+struct BeaconObservation{
+    int tick;
+    RobotPosition beacon;
+    double range;
+    double bearing;
+};
+
+// Simulated robot driving an arc, with encoders overestimating the distance and a biased gyroscope.
+class Simulation
+{
+    public:
+        Simulation(int const& nTicks)
+        {
+            std::default_random_engine generator(42);
+            std::normal_distribution<double> noise(0.0, 1.0);
+            RobotPosition const beacons[3] = {RobotPosition(-22, 1000, 0),
+                                              RobotPosition(3022, 50, 0),
+                                              RobotPosition(3022, 1950, 0)};
+
+            RobotPosition position(500, 1000, 0);
+            truth.push_back(position);
+            for(int i = 1; i <= nTicks; i++)
+            {
+                double const distance = 5.0;
+                double const angle = 0.003;
+                position.x += distance * std::cos(position.theta + angle / 2.0);
+                position.y += distance * std::sin(position.theta + angle / 2.0);
+                position.theta += angle;
+                truth.push_back(position);
+                inputs.push_back({1.03 * distance, 1.01 * angle, angle / DT + GYRO_BIAS + 0.01 * noise(generator)});
+
+                // One beacon every 5 ticks.
+                if(i % 5 == 0)
+                {
+                    BeaconObservation observation;
+                    observation.tick = i;
+                    observation.beacon = beacons[(i / 5) % 3];
+                    double const dx = observation.beacon.x - position.x;
+                    double const dy = observation.beacon.y - position.y;
+                    observation.range = std::sqrt(dx * dx + dy * dy) + 3.0 * noise(generator);
+                    observation.bearing = std::atan2(dy, dx) - position.theta + 0.005 * noise(generator);
+                    observations.push_back(observation);
+                }
+            }
+        }
+
+        std::vector<RobotPosition> truth;
+        std::vector<OdometryInput> inputs;
+        std::vector<BeaconObservation> observations;
+};
+
+double getError(PoseEKF const& filter, RobotPosition const& truth)
+{
+    RobotPosition const error = filter.getPosition() - truth;
+    return std::hypot(error.x, error.y);
+}
+
+TEST(PoseEKFTest, GyroBias)
+{
+    // Robot not moving: the gyroscope bias is estimated from the encoders, and the heading does not drift.
+    PoseEKF filter;
+    filter.reset(0.0, RobotPosition(100, 100, 0));
+    for(int i = 1; i <= 1000; i++)
+        filter.predict(i * DT, 0.0, 0.0, GYRO_BIAS);
+    ASSERT_NEAR(filter.getGyroBias(), GYRO_BIAS, 1e-3);
+    ASSERT_NEAR(filter.getPosition().theta, 0.0, 0.02);
+    ASSERT_NEAR(filter.getPosition().x, 100.0, 1e-6);
+
+    // Without bias estimation, the heading drifts.
+    miam::PoseEKFParameters parameters;
+    parameters.estimateGyroBias = false;
+    PoseEKF noBias(parameters);
+    noBias.reset(0.0, RobotPosition(100, 100, 0));
+    for(int i = 1; i <= 1000; i++)
+        noBias.predict(i * DT, 0.0, 0.0, GYRO_BIAS);
+    ASSERT_EQ(noBias.getGyroBias(), 0.0);
+    ASSERT_NEAR(noBias.getPosition().theta, 10 * GYRO_BIAS, 1e-6);
+}
+
+TEST(PoseEKFTest, BeaconUpdate)
+{
+    int const nTicks = 400;
+    Simulation simulation(nTicks);
+
+    // Odometry only, observations applied as soon as they are made, and observations received late, out of order.
+    // Encoder errors are systematic here: the distance noise is increased to account for it.
+    miam::PoseEKFParameters parameters;
+    parameters.distanceNoise = 0.05;
+    PoseEKF odometry(parameters), online(parameters), delayed(parameters);
+    for(PoseEKF *filter : {&odometry, &online, &delayed})
+        filter->reset(0.0, simulation.truth[0]);
+    unsigned int nextObservation = 0;
+    std::vector<BeaconObservation> pending;
+    for(int i = 1; i <= nTicks; i++)
+    {
+        OdometryInput const& input = simulation.inputs[i - 1];
+        for(PoseEKF *filter : {&odometry, &online, &delayed})
+            filter->predict(i * DT, input.distance, input.encoderAngle, input.gyroRate);
+
+        while(nextObservation < simulation.observations.size() && simulation.observations[nextObservation].tick == i)
+        {
+            BeaconObservation const& observation = simulation.observations[nextObservation];
+            ASSERT_TRUE(online.updateBeacon(i * DT, observation.beacon, observation.range, observation.bearing, 3.0, 0.005));
+            pending.push_back(observation);
+            nextObservation++;
+        }
+        // Delayed filter: observations are received by groups of three, 120ms late, newest first.
+        if(pending.size() == 3 && i >= pending.front().tick + 12)
+        {
+            std::reverse(pending.begin(), pending.end());
+            for(BeaconObservation const& observation : pending)
+                ASSERT_TRUE(delayed.updateBeacon(observation.tick * DT,
+                                                 observation.beacon,
+                                                 observation.range,
+                                                 observation.bearing,
+                                                 3.0,
+                                                 0.005));
+            pending.clear();
+        }
+    }
+
+    // Odometry only: the error builds up.
+    ASSERT_GT(getError(odometry, simulation.truth.back()), 50.0);
+    // With observations, the error stays small.
+    ASSERT_LT(getError(online, simulation.truth.back()), 10.0);
+    ASSERT_NEAR(online.getPosition().theta, simulation.truth.back().theta, 0.01);
+    ASSERT_NEAR(online.getGyroBias(), GYRO_BIAS, 5e-3);
+
+    // Late observations give the same result as online ones, once received.
+    PoseEKF replay = delayed;
+    for(BeaconObservation const& observation : pending)
+        ASSERT_TRUE(replay.updateBeacon(observation.tick * DT,
+                                        observation.beacon,
+                                        observation.range,
+                                        observation.bearing,
+                                        3.0,
+                                        0.005));
+    ASSERT_NEAR(replay.getPosition().x, online.getPosition().x, 1e-6);
+    ASSERT_NEAR(replay.getPosition().y, online.getPosition().y, 1e-6);
+    ASSERT_NEAR(replay.getPosition().theta, online.getPosition().theta, 1e-9);
+
+    // Observations older than the history are rejected.
+    ASSERT_FALSE(replay.updateBeacon(DT, simulation.observations[0].beacon, 1000, 0, 3.0, 0.005));
+    // Outliers are rejected.
+    BeaconObservation const& last = simulation.observations.back();
+    ASSERT_FALSE(online.updateBeacon(nTicks * DT, last.beacon, last.range + 500, last.bearing, 3.0, 0.005));
+}
@@ -0,0 +1,150 @@
+// Testing of the SPI bus manager, using the L6470 emulator as device.
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "miam_utils/drivers/SPIBusManager.h"
+#include "miam_utils/drivers/L6470Driver.h"
+#include "miam_utils/drivers/L6470Emulator.h"
+
+using miam::L6470;
+using miam::L6470Emulator;
+using miam::SPIBusManager;
+using miam::SPIBusClient;
+using miam::SPIClientConfiguration;
+using miam::SPIClientStatistics;
+
+// Bus manager where the port is an L6470 emulator instead of a spidev file.
+class EmulatedBusManager: public SPIBusManager
+{
+    public:
+        EmulatedBusManager(std::shared_ptr<L6470Emulator> emulator):
+            nMessages_(0),
+            nModeChanges_(0),
+            lastSpeed_(0),
+            emulator_(emulator)
+        {}
+
+        int nMessages_;
+        int nModeChanges_;
+        uint32_t lastSpeed_;
+
+    protected:
+        int openPort(std::string const& portName, int const& frequency) override
+        {
+            return open("/dev/null", O_RDWR);
+        }
+
+        int setPortMode(int const& port, uint8_t const& mode) override
+        {
+            nModeChanges_++;
+            return 0;
+        }
+
+        int performMessage(int const& port, struct spi_ioc_transfer *transfers, int const& nTransfers) override
+        {
+            nMessages_++;
+            lastSpeed_ = transfers[0].speed_hz;
+            return emulator_->transfer(transfers, nTransfers);
+        }
+
+    private:
+        std::shared_ptr<L6470Emulator> emulator_;
+};
+
+
+static SPIClientConfiguration createConfiguration(std::string const& name, int const& frequency, int const& priority)
+{
+    SPIClientConfiguration configuration;
+    configuration.name = name;
+    configuration.portName = "/dev/spidev0.0";
+    configuration.frequency = frequency;
+    configuration.priority = priority;
+    return configuration;
+}
+
+
+TEST(SPIBusManagerTest, SingleClient)
+{
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(2);
+    EmulatedBusManager manager(emulator);
+    std::shared_ptr<SPIBusClient> client = manager.addClient(createConfiguration("motors", 1000000, 1));
+
+    // Driver requests 4MHz, client is limited to 1MHz.
+    L6470 driver(client, 2);
+    ASSERT_TRUE(driver.init(1000, 2000, 0x30, 0x3B, 0x1430, 0x22, 0x53));
+    ASSERT_EQ(manager.lastSpeed_, 1000000u);
+
+    double speeds[2] = {300.0, -300.0};
+    driver.setSpeed(speeds);
+    emulator->update(0.5);
+    double positions[2];
+    driver.getPosition(positions);
+    ASSERT_NEAR(positions[0], emulator->getDevice(0).getPosition(), 1.0);
+
+    // Mode is set once, on first use of the port.
+    ASSERT_EQ(manager.nModeChanges_, 1);
+
+    SPIClientStatistics stats = client->getStatistics();
+    ASSERT_EQ(stats.nMessages, manager.nMessages_);
+    ASSERT_EQ(stats.nErrors, 0);
+    ASSERT_GT(stats.maxLatency, 0.0);
+    client->resetStatistics();
+    ASSERT_EQ(client->getStatistics().nMessages, 0);
+}
+
+
+TEST(SPIBusManagerTest, ConcurrentClients)
+{
+    // Two threads using the same chain through two clients: all messages must be performed, without error.
+    int const N_MESSAGES = 500;
+    std::shared_ptr<L6470Emulator> emulator = std::make_shared<L6470Emulator>(2);
+    EmulatedBusManager manager(emulator);
+    std::shared_ptr<SPIBusClient> motorClient = manager.addClient(createConfiguration("motors", 4000000, 1));
+    std::shared_ptr<SPIBusClient> sensorClient = manager.addClient(createConfiguration("sensor", 800000, 0));
+
+    L6470 motors(motorClient, 2);
+    ASSERT_TRUE(motors.init(1000, 2000, 0x30, 0x3B, 0x1430, 0x22, 0x53));
+    L6470 monitor(sensorClient, 2);
+    motorClient->resetStatistics();
+    manager.nMessages_ = 0;
+
+    std::atomic<int> nFailures(0);
+    std::thread sensorThread([&]()
+    {
+        for(int i = 0; i < N_MESSAGES; i++)
+        {
+            uint32_t status[2];
+            monitor.getStatus(status);
+        }
+    });
+    for(int i = 0; i < N_MESSAGES; i++)
+    {
+        double positions[2];
+        if(motors.exchange(NULL, positions, NULL) < 0)
+            nFailures++;
+    }
+    sensorThread.join();
+
+    ASSERT_EQ(nFailures, 0);
+    SPIClientStatistics motorStats = motorClient->getStatistics();
+    SPIClientStatistics sensorStats = sensorClient->getStatistics();
+    ASSERT_EQ(motorStats.nMessages, N_MESSAGES);
+    ASSERT_EQ(sensorStats.nMessages, N_MESSAGES);
+    ASSERT_EQ(motorStats.nErrors + sensorStats.nErrors, 0);
+    // Merged messages are sent in a single call.
+    ASSERT_EQ(manager.nMessages_ + (motorStats.nMergedMessages + sensorStats.nMergedMessages) / 2,
+              2 * N_MESSAGES);
+    // Same statistics through the manager, with consistent latencies.
+    for(int clientId = 0; clientId < 2; clientId++)
+    {
+        SPIClientStatistics const stats = manager.getStatistics(clientId);
+        ASSERT_EQ(stats.nMessages, N_MESSAGES);
+        ASSERT_GT(stats.getMeanLatency(), 0.0);
+        ASSERT_LE(stats.getMeanLatency(), stats.maxLatency);
+        ASSERT_LE(stats.lastLatency, stats.maxLatency);
+    }
+}
@@ -0,0 +1,443 @@
+// Testing of trajectory evaluation.
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "miam_utils/trajectory/ArcCircle.h"
+#include "miam_utils/trajectory/PointTurn.h"
+#include "miam_utils/trajectory/ProfiledTrajectory.h"
+#include "miam_utils/trajectory/SampledTrajectory.h"
+#include "miam_utils/trajectory/SCurve.h"
+#include "miam_utils/trajectory/StraightLine.h"
+#include "miam_utils/trajectory/TrajectoryLibrary.h"
+#include "miam_utils/trajectory/TrajectoryQueue.h"
+#include "miam_utils/trajectory/Utilities.h"
+
+using miam::RobotPosition;
+using miam::trajectory::StraightLine;
+using miam::trajectory::TrajectoryPoint;
+using miam::trajectory::Trapezoid;
+using miam::trajectory::TrapezoidState;
+
+TEST(TrajectoryTest, StraightLine)
+{
+    // Point along the line, computed directly from the trapezoid.
+    RobotPosition const start(100, 200, 0.3);
+    RobotPosition const end(-400, 900, 0);
+    for(int backward = 0; backward < 2; backward++)
+    {
+        StraightLine line(start, end, 0.0, 0.0, backward == 1, 500.0, 700.0);
+        Trapezoid trapezoid(std::hypot(end.x - start.x, end.y - start.y), 0.0, 0.0, 500.0, 700.0);
+        double const angle = std::atan2(end.y - start.y, end.x - start.x);
+        ASSERT_DOUBLE_EQ(line.getDuration(), trapezoid.getDuration());
+        for(double t = 0; t < line.getDuration() + 0.1; t += 0.05)
+        {
+            TrajectoryPoint const point = line.getCurrentPoint(t);
+            TrapezoidState const state = trapezoid.getState(t);
+            ASSERT_NEAR(point.position.x, start.x + state.position * std::cos(angle), 1e-9);
+            ASSERT_NEAR(point.position.y, start.y + state.position * std::sin(angle), 1e-9);
+            ASSERT_DOUBLE_EQ(point.linearVelocity, (backward == 1 ? -1 : 1) * state.velocity);
+        }
+    }
+}
+
+TEST(TrajectoryTest, SCurve)
+{
+    double const MAX_VELOCITY = 500.0;
+    double const MAX_ACCELERATION = 700.0;
+    double const MAX_JERK = 5000.0;
+    // Distance, start and end velocity: long and short motions, non-zero velocities, unreachable end velocity.
+    double const cases[][3] = {{1000, 0, 0}, {1000, 200, 100}, {300, 50, 400}, {20, 0, 0}, {50, 0, 500}, {10, 400, 0}};
+    for(double const (&c)[3] : cases)
+    {
+        miam::trajectory::SCurve const profile(c[0], c[1], c[2], MAX_VELOCITY, MAX_ACCELERATION, MAX_JERK);
+        ASSERT_GT(profile.getDuration(), 0.0);
+        // At most one jerk phase more than the trapezoid at each acceleration change.
+        Trapezoid trapezoid(c[0], c[1], c[2], MAX_VELOCITY, MAX_ACCELERATION);
+        ASSERT_LT(profile.getDuration(), trapezoid.getDuration() + 2 * MAX_ACCELERATION / MAX_JERK);
+        ASSERT_DOUBLE_EQ(profile.getState(0.0).velocity, c[1]);
+        if(c[0] > 100)
+        {
+            ASSERT_DOUBLE_EQ(profile.getEndVelocity(), c[2]);
+        }
+
+        // Velocity, acceleration and jerk within bounds, continuous acceleration.
+        double const dt = 1e-4;
+        TrapezoidState previous = profile.getState(0.0);
+        double previousAcceleration = profile.getAcceleration(0.0);
+        for(double t = dt; t < profile.getDuration(); t += dt)
+        {
+            TrapezoidState const state = profile.getState(t);
+            double const acceleration = profile.getAcceleration(t);
+            ASSERT_LE(state.velocity, MAX_VELOCITY + 1e-6);
+            ASSERT_GE(state.velocity, -1e-6);
+            ASSERT_LE(std::abs(acceleration), MAX_ACCELERATION + 1e-6);
+            ASSERT_LE(std::abs(acceleration - previousAcceleration), MAX_JERK * dt + 1e-6);
+            ASSERT_NEAR(state.position - previous.position, (state.velocity + previous.velocity) / 2.0 * dt, 1e-6);
+            previous = state;
+            previousAcceleration = acceleration;
+        }
+        TrapezoidState const end = profile.getState(profile.getDuration() - 1e-9);
+        ASSERT_NEAR(end.position, c[0], 1e-6);
+        ASSERT_NEAR(end.velocity, profile.getEndVelocity(), 1e-3);
+
+        // Time to distance inversion.
+        for(double position = 0.0; position <= c[0]; position += c[0] / 37.0)
+            ASSERT_NEAR(profile.getState(profile.getTime(position)).position, position, 1e-6);
+    }
+
+    // A very high jerk gives back the velocity trapezoid.
+    Trapezoid trapezoid(1000, 100, 0, MAX_VELOCITY, MAX_ACCELERATION);
+    Trapezoid sCurve(1000, 100, 0, MAX_VELOCITY, MAX_ACCELERATION, 1e9);
+    ASSERT_NEAR(sCurve.getDuration(), trapezoid.getDuration(), 1e-3);
+    for(double t = 0; t < trapezoid.getDuration(); t += 0.05)
+        ASSERT_NEAR(sCurve.getState(t).position, trapezoid.getState(t).position, 0.1);
+
+    // Selectable per trajectory: with the same jerk bound as a trapezoid switching acceleration in 1ms, an S-curve with
+    // twice the acceleration is faster.
+    StraightLine line(RobotPosition(0, 0, 0), RobotPosition(1000, 0, 0), 0.0, 0.0, false, MAX_VELOCITY, MAX_ACCELERATION);
+    StraightLine sCurveLine(RobotPosition(0, 0, 0), RobotPosition(1000, 0, 0), 0.0, 0.0, false,
+                            MAX_VELOCITY, 2 * MAX_ACCELERATION, 2 * MAX_JERK);
+    ASSERT_LT(sCurveLine.getDuration(), line.getDuration());
+    ASSERT_DOUBLE_EQ(sCurveLine.getEndPoint().position.x, 1000.0);
+}
+
+TEST(TrajectoryTest, EvaluationContext)
+{
+    StraightLine line(RobotPosition(0, 0, 0), RobotPosition(1000, 0, 0));
+    StraightLine otherLine(RobotPosition(0, 0, 0), RobotPosition(0, 1000, 0));
+    miam::trajectory::TrajectoryEvaluationContext context;
+
+    // Repeated queries within a tick: evaluated once.
+    TrajectoryPoint point = context.getCurrentPoint(&line, 0.5);
+    ASSERT_DOUBLE_EQ(point.position.x, line.getCurrentPoint(0.5).position.x);
+    ASSERT_DOUBLE_EQ(context.getCurrentPoint(&line, 0.5).position.x, point.position.x);
+    ASSERT_EQ(context.getNumberOfEvaluations(), 1);
+
+    // Other time, or other trajectory: new evaluation.
+    point = context.getCurrentPoint(&line, 0.6);
+    ASSERT_DOUBLE_EQ(point.position.x, line.getCurrentPoint(0.6).position.x);
+    point = context.getCurrentPoint(&otherLine, 0.5);
+    ASSERT_DOUBLE_EQ(point.position.y, otherLine.getCurrentPoint(0.5).position.y);
+    ASSERT_EQ(context.getNumberOfEvaluations(), 3);
+    context.getCurrentPoint(&line, 0.6);
+    ASSERT_EQ(context.getNumberOfEvaluations(), 3);
+
+    // The oldest entries are overwritten once the cache is full.
+    for(int i = 0; i < miam::trajectory::TrajectoryEvaluationContext::CACHE_SIZE; i++)
+        context.getCurrentPoint(&line, 1.0 + i);
+    context.getCurrentPoint(&line, 0.5);
+    ASSERT_EQ(context.getNumberOfEvaluations(), 8);
+
+    // After clear, everything is evaluated again.
+    context.clear();
+    context.getCurrentPoint(&line, 1.0);
+    ASSERT_EQ(context.getNumberOfEvaluations(), 9);
+}
+
+TEST(TrajectoryTest, TimedSampledTrajectory)
+{
+    // Adaptive sampling: few samples on a straight line, more on an arc.
+    StraightLine line(RobotPosition(0, 0, 0), RobotPosition(1500, 1000, 0));
+    miam::trajectory::ArcCircle arc(RobotPosition(0, 0, 0), 300, miam::trajectory::rotationside::LEFT, M_PI);
+    std::shared_ptr<miam::trajectory::TrajectorySamples const> lineSamples =
+        std::make_shared<miam::trajectory::TrajectorySamples>(miam::trajectory::sampleTrajectory(line));
+    miam::trajectory::TrajectorySamples const arcSamples = miam::trajectory::sampleTrajectory(arc);
+    int const nDenseSamples = static_cast<int>(line.getDuration() / 0.001);
+    ASSERT_LT(lineSamples->size(), nDenseSamples / 20);
+    ASSERT_GT(arcSamples.size(), lineSamples->size());
+
+    // Shared and borrowed samples: the trajectory is reproduced within the error bounds.
+    miam::trajectory::TimedSampledTrajectory sampledLine(lineSamples);
+    miam::trajectory::TimedSampledTrajectory sampledArc(arcSamples.data(), arcSamples.size());
+    ASSERT_EQ(lineSamples.use_count(), 2);
+    ASSERT_DOUBLE_EQ(sampledLine.getDuration(), line.getDuration());
+    ASSERT_DOUBLE_EQ(sampledArc.getDuration(), arc.getDuration());
+    for(double t = 0; t < arc.getDuration() + 0.1; t += 0.0037)
+    {
+        TrajectoryPoint const point = sampledArc.getCurrentPoint(t);
+        TrajectoryPoint const reference = arc.getCurrentPoint(t);
+        ASSERT_LT(miam::trajectory::distance(point.position, reference.position), 0.5 + 1e-6);
+        ASSERT_LT(std::abs(miam::trajectory::moduloTwoPi(point.position.theta - reference.position.theta)), 0.002 + 1e-9);
+    }
+
+    // Random order queries: same result as monotonic ones.
+    for(int i = 0; i < 100; i++)
+    {
+        double const t = std::fmod(i * 0.6180339 * line.getDuration(), line.getDuration());
+        TrajectoryPoint const point = sampledLine.getCurrentPoint(t);
+        ASSERT_LT(miam::trajectory::distance(point.position, line.getCurrentPoint(t).position), 0.5 + 1e-6);
+    }
+
+    // Replanification: restart from the current point.
+    RobotPosition const midPoint = sampledLine.getCurrentPoint(1.0).position;
+    double const duration = sampledLine.getDuration();
+    sampledLine.replanify(1.0);
+    ASSERT_DOUBLE_EQ(sampledLine.getDuration(), duration - 1.0);
+    ASSERT_DOUBLE_EQ(sampledLine.getCurrentPoint(0.0).position.x, midPoint.x);
+    ASSERT_DOUBLE_EQ(sampledLine.getCurrentPoint(0.0).position.y, midPoint.y);
+}
+
+TEST(TrajectoryTest, ProfiledTrajectory)
+{
+    double const MAX_VELOCITY = 500.0;
+    double const MAX_ACCELERATION = 700.0;
+    double const WHEEL_SPACING = 100.0;
+    double const MAX_JERK = 5000.0;
+    miam::trajectory::setTrajectoryGenerationConfig(MAX_VELOCITY, MAX_ACCELERATION, WHEEL_SPACING);
+    std::vector<RobotPosition> waypoints;
+    waypoints.push_back(RobotPosition(0, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 800, 0));
+    waypoints.push_back(RobotPosition(300, 1200, 0));
+
+    miam::trajectory::GeometricPath const path = miam::trajectory::computeRoundedCornerPath(waypoints, 200.0);
+    ASSERT_EQ(path.getElements().size(), 5u);
+    ASSERT_LT(miam::trajectory::distance(path.getEndPosition(), waypoints.back()), 1e-6);
+    miam::trajectory::ProfiledTrajectory trajectory(path);
+
+    // Faster than chaining independent primitives.
+    miam::trajectory::TrajectoryVector chain = miam::trajectory::computeTrajectoryRoundedCorner(waypoints, 200.0);
+    double chainDuration = 0.0;
+    for(std::shared_ptr<miam::trajectory::Trajectory> const& element : chain)
+        chainDuration += element->getDuration();
+    ASSERT_LT(trajectory.getDuration(), 0.97 * chainDuration);
+
+    // Same path with limited jerk: the acceleration becomes continuous, at the cost of some time.
+    miam::trajectory::ProfiledTrajectory jerkLimited(path, 0.0, 0.0, MAX_VELOCITY, MAX_ACCELERATION, WHEEL_SPACING,
+                                                     5.0, MAX_JERK);
+    ASSERT_GT(jerkLimited.getDuration(), trajectory.getDuration());
+
+    miam::trajectory::ProfiledTrajectory *trajectories[2] = {&trajectory, &jerkLimited};
+    for(int i = 0; i < 2; i++)
+    {
+        // Wheel velocity, robot acceleration (and jerk) within limits, continuous position, ends at rest at the last
+        // point.
+        double const dt = 0.001;
+        TrajectoryPoint previous = trajectories[i]->getCurrentPoint(0.0);
+        double previousAcceleration = 0.0;
+        for(double t = dt; t < trajectories[i]->getDuration() + 0.01; t += dt)
+        {
+            TrajectoryPoint const point = trajectories[i]->getCurrentPoint(t);
+            ASSERT_LE(std::abs(point.linearVelocity) + std::abs(point.angularVelocity) * WHEEL_SPACING, MAX_VELOCITY + 1e-6);
+            ASSERT_LE(miam::trajectory::distance(point.position, previous.position), MAX_VELOCITY * dt + 1e-6);
+            if(t < trajectories[i]->getDuration())
+            {
+                double const acceleration = (point.linearVelocity - previous.linearVelocity) / dt;
+                ASSERT_LE(std::abs(acceleration), MAX_ACCELERATION + 1e-3);
+                if(trajectories[i] == &jerkLimited)
+                {
+                    ASSERT_LE(std::abs(acceleration - previousAcceleration), MAX_JERK * dt + 1e-3);
+                }
+                previousAcceleration = acceleration;
+            }
+            previous = point;
+        }
+        ASSERT_LT(miam::trajectory::distance(previous.position, waypoints.back()), 1e-6);
+        ASSERT_DOUBLE_EQ(previous.linearVelocity, 0.0);
+
+        // Replanification: restart at rest, from the current point.
+        RobotPosition const position = trajectories[i]->getCurrentPoint(2.0).position;
+        trajectories[i]->replanify(2.0);
+        ASSERT_LT(miam::trajectory::distance(trajectories[i]->getCurrentPoint(0.0).position, position), 1e-6);
+        ASSERT_DOUBLE_EQ(trajectories[i]->getCurrentPoint(0.0).linearVelocity, 0.0);
+        ASSERT_LT(miam::trajectory::distance(trajectories[i]->getEndPoint().position, waypoints.back()), 1e-6);
+    }
+
+    // Very short rest-to-rest motions, shorter than the station spacing: bang-bang acceleration, delayed by the
+    // averaging window if jerk is limited.
+    for(double length = 1.0; length <= 5.0; length += 1.0)
+    {
+        miam::trajectory::GeometricPath shortPath;
+        shortPath.addLine(length);
+        for(double jerk : {0.0, MAX_JERK})
+        {
+            miam::trajectory::ProfiledTrajectory shortMotion(shortPath, 0.0, 0.0, MAX_VELOCITY, MAX_ACCELERATION,
+                                                             WHEEL_SPACING, 5.0, jerk);
+            double const expectedDuration = 2.0 * std::sqrt(length / MAX_ACCELERATION)
+                                            + (jerk > 0.0 ? 2.0 * MAX_ACCELERATION / jerk : 0.0);
+            ASSERT_GE(shortMotion.getDuration(), expectedDuration - 1e-9);
+            ASSERT_LT(shortMotion.getDuration(), 1.5 * expectedDuration);
+            ASSERT_NEAR(shortMotion.getEndPoint().position.x, length, 1e-6);
+            ASSERT_NEAR(shortMotion.getCurrentPoint(shortMotion.getDuration() / 2.0).position.x, length / 2.0, 1e-6);
+        }
+    }
+}
+
+TEST(TrajectoryTest, ContinuousCurvaturePath)
+{
+    // Clothoid: curvature linear in abscissa, end point checked against a fine numerical integration.
+    double const LENGTH = 500.0;
+    double const CURVATURE = 1.0 / 200.0;
+    miam::trajectory::GeometricPath path;
+    path.addClothoid(LENGTH, CURVATURE);
+    double x = 0, y = 0;
+    int const N_STEPS = 100000;
+    for(int i = 0; i < N_STEPS; i++)
+    {
+        double const s = (i + 0.5) * LENGTH / N_STEPS;
+        double const theta = CURVATURE * s * s / (2 * LENGTH);
+        x += std::cos(theta) * LENGTH / N_STEPS;
+        y += std::sin(theta) * LENGTH / N_STEPS;
+    }
+    ASSERT_NEAR(path.getEndPosition().x, x, 1e-3);
+    ASSERT_NEAR(path.getEndPosition().y, y, 1e-3);
+    ASSERT_NEAR(path.getEndPosition().theta, CURVATURE * LENGTH / 2, 1e-9);
+    ASSERT_NEAR(path.getCurvature(LENGTH / 4), CURVATURE / 4, 1e-9);
+    ASSERT_DOUBLE_EQ(path.getEndCurvature(), CURVATURE);
+
+    // Spline path through waypoints: goes through them, with continuous position, heading and curvature.
+    std::vector<RobotPosition> waypoints;
+    waypoints.push_back(RobotPosition(0, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 800, 0));
+    waypoints.push_back(RobotPosition(300, 1200, 0));
+    miam::trajectory::GeometricPath const smoothPath = miam::trajectory::computeSmoothPath(waypoints);
+    ASSERT_EQ(smoothPath.getElements().size(), waypoints.size() - 1);
+    for(unsigned int i = 1; i < waypoints.size(); i++)
+    {
+        miam::trajectory::GeometricPath::Element const& element = smoothPath.getElements()[i - 1];
+        RobotPosition const end = smoothPath.getPosition(element.startAbscissa + element.length);
+        ASSERT_LT(miam::trajectory::distance(end, waypoints[i]), 1e-6);
+    }
+    double const ds = 0.5;
+    RobotPosition previous = smoothPath.getPosition(0.0);
+    double previousCurvature = smoothPath.getCurvature(0.0);
+    for(double s = ds; s < smoothPath.getLength(); s += ds)
+    {
+        RobotPosition const position = smoothPath.getPosition(s);
+        double const curvature = smoothPath.getCurvature(s);
+        ASSERT_NEAR(miam::trajectory::distance(position, previous), ds, 1e-2);
+        ASSERT_LT(std::abs(position.theta - previous.theta), 0.01);
+        ASSERT_LT(std::abs(curvature - previousCurvature), 1e-4);
+        previous = position;
+        previousCurvature = curvature;
+    }
+
+    // Profiled along the spline: the robot does not stop at intermediate waypoints.
+    miam::trajectory::setTrajectoryGenerationConfig(500.0, 700.0, 100.0);
+    miam::trajectory::ProfiledTrajectory trajectory(smoothPath);
+    ASSERT_LT(miam::trajectory::distance(trajectory.getEndPoint().position, waypoints.back()), 1e-6);
+    double minVelocity = 1e9;
+    for(double t = 0.5; t < trajectory.getDuration() - 0.5; t += 0.01)
+        minVelocity = std::min(minVelocity, trajectory.getCurrentPoint(t).linearVelocity);
+    ASSERT_GT(minVelocity, 100.0);
+
+    // Going back to the previous point: U-turn, still through all points.
+    std::vector<RobotPosition> backAndForth;
+    backAndForth.push_back(RobotPosition(0, 0, 0));
+    backAndForth.push_back(RobotPosition(500, 0, 0));
+    backAndForth.push_back(RobotPosition(0, 0, 0));
+    miam::trajectory::GeometricPath const uTurn = miam::trajectory::computeSmoothPath(backAndForth);
+    ASSERT_EQ(uTurn.getElements().size(), 2u);
+    ASSERT_TRUE(std::isfinite(uTurn.getLength()));
+    ASSERT_LT(miam::trajectory::distance(uTurn.getPosition(uTurn.getElements()[1].startAbscissa), backAndForth[1]), 1e-6);
+    ASSERT_LT(miam::trajectory::distance(uTurn.getEndPosition(), backAndForth[2]), 1e-6);
+    ASSERT_TRUE(std::isfinite(miam::trajectory::ProfiledTrajectory(uTurn).getDuration()));
+}
+
+TEST(TrajectoryTest, TrajectoryLibrary)
+{
+    std::vector<RobotPosition> waypoints;
+    waypoints.push_back(RobotPosition(0, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 800, 0));
+    miam::trajectory::TrajectoryVector corner = miam::trajectory::computeTrajectoryRoundedCorner(waypoints, 200.0);
+    miam::trajectory::TrajectoryVector turn;
+    turn.push_back(std::make_shared<miam::trajectory::PointTurn>(RobotPosition(0, 0, 0), 2.0));
+
+    std::string const FILENAME = "trajectoryLibraryTest.bin";
+    miam::trajectory::TrajectoryLibraryWriter writer;
+    ASSERT_TRUE(writer.add("corner", corner));
+    ASSERT_TRUE(writer.add("turn", turn));
+    ASSERT_FALSE(writer.add("turn", corner));
+    ASSERT_TRUE(writer.write(FILENAME));
+
+    miam::trajectory::TrajectoryLibrary library;
+    ASSERT_TRUE(library.load(FILENAME));
+    ASSERT_EQ(library.getNames().size(), 2u);
+    ASSERT_TRUE(library.get("unknown").empty());
+
+    // Same types and durations, same points within sampling error, samples read in place.
+    std::vector<miam::trajectory::TrajectoryLibrary::Segment> const segments = library.getSegments("corner");
+    miam::trajectory::TrajectoryVector loaded = library.get("corner");
+    ASSERT_EQ(loaded.size(), corner.size());
+    for(unsigned int i = 0; i < corner.size(); i++)
+    {
+        ASSERT_EQ(segments[i].type, miam::trajectory::getTrajectoryType(*corner[i]));
+        ASSERT_DOUBLE_EQ(segments[i].duration, corner[i]->getDuration());
+        ASSERT_DOUBLE_EQ(loaded[i]->getDuration(), corner[i]->getDuration());
+        for(double t = 0; t < corner[i]->getDuration(); t += 0.01)
+            ASSERT_LT(miam::trajectory::distance(loaded[i]->getCurrentPoint(t).position,
+                                                 corner[i]->getCurrentPoint(t).position), 0.5 + 1e-6);
+    }
+    ASSERT_EQ(segments[2].type, miam::trajectory::TrajectoryType::ARC_CIRCLE);
+    ASSERT_EQ(library.getSegments("turn")[0].type, miam::trajectory::TrajectoryType::POINT_TURN);
+    ASSERT_DOUBLE_EQ(loaded[0]->getCurrentPoint(0.0).position.x, segments[0].samples[0].point.position.x);
+
+    // Truncated file: rejected.
+    std::ifstream input(FILENAME, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    std::ofstream(FILENAME, std::ios::binary).write(content.data(), content.size() - 8);
+    miam::trajectory::TrajectoryLibrary truncated;
+    ASSERT_FALSE(truncated.load(FILENAME));
+    ASSERT_TRUE(truncated.getNames().empty());
+    std::remove(FILENAME.c_str());
+}
+
+TEST(TrajectoryTest, TrajectoryQueue)
+{
+    miam::trajectory::setTrajectoryGenerationConfig(500.0, 700.0, 100.0);
+    std::vector<RobotPosition> waypoints;
+    waypoints.push_back(RobotPosition(0, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 0, 0));
+    waypoints.push_back(RobotPosition(1000, 800, 0));
+    miam::trajectory::TrajectoryVector corner = miam::trajectory::computeTrajectoryRoundedCorner(waypoints, 200.0);
+    corner.push_back(std::make_shared<miam::trajectory::ProfiledTrajectory>(
+        miam::trajectory::computeRoundedCornerPath(waypoints, 200.0)));
+
+    // Primitives stored by value, other types shared; same points as the original trajectories.
+    miam::trajectory::TrajectoryQueue queue(corner);
+    ASSERT_EQ(queue.size(), corner.size());
+    ASSERT_EQ(queue[0].getType(), miam::trajectory::TrajectorySegment::Type::POINT_TURN);
+    ASSERT_EQ(queue[1].getType(), miam::trajectory::TrajectorySegment::Type::STRAIGHT_LINE);
+    ASSERT_EQ(queue[2].getType(), miam::trajectory::TrajectorySegment::Type::ARC_CIRCLE);
+    ASSERT_EQ(queue.back().getType(), miam::trajectory::TrajectorySegment::Type::SHARED);
+    ASSERT_EQ(queue.back().get(), corner.back().get());
+    for(unsigned int i = 0; i < corner.size(); i++)
+    {
+        if(i + 1 < corner.size())
+        {
+            ASSERT_NE(queue[i].get(), corner[i].get());
+        }
+        ASSERT_DOUBLE_EQ(queue[i].getDuration(), corner[i]->getDuration());
+        for(double t = 0; t < corner[i]->getDuration(); t += 0.05)
+            ASSERT_DOUBLE_EQ(queue[i].getCurrentPoint(t).position.x, corner[i]->getCurrentPoint(t).position.x);
+    }
+    ASSERT_DOUBLE_EQ(queue.getEndPoint().position.y, corner.getEndPoint().position.y);
+
+    // Replanifying a copy does not affect the original.
+    miam::trajectory::TrajectorySegment copy = queue[1];
+    copy.replanify(0.2);
+    ASSERT_NE(copy.getDuration(), queue[1].getDuration());
+    ASSERT_DOUBLE_EQ(queue[1].getDuration(), corner[1]->getDuration());
+
+    // Constant-time removal, then appending reuses the queue.
+    queue.pop_front();
+    queue.pop_front();
+    ASSERT_EQ(queue.size(), corner.size() - 2);
+    ASSERT_EQ(queue.front().getType(), miam::trajectory::TrajectorySegment::Type::ARC_CIRCLE);
+    queue.push_back(copy);
+    ASSERT_EQ(queue.size(), corner.size() - 1);
+    ASSERT_EQ(queue.back().getType(), miam::trajectory::TrajectorySegment::Type::STRAIGHT_LINE);
+    ASSERT_EQ(queue.front().getType(), miam::trajectory::TrajectorySegment::Type::ARC_CIRCLE);
+
+    miam::trajectory::TrajectoryVector const vector = queue.toTrajectoryVector();
+    ASSERT_EQ(vector.size(), queue.size());
+    ASSERT_DOUBLE_EQ(vector.back()->getDuration(), copy.getDuration());
+
+    while(!queue.empty())
+        queue.pop_front();
+    ASSERT_EQ(queue.size(), 0u);
+}
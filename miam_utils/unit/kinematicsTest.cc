@@ -4,6 +4,7 @@
 
 #include "gtest/gtest.h"
 #include "miam_utils/trajectory/ThreeWheelsKinematics.hpp"
+#include "miam_utils/trajectory/HolonomicControl.hpp"
 
 double randf()
 {
@@ -56,3 +57,75 @@ TEST(ThreeWheelsKinematicsTest, ForwardInverse)
     ASSERT_FLOAT_EQ(baseSpeed.vy_, convertedBaseSpeed.vy_);
     ASSERT_FLOAT_EQ(baseSpeed.omega_, convertedBaseSpeed.omega_);
 }
+
+
+TEST(ThreeWheelsKinematicsTest, Integration)
+{
+    // Constant speed: the robot center goes along a circle, whatever the integration step.
+    omni::BaseSpeed baseSpeed(0.3, -0.4, 1.5);
+    double const radius = 0.5 / 1.5;
+    miam::RobotPosition start(1.0, 2.0, 0.7);
+    // Center of the circle, in the table frame: robot left of the velocity direction.
+    double const velocityAngle = start.theta + std::atan2(baseSpeed.vy_, baseSpeed.vx_);
+    double const centerX = start.x - radius * std::sin(velocityAngle);
+    double const centerY = start.y + radius * std::cos(velocityAngle);
+
+    for(double const& dt : {0.001, 0.1, 1.0})
+    {
+        miam::RobotPosition position = start;
+        int const nSteps = static_cast<int>(2.0 / dt);
+        for(int i = 0; i < nSteps; i++)
+            position = omni::ThreeWheelsKinematics::integratePosition(position, baseSpeed, dt);
+        ASSERT_NEAR(std::hypot(position.x - centerX, position.y - centerY), radius, 1e-9);
+        ASSERT_NEAR(position.theta, start.theta + 3.0, 1e-9);
+    }
+    // Pure translation.
+    miam::RobotPosition position = omni::ThreeWheelsKinematics::integratePosition(miam::RobotPosition(0, 0, M_PI / 2),
+                                                                                  omni::BaseSpeed(1.0, 0.0, 0.0),
+                                                                                  0.5);
+    ASSERT_NEAR(position.x, 0.0, 1e-12);
+    ASSERT_NEAR(position.y, 0.5, 1e-12);
+}
+
+
+TEST(ThreeWheelsKinematicsTest, TrajectoryFollowing)
+{
+    // Simulated robot, with 20% velocity error and 10ms latency, following a cleaning path at 100Hz.
+    omni::ThreeWheelsKinematics kinematics(0.165, 0.05);
+    std::vector<miam::RobotPosition> waypoints = {miam::RobotPosition(0.0, 0.0, 0.0),
+                                                  miam::RobotPosition(1.0, 0.0, 0.0),
+                                                  miam::RobotPosition(1.0, 0.3, M_PI / 2),
+                                                  miam::RobotPosition(0.0, 0.3, M_PI)};
+    omni::HolonomicTrajectory trajectory(waypoints, 0.5, 1.0, 2.0, 4.0);
+    ASSERT_GT(trajectory.getDuration(), 4.0);
+    omni::HolonomicPoseController controller(5.0, 5.0, 0.6, 3.0);
+    omni::HolonomicOdometry odometry;
+    odometry.reset(waypoints[0], 0.0);
+
+    double const dt = 0.01;
+    miam::RobotPosition truth = waypoints[0];
+    omni::BaseSpeed command;
+    double maxError = 0.0;
+    for(int i = 1; i * dt < trajectory.getDuration() + 1.0; i++)
+    {
+        // Robot: applies the previous command, with a gain error on the wheels.
+        omni::WheelSpeed wheelSpeed = kinematics.inverseKinematics(command);
+        for(int j = 0; j < 3; j++)
+            wheelSpeed.w_[j] *= 0.8;
+        omni::BaseSpeed const realSpeed = kinematics.forwardKinematics(wheelSpeed);
+        truth = omni::ThreeWheelsKinematics::integratePosition(truth, realSpeed, dt);
+        odometry.update(realSpeed, i * dt);
+
+        omni::HolonomicTrajectoryPoint const target = trajectory.getCurrentPoint(i * dt);
+        command = controller.computeCommand(odometry.getPosition(), target);
+        maxError = std::max(maxError, std::hypot(target.position_.x - truth.x, target.position_.y - truth.y));
+    }
+    // Odometry, from speed measurements.
+    ASSERT_NEAR(odometry.getPosition().x, truth.x, 5e-3);
+    ASSERT_NEAR(odometry.getPosition().y, truth.y, 5e-3);
+    // Tracking error.
+    ASSERT_LT(maxError, 0.05);
+    ASSERT_NEAR(truth.x, 0.0, 1e-3);
+    ASSERT_NEAR(truth.y, 0.3, 1e-3);
+    ASSERT_NEAR(truth.theta, M_PI, 1e-3);
+}
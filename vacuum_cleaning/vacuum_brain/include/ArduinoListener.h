@@ -2,7 +2,8 @@
 /// \brief Communication between the rapsberry and the arduino.
 ///
 /// \details This class starts a background thread that monitors the status of the Arduino, sending targets and
-///          receiving current information.
+///          receiving current information. Each speed measurement received is timestamped and integrated into
+///          the robot position (odometry).
 ///
 /// \author MiAM Robotique, Matthieu Vigne
 /// \copyright GNU GPLv3
@@ -11,7 +12,8 @@
 
     ///< Global includes
     #include <miam_utils/miam_utils.h>
-    
+    #include <miam_utils/trajectory/HolonomicControl.hpp>
+
     class ArduinoListener{
         public:
             /// \brief Constructor.
@@ -36,6 +38,16 @@
             ///
             /// \return Current base speed (linear and angular, SI units).
             omni::BaseSpeed getCurrentSpeed();
+
+            /// \brief Get current position of the robot, from odometry.
+            ///
+            /// \return Current position (in m and rad).
+            miam::RobotPosition getCurrentPosition();
+
+            /// \brief Reset the odometry to a given position.
+            ///
+            /// \param[in] position New robot position (in m and rad).
+            void resetPosition(miam::RobotPosition const& position);
             
             /// \brief Get kinematics of the robot.
             /// \return Pointer to the kinematics object.
@@ -50,6 +62,8 @@
         omni::WheelSpeed currentWheelSpeed_; ///< Current angular
         double SI_TO_TICKS_; ///< Convertion from SI units (rad/s) to ticks/s
         double lastWriteTime_; ///< Sime since last write to Arduino, for controlling write frequency.
+        Metronome timer_; ///< Timer, for timestamping measurements.
+        omni::HolonomicOdometry odometry_; ///< Odometry, integrating speed measurements.
         
         std::mutex mutex_; ///< Mutex, for thread safety.
         
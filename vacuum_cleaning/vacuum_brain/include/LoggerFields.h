@@ -23,6 +23,12 @@
         f(LOGGER_CURRENT_VELOCITY_X)  \
         f(LOGGER_CURRENT_VELOCITY_Y)  \
         f(LOGGER_CURRENT_VELOCITY_OMEGA)  \
+        f(LOGGER_TARGET_POSITION_X)  \
+        f(LOGGER_TARGET_POSITION_Y)  \
+        f(LOGGER_TARGET_POSITION_THETA)  \
+        f(LOGGER_CURRENT_POSITION_X)  \
+        f(LOGGER_CURRENT_POSITION_Y)  \
+        f(LOGGER_CURRENT_POSITION_THETA)  \
         f(LOGGER_TARGET_WHEEL_VELOCITY_1)  \
         f(LOGGER_TARGET_WHEEL_VELOCITY_2)  \
         f(LOGGER_TARGET_WHEEL_VELOCITY_3)  \
@@ -24,7 +24,9 @@ ArduinoListener::ArduinoListener(omni::ThreeWheelsKinematics const& kinematics,
     port_(-1),
     mutex_(),
     SI_TO_TICKS_(encoderResolution / 2.0 / M_PI),
-    lastWriteTime_(0.0)
+    lastWriteTime_(0.0),
+    timer_(0.1),
+    odometry_()
 {
     // EmptySI_TO_TICKS
 }
@@ -71,6 +73,23 @@ omni::BaseSpeed ArduinoListener::getCurrentSpeed()
 }
 
 
+miam::RobotPosition ArduinoListener::getCurrentPosition()
+{
+    mutex_.lock();
+    miam::RobotPosition position = odometry_.getPosition();
+    mutex_.unlock();
+    return position;
+}
+
+
+void ArduinoListener::resetPosition(miam::RobotPosition const& position)
+{
+    mutex_.lock();
+    odometry_.reset(position, timer_.getElapsedTime());
+    mutex_.unlock();
+}
+
+
 omni::ThreeWheelsKinematics *ArduinoListener::getKinematics()
 {
     return &kinematics_;
@@ -82,8 +101,6 @@ double const TARGET_UPDATE_PERIOD = 0.004; // Time increment to send new target,
 void ArduinoListener::communicationThread()
 {
     // Init
-    // Metronome object: simple wrapper for getting current time.
-    Metronome timer(0.1);
     lastWriteTime_ = 0.0;
 
     unsigned char arduinoMessage[ARDUINO_MESSAGE_LENGTH];
@@ -93,7 +110,7 @@ void ArduinoListener::communicationThread()
 
     while(true)
     {
-        double time = timer.getElapsedTime();
+        double time = timer_.getElapsedTime();
 
         // Send new target to arduino.
         if (time - lastWriteTime_ > TARGET_UPDATE_PERIOD)
@@ -168,6 +185,8 @@ void ArduinoListener::communicationThread()
                             int16_t wheelSpeedTicks = (1 << 15) - ((arduinoMessage[0 + 2 * i] << 8) + arduinoMessage[1 + 2 * i]);
                             currentWheelSpeed_.w_[i] = wheelSpeedTicks / SI_TO_TICKS_;
                         }
+                        // Integrate odometry, using the reception time of the measurement.
+                        odometry_.update(kinematics_.forwardKinematics(currentWheelSpeed_), timer_.getElapsedTime());
                         mutex_.unlock();
                     }
                 }
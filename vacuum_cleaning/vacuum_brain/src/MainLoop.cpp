@@ -8,12 +8,15 @@
 #include "ArduinoListener.h"
 #include <miam_utils/raspberry_pi/RaspberryPi.h>
 #include <miam_utils/trajectory/ThreeWheelsKinematics.hpp>
+#include <miam_utils/trajectory/HolonomicControl.hpp>
 //~ #include "Utilities.h"
 
 #include <iostream>
 #include <unistd.h>
 #include <signal.h>
 #include <cmath>
+#include <memory>
+#include <vector>
 
 
 #include <unistd.h>
@@ -118,6 +121,43 @@ size_t get_axis_state(struct js_event *event, struct axis_state axes[3])
 
 
 
+/// \brief Create a cleaning path: back and forth lines covering a rectangle in front of the robot.
+///
+/// \param[in] start Starting position.
+/// \param[in] length Length of each line, in m.
+/// \param[in] width Width of the area, to the left of the robot, in m.
+/// \param[in] spacing Distance between two lines, in m.
+/// \return Waypoints, including the starting position.
+std::vector<miam::RobotPosition> createCleaningPath(miam::RobotPosition const& start,
+                                                    double const& length,
+                                                    double const& width,
+                                                    double const& spacing)
+{
+    std::vector<miam::RobotPosition> waypoints;
+    waypoints.push_back(start);
+    double const c = std::cos(start.theta);
+    double const s = std::sin(start.theta);
+    int const nLines = static_cast<int>(width / spacing) + 1;
+    for(int i = 0; i < nLines; i++)
+    {
+        // Along the line, then sideways to the next one: the robot keeps facing forward.
+        double const lateral = i * spacing;
+        double const forward = (i % 2 == 0 ? length : 0.0);
+        if(i > 0)
+        {
+            double const previousForward = length - forward;
+            waypoints.push_back(miam::RobotPosition(start.x + c * previousForward - s * lateral,
+                                                    start.y + s * previousForward + c * lateral,
+                                                    start.theta));
+        }
+        waypoints.push_back(miam::RobotPosition(start.x + c * forward - s * lateral,
+                                                start.y + s * forward + c * lateral,
+                                                start.theta));
+    }
+    return waypoints;
+}
+
+
 // Update loop frequency, in s.
 //~ double const LOOP_PERIOD = 0.005;
 double const LOOP_PERIOD = 0.010;
@@ -144,6 +184,7 @@ int main(int argc, char **argv)
         std::cout << "Failed to init communication with Arduino" << std::endl;
         exit(0);
     }
+    arduino.resetPosition(miam::RobotPosition());
 
 
     struct js_event event;
@@ -171,6 +212,13 @@ int main(int argc, char **argv)
     double const MAX_ANGULAR_VELOCITY = 4.0;
     double const DEADZONE = 0.15;
 
+    // Trajectory following: started by joystick button 0, stopped by any joystick motion.
+    omni::HolonomicPoseController controller(5.0, 5.0, MAX_VELOCITY, MAX_ANGULAR_VELOCITY);
+    std::shared_ptr<omni::HolonomicTrajectory> trajectory;
+    double trajectoryStartTime = 0.0;
+    miam::RobotPosition currentPosition;
+    omni::HolonomicTrajectoryPoint targetPoint;
+
     while (true)
     {
         // Wait for next tick.
@@ -193,6 +241,14 @@ int main(int argc, char **argv)
             {
                 case JS_EVENT_BUTTON:
                     std::cout << "Button " << int(event.number) <<  (event.value ? " pressed" : " released");
+                    if (event.number == 0 && event.value)
+                    {
+                        // Clean the area in front of the robot.
+                        trajectory = std::make_shared<omni::HolonomicTrajectory>(
+                            createCleaningPath(arduino.getCurrentPosition(), 1.0, 0.6, 0.2),
+                            0.8 * MAX_VELOCITY, 0.5, 0.5 * MAX_ANGULAR_VELOCITY, 2.0);
+                        trajectoryStartTime = currentTime;
+                    }
                     break;
                 case JS_EVENT_AXIS:
                     get_axis_state(&event, axes);
@@ -214,6 +270,10 @@ int main(int argc, char **argv)
                     targetSpeed.vy_ *= MAX_VELOCITY;
                     targetSpeed.omega_ *= MAX_ANGULAR_VELOCITY;
 
+                    // Manual control takes over trajectory following.
+                    if (targetSpeed.vx_ != 0 || targetSpeed.vy_ != 0 || targetSpeed.omega_ != 0)
+                        trajectory.reset();
+
                 default:
                     /* Ignore init events. */
                     break;
@@ -222,6 +282,22 @@ int main(int argc, char **argv)
 
         //~ std::cout << "Target speed " << targetSpeed.vx_ << " " << targetSpeed.vy_ << " " << targetSpeed.omega_ << std::endl;;
 
+        currentPosition = arduino.getCurrentPosition();
+        if (trajectory)
+        {
+            double const trajectoryTime = currentTime - trajectoryStartTime;
+            targetPoint = trajectory->getCurrentPoint(trajectoryTime);
+            targetSpeed = controller.computeCommand(currentPosition, targetPoint);
+            // Keep servoing a short time at the end, to converge onto the final point.
+            if (trajectoryTime > trajectory->getDuration() + 0.5)
+            {
+                trajectory.reset();
+                targetSpeed = omni::BaseSpeed();
+            }
+        }
+        else
+            targetPoint.position_ = currentPosition;
+
         arduino.setTarget(targetSpeed);
         currentSpeed = arduino.getCurrentSpeed();
 
@@ -233,6 +309,12 @@ int main(int argc, char **argv)
         logger.setData(LOGGER_CURRENT_VELOCITY_X, currentSpeed.vx_);
         logger.setData(LOGGER_CURRENT_VELOCITY_Y, currentSpeed.vy_);
         logger.setData(LOGGER_CURRENT_VELOCITY_OMEGA, currentSpeed.omega_);
+        logger.setData(LOGGER_TARGET_POSITION_X, targetPoint.position_.x);
+        logger.setData(LOGGER_TARGET_POSITION_Y, targetPoint.position_.y);
+        logger.setData(LOGGER_TARGET_POSITION_THETA, targetPoint.position_.theta);
+        logger.setData(LOGGER_CURRENT_POSITION_X, currentPosition.x);
+        logger.setData(LOGGER_CURRENT_POSITION_Y, currentPosition.y);
+        logger.setData(LOGGER_CURRENT_POSITION_THETA, currentPosition.theta);
 
         targetWheelSpeed = kinematics.inverseKinematics(targetSpeed);
         currentWheelSpeed = kinematics.inverseKinematics(currentSpeed);